@@ -0,0 +1,533 @@
+/**************************************************************************//**
+ * @file lolan-cbor.c
+ * @brief LoLaN CBOR payload validation and cursor
+ * @author Sunstone-RTLS Ltd.
+ ******************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "lolan_config.h"
+#include "lolan.h"
+#include "lolan-utils.h"
+#include "cbor.h"
+
+/*
+ * LoLaN CBOR payload cursor
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ *   A received payload is checked once by lolanCborValidate() (the heads
+ *   and lengths of all items are in bounds, the break bytes and the chunks
+ *   of the indefinite length strings are at valid positions). The nested
+ *   path maps are walked after it with an unchecked cursor.
+ *
+ *   The containers (maps, arrays and indefinite length strings) are
+ *   numbered in the order of their heads. The validation stores the end
+ *   and the next container ordinal of the first LOLAN_CBOR_INDEX_SIZE
+ *   containers, so the cursor skips them in constant time. The other
+ *   containers are skipped by walking their items, and the definite length
+ *   strings are skipped by their length.
+ *
+ *   A tag is a separate item which is not counted in its container (as in
+ *   tinycbor). The variable data is decoded at the cursor without checks
+ *   (see lolanGetDataFromCbor() and lolanVarIndexUpdateFromCbor()), the
+ *   zero key entry with tinycbor (see lolanCborCursorValue()).
+ */
+
+#define LOLAN_CBOR_BREAK   0xff   // break byte (end of an indefinite length item)
+
+
+/**************************************************************************//**
+ * @brief
+ *   Decode the head of a CBOR data item without checks.
+ * @param[in,out] p
+ *   Pointer to the pointer to the initial byte of the item, it is advanced
+ *   after the head.
+ * @return
+ *   The argument of the head (0 for indefinite length).
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static inline uint64_t lolanCborHead(const uint8_t **p)
+{
+  const uint8_t *q;
+  uint8_t ai;
+  uint64_t value;
+
+  q = *p;
+  ai = *q++ & 0x1f;   // additional information
+  switch (ai) {   // (big-endian argument)
+    case 24:
+      value = q[0];
+      q += 1;
+      break;
+    case 25:
+      value = ((uint16_t) q[0] << 8) | q[1];
+      q += 2;
+      break;
+    case 26:
+      value = ((uint32_t) q[0] << 24) | ((uint32_t) q[1] << 16) | ((uint32_t) q[2] << 8) | q[3];
+      q += 4;
+      break;
+    case 27:
+      value = ((uint64_t) q[0] << 56) | ((uint64_t) q[1] << 48) | ((uint64_t) q[2] << 40) | ((uint64_t) q[3] << 32)
+            | ((uint64_t) q[4] << 24) | ((uint64_t) q[5] << 16) | ((uint64_t) q[6] << 8) | q[7];
+      q += 8;
+      break;
+    default:
+      value = (ai < 24) ? ai : 0;   // (0: indefinite length)
+      break;
+  }
+  *p = q;
+  return value;
+} /* lolanCborHead */
+
+/**************************************************************************//**
+ * @brief
+ *   Validate a CBOR payload and build its container index.
+ * @details
+ *   Only the first (root) data item is validated, the bytes after it are
+ *   ignored. Containers nested deeper than LOLAN_CBOR_MAX_NESTING are
+ *   refused.
+ * @param[out] idx
+ *   Pointer to the container index.
+ * @param[in] data
+ *   Pointer to the payload (it has to remain valid while the index is
+ *   used).
+ * @param[in] size
+ *   The size of the payload.
+ * @return
+ *   LOLAN_RETVAL_YES:        The payload is valid.
+ *   LOLAN_RETVAL_CBORERROR:  The payload is not a valid CBOR data item.
+ ******************************************************************************/
+int8_t lolanCborValidate(lolan_CborIndex *idx, const uint8_t *data, size_t size)
+{
+  size_t remaining[LOLAN_CBOR_MAX_NESTING + 1];   // items left in the enclosing containers of the open containers (by level)
+  LP_SIZE_T ord[LOLAN_CBOR_MAX_NESTING + 1];      // ordinals of the open containers (by level)
+  const uint8_t *p, *end;
+  uint8_t level, ib, major, ai;
+  size_t left, total;
+  uint64_t arg;
+
+  idx->data = data;
+  idx->end = data + size;
+  p = data;
+  end = idx->end;
+  total = 0;   // number of containers found
+
+  level = 0;   // (level 0: the root item)
+  left = 1;    // items left in the current container (indefinite length: counted down from LOLAN_CBOR_INDEFINITE, it remains above size)
+
+  for (;;) {
+    /* close a finished container */
+    if (left == 0) {
+      if (level == 0) {   // the root item is complete
+        idx->count = (total < LOLAN_CBOR_INDEX_SIZE) ? total : LOLAN_CBOR_INDEX_SIZE;
+        return LOLAN_RETVAL_YES;
+      }
+      if (ord[level] < LOLAN_CBOR_INDEX_SIZE) {
+        idx->skip[ord[level]] = p - data;
+        idx->next[ord[level]] = total;
+      }
+      left = remaining[level];
+      level--;
+      continue;
+    }
+    if (p >= end) return LOLAN_RETVAL_CBORERROR;
+    ib = *p;
+    if (ib == LOLAN_CBOR_BREAK) {   // end of an indefinite length container
+      if (left <= size) return LOLAN_RETVAL_CBORERROR;   // unexpected break (definite length container)
+      p++;
+      left = 0;
+      continue;
+    }
+
+    /* check the head of the next item (with its tags, which are not counted) */
+    for (;;) {
+      ai = ib & 0x1f;   // additional information
+      if (ai < 24) {
+        arg = ai;
+        p++;
+      } else if (ai <= 27) {
+        if ((size_t) (end - p) <= ((size_t) 1 << (ai - 24))) return LOLAN_RETVAL_CBORERROR;   // truncated head
+        arg = lolanCborHead(&p);
+      } else if ((ai == 31) && (ib >= 0x40) && (ib < 0xc0)) {   // indefinite length string, array or map
+        arg = 0;
+        p++;
+      } else {   // reserved additional information, break after a tag or unexpected indefinite length
+        return LOLAN_RETVAL_CBORERROR;
+      }
+      if ((ib >> 5) != 6) break;
+      if (p >= end) return LOLAN_RETVAL_CBORERROR;   // (tag without item)
+      ib = *p;
+    }
+    left--;
+
+    major = ib >> 5;
+    if (major <= 1) {   // integer (the most frequent item)
+      continue;
+    } else if (major == 7) {   // simple value or floating-point
+      if ((ai == 24) && (arg < 32)) return LOLAN_RETVAL_CBORERROR;   // illegal simple type
+      continue;
+    } else if (major <= 3) {   // byte or text string
+      if (ai != 31) {
+        if (arg > (uint64_t) (end - p)) return LOLAN_RETVAL_CBORERROR;   // truncated string
+        p += arg;
+        continue;
+      }
+      for (;;) {   // chunks (definite length strings of the same major type)
+        if (p >= end) return LOLAN_RETVAL_CBORERROR;
+        ib = *p;
+        if (ib == LOLAN_CBOR_BREAK) break;
+        ai = ib & 0x1f;
+        if (((ib >> 5) != major) || (ai >= 28)) return LOLAN_RETVAL_CBORERROR;   // invalid chunk
+        if ((ai >= 24) && ((size_t) (end - p) <= ((size_t) 1 << (ai - 24))))
+          return LOLAN_RETVAL_CBORERROR;   // truncated head
+        arg = lolanCborHead(&p);
+        if (arg > (uint64_t) (end - p)) return LOLAN_RETVAL_CBORERROR;   // truncated chunk
+        p += arg;
+      }
+      p++;   // (break byte)
+      if (total < LOLAN_CBOR_INDEX_SIZE) {
+        idx->skip[total] = p - data;
+        idx->next[total] = total + 1;
+      }
+      total++;
+      continue;
+    }
+
+    /* open an array or map */
+    if (ai != 31) {
+      if ((arg > (uint64_t) (end - p)) || ((major == 5) && (2 * arg > (uint64_t) (end - p))))
+        return LOLAN_RETVAL_CBORERROR;   // (every item needs at least 1 byte)
+      if (major == 5) arg *= 2;
+    } else {
+      arg = LOLAN_CBOR_INDEFINITE;
+    }
+    if (level >= LOLAN_CBOR_MAX_NESTING) return LOLAN_RETVAL_CBORERROR;   // (nested too deep)
+    level++;
+    ord[level] = total++;
+    remaining[level] = left;
+    left = arg;
+  }
+} /* lolanCborValidate */
+
+/**************************************************************************//**
+ * @brief
+ *   Initialize a cursor at the root item of a validated payload.
+ * @param[in] idx
+ *   Pointer to the container index of the payload.
+ * @param[out] cur
+ *   Pointer to the cursor.
+ ******************************************************************************/
+void lolanCborCursorRoot(const lolan_CborIndex *idx, lolan_CborCursor *cur)
+{
+  cur->idx = idx;
+  cur->ptr = idx->data;
+  cur->remaining = 1;
+  cur->ord = 0;
+} /* lolanCborCursorRoot */
+
+/**************************************************************************//**
+ * @brief
+ *   Get the integer at a cursor (see LOLAN_CBOR_IS_INTEGER()).
+ * @details
+ *   The value is truncated to int in the same way as cbor_value_get_int().
+ * @param[in] cur
+ *   Pointer to the cursor.
+ * @return
+ *   The value of the integer.
+ ******************************************************************************/
+int lolanCborCursorGetInt(const lolan_CborCursor *cur)
+{
+  const uint8_t *p;
+  int value;
+
+  p = cur->ptr;
+  value = (int) lolanCborHead(&p);
+  if (*cur->ptr >= 0x20)   // negative integer
+    value = -value - 1;
+  return value;
+} /* lolanCborCursorGetInt */
+
+/**************************************************************************//**
+ * @brief
+ *   Get the argument of the head of the item at a cursor.
+ * @details
+ *   It is the value of an unsigned integer, the bit pattern of a floating
+ *   point number (or the length of a definite length string).
+ * @param[in] cur
+ *   Pointer to the cursor.
+ * @return
+ *   The argument of the head.
+ ******************************************************************************/
+uint64_t lolanCborCursorGetUint(const lolan_CborCursor *cur)
+{
+  const uint8_t *p;
+
+  p = cur->ptr;
+  return lolanCborHead(&p);
+} /* lolanCborCursorGetUint */
+
+/**************************************************************************//**
+ * @brief
+ *   Get the length of the string at a cursor.
+ * @param[in] cur
+ *   Pointer to the cursor at a byte or text string.
+ * @return
+ *   The length of the string (the sum of the chunks).
+ ******************************************************************************/
+size_t lolanCborCursorStringLength(const lolan_CborCursor *cur)
+{
+  const uint8_t *p;
+  size_t len, n;
+
+  p = cur->ptr;
+  if ((*p & 0x1f) != 31)
+    return lolanCborHead(&p);
+  p++;
+  len = 0;
+  while (*p != LOLAN_CBOR_BREAK) {   // chunks
+    n = lolanCborHead(&p);
+    len += n;
+    p += n;
+  }
+  return len;
+} /* lolanCborCursorStringLength */
+
+/**************************************************************************//**
+ * @brief
+ *   Copy the string at a cursor.
+ * @details
+ *   A terminating zero is added if it fits into the buffer (as tinycbor
+ *   does).
+ * @param[in] cur
+ *   Pointer to the cursor at a byte or text string.
+ * @param[out] buf
+ *   Address of the buffer which receives the string.
+ * @param[in] size
+ *   The size of the buffer, it must not be less than the length of the
+ *   string (see lolanCborCursorStringLength()).
+ ******************************************************************************/
+void lolanCborCursorCopyString(const lolan_CborCursor *cur, uint8_t *buf, size_t size)
+{
+  const uint8_t *p;
+  size_t len, n;
+
+  p = cur->ptr;
+  if ((*p & 0x1f) != 31) {
+    len = lolanCborHead(&p);
+    memcpy(buf, p, len);
+  } else {   // chunks
+    p++;
+    len = 0;
+    while (*p != LOLAN_CBOR_BREAK) {
+      n = lolanCborHead(&p);
+      memcpy(buf + len, p, n);
+      len += n;
+      p += n;
+    }
+  }
+  if (len < size)
+    buf[len] = 0;   // terminating zero
+} /* lolanCborCursorCopyString */
+
+/**************************************************************************//**
+ * @brief
+ *   Get the next chunk of the string at a cursor.
+ * @details
+ *   A definite length string is a single chunk.
+ * @param[in] cur
+ *   Pointer to the cursor at a byte or text string.
+ * @param[in,out] pos
+ *   Pointer to the position of the next chunk (set it to NULL before the
+ *   first call).
+ * @param[out] len
+ *   Pointer to the variable which receives the length of the chunk.
+ * @return
+ *   Pointer to the data of the chunk (NULL: no more chunks).
+ ******************************************************************************/
+const uint8_t *lolanCborCursorStringChunk(const lolan_CborCursor *cur, const uint8_t **pos, size_t *len)
+{
+  const uint8_t *p;
+
+  p = *pos;
+  if (p == cur->ptr) return NULL;   // (after the definite length string)
+  if (p == NULL) {   // first chunk
+    p = cur->ptr;
+    if ((*p & 0x1f) != 31) {   // definite length string
+      *len = lolanCborHead(&p);
+      *pos = cur->ptr;
+      return p;
+    }
+    p++;
+  }
+  if (*p == LOLAN_CBOR_BREAK) return NULL;
+  *len = lolanCborHead(&p);
+  *pos = p + *len;
+  return p;
+} /* lolanCborCursorStringChunk */
+
+/**************************************************************************//**
+ * @brief
+ *   Skip a CBOR data item (with its tags) without the container index.
+ * @param[in] p
+ *   Pointer to the initial byte of the item.
+ * @param[in,out] ord
+ *   Pointer to the ordinal of the next container, it is advanced after the
+ *   containers of the item.
+ * @return
+ *   Pointer after the item.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static const uint8_t *lolanCborSkip(const uint8_t *p, LP_SIZE_T *ord)
+{
+  uint8_t ib;
+  uint64_t n;
+
+  do {   // (tags)
+    ib = *p;
+    n = lolanCborHead(&p);
+  } while ((ib >> 5) == 6);
+
+  switch (ib >> 5) {
+    case 2:   // string
+    case 3:
+      if ((ib & 0x1f) != 31) {
+        p += n;
+      } else {   // chunks
+        (*ord)++;
+        while (*p != LOLAN_CBOR_BREAK) {
+          n = lolanCborHead(&p);
+          p += n;
+        }
+        p++;
+      }
+      break;
+    case 4:   // array
+    case 5:   // map
+      (*ord)++;
+      if ((ib & 0x1f) != 31) {
+        if ((ib >> 5) == 5) n *= 2;
+        while (n--)
+          p = lolanCborSkip(p, ord);   // (the nesting is limited by the validation)
+      } else {
+        while (*p != LOLAN_CBOR_BREAK)
+          p = lolanCborSkip(p, ord);
+        p++;
+      }
+      break;
+    default:   // (fixed size)
+      break;
+  }
+  return p;
+} /* lolanCborSkip */
+
+/**************************************************************************//**
+ * @brief
+ *   Advance a cursor to the next item in its container.
+ * @details
+ *   Indexed containers and definite length strings are skipped in
+ *   constant time. The cursor must not be at the end of its container.
+ * @param[in,out] cur
+ *   Pointer to the cursor.
+ ******************************************************************************/
+void lolanCborCursorAdvance(lolan_CborCursor *cur)
+{
+  const uint8_t *p;
+  uint8_t ib;
+  uint64_t n;
+
+  p = cur->ptr;
+  ib = *p;
+  if ((ib < 0x40) || (ib >= 0xe0)) {   // integer, floating-point or simple value (fixed size)
+    lolanCborHead(&p);
+    cur->ptr = p;
+  } else if ((ib >> 5) == 6) {   // tag: only the tag is skipped (it is not counted)
+    lolanCborHead(&p);
+    cur->ptr = p;
+    return;
+  } else if ((ib >= 0x80) || ((ib & 0x1f) == 31)) {   // container (or chunked string)
+    if (cur->ord < cur->idx->count) {   // indexed
+      cur->ptr = cur->idx->data + cur->idx->skip[cur->ord];
+      cur->ord = cur->idx->next[cur->ord];
+    } else {
+      cur->ptr = lolanCborSkip(p, &cur->ord);
+    }
+  } else {   // definite length string
+    n = lolanCborHead(&p);
+    cur->ptr = p + n;
+  }
+  if (cur->remaining != LOLAN_CBOR_INDEFINITE)
+    cur->remaining--;
+} /* lolanCborCursorAdvance */
+
+/**************************************************************************//**
+ * @brief
+ *   Enter the map or array at a cursor.
+ * @details
+ *   The parent cursor is not modified, see lolanCborCursorLeave().
+ * @param[in] cur
+ *   Pointer to the cursor at a map or array.
+ * @param[out] child
+ *   Pointer to the cursor which receives the first item of the container.
+ ******************************************************************************/
+void lolanCborCursorEnter(const lolan_CborCursor *cur, lolan_CborCursor *child)
+{
+  const uint8_t *p;
+  uint8_t ib;
+  uint64_t n;
+
+  p = cur->ptr;
+  ib = *p;
+  n = lolanCborHead(&p);
+  child->idx = cur->idx;
+  child->ptr = p;
+  child->ord = cur->ord + 1;
+  if ((ib & 0x1f) == 31)
+    child->remaining = LOLAN_CBOR_INDEFINITE;
+  else
+    child->remaining = ((ib >> 5) == 5) ? 2 * n : n;   // (a map has key and data items)
+} /* lolanCborCursorEnter */
+
+/**************************************************************************//**
+ * @brief
+ *   Leave a container, and advance the cursor of the container to the
+ *   next item.
+ * @param[in,out] cur
+ *   Pointer to the cursor at the container (see lolanCborCursorEnter()).
+ * @param[in] child
+ *   Pointer to the cursor in the container, it must be at the end of the
+ *   container (see LOLAN_CBOR_AT_END()).
+ ******************************************************************************/
+void lolanCborCursorLeave(lolan_CborCursor *cur, const lolan_CborCursor *child)
+{
+  cur->ptr = child->ptr;
+  if (child->remaining == LOLAN_CBOR_INDEFINITE)
+    cur->ptr++;   // (break byte)
+  cur->ord = child->ord;
+  if (cur->remaining != LOLAN_CBOR_INDEFINITE)
+    cur->remaining--;
+} /* lolanCborCursorLeave */
+
+/**************************************************************************//**
+ * @brief
+ *   Get a tinycbor iterator to decode the item at a cursor.
+ * @details
+ *   The iterator is at the end after advancing over the item, the cursor
+ *   is not modified (see lolanCborCursorAdvance()).
+ * @param[in] cur
+ *   Pointer to the cursor.
+ * @param[out] parser
+ *   Pointer to the CBOR parser of the iterator.
+ * @param[out] value
+ *   Pointer to the CBOR iterator.
+ * @return
+ *   The error code of cbor_parser_init().
+ ******************************************************************************/
+CborError lolanCborCursorValue(const lolan_CborCursor *cur, CborParser *parser, CborValue *value)
+{
+  return cbor_parser_init(cur->ptr, cur->idx->end - cur->ptr, 0, parser, value);
+} /* lolanCborCursorValue */
@@ -0,0 +1,202 @@
+/**************************************************************************//**
+ * @file lolan-dupfilter.c
+ * @brief LoLaN duplicate request filter
+ * @author Sunstone-RTLS Ltd.
+ ******************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "lolan_config.h"
+#include "lolan.h"
+#include "lolan-utils.h"
+
+#ifdef LOLAN_DUPFILTER_SOURCES
+
+/*
+ * LoLaN duplicate request filter
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ *   A master retransmits a GET or SET request with the same packet counter
+ *   if the reply is lost. For every sender (up to LOLAN_DUPFILTER_SOURCES)
+ *   the newest packet counter processed and a bitmap of the previous
+ *   LOLAN_DUPFILTER_WINDOW packet counters are stored:
+ *
+ *   - a retransmission of the newest request is answered with the cached
+ *     reply (without processing the request again),
+ *   - a retransmission of an older request is dropped (its reply is not
+ *     cached, and the master is not waiting for it any more).
+ *
+ *   A GET request has no side effects, so it is processed again instead of
+ *   being dropped if its reply is not available (the reply was larger than
+ *   LOLAN_DUPFILTER_REPLY_SIZE, or it is an older request). A SET request
+ *   is never processed again (the variables may have been changed since
+ *   then): if its reply was not cached, the retransmission is dropped, and
+ *   the master does not get a reply for it. Set LOLAN_DUPFILTER_REPLY_SIZE
+ *   to at least the size of the largest SET reply (the default is
+ *   LOLAN_PACKET_MAX_PAYLOAD_SIZE) to avoid this.
+ *
+ *   The newest request is recognized also by the CRC of its payload, so
+ *   a sender which restarts its packet counter is not mistaken for a
+ *   retransmission (unless an older packet counter of the window is
+ *   reused). The least recently used entry is replaced by a new sender.
+ */
+
+
+/**************************************************************************//**
+ * @brief
+ *   Find the duplicate filter entry of a sender.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] fromId
+ *   Address of the sender.
+ * @return
+ *   The entry, or NULL if not found.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ *****************************************************************************/
+static lolan_DupFilterEntry* lolanDupFilterFind(lolan_ctx *ctx, uint16_t fromId)
+{
+  uint8_t i;
+
+  for (i = 0; i < LOLAN_DUPFILTER_SOURCES; i++) {
+    if (ctx->dupFilter[i].used && (ctx->dupFilter[i].fromId == fromId))
+      return &ctx->dupFilter[i];
+  }
+  return NULL;
+} /* lolanDupFilterFind */
+
+/**************************************************************************//**
+ * @brief
+ *   Check whether a GET or SET request is a retransmission.
+ * @details
+ *   If the request is a retransmission of the newest request of the sender
+ *   and its reply is cached, the reply packet structure is filled up with
+ *   the cached reply. A retransmitted GET request without cached reply is
+ *   not reported (it should be processed again).
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] pak
+ *   Pointer to the LoLaN packet structure of the request.
+ * @param[out] reply
+ *   Pointer to the LoLaN packet structure in which the reply will be
+ *   returned (see lolan_processGet()).
+ * @param[out] result
+ *   The return value of the request processing function if the request is
+ *   a retransmission:
+ *     LOLAN_RETVAL_YES: The cached reply is filled in the reply packet
+ *       structure.
+ *     LOLAN_RETVAL_NO: No reply should be sent (SET request).
+ * @return
+ *   True if the request is a retransmission (it should not be processed).
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ *****************************************************************************/
+bool lolanDupFilterCheck(lolan_ctx *ctx, const lolan_Packet *pak, lolan_Packet *reply, int8_t *result)
+{
+  lolan_DupFilterEntry *e;
+  uint8_t back;
+
+  e = lolanDupFilterFind(ctx, pak->fromId);
+  if (e == NULL)   // unknown sender
+    return false;
+
+  back = (uint8_t) (e->lastCounter - pak->packetCounter);
+  if (back == 0) {   // same packet counter as the newest request
+    if ((pak->packetType != e->requestType) ||
+        (lolan_CRC_calc(pak->payload, pak->payloadSize) != e->requestCRC))
+      return false;   // another request (the sender has restarted its packet counter)
+    e->lastUse = ++ctx->dupFilterClock;
+    if (!e->replyCached) {
+      if (pak->packetType == LOLAN_PAK_GET) {   // (no side effects)
+        DLOG(("\n Retransmitted GET request, reply not cached, processed again"));
+        return false;
+      }
+      DLOG(("\n Retransmitted SET request, reply not cached"));
+      *result = LOLAN_RETVAL_NO;
+      return true;
+    }
+    DLOG(("\n Retransmitted request, answered from cache"));
+    lolan_resetPacket(reply);   // reset options
+    reply->packetCounter = pak->packetCounter;
+    reply->packetType = LOLAN_PAK_ACK;
+    if (LOLAN_COPY_ROUTINGREQUEST_ON_ACK) reply->routingRequested = pak->routingRequested;
+    reply->fromId = ctx->myAddress;
+    reply->toId = pak->fromId;
+    memcpy(reply->payload, e->reply, e->replySize);
+    reply->payloadSize = e->replySize;
+    *result = LOLAN_RETVAL_YES;
+    return true;
+  }
+
+  if ((back <= LOLAN_DUPFILTER_WINDOW) && (e->window & (1UL << (back - 1)))) {   // older request already processed
+    if (pak->packetType == LOLAN_PAK_GET) {   // (no side effects)
+      DLOG(("\n Retransmitted old GET request processed again"));
+      return false;
+    }
+    DLOG(("\n Retransmitted old SET request dropped"));
+    *result = LOLAN_RETVAL_NO;
+    return true;
+  }
+
+  return false;
+} /* lolanDupFilterCheck */
+
+/**************************************************************************//**
+ * @brief
+ *   Record a processed GET or SET request in the duplicate filter.
+ * @details
+ *   The reply is cached if it is the reply to the newest request of the
+ *   sender and it is not longer than LOLAN_DUPFILTER_REPLY_SIZE.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] pak
+ *   Pointer to the LoLaN packet structure of the request.
+ * @param[in] reply
+ *   Pointer to the LoLaN packet structure of the reply.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ *****************************************************************************/
+void lolanDupFilterStore(lolan_ctx *ctx, const lolan_Packet *pak, const lolan_Packet *reply)
+{
+  lolan_DupFilterEntry *e;
+  uint8_t i, d;
+
+  e = lolanDupFilterFind(ctx, pak->fromId);
+  if (e == NULL) {   // new sender: use a free or the least recently used entry
+    e = &ctx->dupFilter[0];
+    for (i = 0; (i < LOLAN_DUPFILTER_SOURCES) && e->used; i++) {
+      if (!ctx->dupFilter[i].used ||
+          ((uint32_t) (ctx->dupFilterClock - ctx->dupFilter[i].lastUse) > (uint32_t) (ctx->dupFilterClock - e->lastUse)))
+        e = &ctx->dupFilter[i];
+    }
+    e->used = true;
+    e->fromId = pak->fromId;
+    e->lastCounter = pak->packetCounter;
+    e->window = 0;
+  }
+  e->lastUse = ++ctx->dupFilterClock;
+
+  d = (uint8_t) (pak->packetCounter - e->lastCounter);
+  if (d >= 128) {   // older packet counter
+    d = (uint8_t) -d;
+    if (d <= LOLAN_DUPFILTER_WINDOW) {
+      e->window |= 1UL << (d - 1);
+      return;   // (the cached reply belongs to the newest request)
+    }
+    e->window = 0;   // far behind: the sender has restarted its packet counter
+  } else if (d > 0) {   // newer packet counter: slide the window
+    e->window = (d > LOLAN_DUPFILTER_WINDOW) ? 0 : ((e->window << 1) | 1UL) << (d - 1);
+  }
+
+  e->lastCounter = pak->packetCounter;
+  e->requestType = pak->packetType;
+  e->requestCRC = lolan_CRC_calc(pak->payload, pak->payloadSize);
+  e->replyCached = (reply->payloadSize <= LOLAN_DUPFILTER_REPLY_SIZE);
+  if (e->replyCached) {
+    memcpy(e->reply, reply->payload, reply->payloadSize);
+    e->replySize = reply->payloadSize;
+  }
+} /* lolanDupFilterStore */
+
+#endif
@@ -119,7 +119,42 @@
  *      LoLaN GET packet).
  *    LOLAN_RETVAL_CBORERROR: A CBOR-related error has occurred.
  *****************************************************************************/
-int8_t lolan_processGet(lolan_ctx *ctx, lolan_Packet *pak, lolan_Packet *reply)
+int8_t lolan_processGet(lolan_ctx *ctx, const lolan_Packet *pak, lolan_Packet *reply)
+{
+  return lolan_processGetEx(ctx, pak, reply, 0);
+} /* lolan_processGet */
+
+/**************************************************************************//**
+ * @brief
+ *   Process a LoLaN GET command.  EXTENDED VERSION
+ * @details
+ *   The same as lolan_processGet, but the size limit of the reply can be
+ *   overridden: a reply larger than LOLAN_PACKET_MAX_PAYLOAD_SIZE can be
+ *   sent as a multipart packet (see lolan_fragmenterInit()).
+ * @note
+ *   In the reply packet structure the payload parameter should be
+ *   assigned to a buffer with a minimum length of
+ *   LOLAN_PACKET_MAX_PAYLOAD_SIZE (or plSizeOverride)!
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] pak
+ *   Pointer to the input LoLaN packet structure which contains the GET
+ *   command.
+ * @param[out] reply
+ *   Pointer to the LoLaN packet structure in which the reply will be
+ *   generated.
+ * @param[in] plSizeOverride
+ *   Override LOLAN_PACKET_MAX_PAYLOAD_SIZE with the specified value.
+ *   Set to zero to disable this feature.
+ * @return
+ *   	LOLAN_RETVAL_YES: Request is processed, reply packet structure
+ *   	  is filled.
+ *    LOLAN_RETVAL_GENERROR: An error has occurred (e.g. pak is not a
+ *      LoLaN GET packet).
+ *    LOLAN_RETVAL_CBORERROR: A CBOR-related error has occurred.
+ *****************************************************************************/
+int8_t lolan_processGetEx(lolan_ctx *ctx, const lolan_Packet *pak, lolan_Packet *reply,
+          LP_SIZE_T plSizeOverride)
 {
   LR_SIZE_T i;
   int8_t err;
@@ -130,12 +165,18 @@ int8_t lolan_processGet(lolan_ctx *ctx, lolan_Packet *pak, lolan_Packet *reply)
   CborEncoder enc, map_enc;
   CborError cerr;
 
+  const LP_SIZE_T maxPayloadSize =  plSizeOverride > 0  ?  plSizeOverride  :  LOLAN_PACKET_MAX_PAYLOAD_SIZE;
+
   DLOG(("\n LoLaN GET:  "));
 
   if (pak->packetType != LOLAN_PAK_GET) {   // not a LoLaN GET packet
     DLOG(("not a LoLaN GET packet"));
     return LOLAN_RETVAL_GENERROR;
   }
+#ifdef LOLAN_DUPFILTER_SOURCES
+  if (lolanDupFilterCheck(ctx, pak, reply, &err))   // retransmitted request
+    return err;
+#endif
 
   /* extract (base) path */
   err = lolanGetZeroKeyEntryFromPayload(pak, path, NULL, NULL);
@@ -164,7 +205,7 @@ int8_t lolan_processGet(lolan_ctx *ctx, lolan_Packet *pak, lolan_Packet *reply)
   }
   lolanPathDefinitionLevel(ctx, path, &occ, true);  // obtain the number of variable occurrences
 
-  cbor_encoder_init(&enc, reply->payload, LOLAN_PACKET_MAX_PAYLOAD_SIZE, 0);  // initialize CBOR encoder for the reply
+  cbor_encoder_init(&enc, reply->payload, maxPayloadSize, 0);  // initialize CBOR encoder for the reply
 
   switch (occ) {   // the number of variable occurrences with the specified (base) path determine the reply type
     case 0:   // no variable found
@@ -176,11 +217,9 @@ int8_t lolan_processGet(lolan_ctx *ctx, lolan_Packet *pak, lolan_Packet *reply)
     case 1:   // one variable found
       /* figure out whether a single variable has been requested intentionally */
       force_vr = true;  // (the path of the variable should be reported when the only one occurrence is due to recursion depth restrictions)
-      for (i = 0; i < LOLAN_REGMAP_SIZE; i++)   // check whether the path definition is exact
-        if (memcmp(ctx->regMap[i].p, path, LOLAN_REGMAP_DEPTH) == 0) {  // a single variable is requested intentionally
-          force_vr = false; // a simplified reply is allowed
-          break;
-        }
+      i = lolanRegMapFindByPath(ctx, path);
+      if (i < LOLAN_REGMAP_SIZE)   // the path definition is exact: a single variable is requested intentionally
+        force_vr = false; // a simplified reply is allowed
       /* encode variable */
       if (LOLAN_FORCE_GET_VERBOSE_REPLY || force_vr) {   // a full reply is needed
         cerr = cbor_encoder_create_map(&enc, &map_enc, CborIndefiniteLength);   // create root map
@@ -192,7 +231,10 @@ int8_t lolan_processGet(lolan_ctx *ctx, lolan_Packet *pak, lolan_Packet *reply)
           DLOG(("\n CBOR encode error"));
           return LOLAN_RETVAL_CBORERROR;
         }
+        if (map_enc.end > map_enc.data.ptr)   // leave room for closing the root map (BreakByte), every variable is checked before encoding
+          map_enc.end--;                      //   (on LOLAN_RETVAL_MEMERROR the encoder is re-initialized below)
         err = lolanVarBranchToCbor(ctx, path, &map_enc);   // encode the variable with nested path entries
+        map_enc.end++;    // restore buffer size setting
         switch (err) {
           case LOLAN_RETVAL_YES:   // o.k.
             cerr = cbor_encoder_close_container(&enc, &map_enc);   // close the root map
@@ -202,7 +244,7 @@ int8_t lolan_processGet(lolan_ctx *ctx, lolan_Packet *pak, lolan_Packet *reply)
             }
             break;
           case LOLAN_RETVAL_MEMERROR:   // the reply would be too big
-            cbor_encoder_init(&enc, reply->payload, LOLAN_PACKET_MAX_PAYLOAD_SIZE, 0);  // re-initialize CBOR encoder
+            cbor_encoder_init(&enc, reply->payload, maxPayloadSize, 0);  // re-initialize CBOR encoder
             if (createCborUintDataSimple(&enc, 0, 507, true) != LOLAN_RETVAL_YES) {   // encode error code
               DLOG(("\n CBOR encode error"));
               return LOLAN_RETVAL_CBORERROR;
@@ -214,13 +256,16 @@ int8_t lolan_processGet(lolan_ctx *ctx, lolan_Packet *pak, lolan_Packet *reply)
             break;
         }
       } else {   // a simplified reply is needed
-        err = lolanVarToCbor(ctx, path, 0, &enc);   // encode the variable only
+        if (lolanVarCborSize(ctx, i) > LOLAN_CBOR_REMAINING(&enc))
+          err = LOLAN_RETVAL_MEMERROR;   // (not encoded)
+        else
+          err = lolanVarToCbor(ctx, NULL, i, &enc);   // encode the variable only
         switch (err) {
           case LOLAN_RETVAL_YES:   // o.k.
             /* do nothing */
             break;
           case LOLAN_RETVAL_MEMERROR:   // the reply would be too big
-            cbor_encoder_init(&enc, reply->payload, LOLAN_PACKET_MAX_PAYLOAD_SIZE, 0);  // re-initialize CBOR encoder
+            cbor_encoder_init(&enc, reply->payload, maxPayloadSize, 0);  // re-initialize CBOR encoder
             if (createCborUintDataSimple(&enc, 0, 507, true) != LOLAN_RETVAL_YES) {   // encode error code
               DLOG(("\n CBOR encode error"));
               return LOLAN_RETVAL_CBORERROR;
@@ -249,7 +294,10 @@ int8_t lolan_processGet(lolan_ctx *ctx, lolan_Packet *pak, lolan_Packet *reply)
           DLOG(("\n CBOR encode error"));
           return LOLAN_RETVAL_CBORERROR;
         }
+        if (map_enc.end > map_enc.data.ptr)   // leave room for closing the root map (BreakByte), every variable is checked before encoding
+          map_enc.end--;                      //   (on LOLAN_RETVAL_MEMERROR the encoder is re-initialized below)
         err = lolanVarBranchToCbor(ctx, path, &map_enc);   // encode the variables with nested path entries
+        map_enc.end++;    // restore buffer size setting
         switch (err) {
           case LOLAN_RETVAL_YES:   // o.k.
             cerr = cbor_encoder_close_container(&enc, &map_enc);   // close the root map
@@ -259,7 +307,7 @@ int8_t lolan_processGet(lolan_ctx *ctx, lolan_Packet *pak, lolan_Packet *reply)
             }
             break;
           case LOLAN_RETVAL_MEMERROR:   // the reply would be too big
-            cbor_encoder_init(&enc, reply->payload, LOLAN_PACKET_MAX_PAYLOAD_SIZE, 0);  // re-initialize CBOR encoder
+            cbor_encoder_init(&enc, reply->payload, maxPayloadSize, 0);  // re-initialize CBOR encoder
             if (createCborUintDataSimple(&enc, 0, 507, true) != LOLAN_RETVAL_YES) {   // encode error code
               DLOG(("\n CBOR encode error"));
               return LOLAN_RETVAL_CBORERROR;
@@ -283,9 +331,12 @@ int8_t lolan_processGet(lolan_ctx *ctx, lolan_Packet *pak, lolan_Packet *reply)
   reply->toId = pak->fromId;        // back to the sender of the request
   reply->payloadSize = cbor_encoder_get_buffer_size(&enc, reply->payload);   // get the CBOR data size
   DLOG(("\n Encoded reply to %d bytes", reply->payloadSize));
+#ifdef LOLAN_DUPFILTER_SOURCES
+  lolanDupFilterStore(ctx, pak, reply);
+#endif
 
   return LOLAN_RETVAL_YES;
-} /* lolan_processGet */
+} /* lolan_processGetEx */
 
 
 /**************************************************************************//**
@@ -113,6 +113,7 @@ static inline int8_t lolan_createInform_internal(lolan_ctx *ctx, uint8_t *payloa
           LP_SIZE_T *payloadSize, bool multi, bool secondary, LP_SIZE_T plSizeOverride)
 {
   LR_SIZE_T i, count;
+  size_t vsize;
   uint8_t defLvl, bpath[LOLAN_REGMAP_DEPTH-1];
   bool dlbpsame;
   int8_t err;
@@ -130,8 +131,7 @@ static inline int8_t lolan_createInform_internal(lolan_ctx *ctx, uint8_t *payloa
   if (count == 0) return LOLAN_RETVAL_NO;   // no variable to report
 
   /* clear the LOLAN_REGMAP_AUX_BIT flags */
-  for (i = 0; i < LOLAN_REGMAP_SIZE; i++)
-    ctx->regMap[i].flags &= ~(LOLAN_REGMAP_AUX_BIT);
+  lolanFlagClearAll(ctx, LOLAN_REGMAP_AUX_BIT);
 
   cbor_encoder_init(&enc, payload, maxPayloadSize, 0);  // initialize CBOR encoder for the pak
 
@@ -157,13 +157,9 @@ static inline int8_t lolan_createInform_internal(lolan_ctx *ctx, uint8_t *payloa
         return err;
       }
     } else {   // if multiple variable reporting is not allowed
-      for (i = 0; i < LOLAN_REGMAP_SIZE; i++) {   // search for the first variable to report
-        if ( ((ctx->regMap[i].flags & flags) == flags)
-             && (ctx->regMap[i].p[0] != 0) ) {              // (not a free entry)
-          ctx->regMap[i].flags |= LOLAN_REGMAP_AUX_BIT;  // set auxiliary flag
-          break;
-        }
-      }
+      i = lolanFlagNext(ctx, flags, 0);   // search for the first variable to report
+      if (i < LOLAN_REGMAP_SIZE)
+        lolanFlagSet(ctx, i, LOLAN_REGMAP_AUX_BIT);  // set auxiliary flag
       err = lolanVarFlagToCbor(ctx, LOLAN_REGMAP_AUX_BIT, &map_enc, false, false);   // encode the variable
       if (err != LOLAN_RETVAL_YES) {
         DLOG(("\n CBOR encode error"));
@@ -216,41 +212,26 @@ static inline int8_t lolan_createInform_internal(lolan_ctx *ctx, uint8_t *payloa
     }
     /* encode LoLaN variables */
     first = true;  // indicate that the next will be the first variable to encode
-    for (i = 0; i < LOLAN_REGMAP_SIZE; i++) {
-      if ( ((ctx->regMap[i].flags & flags) == flags)      // find variables
-           && (ctx->regMap[i].p[0] != 0) ) {              // (not a free entry)
-        CborEncoder map_enc_bak;
-
-        map_enc_bak = map_enc;   // back-up CBOR encoder variable
-        cerr = cbor_encode_uint(&map_enc, ctx->regMap[i].p[defLvl-1]);   // encode key (path item)
-        if (cerr != CborNoError) {
-          if (first) {   // at the first variable nothing can be done to avoid error
-            DLOG(("\n CBOR encode error"));
-            return (cerr == CborErrorOutOfMemory) ? LOLAN_RETVAL_MEMERROR : LOLAN_RETVAL_CBORERROR;
-          } else {   // not the first variable, revert to back-up to avoid error
-            map_enc = map_enc_bak;   // restore CBOR encoder variable (state) from back-up
-            break;   // stop encoding
-          }
-        }
-        err = lolanVarToCbor(ctx, NULL, i, &map_enc);   // encode variable
-        if (err != LOLAN_RETVAL_YES) {
-          if (first) {   // at the first variable nothing can be done to avoid error
-            DLOG(("\n CBOR encode error"));
-            return err;
-          } else {   // not the first variable, revert to back-up to avoid error
-            map_enc = map_enc_bak;   // restore CBOR encoder variable (state) from back-up
-            break;   // stop encoding
-          }
-        }
-        if (!first && (maxPayloadSize < cbor_encoder_get_buffer_size(&enc, payload) + 1)) {   // 1 is the size of indefinite length container terminator (BreakByte)
-          // no remaining buffer space to close the indefinite length root map (not after the first variable)
-          map_enc = map_enc_bak;   // restore CBOR encoder variable (state) from back-up
-          break;   // stop encoding
-        }  // if (first) but not enough buffer space -> will fail on closing the root map
-        ctx->regMap[i].flags |= LOLAN_REGMAP_AUX_BIT;  // set auxiliary flag (to delete the local update flags finally)
-        first = false;   // the first variable was encoded
-        if (!multi) break;   // if multiple variable reporting is not allowed: break after the first encoded variable
+    for (i = lolanFlagNext(ctx, flags, 0); i < LOLAN_REGMAP_SIZE; i = lolanFlagNext(ctx, flags, i+1)) {   // find variables
+      vsize = lolanVarCborSize(ctx, i);   // exact size of the variable (zero: can not be encoded)
+      if (!first && ((vsize == 0) ||
+          (lolanCborUintSize(LRM_P(ctx, i)[defLvl-1]) + vsize + 1 > LOLAN_CBOR_REMAINING(&map_enc)))) {   // 1 is the size of indefinite length container terminator (BreakByte)
+        // the key and the variable would not fit with the closing of the root map (not after the first variable)
+        break;   // stop encoding (nothing was encoded)
+      }  // if (first) but not enough buffer space -> will fail on encoding or closing the root map
+      cerr = cbor_encode_uint(&map_enc, LRM_P(ctx, i)[defLvl-1]);   // encode key (path item)
+      if (cerr != CborNoError) {
+        DLOG(("\n CBOR encode error"));
+        return (cerr == CborErrorOutOfMemory) ? LOLAN_RETVAL_MEMERROR : LOLAN_RETVAL_CBORERROR;
       }
+      err = lolanVarToCbor(ctx, NULL, i, &map_enc);   // encode variable
+      if (err != LOLAN_RETVAL_YES) {
+        DLOG(("\n CBOR encode error"));
+        return err;
+      }
+      lolanFlagSet(ctx, i, LOLAN_REGMAP_AUX_BIT);  // set auxiliary flag (to delete the local update flags finally)
+      first = false;   // the first variable was encoded
+      if (!multi) break;   // if multiple variable reporting is not allowed: break after the first encoded variable
     }
     cerr = cbor_encoder_close_container(&enc, &map_enc);   // close root map
     if (cerr != CborNoError) {
@@ -260,13 +241,13 @@ static inline int8_t lolan_createInform_internal(lolan_ctx *ctx, uint8_t *payloa
   }
 
   /* reset LOLAN_REGMAP_LOCAL_UPDATE_BIT / LOLAN_REGMAP_INFORMSEC_REQUEST_BIT flags (on variables marked with LOLAN_REGMAP_AUX_BIT) */
-  for (i = 0; i < LOLAN_REGMAP_SIZE; i++)
-    if (ctx->regMap[i].flags & LOLAN_REGMAP_AUX_BIT) {   // auxiliary flag
-      if (!secondary)   // normal request
-        ctx->regMap[i].flags &= ~(LOLAN_REGMAP_LOCAL_UPDATE_BIT);   // reset local update flag
-      else   // secondary request
-        ctx->regMap[i].flags &= ~(LOLAN_REGMAP_INFORMSEC_REQUEST_BIT);   // reset INFORMSEC flag
-    }
+  for (i = lolanFlagNext(ctx, LOLAN_REGMAP_AUX_BIT, 0); i < LOLAN_REGMAP_SIZE;
+       i = lolanFlagNext(ctx, LOLAN_REGMAP_AUX_BIT, i+1)) {   // auxiliary flag
+    if (!secondary)   // normal request
+      lolanFlagClear(ctx, i, LOLAN_REGMAP_LOCAL_UPDATE_BIT);   // reset local update flag
+    else   // secondary request
+      lolanFlagClear(ctx, i, LOLAN_REGMAP_INFORMSEC_REQUEST_BIT);   // reset INFORMSEC flag
+  }
 
   /* compute payload size */
   *payloadSize = cbor_encoder_get_buffer_size(&enc, payload);   // get the CBOR data size
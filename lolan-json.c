@@ -0,0 +1,1011 @@
+/**************************************************************************//**
+ * @file lolan-json.c
+ * @brief LoLaN CBOR to JSON conversion
+ * @author Sunstone-RTLS Ltd.
+ ******************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "lolan_config.h"
+#include "lolan.h"
+#include "lolan-utils.h"
+#include "cbor.h"
+
+/*
+ * CBOR to JSON conversion
+ * ~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ *   The CBOR data is validated by lolanCborValidate() and converted in a
+ *   single pass with the unchecked cursor. The JSON text is appended to
+ *   the buffer of the caller (lolan_JsonBuffer), which is enlarged by the
+ *   callback of the caller if needed (e.g. with realloc() or from an
+ *   arena). The conversion does not allocate memory, the numbers and the
+ *   base64/hex strings are formatted directly into the buffer.
+ *
+ *   The output is the same as of cbor_value_to_json_advance() with the
+ *   CborConvertStringifyMapKeys flag (no metadata), except that
+ *    integers are written with all digits (not through double),
+ *    floating-point numbers are written with the fewest digits which
+ *     give back the same value (single and half precision numbers are
+ *     compared as float),
+ *    the quotation mark, the backslash and the control characters are
+ *     escaped in text strings (the UTF-8 encoding is not checked),
+ *    integer map keys are written as strings, other keys which are not
+ *     text strings are refused.
+ */
+
+/*
+ * LoLaN payload to JSON records
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ *   The variables of INFORM and ACK payloads are written as flat records
+ *   (one JSON object per line) with the full variable path, e.g.
+ *     {"from":12,"path":"2/1/3","type":"uint","value":42}
+ *   The payload is walked in a single pass by the same code as in
+ *   lolan_simpleProcessInform() (see lolanWalkPayloadMap()), so the paths
+ *   and the accepted types are the same:
+ *    INFORM: the paths of a legacy style INFORM are combined with the
+ *     base path of the zero key entry, the zero key of a new style INFORM
+ *     should contain the status code 299.
+ *    ACK: the first record contains the status code of the zero key
+ *     entry (200, 207 etc.) with "path":null and "type":"status", the
+ *     others contain the variables (GET reply) or the status codes of the
+ *     variables (SET reply). A short GET reply (without root map) gives
+ *     one record with "path":null.
+ *   The type is one of "int", "uint", "float", "str" and "data" (byte
+ *   strings, written as in lolan_cborToJson()).
+ */
+
+#define LOLAN_JSON_NUMBER_SIZE   32   // buffer size of a formatted number
+#define LOLAN_JSON_EXACT_MAX     9007199254740992.0   // (2^53: integers above it are not exact in double)
+#define LOLAN_JSON_EXACT_MIN     1e-7   // (numbers above it have at least 15 exact digits, see lolanJsonFloat())
+#define LOLAN_JSON_RECORD_HEAD_SIZE  (56 + 4 * LOLAN_REGMAP_DEPTH)   // buffer size of the beginning of a record (up to the value)
+
+static const char lolanJsonDigits[] =   // decimal digit pairs
+  "0001020304050607080910111213141516171819"
+  "2021222324252627282930313233343536373839"
+  "4041424344454647484950515253545556575859"
+  "6061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+static const double lolanJsonPow10[] = {   // (exact in double)
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const uint64_t lolanJsonPow10u[] = {   // (the fractional digits of the numbers below 2^53)
+  1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull,
+  10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull, 100000000000000ull, 1000000000000000ull
+};
+
+static const char lolanJsonBase64Url[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+static const char lolanJsonBase64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char lolanJsonHex[] = "0123456789abcdef";
+
+static const char * const lolanJsonTypeNames[] = {   // record types (by lolan_VarType)
+  "status", "int", "uint", "float", "str", "data"
+};
+
+typedef struct {        // state of lolan_packetToJson()
+  lolan_JsonBuffer *jb;
+  uint8_t flags;
+  uint8_t headLen;      // length of the common beginning of the records
+  char head[24];        // common beginning of the records: {"from":<id>,"path":
+} lolan_JsonRecordWalk;
+
+
+/**************************************************************************//**
+ * @brief
+ *   Make room for output in a JSON buffer.
+ * @details
+ *   Room for the terminating zero is also kept.
+ * @param[in,out] jb
+ *   Pointer to the JSON buffer.
+ * @param[in] n
+ *   Number of bytes to be written.
+ * @return
+ *   Pointer to the end of the text (NULL: the buffer can not be enlarged).
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static inline char *lolanJsonReserve(lolan_JsonBuffer *jb, size_t n)
+{
+  if (jb->size - jb->len <= n) {
+    if ((jb->grow == NULL) || !jb->grow(jb->growArg, jb, jb->len + n + 1) || (jb->size - jb->len <= n))
+      return NULL;
+  }
+  return jb->buf + jb->len;
+} /* lolanJsonReserve */
+
+/**************************************************************************//**
+ * @brief
+ *   Append bytes to a JSON buffer.
+ * @param[in,out] jb
+ *   Pointer to the JSON buffer.
+ * @param[in] s
+ *   Pointer to the bytes.
+ * @param[in] n
+ *   Number of bytes.
+ * @return
+ *   true: o.k., false: the buffer can not be enlarged.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static inline bool lolanJsonWrite(lolan_JsonBuffer *jb, const char *s, size_t n)
+{
+  char *q;
+
+  q = lolanJsonReserve(jb, n);
+  if (q == NULL) return false;
+  memcpy(q, s, n);
+  jb->len += n;
+  return true;
+} /* lolanJsonWrite */
+
+/**************************************************************************//**
+ * @brief
+ *   Append a character to a JSON buffer.
+ * @param[in,out] jb
+ *   Pointer to the JSON buffer.
+ * @param[in] c
+ *   The character.
+ * @return
+ *   true: o.k., false: the buffer can not be enlarged.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static inline bool lolanJsonPut(lolan_JsonBuffer *jb, char c)
+{
+  char *q;
+
+  q = lolanJsonReserve(jb, 1);
+  if (q == NULL) return false;
+  *q = c;
+  jb->len++;
+  return true;
+} /* lolanJsonPut */
+
+/**************************************************************************//**
+ * @brief
+ *   Format an unsigned integer in decimal.
+ * @details
+ *   The digits are written backwards, two at a time (in 32-bit
+ *   arithmetic below 2^32).
+ * @param[in] end
+ *   Pointer after the place of the last digit.
+ * @param[in] value
+ *   The value.
+ * @return
+ *   Pointer to the first digit.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static char *lolanJsonFormatUint(char *end, uint64_t value)
+{
+  char *p;
+  uint32_t v, d;
+
+  p = end;
+  while (value > UINT32_MAX) {
+    d = (uint32_t) (value % 100) * 2;
+    value /= 100;
+    *--p = lolanJsonDigits[d + 1];
+    *--p = lolanJsonDigits[d];
+  }
+  v = (uint32_t) value;
+  while (v >= 100) {
+    d = (v % 100) * 2;
+    v /= 100;
+    *--p = lolanJsonDigits[d + 1];
+    *--p = lolanJsonDigits[d];
+  }
+  if (v >= 10) {
+    *--p = lolanJsonDigits[2 * v + 1];
+    *--p = lolanJsonDigits[2 * v];
+  } else {
+    *--p = '0' + v;
+  }
+  return p;
+} /* lolanJsonFormatUint */
+
+/**************************************************************************//**
+ * @brief
+ *   Append the integer at a cursor to a JSON buffer.
+ * @param[in] cur
+ *   Pointer to the cursor at an integer (see LOLAN_CBOR_IS_INTEGER()).
+ * @param[in,out] jb
+ *   Pointer to the JSON buffer.
+ * @param[in] quoted
+ *   Write the integer as a string (map key).
+ * @return
+ *   true: o.k., false: the buffer can not be enlarged.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static bool lolanJsonInteger(const lolan_CborCursor *cur, lolan_JsonBuffer *jb, bool quoted)
+{
+  char tmp[LOLAN_JSON_NUMBER_SIZE];
+  char *end, *p;
+  uint64_t value;
+
+  value = lolanCborCursorGetUint(cur);
+  end = tmp + sizeof(tmp);
+  p = end;
+  if (quoted) *--p = '"';
+  if (*cur->ptr < 0x20) {   // unsigned integer
+    p = lolanJsonFormatUint(p, value);
+  } else {   // negative integer: -1 - value
+    if (value != UINT64_MAX) {
+      p = lolanJsonFormatUint(p, value + 1);
+    } else {   // (-2^64)
+      *--p = '6';
+      p = lolanJsonFormatUint(p, UINT64_MAX / 10);
+    }
+    *--p = '-';
+  }
+  if (quoted) *--p = '"';
+  return lolanJsonWrite(jb, p, end - p);
+} /* lolanJsonInteger */
+
+/**************************************************************************//**
+ * @brief
+ *   Round a number to a decimal fraction and check it.
+ * @details
+ *   The decimal value is exact, so the check of the correctly rounded
+ *   division is the same as parsing the decimal number.
+ * @param[in] a
+ *   The number (not negative, a * 10^k < 2^53).
+ * @param[in] k
+ *   Number of fractional digits.
+ * @param[in] single
+ *   Compare as float.
+ * @param[out] n
+ *   Pointer to the variable which receives the digits (a * 10^k rounded).
+ * @return
+ *   true: the decimal number gives back the number.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static inline bool lolanJsonDecimal(double a, uint8_t k, bool single, uint64_t *n)
+{
+  double m, d;
+
+  m = a * lolanJsonPow10[k];
+  *n = (uint64_t) m;   // (rounded to the nearest)
+  if (m - (double) *n >= 0.5) (*n)++;
+  d = (double) *n / lolanJsonPow10[k];
+  return single ? ((float) d == (float) a) : (d == a);
+} /* lolanJsonDecimal */
+
+/**************************************************************************//**
+ * @brief
+ *   Append a floating-point number to a JSON buffer.
+ * @details
+ *   Integral values are written as integers. The other numbers are
+ *   written with the fewest fractional digits which give back the same
+ *   value, if the check with the most exact digits (below 2^53) succeeds.
+ *   Otherwise the number is written with snprintf(): with 17 (float: 9)
+ *   significant digits (as tinycbor does), or for large exponents with the
+ *   fewest significant digits which give back the same value. NaN and
+ *   infinity are written as null.
+ * @param[in,out] jb
+ *   Pointer to the JSON buffer.
+ * @param[in] value
+ *   The number.
+ * @param[in] single
+ *   The number is compared as float (single or half precision data).
+ * @return
+ *   true: o.k., false: the buffer can not be enlarged.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static bool lolanJsonFloat(lolan_JsonBuffer *jb, double value, bool single)
+{
+  char tmp[LOLAN_JSON_NUMBER_SIZE];
+  char *end, *p;
+  double a, d;
+  uint64_t n, ip, fp;
+  uint8_t k, kmax;
+  int len;
+
+  if (isnan(value) || isinf(value))
+    return lolanJsonWrite(jb, "null", 4);
+  a = (value < 0) ? -value : value;
+  end = tmp + sizeof(tmp);
+  if (a < 18446744073709551616.0) {   // (2^64)
+    n = (uint64_t) a;
+    if ((double) n == a) {   // integral value
+      p = lolanJsonFormatUint(end, n);
+      if (signbit(value)) *--p = '-';   // (also -0)
+      return lolanJsonWrite(jb, p, end - p);
+    }
+    for (kmax = 0; (kmax < sizeof(lolanJsonPow10) / sizeof(lolanJsonPow10[0]) - 1) &&
+                   (a * lolanJsonPow10[kmax + 1] < LOLAN_JSON_EXACT_MAX); kmax++)
+      ;   // (most fractional digits)
+    if ((kmax > 0) && lolanJsonDecimal(a, kmax, single, &n)) {
+      for (k = 1; k < kmax; k++)   // fewest fractional digits
+        if (lolanJsonDecimal(a, k, single, &ip)) break;
+      if (k < kmax)
+        n = ip;
+      if (k < sizeof(lolanJsonPow10u) / sizeof(lolanJsonPow10u[0])) {   // integral and fractional part
+        ip = n / lolanJsonPow10u[k];
+        fp = n % lolanJsonPow10u[k];
+      } else {   // (n < 2^53 < 10^16)
+        ip = 0;
+        fp = n;
+      }
+      p = lolanJsonFormatUint(end, fp);
+      while (p > end - k)   // leading zeros of the fraction
+        *--p = '0';
+      *--p = '.';
+      p = lolanJsonFormatUint(p, ip);
+      if (value < 0) *--p = '-';
+      return lolanJsonWrite(jb, p, end - p);
+    }
+  }
+  if ((a < LOLAN_JSON_EXACT_MIN) || (a >= LOLAN_JSON_EXACT_MAX))   // large exponent: try fewer significant digits
+    k = single ? 6 : 15;
+  else
+    k = single ? 9 : 17;
+  for (;;) {
+    len = snprintf(tmp, sizeof(tmp), "%.*g", k, value);
+    if (k >= (single ? 9 : 17)) break;   // (always gives back the value)
+    d = strtod(tmp, NULL);
+    if (single ? ((float) d == (float) value) : (d == value)) break;
+    k++;
+  }
+  return lolanJsonWrite(jb, tmp, len);
+} /* lolanJsonFloat */
+
+/**************************************************************************//**
+ * @brief
+ *   Append a text string to a JSON buffer with escaping.
+ * @details
+ *   The quotation mark, the backslash and the control characters are
+ *   escaped, the other bytes are copied in runs.
+ * @param[in,out] jb
+ *   Pointer to the JSON buffer.
+ * @param[in] s
+ *   Pointer to the text.
+ * @param[in] n
+ *   Length of the text.
+ * @return
+ *   true: o.k., false: the buffer can not be enlarged.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static bool lolanJsonEscape(lolan_JsonBuffer *jb, const uint8_t *s, size_t n)
+{
+  const uint8_t *end, *run;
+  char *q, e;
+  uint8_t c;
+
+  end = s + n;
+  while (s < end) {
+    run = s;
+    while ((s < end) && (*s >= 0x20) && (*s != '"') && (*s != '\\'))
+      s++;
+    if ((s > run) && !lolanJsonWrite(jb, (const char *) run, s - run)) return false;
+    if (s == end) break;
+    c = *s++;
+    switch (c) {
+      case '"':  e = '"'; break;
+      case '\\': e = '\\'; break;
+      case '\b': e = 'b'; break;
+      case '\f': e = 'f'; break;
+      case '\n': e = 'n'; break;
+      case '\r': e = 'r'; break;
+      case '\t': e = 't'; break;
+      default:   e = 0; break;   // (\u00XX)
+    }
+    q = lolanJsonReserve(jb, (e != 0) ? 2 : 6);   // (the exact length, a fixed size buffer can be filled)
+    if (q == NULL) return false;
+    q[0] = '\\';
+    if (e != 0) {
+      q[1] = e;
+      jb->len += 2;
+    } else {
+      q[1] = 'u';
+      q[2] = '0';
+      q[3] = '0';
+      q[4] = lolanJsonHex[c >> 4];
+      q[5] = lolanJsonHex[c & 0x0f];
+      jb->len += 6;
+    }
+  }
+  return true;
+} /* lolanJsonEscape */
+
+/**************************************************************************//**
+ * @brief
+ *   Append the text string at a cursor to a JSON buffer.
+ * @param[in] cur
+ *   Pointer to the cursor at a text string.
+ * @param[in,out] jb
+ *   Pointer to the JSON buffer.
+ * @return
+ *   true: o.k., false: the buffer can not be enlarged.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static bool lolanJsonText(const lolan_CborCursor *cur, lolan_JsonBuffer *jb)
+{
+  const uint8_t *chunk, *pos;
+  size_t n;
+
+  if (!lolanJsonPut(jb, '"')) return false;
+  pos = NULL;
+  while ((chunk = lolanCborCursorStringChunk(cur, &pos, &n)) != NULL)
+    if (!lolanJsonEscape(jb, chunk, n)) return false;
+  return lolanJsonPut(jb, '"');
+} /* lolanJsonText */
+
+/**************************************************************************//**
+ * @brief
+ *   Encode bytes in base64 (a part of a byte string).
+ * @details
+ *   The bytes of an incomplete group are carried over to the next part.
+ * @param[out] q
+ *   Pointer to the output.
+ * @param[in] s
+ *   Pointer to the bytes.
+ * @param[in] n
+ *   Number of bytes.
+ * @param[in] alphabet
+ *   The base64 alphabet (64 characters).
+ * @param[in,out] acc
+ *   Pointer to the bytes carried over.
+ * @param[in,out] count
+ *   Pointer to the number of bytes carried over (0..2).
+ * @return
+ *   Pointer after the output.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static char *lolanJsonBase64Part(char *q, const uint8_t *s, size_t n, const char *alphabet,
+                                 uint32_t *acc, uint8_t *count)
+{
+  uint32_t v;
+  uint8_t c;
+
+  v = *acc;
+  c = *count;
+  while ((n > 0) && (c != 0)) {   // complete the carried group
+    v = (v << 8) | *s++;
+    n--;
+    if (++c == 3) {
+      *q++ = alphabet[(v >> 18) & 0x3f];
+      *q++ = alphabet[(v >> 12) & 0x3f];
+      *q++ = alphabet[(v >> 6) & 0x3f];
+      *q++ = alphabet[v & 0x3f];
+      v = 0;
+      c = 0;
+    }
+  }
+  while (n >= 3) {
+    v = ((uint32_t) s[0] << 16) | ((uint32_t) s[1] << 8) | s[2];
+    *q++ = alphabet[v >> 18];
+    *q++ = alphabet[(v >> 12) & 0x3f];
+    *q++ = alphabet[(v >> 6) & 0x3f];
+    *q++ = alphabet[v & 0x3f];
+    s += 3;
+    n -= 3;
+  }
+  if (c == 0)
+    v = 0;
+  while (n > 0) {   // (carried to the next part)
+    v = (v << 8) | *s++;
+    n--;
+    c++;
+  }
+  *acc = v;
+  *count = c;
+  return q;
+} /* lolanJsonBase64Part */
+
+/**************************************************************************//**
+ * @brief
+ *   Append the byte string at a cursor to a JSON buffer.
+ * @details
+ *   The byte string is written in base64url (without padding) by
+ *   default. The innermost tag selects the encoding as in tinycbor: base64
+ *   (tag 22), hexadecimal (tag 23) or base64url with '~' prefix (negative
+ *   bignum, tag 3).
+ * @param[in] cur
+ *   Pointer to the cursor at a byte string.
+ * @param[in,out] jb
+ *   Pointer to the JSON buffer.
+ * @param[in] tag
+ *   The innermost tag of the byte string (0: none).
+ * @param[in] flags
+ *   Conversion flags (see lolan_cborToJson()).
+ * @return
+ *   true: o.k., false: the buffer can not be enlarged.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static bool lolanJsonBytes(const lolan_CborCursor *cur, lolan_JsonBuffer *jb, uint64_t tag, uint8_t flags)
+{
+  const uint8_t *chunk, *pos;
+  const char *alphabet;
+  size_t len, olen, n, i;
+  uint32_t acc;
+  uint8_t count;
+  bool hex, pad, neg;
+  char *q;
+
+  hex = (flags & LOLAN_JSON_BYTES_HEX) || (tag == 23);
+  pad = !hex && (tag == 22);
+  neg = !hex && (tag == 3);
+  alphabet = pad ? lolanJsonBase64 : lolanJsonBase64Url;
+  len = lolanCborCursorStringLength(cur);
+  if (hex)
+    olen = 2 * len;
+  else if (pad)
+    olen = (len + 2) / 3 * 4;
+  else
+    olen = len / 3 * 4 + ((len % 3) ? (len % 3) + 1 : 0);
+  q = lolanJsonReserve(jb, olen + 2 + neg);   // (the exact length)
+  if (q == NULL) return false;
+
+  *q++ = '"';
+  if (neg) *q++ = '~';
+  pos = NULL;
+  acc = 0;
+  count = 0;
+  while ((chunk = lolanCborCursorStringChunk(cur, &pos, &n)) != NULL) {
+    if (hex) {
+      for (i = 0; i < n; i++) {
+        *q++ = lolanJsonHex[chunk[i] >> 4];
+        *q++ = lolanJsonHex[chunk[i] & 0x0f];
+      }
+    } else {
+      q = lolanJsonBase64Part(q, chunk, n, alphabet, &acc, &count);
+    }
+  }
+  if (count == 1) {   // last group of 1 byte
+    *q++ = alphabet[acc >> 2];
+    *q++ = alphabet[(acc & 0x03) << 4];
+    if (pad) {
+      *q++ = '=';
+      *q++ = '=';
+    }
+  } else if (count == 2) {   // last group of 2 bytes
+    *q++ = alphabet[acc >> 10];
+    *q++ = alphabet[(acc >> 4) & 0x3f];
+    *q++ = alphabet[(acc & 0x0f) << 2];
+    if (pad) *q++ = '=';
+  }
+  *q++ = '"';
+  jb->len = q - jb->buf;
+  return true;
+} /* lolanJsonBytes */
+
+/**************************************************************************//**
+ * @brief
+ *   Append the simple value or floating-point number at a cursor to a JSON
+ *   buffer.
+ * @param[in] cur
+ *   Pointer to the cursor at an item of major type 7.
+ * @param[in,out] jb
+ *   Pointer to the JSON buffer.
+ * @return
+ *   true: o.k., false: the buffer can not be enlarged.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static bool lolanJsonSimple(const lolan_CborCursor *cur, lolan_JsonBuffer *jb)
+{
+  char tmp[LOLAN_JSON_NUMBER_SIZE];
+  char *end, *p;
+  uint64_t arg;
+  uint32_t bits;
+  uint16_t half;
+  float f;
+  double d;
+
+  switch (*cur->ptr) {
+    case 0xf4:
+      return lolanJsonWrite(jb, "false", 5);
+    case 0xf5:
+      return lolanJsonWrite(jb, "true", 4);
+    case 0xf6:
+      return lolanJsonWrite(jb, "null", 4);
+    case 0xf7:
+      return lolanJsonWrite(jb, "\"undefined\"", 11);
+    case 0xf9:   // half precision (converted to float)
+      half = (uint16_t) lolanCborCursorGetUint(cur);
+      if ((half & 0x7c00) == 0) {   // zero or subnormal
+        f = (float) (half & 0x03ff) * (1.0f / 16777216.0f);
+        if (half & 0x8000) f = -f;
+      } else {
+        bits = ((uint32_t) (half & 0x8000) << 16) | ((uint32_t) (half & 0x7fff) << 13);
+        bits += ((half & 0x7c00) == 0x7c00) ? 0x70000000 : 0x38000000;   // (rebias the exponent, infinity and NaN)
+        memcpy(&f, &bits, sizeof(f));
+      }
+      return lolanJsonFloat(jb, f, true);
+    case 0xfa:
+      bits = (uint32_t) lolanCborCursorGetUint(cur);
+      memcpy(&f, &bits, sizeof(f));
+      return lolanJsonFloat(jb, f, true);
+    case 0xfb:
+      arg = lolanCborCursorGetUint(cur);
+      memcpy(&d, &arg, sizeof(d));
+      return lolanJsonFloat(jb, d, false);
+    default:   // other simple value: "simple(n)"
+      arg = lolanCborCursorGetUint(cur);
+      end = tmp + sizeof(tmp);
+      p = end;
+      *--p = '"';
+      *--p = ')';
+      p = lolanJsonFormatUint(p, arg);
+      p -= 8;
+      memcpy(p, "\"simple(", 8);
+      return lolanJsonWrite(jb, p, end - p);
+  }
+} /* lolanJsonSimple */
+
+/**************************************************************************//**
+ * @brief
+ *   Convert a CBOR data item to JSON, and advance the cursor to the next
+ *   item.
+ * @details
+ *   The tags are skipped (their values are used only for byte strings).
+ *   The nested containers are converted recursively (the nesting is
+ *   limited by the validation).
+ * @param[in,out] cur
+ *   Pointer to the cursor at the item.
+ * @param[in,out] jb
+ *   Pointer to the JSON buffer.
+ * @param[in] flags
+ *   Conversion flags (see lolan_cborToJson()).
+ * @return
+ *   LOLAN_RETVAL_YES:        O.k.
+ *   LOLAN_RETVAL_GENERROR:   The item contains a map key which is not an
+ *                            integer or a text string.
+ *   LOLAN_RETVAL_CBORERROR:  The item contains a map with a key without
+ *                            value.
+ *   LOLAN_RETVAL_MEMERROR:   The buffer can not be enlarged.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static int8_t lolanJsonItem(lolan_CborCursor *cur, lolan_JsonBuffer *jb, uint8_t flags)
+{
+  lolan_CborCursor child;
+  uint64_t tag;
+  uint8_t major;
+  bool ok, map, first;
+  int8_t err;
+
+  tag = 0;
+  while ((*cur->ptr >> 5) == 6) {   // tags
+    tag = lolanCborCursorGetUint(cur);
+    lolanCborCursorAdvance(cur);
+  }
+
+  major = *cur->ptr >> 5;
+  switch (major) {
+    case 0:   // integer
+    case 1:
+      ok = lolanJsonInteger(cur, jb, false);
+      break;
+    case 2:   // byte string
+      ok = lolanJsonBytes(cur, jb, tag, flags);
+      break;
+    case 3:   // text string
+      ok = lolanJsonText(cur, jb);
+      break;
+    case 4:   // array
+    case 5:   // map
+      map = (major == 5);
+      if (!lolanJsonPut(jb, map ? '{' : '[')) return LOLAN_RETVAL_MEMERROR;
+      lolanCborCursorEnter(cur, &child);
+      first = true;
+      while (!LOLAN_CBOR_AT_END(&child)) {
+        if (!first && !lolanJsonPut(jb, ',')) return LOLAN_RETVAL_MEMERROR;
+        first = false;
+        if (map) {   // key
+          while ((*child.ptr >> 5) == 6)   // (the tags of the key are ignored)
+            lolanCborCursorAdvance(&child);
+          if (LOLAN_CBOR_IS_INTEGER(&child))
+            ok = lolanJsonInteger(&child, jb, true);
+          else if ((*child.ptr >> 5) == 3)
+            ok = lolanJsonText(&child, jb);
+          else
+            return LOLAN_RETVAL_GENERROR;   // (not representable as a JSON key)
+          if (!ok || !lolanJsonPut(jb, ':')) return LOLAN_RETVAL_MEMERROR;
+          lolanCborCursorAdvance(&child);
+          if (LOLAN_CBOR_AT_END(&child)) return LOLAN_RETVAL_CBORERROR;   // key without value (indefinite length map)
+        }
+        err = lolanJsonItem(&child, jb, flags);
+        if (err != LOLAN_RETVAL_YES) return err;
+      }
+      if (!lolanJsonPut(jb, map ? '}' : ']')) return LOLAN_RETVAL_MEMERROR;
+      lolanCborCursorLeave(cur, &child);
+      return LOLAN_RETVAL_YES;
+    default:   // simple value or floating-point number
+      ok = lolanJsonSimple(cur, jb);
+      break;
+  }
+  if (!ok) return LOLAN_RETVAL_MEMERROR;
+  lolanCborCursorAdvance(cur);
+  return LOLAN_RETVAL_YES;
+} /* lolanJsonItem */
+
+/**************************************************************************//**
+ * @brief
+ *   Initialize a JSON output buffer.
+ * @param[out] jb
+ *   Pointer to the JSON buffer.
+ * @param[in] buf
+ *   Address of the buffer (it can be NULL if size is 0).
+ * @param[in] size
+ *   The size of the buffer.
+ * @param[in] grow
+ *   Pointer to the callback function which enlarges the buffer: it must
+ *   set buf and size of the JSON buffer (keeping the first len bytes) to
+ *   at least the requested size, and return true, or return false if it
+ *   is not possible. Set this parameter to NULL for a fixed size buffer.
+ * @param[in] growArg
+ *   User data for the callback function.
+ *****************************************************************************/
+void lolan_jsonBufferInit(lolan_JsonBuffer *jb, char *buf, size_t size, lolan_JsonGrowFunc grow,
+                          void *growArg)
+{
+  jb->buf = buf;
+  jb->size = size;
+  jb->len = 0;
+  jb->grow = grow;
+  jb->growArg = growArg;
+  if (size > 0)
+    buf[0] = 0;
+} /* lolan_jsonBufferInit */
+
+/**************************************************************************//**
+ * @brief
+ *   Convert CBOR data (e.g. a LoLaN payload) to JSON.
+ * @details
+ *   The first CBOR data item is converted to JSON text without
+ *   whitespace, and it is appended to the text in the buffer (the text
+ *   remains zero terminated). Integer map keys are written as strings
+ *   (e.g. {"1":{"2":5}} for the path 1/2). Byte strings are written in
+ *   base64url, or in hexadecimal with the LOLAN_JSON_BYTES_HEX flag.
+ *   See the description at the beginning of lolan-json.c for the details.
+ * @param[in] data
+ *   Pointer to the CBOR data.
+ * @param[in] size
+ *   The size of the CBOR data.
+ * @param[in,out] jb
+ *   Pointer to the JSON buffer (see lolan_jsonBufferInit()).
+ * @param[in] flags
+ *   Conversion flags (0 or LOLAN_JSON_BYTES_HEX).
+ * @return
+ *   LOLAN_RETVAL_YES:        JSON text appended.
+ *   LOLAN_RETVAL_GENERROR:   The data contains a map key which is not an
+ *                            integer or a text string.
+ *   LOLAN_RETVAL_CBORERROR:  The data is not a valid CBOR data item.
+ *   LOLAN_RETVAL_MEMERROR:   The buffer can not be enlarged.
+ *   On error the text in the buffer is not modified.
+ *****************************************************************************/
+int8_t lolan_cborToJson(const uint8_t *data, size_t size, lolan_JsonBuffer *jb, uint8_t flags)
+{
+  lolan_CborIndex idx;
+  lolan_CborCursor cur;
+  size_t start;
+  int8_t err;
+
+  if (lolanCborValidate(&idx, data, size) != LOLAN_RETVAL_YES) return LOLAN_RETVAL_CBORERROR;
+  lolanCborCursorRoot(&idx, &cur);
+  start = jb->len;
+  err = lolanJsonItem(&cur, jb, flags);
+  if (err != LOLAN_RETVAL_YES)
+    jb->len = start;   // (drop the partial text)
+  if (jb->len < jb->size)
+    jb->buf[jb->len] = 0;   // terminating zero
+  return err;
+} /* lolan_cborToJson */
+
+/**************************************************************************//**
+ * @brief
+ *   Append a record to a JSON buffer.
+ * @param[in] walk
+ *   Pointer to the state of the conversion.
+ * @param[in] path
+ *   Variable path array (NULL: unknown path).
+ * @param[in] cur
+ *   Pointer to the cursor at the value (NULL: status code).
+ * @param[in] status
+ *   The status code (if cur is NULL).
+ * @return
+ *   LOLAN_RETVAL_YES:        O.k.
+ *   LOLAN_RETVAL_GENERROR:   The type of the value is not allowed for a
+ *                            LoLaN variable.
+ *   LOLAN_RETVAL_MEMERROR:   The buffer can not be enlarged.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static int8_t lolanJsonRecord(const lolan_JsonRecordWalk *walk, const uint8_t *path,
+          const lolan_CborCursor *cur, uint16_t status)
+{
+  char tmp[LOLAN_JSON_RECORD_HEAD_SIZE];
+  char *p;
+  const char *name;
+  uint8_t type, i;
+  bool ok;
+
+  /* determine the type (as lolanGetDataFromCbor()) */
+  if (cur == NULL) {
+    type = 0;   // status code
+  } else {
+    switch (*cur->ptr >> 5) {   // major type
+      case 0:
+        type = LOLAN_UINT;
+        break;
+      case 1:
+        type = LOLAN_INT;
+        break;
+      case 2:
+        type = LOLAN_DATA;
+        break;
+      case 3:
+        type = LOLAN_STR;
+        break;
+      case 7:
+        if ((*cur->ptr != 0xfa) && (*cur->ptr != 0xfb)) return LOLAN_RETVAL_GENERROR;   // (simple value, half precision)
+        type = LOLAN_FLOAT;
+        break;
+      default:   // type not allowed in LoLaN (array, map, tag)
+        return LOLAN_RETVAL_GENERROR;
+    }
+  }
+
+  /* beginning of the record */
+  memcpy(tmp, walk->head, walk->headLen);
+  p = tmp + walk->headLen;
+  if (path == NULL) {
+    memcpy(p, "null", 4);
+    p += 4;
+  } else {
+    *p++ = '"';
+    for (i = 0; (i < LOLAN_REGMAP_DEPTH) && (path[i] != 0); i++) {   // (up to the definition level)
+      if (i > 0) *p++ = '/';
+      if (path[i] >= 100) *p++ = '0' + path[i] / 100;
+      if (path[i] >= 10) *p++ = '0' + (path[i] / 10) % 10;
+      *p++ = '0' + path[i] % 10;
+    }
+    *p++ = '"';
+  }
+  memcpy(p, ",\"type\":\"", 9);
+  p += 9;
+  name = lolanJsonTypeNames[type];
+  i = strlen(name);
+  memcpy(p, name, i);
+  p += i;
+  memcpy(p, "\",\"value\":", 10);
+  p += 10;
+  if (!lolanJsonWrite(walk->jb, tmp, p - tmp)) return LOLAN_RETVAL_MEMERROR;
+
+  /* value */
+  switch (type) {
+    case 0:
+      p = lolanJsonFormatUint(tmp + sizeof(tmp), status);
+      ok = lolanJsonWrite(walk->jb, p, tmp + sizeof(tmp) - p);
+      break;
+    case LOLAN_UINT:
+    case LOLAN_INT:
+      ok = lolanJsonInteger(cur, walk->jb, false);
+      break;
+    case LOLAN_DATA:
+      ok = lolanJsonBytes(cur, walk->jb, 0, walk->flags);
+      break;
+    case LOLAN_STR:
+      ok = lolanJsonText(cur, walk->jb);
+      break;
+    default:   // LOLAN_FLOAT
+      ok = lolanJsonSimple(cur, walk->jb);
+      break;
+  }
+  if (!ok || !lolanJsonWrite(walk->jb, "}\n", 2)) return LOLAN_RETVAL_MEMERROR;
+  return LOLAN_RETVAL_YES;
+} /* lolanJsonRecord */
+
+/**************************************************************************//**
+ * @brief
+ *   Append the record of a variable entry (handler of
+ *   lolanWalkPayloadMap()).
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static int8_t lolanJsonRecordLeaf(void *arg, const uint8_t *path, const lolan_CborCursor *cur)
+{
+  return lolanJsonRecord(arg, path, cur, 0);
+} /* lolanJsonRecordLeaf */
+
+/**************************************************************************//**
+ * @brief
+ *   Convert the variables of a LoLaN INFORM or ACK packet to JSON
+ *   records.
+ * @details
+ *   The variables are written as flat records with the full variable
+ *   path, one JSON object per line, and they are appended to the text in
+ *   the buffer (the text remains zero terminated), e.g.
+ *     {"from":12,"path":"2/1/3","type":"uint","value":42}
+ *   See the description at the beginning of lolan-json.c for the details.
+ * @note
+ *   The source of the packet should be configured with the same
+ *   LOLAN_REGMAP_DEPTH as the local settings.
+ * @param[in] pak
+ *   Pointer to the LoLaN packet structure which contains the INFORM or ACK
+ *   packet to be processed.
+ * @param[in,out] jb
+ *   Pointer to the JSON buffer (see lolan_jsonBufferInit()).
+ * @param[in] flags
+ *   Conversion flags (0 or LOLAN_JSON_BYTES_HEX).
+ * @return
+ *   LOLAN_RETVAL_YES:        JSON records appended.
+ *   LOLAN_RETVAL_NO:         No data in the INFORM payload.
+ *   LOLAN_RETVAL_GENERROR:   An error has occurred (e.g. pak is not an
+ *                            INFORM or ACK packet, invalid payload
+ *                            structure, or a type not allowed for a
+ *                            LoLaN variable).
+ *   LOLAN_RETVAL_CBORERROR:  A CBOR-related error has occurred.
+ *   LOLAN_RETVAL_MEMERROR:   The buffer can not be enlarged.
+ *   On error the text in the buffer is not modified.
+ *****************************************************************************/
+int8_t lolan_packetToJson(const lolan_Packet *pak, lolan_JsonBuffer *jb, uint8_t flags)
+{
+  lolan_JsonRecordWalk walk;
+  lolan_CborIndex idx;
+  lolan_CborCursor cur, map_cur;
+  uint16_t zeroValue;
+  size_t start;
+  char tmp[LOLAN_JSON_NUMBER_SIZE];
+  char *p, *end;
+  int8_t err;
+
+  /* error checking */
+  if ((pak->packetType != LOLAN_PAK_INFORM) && (pak->packetType != LOLAN_PAK_ACK)) return LOLAN_RETVAL_GENERROR;
+  if (lolanCborValidate(&idx, pak->payload, pak->payloadSize) != LOLAN_RETVAL_YES) return LOLAN_RETVAL_CBORERROR;
+
+  /* common beginning of the records */
+  walk.jb = jb;
+  walk.flags = flags;
+  end = tmp + sizeof(tmp);
+  p = lolanJsonFormatUint(end, pak->fromId);
+  memcpy(walk.head, "{\"from\":", 8);
+  memcpy(walk.head + 8, p, end - p);
+  walk.headLen = 8 + (end - p);
+  memcpy(walk.head + walk.headLen, ",\"path\":", 8);
+  walk.headLen += 8;
+
+  /* convert the payload */
+  start = jb->len;
+  lolanCborCursorRoot(&idx, &cur);
+  if (!LOLAN_CBOR_IS_MAP(&cur)) {   // no root map found
+    if (pak->packetType == LOLAN_PAK_INFORM) return LOLAN_RETVAL_GENERROR;   // the root entry of an INFORM must be a CBOR map
+    err = lolanJsonRecord(&walk, NULL, &cur, 0);   // short GET reply
+  } else {   // root map found
+    lolanCborCursorEnter(&cur, &map_cur);   // enter root map
+    if (pak->packetType == LOLAN_PAK_INFORM) {
+      err = lolanWalkInformPayload(&map_cur, lolanJsonRecordLeaf, &walk);
+    } else {   // ACK
+      err = lolanGetZeroKeyEntryFromCursor(&map_cur, NULL, &zeroValue, NULL);   // (path in zero key entry is not acceptable)
+      if (err != LOLAN_RETVAL_YES) return LOLAN_RETVAL_GENERROR;   // zero key entry with integer data must exist
+      err = lolanJsonRecord(&walk, NULL, NULL, zeroValue);   // status code
+      if (err == LOLAN_RETVAL_YES) {
+        err = lolanWalkPayloadMap(&map_cur, NULL, lolanJsonRecordLeaf, &walk);   // variables or their status codes
+        if (err == LOLAN_RETVAL_NO) err = LOLAN_RETVAL_YES;   // (short reply)
+      }
+    }
+  }
+  if ((err != LOLAN_RETVAL_YES) && (err != LOLAN_RETVAL_NO))
+    jb->len = start;   // (drop the partial text)
+  if (jb->len < jb->size)
+    jb->buf[jb->len] = 0;   // terminating zero
+  return err;
+} /* lolan_packetToJson */
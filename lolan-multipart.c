@@ -0,0 +1,291 @@
+/**************************************************************************//**
+ * @file lolan-multipart.c
+ * @brief LoLaN multipart packet functions
+ * @author Sunstone-RTLS Ltd.
+ ******************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "lolan_config.h"
+#include "lolan.h"
+#include "lolan-utils.h"
+
+
+/*
+ * LoLaN multipart packets
+ * ~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ *   A payload larger than LOLAN_PACKET_MAX_PAYLOAD_SIZE is sent in
+ *   consecutive packets (fragments) with the same header fields (also
+ *   the same packet counter), the multipart field of the fragments is:
+ *
+ *     START, MIDDLE, ..., MIDDLE, END
+ *
+ *   The receiver concatenates the payloads of the fragments with the same
+ *   sender and packet counter. The fragments are expected in order. They
+ *   have no sequence number, so the loss of a MIDDLE fragment can not be
+ *   detected reliably: the reassembled payload is refused if it is not a
+ *   single valid CBOR data item (a lost fragment usually breaks it),
+ *   but the remaining fragments may still form a valid data item with
+ *   wrong keys and values. If the payload has to be protected against
+ *   this, the application should add a check to it (e.g. the number of
+ *   entries or a checksum).
+ */
+
+
+/**************************************************************************//**
+ * @brief
+ *   Initialize a multipart fragmenter.
+ * @details
+ *   The fragmenter splits a payload into fragments which fit in a packet,
+ *   see lolan_fragmenterNext(). The payload is not copied.
+ * @param[out] fr
+ *   Pointer to the fragmenter.
+ * @param[in] lp
+ *   Pointer to the LoLaN packet structure with the header fields of the
+ *   fragments (the payload fields are not used).
+ * @param[in] data
+ *   Starting address of the payload (it should be unchanged until all
+ *   fragments are sent).
+ * @param[in] size
+ *   Size of the payload in bytes.
+ * @param[in] fragmentSize
+ *   Maximum payload size of a fragment. Set to zero to use
+ *   LOLAN_PACKET_MAX_PAYLOAD_SIZE.
+ *****************************************************************************/
+void lolan_fragmenterInit(lolan_Fragmenter *fr, const lolan_Packet *lp, const uint8_t *data,
+                size_t size, LP_SIZE_T fragmentSize)
+{
+  fr->packet = *lp;
+  fr->data = data;
+  fr->size = size;
+  fr->offset = 0;
+  fr->count = 0;
+  fr->fragmentSize = ((fragmentSize > 0) && (fragmentSize <= LOLAN_PACKET_MAX_PAYLOAD_SIZE)) ?
+                     fragmentSize : LOLAN_PACKET_MAX_PAYLOAD_SIZE;
+} /* lolan_fragmenterInit */
+
+/**************************************************************************//**
+ * @brief
+ *   Get the next fragment from a multipart fragmenter.
+ * @details
+ *   Fills a LoLaN packet structure with the next fragment. If the whole
+ *   payload fits in one packet, a single packet is returned without
+ *   the multipart field set.
+ * @note
+ *   The payload of the packet structure points into the payload of the
+ *   fragmenter (use lolan_createPacketSegments() to output the packet
+ *   without copying the payload).
+ * @param[in,out] fr
+ *   Pointer to the fragmenter.
+ * @param[out] lp
+ *   Pointer to the LoLaN packet structure which receives the fragment.
+ * @return
+ *   LOLAN_RETVAL_YES:  The next fragment is filled in the packet structure.
+ *   LOLAN_RETVAL_NO:   All fragments are already returned.
+ *****************************************************************************/
+int8_t lolan_fragmenterNext(lolan_Fragmenter *fr, lolan_Packet *lp)
+{
+  size_t n;
+
+  if ((fr->count > 0) && (fr->offset >= fr->size))   // done
+    return LOLAN_RETVAL_NO;
+
+  n = fr->size - fr->offset;   // remaining size
+  if (n > fr->fragmentSize)
+    n = fr->fragmentSize;
+
+  *lp = fr->packet;
+  lp->payload = (uint8_t*) &fr->data[fr->offset];
+  lp->payloadSize = n;
+  if (fr->count == 0)   // first fragment
+    lp->multiPart = (n == fr->size) ? LOLAN_MPC_NOMULTIPART : LOLAN_MPC_MULTIPART_START;
+  else
+    lp->multiPart = (fr->offset + n == fr->size) ? LOLAN_MPC_MULTIPART_END : LOLAN_MPC_MULTIPART_MIDDLE;
+
+  fr->offset += n;
+  fr->count++;
+  return LOLAN_RETVAL_YES;
+} /* lolan_fragmenterNext */
+
+#ifdef LOLAN_MULTIPART_MAX_SIZE
+
+/**************************************************************************//**
+ * @brief
+ *   Initialize a multipart reassembly table.
+ * @details
+ *   The reassembly table collects the fragments of multipart packets,
+ *   at most LOLAN_MULTIPART_SLOTS packets at the same time, each up to
+ *   LOLAN_MULTIPART_MAX_SIZE bytes (see lolan_reassemblyPush()).
+ * @param[out] ra
+ *   Pointer to the reassembly table.
+ * @param[in] timeout
+ *   An incomplete packet is dropped if no fragment is received for it
+ *   for this time (in the time unit of lolan_reassemblyPush()). Set to
+ *   zero to disable the timeout.
+ *****************************************************************************/
+void lolan_reassemblyInit(lolan_Reassembly *ra, uint32_t timeout)
+{
+  uint8_t i;
+
+  for (i = 0; i < LOLAN_MULTIPART_SLOTS; i++)
+    ra->slot[i].used = false;
+  ra->timeout = timeout;
+} /* lolan_reassemblyInit */
+
+/**************************************************************************//**
+ * @brief
+ *   Find the reassembly slot of a multipart packet.
+ * @param[in] ra
+ *   Pointer to the reassembly table.
+ * @param[in] lp
+ *   Pointer to the LoLaN packet structure of a fragment.
+ * @return
+ *   The slot, or NULL if not found.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ *****************************************************************************/
+static lolan_ReassemblySlot* lolanReassemblyFind(lolan_Reassembly *ra, const lolan_Packet *lp)
+{
+  uint8_t i;
+
+  for (i = 0; i < LOLAN_MULTIPART_SLOTS; i++) {
+    if (ra->slot[i].used && (ra->slot[i].fromId == lp->fromId) &&
+        (ra->slot[i].packetCounter == lp->packetCounter))
+      return &ra->slot[i];
+  }
+  return NULL;
+} /* lolanReassemblyFind */
+
+/**************************************************************************//**
+ * @brief
+ *   Check a reassembled payload.
+ * @details
+ *   The payload has to be a single valid CBOR data item without bytes
+ *   after it (a fragment lost from the middle usually breaks it, see the
+ *   description at the beginning of lolan-multipart.c).
+ * @param[in] data
+ *   Pointer to the payload.
+ * @param[in] size
+ *   The size of the payload.
+ * @return
+ *   true: the payload is accepted.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ *****************************************************************************/
+static bool lolanReassemblyCheck(const uint8_t *data, size_t size)
+{
+  lolan_CborIndex idx;
+  lolan_CborCursor cur;
+
+  if (lolanCborValidate(&idx, data, size) != LOLAN_RETVAL_YES) return false;
+  lolanCborCursorRoot(&idx, &cur);
+  while ((*cur.ptr >> 5) == 6)   // tags of the root item
+    lolanCborCursorAdvance(&cur);
+  lolanCborCursorAdvance(&cur);   // skip the root item
+  return (cur.ptr == idx.end);
+} /* lolanReassemblyCheck */
+
+/**************************************************************************//**
+ * @brief
+ *   Process a received packet with a multipart reassembly table.
+ * @details
+ *   The fragments of a multipart packet are stored in the reassembly
+ *   table, the complete packet is returned when its END fragment is
+ *   received. Packets without the multipart field set are returned
+ *   immediately.
+ *   The incomplete packets are dropped after the timeout. If all slots
+ *   are used, a START fragment replaces the least recently updated
+ *   incomplete packet.
+ * @note
+ *   The payload of a reassembled packet points into the reassembly table,
+ *   it is valid until the next call of this function.
+ * @param[in,out] ra
+ *   Pointer to the reassembly table.
+ * @param[in] lp
+ *   Pointer to the received LoLaN packet structure.
+ * @param[in] now
+ *   The current time (in any time unit, e.g. milliseconds; may wrap
+ *   around).
+ * @param[out] out
+ *   Pointer to the LoLaN packet structure which receives the complete
+ *   packet.
+ * @return
+ *   LOLAN_RETVAL_YES:       A complete packet is filled in out.
+ *   LOLAN_RETVAL_NO:        The fragment is stored, the packet is not
+ *                           complete yet.
+ *   LOLAN_RETVAL_GENERROR:  The fragment is dropped (no START fragment
+ *                           received for it, the packet is too long, or
+ *                           the reassembled payload is not a single valid
+ *                           CBOR data item).
+ *****************************************************************************/
+int8_t lolan_reassemblyPush(lolan_Reassembly *ra, const lolan_Packet *lp, uint32_t now,
+                lolan_Packet *out)
+{
+  lolan_ReassemblySlot *slot, *oldest;
+  uint8_t i;
+
+  /* drop the expired packets */
+  if (ra->timeout > 0) {
+    for (i = 0; i < LOLAN_MULTIPART_SLOTS; i++) {
+      if (ra->slot[i].used && ((uint32_t) (now - ra->slot[i].time) > ra->timeout))
+        ra->slot[i].used = false;
+    }
+  }
+
+  if (lp->multiPart == LOLAN_MPC_NOMULTIPART) {   // single packet
+    *out = *lp;
+    return LOLAN_RETVAL_YES;
+  }
+
+  slot = lolanReassemblyFind(ra, lp);
+  if (lp->multiPart == LOLAN_MPC_MULTIPART_START) {   // first fragment: (re)start the packet
+    if (slot == NULL) {
+      oldest = NULL;
+      for (i = 0; (i < LOLAN_MULTIPART_SLOTS) && (slot == NULL); i++) {
+        if (!ra->slot[i].used)
+          slot = &ra->slot[i];
+        else if ((oldest == NULL) || ((uint32_t) (now - ra->slot[i].time) > (uint32_t) (now - oldest->time)))
+          oldest = &ra->slot[i];
+      }
+      if (slot == NULL) {   // all slots are used
+        DLOG(("\n lolan_reassemblyPush(): incomplete packet replaced"));
+        slot = oldest;
+      }
+    }
+    slot->used = true;
+    slot->fromId = lp->fromId;
+    slot->packetCounter = lp->packetCounter;
+    slot->size = 0;
+  } else if (slot == NULL) {   // no START fragment received
+    return LOLAN_RETVAL_GENERROR;
+  }
+
+  /* append the payload of the fragment */
+  if (lp->payloadSize > LOLAN_MULTIPART_MAX_SIZE - slot->size) {   // too long
+    DLOG(("\n lolan_reassemblyPush(): packet too long"));
+    slot->used = false;
+    return LOLAN_RETVAL_GENERROR;
+  }
+  memcpy(&slot->data[slot->size], lp->payload, lp->payloadSize);
+  slot->size += lp->payloadSize;
+  slot->time = now;
+
+  if (lp->multiPart != LOLAN_MPC_MULTIPART_END)
+    return LOLAN_RETVAL_NO;
+
+  /* the packet is complete */
+  slot->used = false;   // (the data is kept until the next call)
+  if (!lolanReassemblyCheck(slot->data, slot->size)) {   // (e.g. a MIDDLE fragment is lost)
+    DLOG(("\n lolan_reassemblyPush(): invalid reassembled payload"));
+    return LOLAN_RETVAL_GENERROR;
+  }
+  *out = *lp;
+  out->multiPart = LOLAN_MPC_NOMULTIPART;
+  out->payload = slot->data;
+  out->payloadSize = slot->size;
+  return LOLAN_RETVAL_YES;
+} /* lolan_reassemblyPush */
+
+#endif
@@ -0,0 +1,409 @@
+/**************************************************************************//**
+ * @file lolan-pending.c
+ * @brief LoLaN pending request table
+ * @author Sunstone-RTLS Ltd.
+ ******************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "lolan_config.h"
+#include "lolan.h"
+
+#ifdef LOLAN_PENDING_SIZE
+
+/*
+ * LoLaN pending request table
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ *   A master can keep many requests outstanding at the same time. The
+ *   table assigns the packet counters of the requests from a separate
+ *   counter for every destination (so a node receives consecutive packet
+ *   counters, see LOLAN_DUPFILTER_SOURCES), and maps the received ACK
+ *   packets to the completion callbacks of the requests.
+ *
+ *   Both the requests (key: destination and packet counter) and the
+ *   destinations are stored in open-addressing (linear probing) hash
+ *   tables, so an ACK is matched in constant time. At most 3/4 of the
+ *   slots are used to keep the probe sequences short.
+ *
+ *   A destination is kept after its last request completed, so its packet
+ *   counter continues with the next request. When the destination table
+ *   is full, the least recently used destination without pending request
+ *   is replaced (the packet counter of a replaced destination restarts at
+ *   1, so LOLAN_PENDING_DESTS should be large enough for the nodes
+ *   addressed regularly).
+ */
+
+#define LOLAN_PENDING_MAX_COUNT   (LOLAN_PENDING_SIZE - LOLAN_PENDING_SIZE / 4)
+#define LOLAN_PENDING_MAX_DESTS   (LOLAN_PENDING_DESTS - LOLAN_PENDING_DESTS / 4)
+
+
+/**************************************************************************//**
+ * @brief
+ *   Compute the start slot of a request in the pending request table.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static inline uint32_t lolanPendingSlot(uint16_t toId, uint8_t packetCounter)
+{
+  uint32_t h;
+
+  h = ((uint32_t) toId << 8) | packetCounter;
+  h *= 2654435761u;   // multiplicative (Fibonacci) hashing
+  h ^= h >> 16;
+  return h & (LOLAN_PENDING_SIZE - 1);
+} /* lolanPendingSlot */
+
+/**************************************************************************//**
+ * @brief
+ *   Compute the start slot of a destination in the pending request table.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static inline uint32_t lolanPendingDestSlot(uint16_t toId)
+{
+  uint32_t h;
+
+  h = toId * 2654435761u;
+  h ^= h >> 16;
+  return h & (LOLAN_PENDING_DESTS - 1);
+} /* lolanPendingDestSlot */
+
+/**************************************************************************//**
+ * @brief
+ *   Find a destination in the pending request table.
+ * @param[in] pt
+ *   Pointer to the pending request table.
+ * @param[in] toId
+ *   The destination address.
+ * @return
+ *   The slot of the destination, or the empty slot where it can be added.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ *****************************************************************************/
+static uint32_t lolanPendingDestFind(const lolan_PendingTable *pt, uint16_t toId)
+{
+  uint32_t slot;
+
+  slot = lolanPendingDestSlot(toId);
+  while (pt->dest[slot].used && (pt->dest[slot].toId != toId))   // (there is always an empty slot)
+    slot = (slot + 1) & (LOLAN_PENDING_DESTS - 1);
+  return slot;
+} /* lolanPendingDestFind */
+
+/**************************************************************************//**
+ * @brief
+ *   Remove a destination from the pending request table.
+ * @details
+ *   The following entries of the probe sequence are shifted back (see
+ *   lolanPendingRemove()).
+ * @param[in,out] pt
+ *   Pointer to the pending request table.
+ * @param[in] slot
+ *   The slot of the destination.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ *****************************************************************************/
+static void lolanPendingDestRemove(lolan_PendingTable *pt, uint32_t slot)
+{
+  uint32_t next, home;
+
+  pt->destCount--;
+  for (;;) {
+    pt->dest[slot].used = false;
+    next = slot;
+    do {
+      next = (next + 1) & (LOLAN_PENDING_DESTS - 1);
+      if (!pt->dest[next].used)
+        return;
+      home = lolanPendingDestSlot(pt->dest[next].toId);
+    } while (((next - home) & (LOLAN_PENDING_DESTS - 1)) < ((next - slot) & (LOLAN_PENDING_DESTS - 1)));   // (its start slot is after the empty slot)
+    pt->dest[slot] = pt->dest[next];
+    slot = next;
+  }
+} /* lolanPendingDestRemove */
+
+/**************************************************************************//**
+ * @brief
+ *   Replace the least recently used destination without pending request.
+ * @param[in,out] pt
+ *   Pointer to the pending request table.
+ * @return
+ *   true if a destination is removed, false if all destinations have
+ *   pending requests.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ *****************************************************************************/
+static bool lolanPendingDestReplace(lolan_PendingTable *pt)
+{
+  uint32_t slot, lru;
+
+  lru = LOLAN_PENDING_DESTS;
+  for (slot = 0; slot < LOLAN_PENDING_DESTS; slot++) {
+    if (pt->dest[slot].used && (pt->dest[slot].pending == 0) && ((lru == LOLAN_PENDING_DESTS) ||
+        ((uint32_t) (pt->destClock - pt->dest[slot].lastUse) > (uint32_t) (pt->destClock - pt->dest[lru].lastUse))))
+      lru = slot;
+  }
+  if (lru == LOLAN_PENDING_DESTS)
+    return false;
+  DLOG(("\n lolan_pendingAdd(): destination %d replaced", pt->dest[lru].toId));
+  lolanPendingDestRemove(pt, lru);
+  return true;
+} /* lolanPendingDestReplace */
+
+/**************************************************************************//**
+ * @brief
+ *   Initialize a pending request table.
+ * @param[out] pt
+ *   Pointer to the pending request table.
+ *****************************************************************************/
+void lolan_pendingInit(lolan_PendingTable *pt)
+{
+  memset(pt, 0, sizeof(lolan_PendingTable));
+} /* lolan_pendingInit */
+
+/**************************************************************************//**
+ * @brief
+ *   Find a request in the pending request table.
+ * @param[in] pt
+ *   Pointer to the pending request table.
+ * @param[in] toId
+ *   The destination of the request.
+ * @param[in] packetCounter
+ *   The packet counter of the request.
+ * @return
+ *   The slot of the request, or LOLAN_PENDING_SIZE if not found.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ *****************************************************************************/
+static uint32_t lolanPendingFind(const lolan_PendingTable *pt, uint16_t toId, uint8_t packetCounter)
+{
+  uint32_t slot;
+
+  slot = lolanPendingSlot(toId, packetCounter);
+  while (pt->entry[slot].used) {   // (there is always an empty slot)
+    if ((pt->entry[slot].toId == toId) && (pt->entry[slot].packetCounter == packetCounter))
+      return slot;
+    slot = (slot + 1) & (LOLAN_PENDING_SIZE - 1);
+  }
+  return LOLAN_PENDING_SIZE;
+} /* lolanPendingFind */
+
+/**************************************************************************//**
+ * @brief
+ *   Remove a request from the pending request table.
+ * @details
+ *   The following entries of the probe sequence are shifted back (no
+ *   deleted markers are needed).
+ * @param[in,out] pt
+ *   Pointer to the pending request table.
+ * @param[in] slot
+ *   The slot of the request.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ *****************************************************************************/
+static void lolanPendingRemove(lolan_PendingTable *pt, uint32_t slot)
+{
+  uint32_t next, home;
+
+  pt->dest[lolanPendingDestFind(pt, pt->entry[slot].toId)].pending--;
+  pt->count--;
+  for (;;) {
+    pt->entry[slot].used = false;
+    next = slot;
+    do {
+      next = (next + 1) & (LOLAN_PENDING_SIZE - 1);
+      if (!pt->entry[next].used)
+        return;
+      home = lolanPendingSlot(pt->entry[next].toId, pt->entry[next].packetCounter);
+    } while (((next - home) & (LOLAN_PENDING_SIZE - 1)) < ((next - slot) & (LOLAN_PENDING_SIZE - 1)));   // (its start slot is after the empty slot)
+    pt->entry[slot] = pt->entry[next];
+    slot = next;
+  }
+} /* lolanPendingRemove */
+
+/**************************************************************************//**
+ * @brief
+ *   Add a request to the pending request table.
+ * @details
+ *   The packet counter of the request is assigned from the counter of its
+ *   destination (the value set by e.g. lolan_createGet() is overwritten),
+ *   and the ackRequired flag is set. The request has to be sent after this
+ *   call.
+ *   The completion callback is called with the status:
+ *     LOLAN_RETVAL_YES:  The ACK is received (ack points to it, see
+ *                        lolan_pendingAck()).
+ *     LOLAN_RETVAL_NO:   The request is expired (ack is NULL, see
+ *                        lolan_pendingExpire()).
+ * @param[in,out] pt
+ *   Pointer to the pending request table.
+ * @param[in,out] lp
+ *   Pointer to the LoLaN packet structure of the request.
+ * @param[in] now
+ *   The current time (in any time unit, e.g. milliseconds; may wrap
+ *   around).
+ * @param[in] done
+ *   Completion callback (NULL: none).
+ * @param[in] doneArg
+ *   Argument of the completion callback.
+ * @return
+ *   LOLAN_RETVAL_YES:       The request is added.
+ *   LOLAN_RETVAL_MEMERROR:  The table is full (or all packet counters of
+ *                           the destination are pending, or the
+ *                           destination table is full and all
+ *                           destinations have pending requests).
+ *****************************************************************************/
+int8_t lolan_pendingAdd(lolan_PendingTable *pt, lolan_Packet *lp, uint32_t now,
+                lolan_PendingFunc done, void *doneArg)
+{
+  lolan_PendingDest *dest;
+  lolan_PendingEntry *e;
+  uint32_t slot;
+  uint16_t n;
+  uint8_t counter;
+
+  if (pt->count >= LOLAN_PENDING_MAX_COUNT)
+    return LOLAN_RETVAL_MEMERROR;
+
+  /* find or add the destination */
+  dest = &pt->dest[lolanPendingDestFind(pt, lp->toId)];
+  if (!dest->used) {
+    if (pt->destCount >= LOLAN_PENDING_MAX_DESTS) {
+      if (!lolanPendingDestReplace(pt))
+        return LOLAN_RETVAL_MEMERROR;
+      dest = &pt->dest[lolanPendingDestFind(pt, lp->toId)];   // (the entries may be shifted)
+    }
+    dest->used = true;
+    dest->toId = lp->toId;
+    dest->packetCounter = 1;
+    dest->pending = 0;
+    pt->destCount++;
+  }
+  dest->lastUse = ++pt->destClock;
+
+  /* next packet counter which is not pending */
+  for (n = 0; n < 256; n++) {
+    counter = dest->packetCounter++;
+    if (lolanPendingFind(pt, lp->toId, counter) == LOLAN_PENDING_SIZE)
+      break;
+  }
+  if (n == 256)
+    return LOLAN_RETVAL_MEMERROR;
+
+  slot = lolanPendingSlot(lp->toId, counter);
+  while (pt->entry[slot].used)
+    slot = (slot + 1) & (LOLAN_PENDING_SIZE - 1);
+  e = &pt->entry[slot];
+  e->used = true;
+  e->toId = lp->toId;
+  e->packetCounter = counter;
+  e->time = now;
+  e->done = done;
+  e->doneArg = doneArg;
+  pt->count++;
+  dest->pending++;
+
+  lp->packetCounter = counter;
+  lp->ackRequired = true;
+  return LOLAN_RETVAL_YES;
+} /* lolan_pendingAdd */
+
+/**************************************************************************//**
+ * @brief
+ *   Process a received packet with a pending request table.
+ * @details
+ *   If the packet is the ACK of a pending request, the request is removed
+ *   and its completion callback is called (a new request can be added from
+ *   the callback).
+ * @param[in,out] pt
+ *   Pointer to the pending request table.
+ * @param[in] ack
+ *   Pointer to the received LoLaN packet structure.
+ * @return
+ *   LOLAN_RETVAL_YES:  The packet is the ACK of a pending request.
+ *   LOLAN_RETVAL_NO:   The packet is not an ACK of a pending request.
+ *****************************************************************************/
+int8_t lolan_pendingAck(lolan_PendingTable *pt, const lolan_Packet *ack)
+{
+  lolan_PendingFunc done;
+  void *doneArg;
+  uint32_t slot;
+
+  if (ack->packetType != LOLAN_PAK_ACK)
+    return LOLAN_RETVAL_NO;
+
+  slot = lolanPendingFind(pt, ack->fromId, ack->packetCounter);
+  if (slot == LOLAN_PENDING_SIZE)
+    return LOLAN_RETVAL_NO;
+
+  done = pt->entry[slot].done;
+  doneArg = pt->entry[slot].doneArg;
+  lolanPendingRemove(pt, slot);
+  if (done != NULL)
+    done(doneArg, ack, LOLAN_RETVAL_YES);
+  return LOLAN_RETVAL_YES;
+} /* lolan_pendingAck */
+
+/**************************************************************************//**
+ * @brief
+ *   Remove a request from the pending request table without calling its
+ *   completion callback.
+ * @param[in,out] pt
+ *   Pointer to the pending request table.
+ * @param[in] toId
+ *   The destination of the request.
+ * @param[in] packetCounter
+ *   The packet counter of the request (assigned by lolan_pendingAdd()).
+ * @return
+ *   LOLAN_RETVAL_YES:  The request is removed.
+ *   LOLAN_RETVAL_NO:   The request is not pending.
+ *****************************************************************************/
+int8_t lolan_pendingCancel(lolan_PendingTable *pt, uint16_t toId, uint8_t packetCounter)
+{
+  uint32_t slot;
+
+  slot = lolanPendingFind(pt, toId, packetCounter);
+  if (slot == LOLAN_PENDING_SIZE)
+    return LOLAN_RETVAL_NO;
+  lolanPendingRemove(pt, slot);
+  return LOLAN_RETVAL_YES;
+} /* lolan_pendingCancel */
+
+/**************************************************************************//**
+ * @brief
+ *   Remove the expired requests from the pending request table.
+ * @details
+ *   The completion callback of every request added more than timeout ago
+ *   is called with LOLAN_RETVAL_NO. This function should be called
+ *   periodically (it scans the whole table).
+ * @param[in,out] pt
+ *   Pointer to the pending request table.
+ * @param[in] now
+ *   The current time.
+ * @param[in] timeout
+ *   The maximum age of a pending request.
+ * @return
+ *   The number of expired requests.
+ *****************************************************************************/
+uint32_t lolan_pendingExpire(lolan_PendingTable *pt, uint32_t now, uint32_t timeout)
+{
+  lolan_PendingFunc done;
+  void *doneArg;
+  uint32_t slot, n;
+
+  n = 0;
+  for (slot = 0; slot < LOLAN_PENDING_SIZE; slot++) {
+    while (pt->entry[slot].used && ((uint32_t) (now - pt->entry[slot].time) > timeout)) {   // (another entry may be shifted here)
+      done = pt->entry[slot].done;
+      doneArg = pt->entry[slot].doneArg;
+      lolanPendingRemove(pt, slot);
+      n++;
+      if (done != NULL)
+        done(doneArg, NULL, LOLAN_RETVAL_NO);
+    }
+  }
+  return n;
+} /* lolan_pendingExpire */
+
+#endif
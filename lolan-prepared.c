@@ -0,0 +1,387 @@
+/**************************************************************************//**
+ * @file lolan-prepared.c
+ * @brief LoLaN prepared INFORM functions
+ * @author Sunstone-RTLS Ltd.
+ ******************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "lolan_config.h"
+#include "lolan.h"
+#include "lolan-utils.h"
+#include "cbor.h"
+
+#ifdef LOLAN_PREPARED_INFORM_SIZE
+
+/*
+ * LoLaN prepared INFORM
+ * ~~~~~~~~~~~~~~~~~~~~~
+ *
+ *   Periodic reports of the same variables do not need the register map
+ *   search and the CBOR encoding of lolan_createInform() in every cycle.
+ *   lolan_prepareInform() encodes the INFORM payload of a fixed set of
+ *   INT, UINT and FLOAT variables once (in the same format as
+ *   lolan_createInform() would do, see lolan-inform.c), and records the
+ *   offsets of the values in the payload.
+ *
+ *   The values are encoded with a fixed width (the size of the variable):
+ *
+ *     UINT (n bytes):   major type 0, n-byte argument (0x18..0x1b)
+ *     INT (n bytes):    major type 0 or 1, n-byte argument (0x18..0x1b or
+ *                       0x38..0x3b)
+ *     FLOAT (4/8 bytes): single/double precision (0xfa/0xfb)
+ *
+ *   so lolan_createPreparedInform() only copies the payload and
+ *   overwrites the values in place. (The integers are not encoded in the
+ *   shortest form, but it is valid CBOR.)
+ */
+
+
+/**************************************************************************//**
+ * @brief
+ *   Get the definition level of a variable path.
+ * @param[in] path
+ *   Variable path array (length: LOLAN_REGMAP_DEPTH).
+ * @return
+ *   The number of path items (without the trailing zeros).
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static inline uint8_t lolanPreparedDepth(const uint8_t *path)
+{
+  uint8_t depth;
+
+  depth = LOLAN_REGMAP_DEPTH;
+  while ((depth > 1) && (path[depth-1] == 0))
+    depth--;
+  return depth;
+} /* lolanPreparedDepth */
+
+/**************************************************************************//**
+ * @brief
+ *   Write the current values of the variables to a prepared INFORM
+ *   payload.
+ * @param[in] pi
+ *   Pointer to the prepared INFORM.
+ * @param[out] payload
+ *   Pointer to the copy of the prepared INFORM payload.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static void lolanPreparedPatch(const lolan_PreparedInform *pi, uint8_t *payload)
+{
+  const lolan_PreparedVar *v;
+  uint8_t *out;
+  uint64_t value;
+  uint8_t n;
+
+  for (v = pi->var; v < pi->var + pi->count; v++) {
+    out = payload + v->offset;   // initial byte of the value
+    switch (v->size) {   // get the bits of the value
+      case 1:
+        {
+          uint8_t u8;
+          memcpy(&u8, v->data, 1);
+          value = u8;
+        }
+        break;
+      case 2:
+        {
+          uint16_t u16;
+          memcpy(&u16, v->data, 2);
+          value = u16;
+        }
+        break;
+      case 4:
+        {
+          uint32_t u32;
+          memcpy(&u32, v->data, 4);
+          value = u32;
+        }
+        break;
+      default:
+        memcpy(&value, v->data, 8);
+        break;
+    }
+    if (v->type == LOLAN_INT) {   // signed integer: the major type depends on the sign
+      if ((value >> (8 * v->size - 1)) != 0) {   // negative
+        out[0] |= 0x20;   // major type 1 (negative integer)
+        value = ~value;   // argument: -1 - value (the bits above the size are not written)
+      } else {
+        out[0] &= ~0x20;   // major type 0 (unsigned integer)
+      }
+    }
+    for (n = v->size; n > 0; n--) {   // write the argument (big-endian)
+      out[n] = (uint8_t) value;
+      value >>= 8;
+    }
+  }
+} /* lolanPreparedPatch */
+
+/**************************************************************************//**
+ * @brief
+ *   Encode a variable of a prepared INFORM.
+ * @param[in] pi
+ *   Pointer to the prepared INFORM.
+ * @param[in,out] v
+ *   Pointer to the variable (its payload offset is set).
+ * @param[in] encoder
+ *   Pointer to the CborEncoder instance.
+ * @return
+ *    LOLAN_RETVAL_YES: Success.
+ *    LOLAN_RETVAL_CBORERROR: A CBOR-related error has occurred.
+ *    LOLAN_RETVAL_MEMERROR: CBOR out of memory error.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static int8_t lolanPreparedVarToCbor(const lolan_PreparedInform *pi, lolan_PreparedVar *v, CborEncoder *encoder)
+{
+  CborError cerr;
+
+  v->offset = cbor_encoder_get_buffer_size(encoder, pi->payload);
+  if (v->type == LOLAN_FLOAT)   // the width of a floating point number is fixed
+    cerr = cbor_encode_floating_point(encoder, (v->size == 4) ? CborFloatType : CborDoubleType, v->data);
+  else   // placeholder with the maximum argument of the size (the value is written by lolanPreparedPatch())
+    cerr = cbor_encode_uint(encoder, (v->size == 8) ? UINT64_MAX : ((uint64_t) 1 << (8 * v->size)) - 1);
+  if (cerr != CborNoError) {
+    DLOG(("\n CBOR encode error"));
+    return (cerr == CborErrorOutOfMemory) ? LOLAN_RETVAL_MEMERROR : LOLAN_RETVAL_CBORERROR;
+  }
+  return LOLAN_RETVAL_YES;
+} /* lolanPreparedVarToCbor */
+
+/**************************************************************************//**
+ * @brief
+ *   Prepare an INFORM payload for a fixed set of variables.
+ * @details
+ *   The INFORM payload reporting the specified variables is encoded
+ *   into the prepared INFORM structure, and it can be sent any number of
+ *   times with the current values of the variables by
+ *   lolan_createPreparedInform().
+ *   Only INT, UINT (1, 2, 4, 8 bytes) and FLOAT (4, 8 bytes) variables
+ *   can be reported. The variable paths, types and sizes are stored in
+ *   the structure: prepare it again if these variables are removed or
+ *   registered again.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[out] pi
+ *   Pointer to the prepared INFORM.
+ * @param[in] vars
+ *   Data pointers of the variables to report (in any order).
+ * @param[in] count
+ *   Number of the variables (1..LOLAN_PREPARED_INFORM_SIZE).
+ * @return
+ *    LOLAN_RETVAL_YES: The INFORM payload is prepared.
+ *    LOLAN_RETVAL_GENERROR: Invalid variable count, a variable is not
+ *      registered, is specified more than once, or its type is not
+ *      supported.
+ *    LOLAN_RETVAL_CBORERROR: A CBOR-related error has occurred.
+ *    LOLAN_RETVAL_MEMERROR: CBOR out of memory error (the variables do
+ *      not fit in one INFORM packet).
+ ******************************************************************************/
+int8_t lolan_prepareInform(lolan_ctx *ctx, lolan_PreparedInform *pi, const void * const *vars,
+          LR_SIZE_T count)
+{
+  LR_SIZE_T index[LOLAN_PREPARED_INFORM_SIZE];
+  LR_SIZE_T i, j, k;
+  const uint8_t *p, *last;
+  uint8_t type, depth, lvl, open;
+  bool oldStyle;
+  int8_t err;
+
+  CborError cerr;
+  CborEncoder enc[LOLAN_REGMAP_DEPTH+1];   // root encoder, root map and nested maps
+
+  pi->count = 0;
+  pi->payloadSize = 0;
+  if ((count == 0) || (count > LOLAN_PREPARED_INFORM_SIZE))
+    return LOLAN_RETVAL_GENERROR;
+
+  /* find the variables (sorted by register map index, that is by path) */
+  for (i = 0; i < count; i++) {
+    k = lolanRegMapFindByPtr(ctx, vars[i]);
+    if (k >= LOLAN_REGMAP_SIZE) {
+      DLOG(("\n lolan_prepareInform(): variable not found"));
+      return LOLAN_RETVAL_GENERROR;
+    }
+    type = LRM_FLAGS(ctx, k) & LOLAN_REGMAP_TYPE_MASK;
+    switch (LRM_SIZE(ctx, k)) {
+      case 1:
+      case 2:
+        if ((type != LOLAN_INT) && (type != LOLAN_UINT)) return LOLAN_RETVAL_GENERROR;
+        break;
+      case 4:
+      case 8:
+        if ((type != LOLAN_INT) && (type != LOLAN_UINT) && (type != LOLAN_FLOAT)) return LOLAN_RETVAL_GENERROR;
+        break;
+      default:   // unsupported size
+        return LOLAN_RETVAL_GENERROR;
+    }
+    for (j = i; (j > 0) && (index[j-1] > k); j--)   // insertion sort
+      index[j] = index[j-1];
+    if ((j > 0) && (index[j-1] == k)) {
+      DLOG(("\n lolan_prepareInform(): duplicated variable"));
+      return LOLAN_RETVAL_GENERROR;
+    }
+    index[j] = k;
+  }
+
+  /* the legacy format is used if the definition level and the base path of the variables are the same */
+  p = LRM_P(ctx, index[0]);
+  depth = lolanPreparedDepth(p);
+  oldStyle = !LOLAN_FORCE_NEW_STYLE_INFORM;
+  for (i = 1; (i < count) && oldStyle; i++) {
+    if ((lolanPreparedDepth(LRM_P(ctx, index[i])) != depth) || (memcmp(LRM_P(ctx, index[i]), p, depth-1) != 0))
+      oldStyle = false;
+  }
+
+  cbor_encoder_init(&enc[0], pi->payload, LOLAN_PACKET_MAX_PAYLOAD_SIZE, 0);
+
+  if (oldStyle) {   // old style inform
+    cerr = cbor_encoder_create_map(&enc[0], &enc[1], (depth > 1) ? count+1 : count);   // create root map
+    if (cerr != CborNoError) {
+      DLOG(("\n CBOR encode error"));
+      return LOLAN_RETVAL_CBORERROR;
+    }
+    if (depth > 1) {  // base path definition is required
+      cerr = cbor_encode_uint(&enc[1], 0);   // encode key=0
+      if (cerr == CborNoError)
+        cerr = cbor_encoder_create_array(&enc[1], &enc[2], depth-1);  // create array for base path
+      for (lvl = 0; (lvl < depth-1) && (cerr == CborNoError); lvl++)
+        cerr = cbor_encode_uint(&enc[2], p[lvl]);   // encode path item
+      if (cerr == CborNoError)
+        cerr = cbor_encoder_close_container(&enc[1], &enc[2]);   // close array
+      if (cerr != CborNoError) {
+        DLOG(("\n CBOR encode error"));
+        return (cerr == CborErrorOutOfMemory) ? LOLAN_RETVAL_MEMERROR : LOLAN_RETVAL_CBORERROR;
+      }
+    }
+    open = 1;
+  } else {   // new style inform
+    cerr = cbor_encoder_create_map(&enc[0], &enc[1], CborIndefiniteLength);   // create root map
+    if (cerr != CborNoError) {
+      DLOG(("\n CBOR encode error"));
+      return LOLAN_RETVAL_CBORERROR;
+    }
+    err = createCborUintDataSimple(&enc[1], 0, 299, false);   // encode status code
+    if (err != LOLAN_RETVAL_YES) {
+      DLOG(("\n CBOR encode error"));
+      return err;
+    }
+    open = 1;   // enc[open] is the innermost open map, (open - 1) path items are opened
+  }
+
+  /* encode the variables */
+  last = NULL;
+  for (i = 0; i < count; i++) {
+    p = LRM_P(ctx, index[i]);
+    depth = lolanPreparedDepth(p);
+    if (!oldStyle) {
+      /* close the nested maps which are not on the path of the variable */
+      lvl = 0;
+      while ((last != NULL) && (lvl < open-1) && (lvl < depth-1) && (p[lvl] == last[lvl]))
+        lvl++;
+      while (open-1 > lvl) {
+        cerr = cbor_encoder_close_container(&enc[open-1], &enc[open]);
+        if (cerr != CborNoError) {
+          DLOG(("\n CBOR encode error"));
+          return (cerr == CborErrorOutOfMemory) ? LOLAN_RETVAL_MEMERROR : LOLAN_RETVAL_CBORERROR;
+        }
+        open--;
+      }
+      /* open the nested maps of the rest of the path */
+      while (open < depth) {
+        cerr = cbor_encode_uint(&enc[open], p[open-1]);   // encode key (path item)
+        if (cerr == CborNoError)
+          cerr = cbor_encoder_create_map(&enc[open], &enc[open+1], CborIndefiniteLength);   // create map for path level
+        if (cerr != CborNoError) {
+          DLOG(("\n CBOR encode error"));
+          return (cerr == CborErrorOutOfMemory) ? LOLAN_RETVAL_MEMERROR : LOLAN_RETVAL_CBORERROR;
+        }
+        open++;
+      }
+    }
+    cerr = cbor_encode_uint(&enc[open], p[depth-1]);   // encode key (last path item)
+    if (cerr != CborNoError) {
+      DLOG(("\n CBOR encode error"));
+      return (cerr == CborErrorOutOfMemory) ? LOLAN_RETVAL_MEMERROR : LOLAN_RETVAL_CBORERROR;
+    }
+    pi->var[i].data = LRM_DATA(ctx, index[i]);
+    pi->var[i].type = LRM_FLAGS(ctx, index[i]) & LOLAN_REGMAP_TYPE_MASK;
+    pi->var[i].size = LRM_SIZE(ctx, index[i]);
+    err = lolanPreparedVarToCbor(pi, &pi->var[i], &enc[open]);   // encode value
+    if (err != LOLAN_RETVAL_YES)
+      return err;
+    last = p;
+  }
+
+  /* close the maps */
+  while (open > 0) {
+    cerr = cbor_encoder_close_container(&enc[open-1], &enc[open]);
+    if (cerr != CborNoError) {
+      DLOG(("\n CBOR encode error"));
+      return (cerr == CborErrorOutOfMemory) ? LOLAN_RETVAL_MEMERROR : LOLAN_RETVAL_CBORERROR;
+    }
+    open--;
+  }
+
+  pi->count = count;   // (the prepared INFORM is valid only if the whole payload is encoded)
+  pi->payloadSize = cbor_encoder_get_buffer_size(&enc[0], pi->payload);   // get the CBOR data size
+  lolanPreparedPatch(pi, pi->payload);   // (the payload is valid with the current values)
+  DLOG(("\n Prepared INFORM: %d bytes", pi->payloadSize));
+
+  return LOLAN_RETVAL_YES;
+} /* lolan_prepareInform */
+
+/**************************************************************************//**
+ * @brief
+ *   Create a LoLaN INFORM packet from a prepared INFORM.
+ * @details
+ *   The prepared INFORM payload is copied and the current values of the
+ *   variables are written into it. The flags of the variables are not
+ *   affected.
+ *   The prepared INFORM is not modified, so it can be shared (e.g.
+ *   between threads).
+ * @note
+ *   In the output packet structure the payload parameter should be
+ *   assigned to a buffer with a minimum length of
+ *   LOLAN_PACKET_MAX_PAYLOAD_SIZE!
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] pi
+ *   Pointer to the prepared INFORM (see lolan_prepareInform()).
+ * @param[out] pak
+ *   Pointer to the output LoLaN packet structure in which the INFORM
+ *   will be generated.
+ * @param[in] payloadOnly
+ *   Creates only an INFORM payload (fills only payload and payloadSize
+ *   fields of the output packet structure).
+ * @return
+ *    LOLAN_RETVAL_YES: A LoLaN INFORM packet is filled in the output
+ *      packet structure.
+ *    LOLAN_RETVAL_GENERROR: The INFORM is not prepared (or its
+ *      preparation failed).
+ ******************************************************************************/
+int8_t lolan_createPreparedInform(lolan_ctx *ctx, const lolan_PreparedInform *pi, lolan_Packet *pak,
+          bool payloadOnly)
+{
+  if (pi->count == 0)
+    return LOLAN_RETVAL_GENERROR;
+
+  memcpy(pak->payload, pi->payload, pi->payloadSize);
+  lolanPreparedPatch(pi, pak->payload);
+  pak->payloadSize = pi->payloadSize;
+
+  if (!payloadOnly) {
+    /* fill the packet structure */
+    lolan_resetPacket(pak);   // reset options
+    pak->packetCounter = ctx->packetCounter++;   // the packet counter of the context is copied (and incremented)
+    pak->packetType = LOLAN_PAK_INFORM;
+    pak->fromId = ctx->myAddress;
+    pak->toId = LOLAN_BROADCAST_ADDRESS;
+  }
+  return LOLAN_RETVAL_YES;
+} /* lolan_createPreparedInform */
+
+#endif
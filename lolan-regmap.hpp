@@ -0,0 +1,250 @@
+/**************************************************************************//**
+ * @file lolan-regmap.hpp
+ * @brief LoLaN read-only register map tables (C++14)
+ * @details
+ *   Builds a read-only register map at compile time from a table of
+ *   variable definitions: the definitions are validated (with the rules
+ *   of lolan_regVar()) and sorted by path, and a perfect hash is generated
+ *   for the path lookups. The result can be placed in read-only memory and
+ *   used with lolan_initConst() (LOLAN_REGMAP_CONST).
+ *   Example:
+ *     static uint32_t temperature, limit;
+ *     constexpr lolan_VarDef defs[] = {
+ *       { {2, 1, 0}, LOLAN_UINT, &limit, sizeof(limit), false },
+ *       { {1, 1, 0}, LOLAN_UINT, &temperature, sizeof(temperature), true },
+ *     };
+ *     constexpr auto table = lolan::makeConstRegMap(defs);   // (static storage)
+ *     constexpr lolan_ConstRegMap regMap = table.regMap();
+ *     ...
+ *     lolan_initConst(&ctx, address, &regMap, NULL);
+ *   An invalid table results in a compile error at a call of one of the
+ *   lolan::error_xxx() functions.
+ * @note
+ *   The build time is O(N log N) for N variables. Tested with GCC 12 up
+ *   to N = 16384: N = 4096 fits the default -fconstexpr-ops-limit, larger
+ *   tables need a higher limit (about 8192 operations per variable; with
+ *   clang, see -fconstexpr-steps).
+ * @note
+ *   Data pointers can only be compared for equality in a constant
+ *   expression (they can not be ordered), so the duplicate data pointers
+ *   are checked pairwise at build time only in tables of at most
+ *   lolan::ptrCheckMax variables. Larger tables are checked by
+ *   lolan_initConst() with LOLAN_REGMAP_HASH_SIZE, otherwise call
+ *   lolan_checkRegMap() at startup.
+ * @author Sunstone-RTLS Ltd.
+ ******************************************************************************/
+#ifndef LOLAN_REGMAP_HPP_
+#define LOLAN_REGMAP_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+extern "C" {
+#include "lolan_config.h"
+#include "lolan.h"
+}
+
+#ifndef LOLAN_REGMAP_CONST
+  #error "lolan-regmap.hpp requires LOLAN_REGMAP_CONST"
+#endif
+
+namespace lolan {
+
+/* compile errors for invalid tables (not constexpr, intentionally not defined) */
+void error_invalid_path();              // formal error in a path (see lolanIsPathValid())
+void error_invalid_size();              // unsupported variable size for the type
+void error_conflicting_paths();         // same path, or base path of an other variable
+void error_duplicate_data_pointer();    // two variables are mapped to the same address
+void error_perfect_hash_not_found();    // (should not happen)
+
+constexpr size_t ptrCheckMax = 256;     // maximum number of variables for the duplicate data pointer check at build time
+
+/* path hash (must be the same as lolanPathHash() in lolan-utils.c) */
+constexpr uint32_t pathHash(const uint8_t *path, uint32_t seed)
+{
+  uint32_t h = 2166136261u ^ seed;   // FNV-1a
+  for (size_t l = 0; l < LOLAN_REGMAP_DEPTH; l++) {
+    h ^= path[l];
+    h *= 16777619u;
+  }
+  h ^= h >> 16;   // (final mixing, the low bits are used)
+  h *= 0x85EBCA6Bu;
+  h ^= h >> 13;
+  return h;
+}
+
+constexpr uint32_t pow2AtLeast(size_t n)
+{
+  uint32_t p = 1;
+  while (p < n) p <<= 1;
+  return p;
+}
+
+constexpr int comparePaths(const uint8_t *a, const uint8_t *b)
+{
+  for (size_t l = 0; l < LOLAN_REGMAP_DEPTH; l++)
+    if (a[l] != b[l]) return (a[l] < b[l]) ? -1 : 1;
+  return 0;
+}
+
+constexpr bool isPathValid(const uint8_t *path)   // (a zero path is not valid for a variable)
+{
+  bool zero = false;
+  for (size_t l = 0; l < LOLAN_REGMAP_DEPTH; l++) {
+    if (path[l] == 0)
+      zero = true;
+    else if (zero)
+      return false;   // other values under a zero part
+  }
+  return path[0] != 0;
+}
+
+constexpr bool isSizeValid(lolan_VarType vType, LV_SIZE_T size)
+{
+  if (size == 0) return false;
+  if ((vType == LOLAN_INT) || (vType == LOLAN_UINT))
+    return (size == 1) || (size == 2) || (size == 4) || (size == 8);
+  if (vType == LOLAN_FLOAT)
+    return (size == 4) || (size == 8);
+  return true;
+}
+
+/* read-only register map built from N variable definitions */
+template <size_t N>
+class ConstRegMap {
+  static_assert((N > 0) && (N <= LOLAN_REGMAP_SIZE), "invalid number of variables");
+
+public:
+  static constexpr uint32_t hashSize = pow2AtLeast(2 * N);            // number of path hash slots (at most half-full)
+  static constexpr uint32_t hashBuckets = pow2AtLeast((N + 3) / 4);   // number of path hash buckets
+
+  constexpr explicit ConstRegMap(const lolan_VarDef (&defs)[N])
+    : p_(), flags_(), size_(), data_(), hash_(), disp_()
+  {
+    size_t order[N] = {};
+    size_t l = 0;
+
+    /* validate the definitions */
+    for (size_t i = 0; i < N; i++) {
+      if (!isPathValid(defs[i].p)) error_invalid_path();
+      if (!isSizeValid(defs[i].vType, defs[i].size)) error_invalid_size();
+      for (size_t j = 0; (N <= ptrCheckMax) && (j < i); j++)   // (quadratic, see above)
+        if (defs[j].data == defs[i].data) error_duplicate_data_pointer();
+      order[i] = i;
+    }
+
+    /* sort by path (heapsort) and fill the tables */
+    for (size_t i = N / 2; i > 0; i--)
+      siftDown(defs, order, i - 1, N);
+    for (size_t n = N - 1; n > 0; n--) {
+      size_t t = order[0];
+      order[0] = order[n];
+      order[n] = t;
+      siftDown(defs, order, 0, n);
+    }
+    for (size_t i = 0; i < N; i++) {
+      const lolan_VarDef &d = defs[order[i]];
+      for (l = 0; l < LOLAN_REGMAP_DEPTH; l++)
+        p_[i][l] = d.p[l];
+      flags_[i] = d.vType + (d.readOnly ? LOLAN_REGMAP_REMOTE_READONLY_BIT : 0);
+      size_[i] = d.size;
+      data_[i] = d.data;
+      if (i > 0) {   // (conflicting paths are adjacent)
+        for (l = 0; (l < LOLAN_REGMAP_DEPTH) && (p_[i-1][l] != 0); l++)
+          if (p_[i-1][l] != p_[i][l]) break;
+        if ((l == LOLAN_REGMAP_DEPTH) || (p_[i-1][l] == 0))   // same path or base path of this one
+          error_conflicting_paths();
+      }
+    }
+
+    buildPathHash();
+  }
+
+  /* the register map descriptor for lolan_initConst() */
+  constexpr lolan_ConstRegMap regMap() const
+  {
+    return { N, p_, flags_, size_, data_, hashSize, hashBuckets, hash_, disp_ };
+  }
+
+private:
+  lolan_RegMapPath p_[N];
+  uint16_t flags_[N];
+  LV_SIZE_T size_[N];
+  void *data_[N];
+  LR_SIZE_T hash_[hashSize];     // register map index + 1 (0: empty slot)
+  uint16_t disp_[hashBuckets];   // seed of the bucket
+
+  static constexpr void siftDown(const lolan_VarDef (&defs)[N], size_t (&order)[N], size_t root, size_t n)
+  {
+    size_t child = 0, t = 0;
+
+    while ((child = 2 * root + 1) < n) {
+      if ((child + 1 < n) && (comparePaths(defs[order[child]].p, defs[order[child+1]].p) < 0))
+        child++;
+      if (comparePaths(defs[order[root]].p, defs[order[child]].p) >= 0)
+        return;
+      t = order[root];
+      order[root] = order[child];
+      order[child] = t;
+      root = child;
+    }
+  }
+
+  /* hash and displace: the keys are distributed into buckets, then a seed
+     is searched for each bucket (the largest first) to place its keys into
+     free slots */
+  constexpr void buildPathHash()
+  {
+    uint32_t bucketOf[N] = {};
+    size_t start[hashBuckets + 1] = {};
+    size_t members[N] = {};
+    size_t fill[hashBuckets] = {};
+    size_t maxSize = 0, s = 0, i = 0, k = 0;
+    uint32_t b = 0, seed = 0, slot = 0;
+    bool ok = false;
+
+    for (i = 0; i < N; i++) {
+      bucketOf[i] = pathHash(p_[i], 0) & (hashBuckets - 1);
+      start[bucketOf[i] + 1]++;
+    }
+    for (b = 0; b < hashBuckets; b++) {
+      if (start[b + 1] > maxSize) maxSize = start[b + 1];
+      start[b + 1] += start[b];
+    }
+    for (i = 0; i < N; i++)
+      members[start[bucketOf[i]] + fill[bucketOf[i]]++] = i;
+
+    for (s = maxSize; s > 0; s--) {
+      for (b = 0; b < hashBuckets; b++) {
+        if (start[b + 1] - start[b] != s) continue;
+        for (seed = 1; ; seed++) {
+          if (seed > UINT16_MAX) error_perfect_hash_not_found();
+          ok = true;
+          for (k = start[b]; ok && (k < start[b + 1]); k++) {
+            slot = pathHash(p_[members[k]], seed) & (hashSize - 1);
+            if (hash_[slot] != 0)
+              ok = false;
+            else
+              hash_[slot] = members[k] + 1;
+          }
+          if (ok) break;
+          for (k = start[b]; k < start[b + 1]; k++) {   // (remove the keys placed with this seed)
+            slot = pathHash(p_[members[k]], seed) & (hashSize - 1);
+            if (hash_[slot] == members[k] + 1) hash_[slot] = 0;
+          }
+        }
+        disp_[b] = seed;
+      }
+    }
+  }
+};
+
+template <size_t N>
+constexpr ConstRegMap<N> makeConstRegMap(const lolan_VarDef (&defs)[N])
+{
+  return ConstRegMap<N>(defs);
+}
+
+} /* namespace lolan */
+
+#endif /* LOLAN_REGMAP_HPP_ */
@@ -149,6 +149,8 @@
  *
  */
 
+#define LOLAN_SET_STATUS_OFFSET  5   // maximum size of the root map header and the main status code entry in the reply
+
 
 /**************************************************************************//**
  * @brief
@@ -157,6 +159,10 @@
  *   This subroutine processes a SET command, automatically updates the
  *   requested variables and creates a reply packet structure filled up
  *   with information about the results of the action.
+ *   The command is processed in a single pass over the payload if the
+ *   zero key entry is the first entry of the root map (otherwise the zero
+ *   key entry is searched first). The status codes of a New Style reply
+ *   are encoded during the update of the variables.
  * @note
  *   In the reply packet structure the payload parameter should be
  *   assigned to a buffer with a minimum length of
@@ -175,10 +181,13 @@
  *    LOLAN_RETVAL_GENERROR: An error has occurred (e.g. pak is not a
  *      LoLaN SET packet).
  *    LOLAN_RETVAL_CBORERROR: A CBOR-related error has occurred.
+ *    LOLAN_RETVAL_NO: Retransmitted request whose reply is not cached
+ *      (it is not processed again), no reply should be sent (only with
+ *      LOLAN_DUPFILTER_SOURCES, see lolan-dupfilter.c).
  *****************************************************************************/
-int8_t lolan_processSet(lolan_ctx *ctx, lolan_Packet *pak, lolan_Packet *reply)
+int8_t lolan_processSet(lolan_ctx *ctx, const lolan_Packet *pak, lolan_Packet *reply)
 {
-  LR_SIZE_T i;
+  LR_SIZE_T i, index;
   int8_t err;
   uint8_t path[LOLAN_REGMAP_DEPTH], defLvl;
   uint16_t zerovalue;
@@ -189,11 +198,14 @@ int8_t lolan_processSet(lolan_ctx *ctx, lolan_Packet *pak, lolan_Packet *reply)
   bool problems;
   uint16_t code;
   lolan_BunchUpdateOutputStruct buStruct;
+  size_t statusSize;
 
   CborError cerr;
-  CborEncoder enc, map_enc;
+  CborEncoder enc, map_enc, status_enc;
   CborParser parser;
-  CborValue it, map_it;
+  CborValue it;
+  lolan_CborIndex idx;
+  lolan_CborCursor cur, map_cur;
 
   DLOG(("\n LoLaN SET:  "));
 
@@ -201,9 +213,43 @@ int8_t lolan_processSet(lolan_ctx *ctx, lolan_Packet *pak, lolan_Packet *reply)
     DLOG(("not a LoLaN SET packet"));
     return LOLAN_RETVAL_GENERROR;
   }
+#ifdef LOLAN_DUPFILTER_SOURCES
+  if (lolanDupFilterCheck(ctx, pak, reply, &err))   // retransmitted request: do not update the variables again
+    return err;
+#endif
+
+  /* validate the payload and enter the root map */
+  if (lolanCborValidate(&idx, pak->payload, pak->payloadSize) != LOLAN_RETVAL_YES) {
+    DLOG(("CBOR error"));
+    return LOLAN_RETVAL_CBORERROR;
+  }
+  lolanCborCursorRoot(&idx, &cur);
+  if (!LOLAN_CBOR_IS_MAP(&cur)) {   // the root entry must be a CBOR map
+    DLOG(("\n LoLaN CBOR packet error: root map not found"));
+    return LOLAN_RETVAL_GENERROR;
+  }
+  lolanCborCursorEnter(&cur, &map_cur);   // enter root map
 
   /* extract (base) path */
-  err = lolanGetZeroKeyEntryFromPayload(pak, path, &zerovalue, &oldStyle);   // (Old Style if a base path is specified)
+  key = -1;
+  if (!LOLAN_CBOR_AT_END(&map_cur) && LOLAN_CBOR_IS_INTEGER(&map_cur))
+    key = lolanCborCursorGetInt(&map_cur);   // get the first key
+  if (key == 0) {   // the first entry is the zero key entry
+    lolanCborCursorAdvance(&map_cur);   // advance cursor to data
+    if (LOLAN_CBOR_AT_END(&map_cur)) {   // unexpected end of root map (no data for key)
+      DLOG(("\n LoLaN CBOR packet error: key must be followed by data"));
+      return LOLAN_RETVAL_GENERROR;
+    }
+    if (lolanCborCursorValue(&map_cur, &parser, &it) != CborNoError) {
+      DLOG(("CBOR error"));
+      return LOLAN_RETVAL_CBORERROR;
+    }
+    err = lolanGetZeroKeyValueFromCbor(&it, path, &zerovalue, &oldStyle);   // (Old Style if a base path is specified)
+    if (err == LOLAN_RETVAL_YES)
+      lolanCborCursorAdvance(&map_cur);   // advance cursor to the next key
+  } else {   // search for the zero key entry (the cursor remains at the first entry)
+    err = lolanGetZeroKeyEntryFromCursor(&map_cur, path, &zerovalue, &oldStyle);
+  }
   switch (err)  {
     case LOLAN_RETVAL_YES:   // zero key entry got
       /* (nothing to do here) */
@@ -235,25 +281,10 @@ int8_t lolan_processSet(lolan_ctx *ctx, lolan_Packet *pak, lolan_Packet *reply)
       return LOLAN_RETVAL_GENERROR;
     }
 
-    /* initialize and enter the root map */
     if (!lolanIsPathValid(path)) {   // check path formal validity
       DLOG(("\n Formally invalid path in request."));
       return LOLAN_RETVAL_GENERROR;
     }
-    cerr = cbor_parser_init(pak->payload, pak->payloadSize, 0, &parser, &it);   // initialize CBOR parser
-    if (cerr != CborNoError) {
-      DLOG(("\n CBOR parse error"));
-      return LOLAN_RETVAL_CBORERROR;
-    }
-    if (cbor_value_get_type(&it) != CborMapType) {   // the root entry must be a CBOR map
-      DLOG(("\n LoLaN CBOR packet error: root map not found"));
-      return LOLAN_RETVAL_GENERROR;
-    }
-    cerr = cbor_value_enter_container(&it, &map_it);   // enter root map
-    if (cerr != CborNoError) {
-      DLOG(("\n CBOR parse error"));
-      return LOLAN_RETVAL_CBORERROR;
-    }
     /* initialize encoder and create root map */
     cbor_encoder_init(&enc, reply->payload, LOLAN_PACKET_MAX_PAYLOAD_SIZE, 0);  // initialize CBOR encoder for the reply
     cerr = cbor_encoder_create_map(&enc, &map_enc, CborIndefiniteLength);   // create root map
@@ -266,34 +297,33 @@ int8_t lolan_processSet(lolan_ctx *ctx, lolan_Packet *pak, lolan_Packet *reply)
     problems = false;
     success = 0;
     overall = 0;
-    while (!cbor_value_at_end(&map_it)) {   // until the end of root map is reached
+    while (!LOLAN_CBOR_AT_END(&map_cur)) {   // until the end of root map is reached
       /* extract key */
-      if (cbor_value_get_type(&map_it) != CborIntegerType) {  // check key of a key-data pair (must be integer)
+      if (!LOLAN_CBOR_IS_INTEGER(&map_cur)) {  // check key of a key-data pair (must be integer)
         DLOG(("\n LoLaN CBOR packet error: key has to be integer"));
         return LOLAN_RETVAL_GENERROR;
       }
-      cbor_value_get_int(&map_it, &key);   // get key
-      cerr = cbor_value_advance_fixed(&map_it);   // advance iterator to data
-      if (cerr != CborNoError) {
-        DLOG(("\n CBOR parse error"));
-        return LOLAN_RETVAL_CBORERROR;
-      }
-      if (cbor_value_at_end(&map_it)) {   // unexpected end of root map (no data for key)
+      key = lolanCborCursorGetInt(&map_cur);   // get key
+      lolanCborCursorAdvance(&map_cur);   // advance cursor to data
+      if (LOLAN_CBOR_AT_END(&map_cur)) {   // unexpected end of root map (no data for key)
         DLOG(("\n LoLaN CBOR packet error: key must be followed by data"));
         return LOLAN_RETVAL_GENERROR;
       }
       /* process key-data pair */
       if ((key <= 0) || (key > 255)) {   // key can not be a path element, or zero key found
         /* advance to the next key */
-        cerr = cbor_value_advance(&map_it);
-        if (cerr != CborNoError) {
-          DLOG(("\n CBOR parse error"));
-          return LOLAN_RETVAL_CBORERROR;
-        }
+        lolanCborCursorAdvance(&map_cur);
         if (key != 0) problems = true;  // set problem indicator
       } else {  // key is o.k.
         path[defLvl] = key;   // complete path with key
-        err = lolanVarUpdateFromCbor(ctx, path, &map_it, &exterr);  // update variable
+        index = lolanRegMapFindByPath(ctx, path);   // searching for the variable by path
+        if (index >= LOLAN_REGMAP_SIZE) {   // variable not found (the data is skipped by the cursor)
+          err = LOLAN_RETVAL_NO;
+          exterr = LVUFC_NOTFOUND;
+        } else {
+          err = lolanVarIndexUpdateFromCbor(ctx, index, &map_cur, &exterr);  // update variable
+        }
+        lolanCborCursorAdvance(&map_cur);   // advance cursor to the next key
         switch (err) {   // encode status code according to the result
           case LOLAN_RETVAL_YES:   // successfully updated
             code = 200;
@@ -317,7 +347,7 @@ int8_t lolan_processSet(lolan_ctx *ctx, lolan_Packet *pak, lolan_Packet *reply)
             }
             break;
           default:  // other errors
-            DLOG(("\n Error during lolanVarUpdateFromCbor()."));
+            DLOG(("\n Error during lolanVarIndexUpdateFromCbor()."));
             return err;
             break;
         }
@@ -378,15 +408,17 @@ int8_t lolan_processSet(lolan_ctx *ctx, lolan_Packet *pak, lolan_Packet *reply)
       return LOLAN_RETVAL_GENERROR;
     }
     /* clear the LOLAN_REGMAP_AUX_BIT flags */
-    for (i = 0; i < LOLAN_REGMAP_SIZE; i++)
-      ctx->regMap[i].flags &= ~(LOLAN_REGMAP_AUX_BIT);
+    lolanFlagClearAll(ctx, LOLAN_REGMAP_AUX_BIT);
 
     /* update the variables from CBOR with the new values nested by path  */
-    err = lolanVarBunchUpdateFromCbor(ctx, pak, &buStruct);   // the AUX flags are set on the affected variables
+    /* (the status codes are encoded after the space of the root map header and the main status code, 1 byte is left for closing the root map) */
+    cbor_encoder_init(&status_enc, reply->payload + LOLAN_SET_STATUS_OFFSET, LOLAN_PACKET_MAX_PAYLOAD_SIZE - LOLAN_SET_STATUS_OFFSET - 1, 0);
+    err = lolanVarBunchUpdateFromCbor(ctx, &map_cur, &status_enc, &buStruct);   // the AUX flags are set on the affected variables
     if (err != LOLAN_RETVAL_YES) {
       DLOG(("\n lolanVarBunchUpdateFromCbor() error"));
       return err;
     }
+    statusSize = cbor_encoder_get_buffer_size(&status_enc, reply->payload + LOLAN_SET_STATUS_OFFSET);
 
     /* initialize encoder and create root map */
     cbor_encoder_init(&enc, reply->payload, LOLAN_PACKET_MAX_PAYLOAD_SIZE, 0);  // initialize CBOR encoder for the reply
@@ -429,11 +461,18 @@ int8_t lolan_processSet(lolan_ctx *ctx, lolan_Packet *pak, lolan_Packet *reply)
         DLOG(("\n CBOR encode error"));
         return LOLAN_RETVAL_CBORERROR;
       }
-      /* (the AUX flag indicates that the variable is affected by the update process) */
-      err = lolanVarFlagToCbor(ctx, LOLAN_REGMAP_AUX_BIT, &map_enc, false, true);  // generate status codes in nested structure
-      if ((err != LOLAN_RETVAL_YES) && (err != LOLAN_RETVAL_NO)) {
-        DLOG(("\n lolanVarFlagToCbor() error"));
-        return err;
+      if (!buStruct.unsorted) {   // move the status codes encoded during the update after the main status code
+        memmove(map_enc.data.ptr, reply->payload + LOLAN_SET_STATUS_OFFSET, statusSize);
+        map_enc.data.ptr += statusSize;
+      } else {
+        /* (the AUX flag indicates that the variable is affected by the update process) */
+        map_enc.end = map_enc.data.ptr + LOLAN_PACKET_MAX_PAYLOAD_SIZE - LOLAN_SET_STATUS_OFFSET - 1;   // the same space as above (room for closing the root map)
+        err = lolanVarFlagToCbor(ctx, LOLAN_REGMAP_AUX_BIT, &map_enc, false, true);  // generate status codes in nested structure
+        map_enc.end = reply->payload + LOLAN_PACKET_MAX_PAYLOAD_SIZE;   // restore buffer size setting
+        if ((err != LOLAN_RETVAL_YES) && (err != LOLAN_RETVAL_NO)) {
+          DLOG(("\n lolanVarFlagToCbor() error"));
+          return err;
+        }
       }
     }
 
@@ -453,6 +492,9 @@ int8_t lolan_processSet(lolan_ctx *ctx, lolan_Packet *pak, lolan_Packet *reply)
   reply->toId = pak->fromId;
   reply->payloadSize = cbor_encoder_get_buffer_size(&enc, reply->payload);
   DLOG(("\n Encoded reply to %d bytes", reply->payloadSize));
+#ifdef LOLAN_DUPFILTER_SOURCES
+  lolanDupFilterStore(ctx, pak, reply);
+#endif
 
   return LOLAN_RETVAL_YES;
 } /* lolan_processSet */
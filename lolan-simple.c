@@ -18,9 +18,9 @@
  *   Search for data in a LoLaN CBOR structure and get it.
  * @note
  *   FOR INTERNAL USE ONLY.
- * @param[in] pak
- *   Pointer to the LoLaN packet structure which contains the packet to be
- *   processed.
+ * @param[in] map_cur
+ *   Pointer to the cursor at the first entry of the root map of the
+ *   validated payload (the cursor is not modified).
  * @param[in] rpath
  *   Address of the uint8_t array containing the path of the
  *   LoLaN variable to obtain. If the packet contains variable data
@@ -40,66 +40,52 @@
  *   LOLAN_RETVAL_GENERROR: An error has occurred.
  *   LOLAN_RETVAL_CBORERROR: A CBOR-related error has occurred.
  *****************************************************************************/
-static int8_t lolan_seekAndGet(lolan_Packet *pak, const uint8_t *rpath, uint8_t *data,
+static int8_t lolan_seekAndGet(const lolan_CborCursor *map_cur, const uint8_t *rpath, uint8_t *data,
           LV_SIZE_T data_max, LV_SIZE_T *data_len, uint8_t *type)
 {
   uint8_t path[LOLAN_REGMAP_DEPTH];
   uint8_t i, alevel;
   int key;
 
-  CborParser parser;
-  CborValue root_it, it[LOLAN_REGMAP_DEPTH];
-  CborError cerr;
+  lolan_CborCursor cur[LOLAN_REGMAP_DEPTH];
 
-  /* initialize and enter the root container (map) */
-  cerr = cbor_parser_init(pak->payload, pak->payloadSize, 0, &parser, &root_it);  // initialize CBOR parser
-  if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-  if (cbor_value_get_type(&root_it) != CborMapType) return LOLAN_RETVAL_GENERROR;   // the root entry must be a CBOR map
-  cerr = cbor_value_enter_container(&root_it, &it[0]);   // enter root map
-  if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
+  cur[0] = *map_cur;   // (the root map level)
 
   /* process the nested CBOR structure */
   alevel = 0;  // address level is 0 at this point
-  while (!((alevel == 0) && cbor_value_at_end(&it[alevel]))) {   // until entries are available in the root map level
+  while (!((alevel == 0) && LOLAN_CBOR_AT_END(&cur[alevel]))) {   // until entries are available in the root map level
     /* check for end of container */
-    if (cbor_value_at_end(&it[alevel])) {   // end of map (alevel is always >0 at this point)
-      cerr = cbor_value_leave_container(&it[alevel-1], &it[alevel]);   // leave container
+    if (LOLAN_CBOR_AT_END(&cur[alevel])) {   // end of map (alevel is always >0 at this point)
+      lolanCborCursorLeave(&cur[alevel-1], &cur[alevel]);   // leave container
       alevel--;  // decrement current address level
-      if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
       continue;
     }
     /* extract key */
-    if (cbor_value_get_type(&it[alevel]) != CborIntegerType) return LOLAN_RETVAL_GENERROR;  // check key of a key-data pair (must be integer)
-    cbor_value_get_int(&it[alevel], &key);   // get key
-    cerr = cbor_value_advance_fixed(&it[alevel]);   // advance iterator to data
-    if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-    if (cbor_value_at_end(&it[alevel])) return LOLAN_RETVAL_GENERROR;   // unexpected end of map (no data for key)
+    if (!LOLAN_CBOR_IS_INTEGER(&cur[alevel])) return LOLAN_RETVAL_GENERROR;  // check key of a key-data pair (must be integer)
+    key = lolanCborCursorGetInt(&cur[alevel]);   // get key
+    lolanCborCursorAdvance(&cur[alevel]);   // advance cursor to data
+    if (LOLAN_CBOR_AT_END(&cur[alevel])) return LOLAN_RETVAL_GENERROR;   // unexpected end of map (no data for key)
     /* process key-data pair */
     if ((key <= 0) || (key > 255)) {   // zero key found, or key can not be a path element
       /* advance to the next key */
-      cerr = cbor_value_advance(&it[alevel]);
-      if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
+      lolanCborCursorAdvance(&cur[alevel]);
     } else {   // other key found
       path[alevel] = key;  // store path element
-      if (cbor_value_get_type(&it[alevel]) == CborMapType) {  // the data is a map -> subpath branch
+      if (LOLAN_CBOR_IS_MAP(&cur[alevel])) {  // the data is a map -> subpath branch
         if (alevel < LOLAN_REGMAP_DEPTH-1) {  // entering a lower path level is o.k.
-          cerr = cbor_value_enter_container(&it[alevel], &it[alevel+1]);   // enter map
-          if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
+          lolanCborCursorEnter(&cur[alevel], &cur[alevel+1]);   // enter map
           alevel++;  // increment current address level
         } else {  // can not enter a lower path, skip this sub-branch
-          cerr = cbor_value_advance(&it[alevel]);   // skip map
-          if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
+          lolanCborCursorAdvance(&cur[alevel]);   // skip map
         }
       } else {  // the data is not a map (may be valid data)
         for (i = alevel+1; i < LOLAN_REGMAP_DEPTH; i++)   // correct path with zeros if needed
           path[i] = 0;
-        if (rpath == NULL) {   // do not care the path, just return the position of data
-          return lolanGetDataFromCbor(&it[alevel], data, data_max, data_len, type);    // get data
-        } else {   // data with only the specified path is needed
-          if (memcmp(path, rpath, LOLAN_REGMAP_DEPTH) == 0) {   // the specified path is found
-            return lolanGetDataFromCbor(&it[alevel], data, data_max, data_len, type);    // get data
-          }
+        /* data with any path (rpath == NULL), or with the specified path is needed */
+        if ((rpath == NULL) || (memcmp(path, rpath, LOLAN_REGMAP_DEPTH) == 0)) {
+          return lolanGetDataFromCbor(&cur[alevel], data, data_max, data_len, type);    // get data
         }
+        lolanCborCursorAdvance(&cur[alevel]);   // skip the data of an other path
       }
     }
   }
@@ -237,12 +223,11 @@ int8_t lolan_simpleCreateSet(lolan_ctx *ctx, lolan_Packet *pak, const uint8_t *p
  *     LoLaN ACK packet).
  *   LOLAN_RETVAL_CBORERROR: A CBOR-related error has occurred.
  *****************************************************************************/
-int8_t lolan_simpleProcessAck(lolan_Packet *pak, uint8_t *data, LV_SIZE_T data_max,
+int8_t lolan_simpleProcessAck(const lolan_Packet *pak, uint8_t *data, LV_SIZE_T data_max,
              LV_SIZE_T *data_len, uint8_t *type, bool *zerokey)
 {
-  CborParser parser;
-  CborValue it;
-  CborError cerr;
+  lolan_CborIndex idx;
+  lolan_CborCursor cur, map_cur;
 
   int8_t err;
   uint16_t zerovalue;
@@ -252,18 +237,19 @@ int8_t lolan_simpleProcessAck(lolan_Packet *pak, uint8_t *data, LV_SIZE_T data_m
   if (data_max != 0 && data_max < 8) return LOLAN_RETVAL_GENERROR;  // (see description of data_max)
 
   /* determine reply type */
-  cerr = cbor_parser_init(pak->payload, pak->payloadSize, 0, &parser, &it);   // initialize CBOR parser
-  if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-  if (cbor_value_get_type(&it) != CborMapType) {   // no root map found
+  if (lolanCborValidate(&idx, pak->payload, pak->payloadSize) != LOLAN_RETVAL_YES) return LOLAN_RETVAL_CBORERROR;
+  lolanCborCursorRoot(&idx, &cur);
+  if (!LOLAN_CBOR_IS_MAP(&cur)) {   // no root map found
     /* may be a short GET reply */
     *zerokey = false;
-    return lolanGetDataFromCbor(&it, data, data_max, data_len, type);   // try to get data
+    return lolanGetDataFromCbor(&cur, data, data_max, data_len, type);   // try to get data
   } else {   // root map found
+    lolanCborCursorEnter(&cur, &map_cur);   // enter root map
     /* search for zero key entry */
-    err = lolanGetZeroKeyEntryFromPayload(pak, NULL, &zerovalue, NULL);   // (path in zero key entry is not acceptable)
+    err = lolanGetZeroKeyEntryFromCursor(&map_cur, NULL, &zerovalue, NULL);   // (path in zero key entry is not acceptable)
     if (err != LOLAN_RETVAL_YES) return LOLAN_RETVAL_GENERROR;   // zero key entry with integer data must exist
     /* look for other entries */
-    err = lolan_seekAndGet(pak, NULL, data, data_max, data_len, type);   // try to detect any data
+    err = lolan_seekAndGet(&map_cur, NULL, data, data_max, data_len, type);   // try to detect any data
     switch (err) {
       case LOLAN_RETVAL_YES:   // data found
         *zerokey = false;
@@ -314,19 +300,27 @@ int8_t lolan_simpleProcessAck(lolan_Packet *pak, uint8_t *data, LV_SIZE_T data_m
  *   LOLAN_RETVAL_GENERROR: An error has occurred (e.g. invalid INFORM packet).
  *   LOLAN_RETVAL_CBORERROR: A CBOR-related error has occurred.
  *****************************************************************************/
-int8_t lolan_simpleExtractFromInform(lolan_Packet *pak, const uint8_t *path, uint8_t *data,
+int8_t lolan_simpleExtractFromInform(const lolan_Packet *pak, const uint8_t *path, uint8_t *data,
                   LV_SIZE_T data_max, LV_SIZE_T *data_len, uint8_t *type)
 {
   int8_t err;
   uint8_t xpath[LOLAN_REGMAP_DEPTH];
   uint16_t zerovalue;
   bool isPath;
+  lolan_CborIndex idx;
+  lolan_CborCursor cur, map_cur;
 
   /* error checking */
   if (data_max != 0 && data_max < 8) return LOLAN_RETVAL_GENERROR;  // (see description of data_max)
 
+  /* validate the payload and enter the root container (map) */
+  if (lolanCborValidate(&idx, pak->payload, pak->payloadSize) != LOLAN_RETVAL_YES) return LOLAN_RETVAL_CBORERROR;
+  lolanCborCursorRoot(&idx, &cur);
+  if (!LOLAN_CBOR_IS_MAP(&cur)) return LOLAN_RETVAL_GENERROR;   // the root entry must be a CBOR map
+  lolanCborCursorEnter(&cur, &map_cur);
+
   /* get base path or code from zero key entry */
-  err = lolanGetZeroKeyEntryFromPayload(pak, xpath, &zerovalue, &isPath);
+  err = lolanGetZeroKeyEntryFromCursor(&map_cur, xpath, &zerovalue, &isPath);
   switch (err) {
     case LOLAN_RETVAL_YES:   // zero key entry found
       break;
@@ -358,9 +352,45 @@ int8_t lolan_simpleExtractFromInform(lolan_Packet *pak, const uint8_t *path, uin
   }
 
   /* looking for data (xpath now contains the path for search) */
-  return lolan_seekAndGet(pak, xpath, data, data_max, data_len, type);
+  return lolan_seekAndGet(&map_cur, xpath, data, data_max, data_len, type);
 } /* lolan_simpleExtractFromInform */
 
+typedef struct {        // state of lolan_simpleProcessInform()
+  uint8_t *buffer;
+  LV_SIZE_T bufSize;
+  lspiCallback callback;
+} lolan_SimpleInformWalk;
+
+/**************************************************************************//**
+ * @brief
+ *   Obtain the data of an INFORM entry and pass it to the callback of
+ *   lolan_simpleProcessInform().
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ * @param[in] arg
+ *   Pointer to the lolan_SimpleInformWalk structure.
+ * @param[in] path
+ *   Variable path array.
+ * @param[in] cur
+ *   Pointer to the cursor at the data.
+ * @return
+ *   See lolanGetDataFromCbor().
+ *****************************************************************************/
+static int8_t lolan_simpleInformLeaf(void *arg, const uint8_t *path, const lolan_CborCursor *cur)
+{
+  lolan_SimpleInformWalk *walk = arg;
+  uint8_t cPath[LOLAN_REGMAP_DEPTH];
+  uint8_t type;
+  LV_SIZE_T dataLen;
+  int8_t err;
+
+  err = lolanGetDataFromCbor(cur, walk->buffer, walk->bufSize, &dataLen, &type);    // get data
+  if (err != LOLAN_RETVAL_YES) return err;   // error check
+  memcpy(cPath, path, LOLAN_REGMAP_DEPTH);   // (the callback gets a modifiable copy)
+  walk->callback(cPath, walk->buffer, dataLen, type);   // call handler
+  return LOLAN_RETVAL_YES;
+} /* lolan_simpleInformLeaf */
+
 /**************************************************************************//**
  * @brief
  *   Extract all data from a LoLaN INFORM packet payload.
@@ -390,109 +420,24 @@ int8_t lolan_simpleExtractFromInform(lolan_Packet *pak, const uint8_t *path, uin
  *   LOLAN_RETVAL_GENERROR: An error has occurred (e.g. invalid INFORM packet).
  *   LOLAN_RETVAL_CBORERROR: A CBOR-related error has occurred.
  *****************************************************************************/
-int8_t lolan_simpleProcessInform(lolan_Packet *pak, uint8_t *buffer, LV_SIZE_T bufSize, lspiCallback callback)
+int8_t lolan_simpleProcessInform(const lolan_Packet *pak, uint8_t *buffer, LV_SIZE_T bufSize, lspiCallback callback)
 {
-  int8_t err;
-  uint8_t basePath[LOLAN_REGMAP_DEPTH], path[LOLAN_REGMAP_DEPTH], cPath[LOLAN_REGMAP_DEPTH];
-  uint16_t zeroValue;
-  bool zeroIsPath;
-  bool foundSomething;
-
-  uint8_t i, alevel;
-  int key;
-
-  CborParser parser;
-  CborValue root_it, it[LOLAN_REGMAP_DEPTH];
-  CborError cerr;
+  lolan_SimpleInformWalk walk;
+  lolan_CborIndex idx;
+  lolan_CborCursor cur, map_cur;
 
   /* error checking */
   if (bufSize != 0 && bufSize < 8) return LOLAN_RETVAL_GENERROR;  // (see description of data_max)
 
-  /* get base path or code from zero key entry */
-  err = lolanGetZeroKeyEntryFromPayload(pak, basePath, &zeroValue, &zeroIsPath);
-  switch (err) {
-    case LOLAN_RETVAL_YES:   // zero key entry found
-      if (!zeroIsPath)    // new style INFORM, check number at zero key
-        if (zeroValue != 299) return LOLAN_RETVAL_GENERROR;   // the zero key should contain the status code 299
-      break;
-    case LOLAN_RETVAL_NO:   // no zero key entry
-      /* legacy style INFORM, the base path is the root */
-      memset(basePath, 0, LOLAN_REGMAP_DEPTH);
-      zeroIsPath = true;
-      break;
-    default:   // error
-      return err;
-      break;
-  }
-
-  /* initialize and enter the root container (map) */
-  cerr = cbor_parser_init(pak->payload, pak->payloadSize, 0, &parser, &root_it);  // initialize CBOR parser
-  if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-  if (cbor_value_get_type(&root_it) != CborMapType) return LOLAN_RETVAL_GENERROR;   // the root entry must be a CBOR map
-  cerr = cbor_value_enter_container(&root_it, &it[0]);   // enter root map
-  if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
+  /* validate the payload and enter the root container (map) */
+  if (lolanCborValidate(&idx, pak->payload, pak->payloadSize) != LOLAN_RETVAL_YES) return LOLAN_RETVAL_CBORERROR;
+  lolanCborCursorRoot(&idx, &cur);
+  if (!LOLAN_CBOR_IS_MAP(&cur)) return LOLAN_RETVAL_GENERROR;   // the root entry must be a CBOR map
+  lolanCborCursorEnter(&cur, &map_cur);   // enter root map
 
   /* process the nested CBOR structure */
-  foundSomething = false;
-  alevel = 0;  // address level is 0 at this point
-  while (!((alevel == 0) && cbor_value_at_end(&it[alevel]))) {   // until entries are available in the root map level
-    /* check for end of container */
-    if (cbor_value_at_end(&it[alevel])) {   // end of map (alevel is always >0 at this point)
-      cerr = cbor_value_leave_container(&it[alevel-1], &it[alevel]);   // leave container
-      alevel--;  // decrement current address level
-      if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-      continue;
-    }
-    /* extract key */
-    if (cbor_value_get_type(&it[alevel]) != CborIntegerType) return LOLAN_RETVAL_GENERROR;  // check key of a key-data pair (must be integer)
-    cbor_value_get_int(&it[alevel], &key);   // get key
-    cerr = cbor_value_advance_fixed(&it[alevel]);   // advance iterator to data
-    if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-    if (cbor_value_at_end(&it[alevel])) return LOLAN_RETVAL_GENERROR;   // unexpected end of map (no data for key)
-    /* process key-data pair */
-    if ((key <= 0) || (key > 255)) {   // zero key found, or key can not be a path element
-      /* advance to the next key */
-      cerr = cbor_value_advance(&it[alevel]);
-      if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-    } else {   // other key found
-      path[alevel] = key;  // store path element
-      if (cbor_value_get_type(&it[alevel]) == CborMapType) {  // the data is a map -> subpath branch
-        if (alevel < LOLAN_REGMAP_DEPTH-1) {  // entering a lower path level is o.k.
-          cerr = cbor_value_enter_container(&it[alevel], &it[alevel+1]);   // enter map
-          if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-          alevel++;  // increment current address level
-        } else {  // can not enter a lower path, skip this sub-branch
-          cerr = cbor_value_advance(&it[alevel]);   // skip map
-          if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-        }
-      } else {  // the data is not a map (may be valid data)
-        uint8_t defLvl, type;
-        LV_SIZE_T dataLen;
-
-        foundSomething = true;
-        /* assemble path */
-        if (zeroIsPath) {   // legacy style INFORM, need to combine base with path
-          defLvl = lolanPathDefinitionLevel(NULL, basePath, NULL, false);   // get base path definition level
-          memcpy(cPath, basePath, defLvl);   // copy base part
-          memcpy(cPath + defLvl, path, LOLAN_REGMAP_DEPTH - defLvl);   // copy others
-          for (i = defLvl+alevel+1; i < LOLAN_REGMAP_DEPTH; i++)   // correct path with zeros if needed
-            cPath[i] = 0;
-        } else {   // new style INFORM, just copy path
-          memcpy(cPath, path, LOLAN_REGMAP_DEPTH);
-          for (i = alevel+1; i < LOLAN_REGMAP_DEPTH; i++)   // correct path with zeros if needed
-            cPath[i] = 0;
-        }
-        /* obtain data and pass it to the callback */
-        err = lolanGetDataFromCbor(&it[alevel], buffer, bufSize, &dataLen, &type);    // get data
-        if (err != LOLAN_RETVAL_YES) return err;   // error check
-        callback(cPath, buffer, dataLen, type);   // call handler
-      }
-    }
-  }
-
-  /* return */
-  if (foundSomething)   // not an empty INFORM
-    return LOLAN_RETVAL_YES;
-  else   // it was an empty INFORM
-    return LOLAN_RETVAL_NO;
+  walk.buffer = buffer;
+  walk.bufSize = bufSize;
+  walk.callback = callback;
+  return lolanWalkInformPayload(&map_cur, lolan_simpleInformLeaf, &walk);   // (LOLAN_RETVAL_NO if it was an empty INFORM)
 } /* lolan_simpleProcessInform */
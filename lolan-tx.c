@@ -0,0 +1,270 @@
+/**************************************************************************//**
+ * @file lolan-tx.c
+ * @brief LoLaN ACK/retransmit engine
+ * @author Sunstone-RTLS Ltd.
+ ******************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "lolan_config.h"
+#include "lolan.h"
+
+#ifdef LOLAN_TX_SLOTS
+
+/*
+ * LoLaN ACK/retransmit engine
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ *   The engine stores the submitted GET and SET requests (at most
+ *   LOLAN_TX_SLOTS) until their ACK is received. At most 'window' requests
+ *   are in flight to the same destination, the others are queued and sent
+ *   in submission order.
+ *
+ *   A request without ACK is retransmitted (with the same packet counter)
+ *   when its retransmission timeout expires, the timeout is doubled on
+ *   every retransmission (up to 8 times the initial timeout). After
+ *   'maxTries' transmissions the request fails.
+ *
+ *   The engine has no clock: the current time is passed to the functions
+ *   (in any time unit, e.g. milliseconds; it may wrap around), and
+ *   lolan_txPoll() has to be called periodically.
+ */
+
+#define LOLAN_TX_BACKOFF_MAX   8   // maximum retransmission timeout (multiple of the initial timeout)
+
+
+/**************************************************************************//**
+ * @brief
+ *   Initialize an ACK/retransmit engine.
+ * @param[out] tx
+ *   Pointer to the transmit engine.
+ * @param[in] send
+ *   Function which sends a packet (e.g. with lolan_createPacket()).
+ * @param[in] sendArg
+ *   Argument of the send function.
+ * @param[in] timeout
+ *   Initial retransmission timeout (in the time unit of the other
+ *   functions).
+ * @param[in] maxTries
+ *   Maximum number of transmissions of a request.
+ * @param[in] window
+ *   Maximum number of requests in flight per destination.
+ *****************************************************************************/
+void lolan_txInit(lolan_TxEngine *tx, lolan_TxSendFunc send, void *sendArg,
+                uint32_t timeout, uint8_t maxTries, uint8_t window)
+{
+  memset(tx, 0, sizeof(lolan_TxEngine));   // (all slots are free)
+  tx->send = send;
+  tx->sendArg = sendArg;
+  tx->timeout = timeout;
+  tx->maxTries = (maxTries > 0) ? maxTries : 1;
+  tx->window = (window > 0) ? window : 1;
+} /* lolan_txInit */
+
+/**************************************************************************//**
+ * @brief
+ *   Send the queued requests of a destination while its window allows.
+ * @param[in,out] tx
+ *   Pointer to the transmit engine.
+ * @param[in] toId
+ *   The destination address.
+ * @param[in] now
+ *   The current time.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ *****************************************************************************/
+static void lolanTxStartQueued(lolan_TxEngine *tx, uint16_t toId, uint32_t now)
+{
+  lolan_TxSlot *next;
+  uint8_t i, inFlight;
+
+  for (;;) {
+    inFlight = 0;
+    next = NULL;
+    for (i = 0; i < LOLAN_TX_SLOTS; i++) {
+      if ((tx->slot[i].state == LOLAN_TXS_FREE) || (tx->slot[i].packet.toId != toId))
+        continue;
+      if (tx->slot[i].state == LOLAN_TXS_INFLIGHT)
+        inFlight++;
+      else if ((next == NULL) || ((int32_t) (tx->slot[i].seq - next->seq) < 0))   // oldest queued request
+        next = &tx->slot[i];
+    }
+    if ((next == NULL) || (inFlight >= tx->window))
+      return;
+
+    next->state = LOLAN_TXS_INFLIGHT;
+    next->tries = 1;
+    next->deadline = now + next->rto;
+    tx->send(tx->sendArg, &next->packet);
+  }
+} /* lolanTxStartQueued */
+
+/**************************************************************************//**
+ * @brief
+ *   Submit a GET or SET request to an ACK/retransmit engine.
+ * @details
+ *   The request is copied into the engine (the ackRequired flag is set),
+ *   it is sent immediately if the window of its destination allows,
+ *   otherwise it is queued.
+ *   The completion callback is called with the status:
+ *     LOLAN_RETVAL_YES:  The ACK is received (ack points to it).
+ *     LOLAN_RETVAL_NO:   No ACK received after maxTries transmissions
+ *                        (ack is NULL).
+ *   A new request can be submitted from the completion callback.
+ * @param[in,out] tx
+ *   Pointer to the transmit engine.
+ * @param[in] lp
+ *   Pointer to the LoLaN packet structure of the request (e.g. created by
+ *   lolan_createGet()).
+ * @param[in] now
+ *   The current time.
+ * @param[in] done
+ *   Completion callback (NULL: none).
+ * @param[in] doneArg
+ *   Argument of the completion callback.
+ * @return
+ *   LOLAN_RETVAL_YES:       The request is submitted.
+ *   LOLAN_RETVAL_GENERROR:  The packet is not a GET or SET request, or it
+ *                           is a multipart packet.
+ *   LOLAN_RETVAL_MEMERROR:  No free slot in the engine.
+ *****************************************************************************/
+int8_t lolan_txSubmit(lolan_TxEngine *tx, const lolan_Packet *lp, uint32_t now,
+                lolan_TxDoneFunc done, void *doneArg)
+{
+  lolan_TxSlot *slot;
+  uint8_t i;
+
+  if (((lp->packetType != LOLAN_PAK_GET) && (lp->packetType != LOLAN_PAK_SET)) ||
+      (lp->multiPart != LOLAN_MPC_NOMULTIPART) || (lp->payloadSize > LOLAN_PACKET_MAX_PAYLOAD_SIZE))
+    return LOLAN_RETVAL_GENERROR;
+
+  slot = NULL;
+  for (i = 0; (i < LOLAN_TX_SLOTS) && (slot == NULL); i++) {
+    if (tx->slot[i].state == LOLAN_TXS_FREE)
+      slot = &tx->slot[i];
+  }
+  if (slot == NULL) {
+    DLOG(("\n lolan_txSubmit(): no free slot"));
+    return LOLAN_RETVAL_MEMERROR;
+  }
+
+  slot->packet = *lp;
+  memcpy(slot->data, lp->payload, lp->payloadSize);
+  slot->packet.payload = slot->data;
+  slot->packet.ackRequired = true;
+  slot->seq = tx->seq++;
+  slot->rto = tx->timeout;
+  slot->tries = 0;
+  slot->done = done;
+  slot->doneArg = doneArg;
+  slot->state = LOLAN_TXS_QUEUED;
+
+  lolanTxStartQueued(tx, lp->toId, now);
+  return LOLAN_RETVAL_YES;
+} /* lolan_txSubmit */
+
+/**************************************************************************//**
+ * @brief
+ *   Complete a request of the transmit engine.
+ * @param[in,out] tx
+ *   Pointer to the transmit engine.
+ * @param[in] slot
+ *   The slot of the request.
+ * @param[in] ack
+ *   Pointer to the ACK packet (NULL: no ACK received).
+ * @param[in] now
+ *   The current time.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ *****************************************************************************/
+static void lolanTxComplete(lolan_TxEngine *tx, lolan_TxSlot *slot, const lolan_Packet *ack, uint32_t now)
+{
+  if (slot->done != NULL)   // (the slot is still used, a new request gets another one)
+    slot->done(slot->doneArg, &slot->packet, ack, (ack != NULL) ? LOLAN_RETVAL_YES : LOLAN_RETVAL_NO);
+  slot->state = LOLAN_TXS_FREE;
+  lolanTxStartQueued(tx, slot->packet.toId, now);
+} /* lolanTxComplete */
+
+/**************************************************************************//**
+ * @brief
+ *   Process a received packet with an ACK/retransmit engine.
+ * @details
+ *   If the packet is the ACK of a request in flight, the completion
+ *   callback of the request is called and the next queued request of the
+ *   destination is sent.
+ * @param[in,out] tx
+ *   Pointer to the transmit engine.
+ * @param[in] ack
+ *   Pointer to the received LoLaN packet structure.
+ * @param[in] now
+ *   The current time.
+ * @return
+ *   LOLAN_RETVAL_YES:  The packet is the ACK of a request.
+ *   LOLAN_RETVAL_NO:   The packet is not an ACK of a request in flight
+ *                      (e.g. a duplicated ACK).
+ *****************************************************************************/
+int8_t lolan_txAck(lolan_TxEngine *tx, const lolan_Packet *ack, uint32_t now)
+{
+  uint8_t i;
+
+  if (ack->packetType != LOLAN_PAK_ACK)
+    return LOLAN_RETVAL_NO;
+
+  for (i = 0; i < LOLAN_TX_SLOTS; i++) {
+    if ((tx->slot[i].state == LOLAN_TXS_INFLIGHT) && (tx->slot[i].packet.packetCounter == ack->packetCounter) &&
+        (tx->slot[i].packet.toId == ack->fromId) && (tx->slot[i].packet.fromId == ack->toId)) {
+      lolanTxComplete(tx, &tx->slot[i], ack, now);
+      return LOLAN_RETVAL_YES;
+    }
+  }
+  return LOLAN_RETVAL_NO;
+} /* lolan_txAck */
+
+/**************************************************************************//**
+ * @brief
+ *   Handle the expired retransmission timeouts of an ACK/retransmit engine.
+ * @details
+ *   The requests without ACK are retransmitted, or they fail after
+ *   maxTries transmissions. This function should be called periodically,
+ *   at the latest after the returned time.
+ * @param[in,out] tx
+ *   Pointer to the transmit engine.
+ * @param[in] now
+ *   The current time.
+ * @return
+ *   The time until the next retransmission timeout, UINT32_MAX if no
+ *   request is in flight.
+ *****************************************************************************/
+uint32_t lolan_txPoll(lolan_TxEngine *tx, uint32_t now)
+{
+  lolan_TxSlot *slot;
+  uint32_t wait;
+  uint8_t i;
+
+  for (i = 0; i < LOLAN_TX_SLOTS; i++) {
+    slot = &tx->slot[i];
+    if ((slot->state != LOLAN_TXS_INFLIGHT) || ((int32_t) (now - slot->deadline) < 0))
+      continue;
+    if (slot->tries >= tx->maxTries) {   // failed
+      DLOG(("\n lolan_txPoll(): no ACK from %d", slot->packet.toId));
+      lolanTxComplete(tx, slot, NULL, now);
+      continue;
+    }
+    if ((slot->rto <= UINT32_MAX / 2) && (slot->rto < tx->timeout * LOLAN_TX_BACKOFF_MAX))   // backoff
+      slot->rto <<= 1;
+    slot->tries++;
+    slot->deadline = now + slot->rto;
+    tx->send(tx->sendArg, &slot->packet);
+  }
+
+  wait = UINT32_MAX;
+  for (i = 0; i < LOLAN_TX_SLOTS; i++) {
+    slot = &tx->slot[i];
+    if ((slot->state == LOLAN_TXS_INFLIGHT) && ((uint32_t) (slot->deadline - now) < wait))
+      wait = ((int32_t) (slot->deadline - now) > 0) ? slot->deadline - now : 0;
+  }
+  return wait;
+} /* lolan_txPoll */
+
+#endif
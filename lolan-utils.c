@@ -17,11 +17,19 @@
 typedef enum {        // auxiliary enumeration for addCborItemNestedPath() function
   LVTCNPAUX_INITIAL,    // do the initialization and add the current item
   LVTCNPAUX_NORMAL,     // next items
-  LVTCNPAUX_FINALIZE,   // the recent was the last item, do the finalization
-  LVTCNPAUX_BACKUP,       // save the internal state of the function
-  LVTCNPAUX_RESTORE     // restore the saved internal state of the function
+  LVTCNPAUX_NORMAL_FIT, // next items, only if it fits in the buffer with the finalization
+  LVTCNPAUX_FINALIZE    // the recent was the last item, do the finalization
 } lolanVarToCborNestedPath_aux;
 
+typedef struct {      // state of a nested path CBOR encoding (owned by the caller of lolanVarToCborNestedPath())
+  CborEncoder nested_enc[LOLAN_REGMAP_DEPTH];   // encoders of the open maps (the first is the parent encoder)
+  uint8_t last_path[LOLAN_REGMAP_DEPTH];        // path of the previous variable
+  uint8_t last_defLvl;                          // definition level of the previous variable
+} lolanVarToCborNestedPath_state;
+
+static int8_t lolanVarToCborNestedPath(lolan_ctx *ctx, lolanVarToCborNestedPath_state *stv, LR_SIZE_T index,
+           CborEncoder *encoder, lolanVarToCborNestedPath_aux action, bool statusCodeInstead);
+
 
 /**************************************************************************//**
  * @brief
@@ -85,6 +93,7 @@ uint8_t lolanPathDefinitionLevel(lolan_ctx *ctx, const uint8_t *path, LR_SIZE_T
 {
   LR_SIZE_T i;
   uint8_t defLvl;
+  lolan_SubtreeIterator st;
 
   /* determine the definition level (no check for invalid paths) */
   for (i = 0; i < LOLAN_REGMAP_DEPTH; i++)
@@ -92,17 +101,13 @@ uint8_t lolanPathDefinitionLevel(lolan_ctx *ctx, const uint8_t *path, LR_SIZE_T
   defLvl = i;
   /* count the number of occurrences */
   if (occurrences != NULL) {
-    *occurrences = 0;
-    for (i = 0; i < LOLAN_REGMAP_SIZE; i++) {
-      if ( (memcmp(ctx->regMap[i].p, path, defLvl) == 0) &&       // (on defLvL=0 memcmp returns 0)
-           (ctx->regMap[i].p[0] != 0)                       ) {   // register map entry is valid
-        if (!occ_maxrec)    // no restriction for maximum recursion depth
-          (*occurrences)++;
-          else {   // only variables within the maxiumum recursion level below the base path are counted
-            if (lolanPathDefinitionLevel(NULL, ctx->regMap[i].p, NULL, false) <= defLvl + LOLAN_REGMAP_RECURSION)  // (recursive call)
-              (*occurrences)++;
-        }
-      }
+    lolanSubtreeInit(ctx, &st, path, occ_maxrec);
+    if (!occ_maxrec) {   // no restriction for maximum recursion depth
+      *occurrences = st.end - st.next;   // (the size of the subtree range)
+    } else {   // only variables within the maxiumum recursion level below the base path are counted
+      *occurrences = 0;
+      while (lolanSubtreeNext(ctx, &st) < LOLAN_REGMAP_SIZE)
+        (*occurrences)++;
     }
   }
 
@@ -145,19 +150,16 @@ LR_SIZE_T lolanVarFlagCount(lolan_ctx *ctx, uint16_t flags, bool *dlbpsame,
 
   found = 0;
   if (dlbpsame != NULL) *dlbpsame = true;
-  for (i = 0; i < LOLAN_REGMAP_SIZE; i++) {
-    if ( ((ctx->regMap[i].flags & flags) == flags)      // variable found with the specified flags
-         && (ctx->regMap[i].p[0] != 0) ) {              // (not a free entry)
-      found++;
-      if ((dlbpsame != NULL) && *dlbpsame) {  // if definition level and base path is the same so far (spare computing if not)
-        if (found == 1) {  // first
-          defLvl = lolanPathDefinitionLevel(ctx, ctx->regMap[i].p, NULL, false);  // get and store definition level
-          memcpy(bpsave, ctx->regMap[i].p, defLvl-1);   // store base path
-        } else {  // not first
-          if ( !( (lolanPathDefinitionLevel(ctx, ctx->regMap[i].p, NULL, false) == defLvl)  // not the same definition level
-                  && (memcmp(ctx->regMap[i].p, bpsave, defLvl-1) == 0) ) )    //  or not the same base path
-            *dlbpsame = false;   // clear indicator
-        }
+  for (i = lolanFlagNext(ctx, flags, 0); i < LOLAN_REGMAP_SIZE; i = lolanFlagNext(ctx, flags, i+1)) {   // variables found with the specified flags
+    found++;
+    if ((dlbpsame != NULL) && *dlbpsame) {  // if definition level and base path is the same so far (spare computing if not)
+      if (found == 1) {  // first
+        defLvl = lolanPathDefinitionLevel(ctx, LRM_P(ctx, i), NULL, false);  // get and store definition level
+        memcpy(bpsave, LRM_P(ctx, i), defLvl-1);   // store base path
+      } else {  // not first
+        if ( !( (lolanPathDefinitionLevel(ctx, LRM_P(ctx, i), NULL, false) == defLvl)  // not the same definition level
+                && (memcmp(LRM_P(ctx, i), bpsave, defLvl-1) == 0) ) )    //  or not the same base path
+          *dlbpsame = false;   // clear indicator
       }
     }
   }
@@ -178,14 +180,14 @@ LR_SIZE_T lolanVarFlagCount(lolan_ctx *ctx, uint16_t flags, bool *dlbpsame,
  ******************************************************************************/
 static uint16_t getLolanSetStatusCodeForVariable(lolan_ctx *ctx, LR_SIZE_T index)
 {
-  if (ctx->regMap[index].flags & LOLAN_REGMAP_AUX_BIT) {
-    if (ctx->regMap[index].flags & LOLAN_REGMAP_REMOTE_UPDATE_BIT)
+  if (LRM_FLAGS(ctx, index) & LOLAN_REGMAP_AUX_BIT) {
+    if (LRM_FLAGS(ctx, index) & LOLAN_REGMAP_REMOTE_UPDATE_BIT)
       return 200;  // update o.k.
-    if (ctx->regMap[index].flags & LOLAN_REGMAP_REMOTE_READONLY_BIT)
+    if (LRM_FLAGS(ctx, index) & LOLAN_REGMAP_REMOTE_READONLY_BIT)
       return 405;  // no update, the variable is read-only
-    if (ctx->regMap[index].flags & LOLAN_REGMAP_REMOTE_UPDATE_MISMATCH_BIT)
+    if (LRM_FLAGS(ctx, index) & LOLAN_REGMAP_REMOTE_UPDATE_MISMATCH_BIT)
       return 472;  // no update, variable type mismatch
-    if (ctx->regMap[index].flags & LOLAN_REGMAP_REMOTE_UPDATE_OUTOFRANGE_BIT)
+    if (LRM_FLAGS(ctx, index) & LOLAN_REGMAP_REMOTE_UPDATE_OUTOFRANGE_BIT)
       return 473;  // no update, integer overrange or string too long
   }
   return 0;  // (the execution should not get here)
@@ -193,44 +195,1004 @@ static uint16_t getLolanSetStatusCodeForVariable(lolan_ctx *ctx, LR_SIZE_T index
 
 /**************************************************************************//**
  * @brief
- *   Helper function for lolan_regMapSort().
+ *   Move register map entries (the ranges may overlap).
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] dst
+ *   Destination index.
+ * @param[in] src
+ *   Source index.
+ * @param[in] n
+ *   Number of entries to move.
+ ******************************************************************************/
+void lolanRegMapMove(lolan_ctx *ctx, LR_SIZE_T dst, LR_SIZE_T src, LR_SIZE_T n)
+{
+#ifndef LOLAN_REGMAP_SOA
+  memmove(&ctx->regMap[dst], &ctx->regMap[src], n * sizeof(lolan_RegMap));
+#else
+  memmove(ctx->regMapP[dst], ctx->regMapP[src], n * sizeof(ctx->regMapP[0]));
+  memmove(&ctx->regMapFlags[dst], &ctx->regMapFlags[src], n * sizeof(ctx->regMapFlags[0]));
+  memmove(&ctx->regMapSize[dst], &ctx->regMapSize[src], n * sizeof(ctx->regMapSize[0]));
+#ifdef LOLAN_ALLOW_VARLEN_LOLANDATA
+  memmove(&ctx->regMapSizeActual[dst], &ctx->regMapSizeActual[src], n * sizeof(ctx->regMapSizeActual[0]));
+#endif
+  memmove(&ctx->regMapData[dst], &ctx->regMapData[src], n * sizeof(ctx->regMapData[0]));
+#ifdef LOLAN_VARIABLE_TAG_TYPE
+  memmove(&ctx->regMapTag[dst], &ctx->regMapTag[src], n * sizeof(ctx->regMapTag[0]));
+#endif
+#endif
+} /* lolanRegMapMove */
+
+/**************************************************************************//**
+ * @brief
+ *   Clear register map entries (make them free entries).
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] from
+ *   Index of the first entry to clear.
+ * @param[in] n
+ *   Number of entries to clear.
+ ******************************************************************************/
+void lolanRegMapClear(lolan_ctx *ctx, LR_SIZE_T from, LR_SIZE_T n)
+{
+#ifndef LOLAN_REGMAP_SOA
+  memset(&ctx->regMap[from], 0, n * sizeof(lolan_RegMap));
+#else
+  memset(ctx->regMapP[from], 0, n * sizeof(ctx->regMapP[0]));
+  memset(&ctx->regMapFlags[from], 0, n * sizeof(ctx->regMapFlags[0]));
+  memset(&ctx->regMapSize[from], 0, n * sizeof(ctx->regMapSize[0]));
+#ifdef LOLAN_ALLOW_VARLEN_LOLANDATA
+  memset(&ctx->regMapSizeActual[from], 0, n * sizeof(ctx->regMapSizeActual[0]));
+#endif
+  memset(&ctx->regMapData[from], 0, n * sizeof(ctx->regMapData[0]));
+#ifdef LOLAN_VARIABLE_TAG_TYPE
+  memset(&ctx->regMapTag[from], 0, n * sizeof(ctx->regMapTag[0]));
+#endif
+#endif
+} /* lolanRegMapClear */
+
+#ifdef LOLAN_REGMAP_DYNAMIC
+#define LOLAN_MEM_ALIGN(x)  (((x) + 7) & ~(size_t) 7)   // alignment of the arrays in the register map memory block
+
+#ifdef LOLAN_REGMAP_HASH_SIZE
+/**************************************************************************//**
+ * @brief
+ *   Compute the size of the data pointer hash index for a register map
+ *   capacity (the index is at most half-full).
+ * @note
+ *   FOR INTERNAL USE ONLY.
  ******************************************************************************/
-static inline void lolan_regMapSwap(lolan_RegMap *entry1, lolan_RegMap *entry2)
+static uint32_t lolanPtrHashSizeFor(size_t capacity)
 {
-  lolan_RegMap tmp = *entry1;
-  *entry1 = *entry2;
-  *entry2 = tmp;
-} /* lolan_regMapSwap */
+  uint32_t size;
+
+  if (capacity == 0) return 0;
+  for (size = 8; size < 2 * capacity; size <<= 1) ;
+  return (size < LOLAN_REGMAP_HASH_SIZE) ? size : LOLAN_REGMAP_HASH_SIZE;
+} /* lolanPtrHashSizeFor */
+#endif
+
+/**************************************************************************//**
+ * @brief
+ *   Lay out the register map arrays (and the indices) in a memory block.
+ * @details
+ *   The arrays are placed one after the other, each aligned to 8 bytes.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable, the array pointers and the
+ *   capacity will be set here. (NULL: only the size is computed)
+ * @param[in] mem
+ *   The memory block. (NULL: the array pointers will be NULL)
+ * @param[in] capacity
+ *   Number of register map entries.
+ * @param[in] ramOnly
+ *   If true, the path, size and data pointer arrays are not placed
+ *   (they are supplied by a read-only register map, see lolan_initConst()).
+ * @return
+ *   The size of the memory block in bytes.
+ ******************************************************************************/
+size_t lolanRegMapLayout(lolan_ctx *ctx, uint8_t *mem, LR_SIZE_T capacity, bool ramOnly)
+{
+  size_t off = 0;
+#ifdef LOLAN_REGMAP_HASH_SIZE
+  uint32_t hashSize;
+#endif
+#ifdef LOLAN_REGMAP_FLAG_BITMAPS
+  size_t k;
+#endif
+
+#define LOLAN_MEM_PLACE(field, count) \
+  do { \
+    if (ctx != NULL) ctx->field = (mem != NULL) ? (void*) (mem + off) : NULL; \
+    off = LOLAN_MEM_ALIGN(off + (size_t) (count) * sizeof(*ctx->field)); \
+  } while (0)
+
+#ifndef LOLAN_REGMAP_SOA
+  LOLAN_MEM_PLACE(regMap, capacity);
+  (void) ramOnly;
+#else
+  if (!ramOnly) {
+    LOLAN_MEM_PLACE(regMapP, capacity);
+    LOLAN_MEM_PLACE(regMapSize, capacity);
+    LOLAN_MEM_PLACE(regMapData, capacity);
+  }
+  LOLAN_MEM_PLACE(regMapFlags, capacity);
+#ifdef LOLAN_ALLOW_VARLEN_LOLANDATA
+  LOLAN_MEM_PLACE(regMapSizeActual, capacity);
+#endif
+#ifdef LOLAN_VARIABLE_TAG_TYPE
+  LOLAN_MEM_PLACE(regMapTag, capacity);
+#endif
+#endif
+#ifdef LOLAN_REGMAP_HASH_SIZE
+  hashSize = lolanPtrHashSizeFor(capacity);
+  LOLAN_MEM_PLACE(ptrHash, hashSize);
+  if (ctx != NULL) ctx->ptrHashSize = hashSize;
+#endif
+#ifdef LOLAN_REGMAP_FLAG_BITMAPS
+  for (k = 0; k < LOLAN_FLAG_BITMAP_COUNT; k++)
+    LOLAN_MEM_PLACE(flagBitmap[k], ((size_t) capacity + 31) / 32);
+#endif
+  if (ctx != NULL) ctx->regMapCapacity = capacity;
+
+#undef LOLAN_MEM_PLACE
+  return off;
+} /* lolanRegMapLayout */
+#endif
+
+/**************************************************************************//**
+ * @brief
+ *   Make sure that the register map can hold the specified number of
+ *   entries.
+ * @details
+ *   With LOLAN_REGMAP_DYNAMIC, a register map allocated by LoLaN is moved
+ *   to a larger memory block if needed (the capacity is at least doubled,
+ *   up to LOLAN_REGMAP_SIZE). The register map in a memory block supplied
+ *   by the application is not extended.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] required
+ *   The required number of register map entries.
+ * @return
+ *   LOLAN_RETVAL_YES if the register map can hold the entries,
+ *   otherwise LOLAN_RETVAL_GENERROR.
+ ******************************************************************************/
+int8_t lolanRegMapReserve(lolan_ctx *ctx, size_t required)
+{
+#ifndef LOLAN_REGMAP_DYNAMIC
+  (void) ctx;
+  return (required <= LOLAN_REGMAP_SIZE) ? LOLAN_RETVAL_YES : LOLAN_RETVAL_GENERROR;
+#else
+  lolan_ctx old;
+  size_t capacity, size;
+  uint8_t *mem;
+
+  if (required <= ctx->regMapCapacity) return LOLAN_RETVAL_YES;
+  if (!ctx->regMapOwned || LOLAN_REGMAP_IS_CONST(ctx) || (required > LOLAN_REGMAP_SIZE))
+    return LOLAN_RETVAL_GENERROR;
+  capacity = 2 * (size_t) ctx->regMapCapacity;
+  if (capacity < required) capacity = required;
+  if (capacity > LOLAN_REGMAP_SIZE) capacity = LOLAN_REGMAP_SIZE;
+
+  size = lolanRegMapLayout(NULL, NULL, capacity, false);
+  mem = LOLAN_MALLOC(size);
+  if (mem == NULL) return LOLAN_RETVAL_GENERROR;
+  memset(mem, 0, size);   // (free entries)
+  old = *ctx;
+  lolanRegMapLayout(ctx, mem, capacity, false);
+  ctx->regMapMem = mem;
+
+  /* copy the used entries */
+  if (ctx->regMapCount > 0) {
+#define LOLAN_MEM_COPY(field)  memcpy(ctx->field, old.field, ctx->regMapCount * sizeof(*ctx->field))
+#ifndef LOLAN_REGMAP_SOA
+    LOLAN_MEM_COPY(regMap);
+#else
+    LOLAN_MEM_COPY(regMapP);
+    LOLAN_MEM_COPY(regMapFlags);
+    LOLAN_MEM_COPY(regMapSize);
+#ifdef LOLAN_ALLOW_VARLEN_LOLANDATA
+    LOLAN_MEM_COPY(regMapSizeActual);
+#endif
+    LOLAN_MEM_COPY(regMapData);
+#ifdef LOLAN_VARIABLE_TAG_TYPE
+    LOLAN_MEM_COPY(regMapTag);
+#endif
+#endif
+#undef LOLAN_MEM_COPY
+  }
+  LOLAN_FREE(old.regMapMem);
+#ifdef LOLAN_REGMAP_HASH_SIZE
+  lolanPtrHashRebuild(ctx);   // (the hash index size is changed)
+#endif
+#ifdef LOLAN_REGMAP_FLAG_BITMAPS
+  lolanFlagBitmapRebuild(ctx);
+#endif
+  return LOLAN_RETVAL_YES;
+#endif
+} /* lolanRegMapReserve */
+
+/**************************************************************************//**
+ * @brief
+ *   Swap two register map entries.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static void lolanRegMapSwap(lolan_ctx *ctx, LR_SIZE_T i, LR_SIZE_T j)
+{
+#ifndef LOLAN_REGMAP_SOA
+  lolan_RegMap tmp = ctx->regMap[i];
+  ctx->regMap[i] = ctx->regMap[j];
+  ctx->regMap[j] = tmp;
+#else
+  uint8_t p[LOLAN_REGMAP_DEPTH];
+  uint16_t flags;
+  LV_SIZE_T size;
+  void *data;
+
+  memcpy(p, ctx->regMapP[i], LOLAN_REGMAP_DEPTH);
+  memcpy(ctx->regMapP[i], ctx->regMapP[j], LOLAN_REGMAP_DEPTH);
+  memcpy(ctx->regMapP[j], p, LOLAN_REGMAP_DEPTH);
+  flags = ctx->regMapFlags[i];  ctx->regMapFlags[i] = ctx->regMapFlags[j];  ctx->regMapFlags[j] = flags;
+  size = ctx->regMapSize[i];  ctx->regMapSize[i] = ctx->regMapSize[j];  ctx->regMapSize[j] = size;
+#ifdef LOLAN_ALLOW_VARLEN_LOLANDATA
+  size = ctx->regMapSizeActual[i];  ctx->regMapSizeActual[i] = ctx->regMapSizeActual[j];  ctx->regMapSizeActual[j] = size;
+#endif
+  data = ctx->regMapData[i];  ctx->regMapData[i] = ctx->regMapData[j];  ctx->regMapData[j] = data;
+#ifdef LOLAN_VARIABLE_TAG_TYPE
+  {
+    LOLAN_VARIABLE_TAG_TYPE tag = ctx->regMapTag[i];
+    ctx->regMapTag[i] = ctx->regMapTag[j];
+    ctx->regMapTag[j] = tag;
+  }
+#endif
+#endif
+} /* lolanRegMapSwap */
+
+/**************************************************************************//**
+ * @brief
+ *   Compare two register map entries by path (the free entries are the
+ *   greatest).
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static int lolanRegMapCompare(lolan_ctx *ctx, LR_SIZE_T i, LR_SIZE_T j)
+{
+  if (LRM_P(ctx, i)[0] == 0) return (LRM_P(ctx, j)[0] == 0) ? 0 : 1;   // the free entries should be sent to the end
+  if (LRM_P(ctx, j)[0] == 0) return -1;
+  return memcmp(LRM_P(ctx, i), LRM_P(ctx, j), LOLAN_REGMAP_DEPTH);
+} /* lolanRegMapCompare */
+
+/**************************************************************************//**
+ * @brief
+ *   Compare two register map entries by data pointer.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static int lolanRegMapComparePtr(lolan_ctx *ctx, LR_SIZE_T i, LR_SIZE_T j)
+{
+  uintptr_t p1 = (uintptr_t) LRM_DATA(ctx, i);
+  uintptr_t p2 = (uintptr_t) LRM_DATA(ctx, j);
+
+  return (p1 > p2) - (p1 < p2);
+} /* lolanRegMapComparePtr */
+
+/**************************************************************************//**
+ * @brief
+ *   Sort a range of the register map in place (heapsort, no additional
+ *   memory is needed, works with both register map layouts).
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static void lolanRegMapHeapSort(lolan_ctx *ctx, LR_SIZE_T from, LR_SIZE_T to,
+                                int (*compare)(lolan_ctx*, LR_SIZE_T, LR_SIZE_T))
+{
+  size_t n, start, end, root, child;
+
+  n = to - from;
+  if (n < 2) return;
+  start = n / 2;
+  end = n;
+  while (end > 1) {
+    if (start > 0) {   // heap construction
+      start--;
+    } else {   // move the largest to the end
+      end--;
+      lolanRegMapSwap(ctx, from, from + end);
+    }
+    root = start;   // sift down
+    while ((child = 2 * root + 1) < end) {
+      if ((child + 1 < end) && (compare(ctx, from + child, from + child + 1) < 0))
+        child++;
+      if (compare(ctx, from + root, from + child) >= 0)
+        break;
+      lolanRegMapSwap(ctx, from + root, from + child);
+      root = child;
+    }
+  }
+} /* lolanRegMapHeapSort */
+
+/**************************************************************************//**
+ * @brief
+ *   Sort a range of the LoLaN register map by path in ascending order.
+ *   The free entries will be at the end of the range.
+ * @note
+ *   The data pointer hash index is not updated.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] from
+ *   Index of the first entry of the range.
+ * @param[in] to
+ *   Index after the last entry of the range.
+ ******************************************************************************/
+void lolanRegMapSortRange(lolan_ctx *ctx, LR_SIZE_T from, LR_SIZE_T to)
+{
+  lolanRegMapHeapSort(ctx, from, to, lolanRegMapCompare);
+} /* lolanRegMapSortRange */
+
+/**************************************************************************//**
+ * @brief
+ *   Sort a range of the LoLaN register map by data pointer (e.g. to find
+ *   duplicates). The range should not contain free entries.
+ * @note
+ *   The register map should be sorted by path again after using this
+ *   function.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] from
+ *   Index of the first entry of the range.
+ * @param[in] to
+ *   Index after the last entry of the range.
+ ******************************************************************************/
+void lolanRegMapSortRangeByPtr(lolan_ctx *ctx, LR_SIZE_T from, LR_SIZE_T to)
+{
+  lolanRegMapHeapSort(ctx, from, to, lolanRegMapComparePtr);
+} /* lolanRegMapSortRangeByPtr */
 
 /**************************************************************************//**
  * @brief
  *   Sort the LoLaN register map by path in ascending order. The free
  *   entries will be at the end of the array.
+ * @details
+ *   The number of used entries, the data pointer hash index and the flag
+ *   bitmaps are also updated, so this function can be called after any modification
+ *   of the register map.
  * @param[in] ctx
  *   Pointer to the LoLaN context variable.
  ******************************************************************************/
 void lolan_regMapSort(lolan_ctx *ctx)
 {
-  LR_SIZE_T i, j;
-  bool changed;
-
-  j = LOLAN_REGMAP_SIZE;
-  do {
-    changed = false;
-    for (i = 1; i < j; i++) {
-      if ((ctx->regMap[i-1].p[0] == 0) && (ctx->regMap[i].p[0] != 0)) {   // the zero entries should be sent to the end
-        lolan_regMapSwap(&(ctx->regMap[i-1]), &(ctx->regMap[i]));   // swap entries
-        changed = true;
-      } else if (ctx->regMap[i].p[0] == 0) {
-        // do nothing
-      } else if (memcmp(ctx->regMap[i-1].p, ctx->regMap[i].p, LOLAN_REGMAP_DEPTH) > 0) {   // the [i] item is less than the [i-1]
-        lolan_regMapSwap(&(ctx->regMap[i-1]), &(ctx->regMap[i]));   // swap entries
-        changed = true;
+  LR_SIZE_T i;
+
+#ifdef LOLAN_REGMAP_DYNAMIC
+  if (LRM_CAPACITY(ctx) == 0) return;   // (no memory block yet)
+#endif
+  if (LOLAN_REGMAP_IS_CONST(ctx)) return;   // (sorted at build time)
+  lolanRegMapSortRange(ctx, 0, LRM_CAPACITY(ctx));
+  for (i = 0; i < LRM_CAPACITY(ctx); i++)   // count the used entries
+    if (LRM_P(ctx, i)[0] == 0) break;
+  ctx->regMapCount = i;
+#ifdef LOLAN_REGMAP_HASH_SIZE
+  lolanPtrHashRebuild(ctx);   // the register map indices may be changed
+#endif
+#ifdef LOLAN_REGMAP_FLAG_BITMAPS
+  lolanFlagBitmapRebuild(ctx);
+#endif
+} /* lolan_regMapSort */
+
+#ifdef LOLAN_REGMAP_HASH_SIZE
+/**************************************************************************//**
+ * @brief
+ *   Compute the start slot in the data pointer hash index.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static inline uint32_t lolanPtrHashSlot(lolan_ctx *ctx, const void *ptr)
+{
+  uint32_t h;
+
+  (void) ctx;   // (not used with the static register map layout)
+  h = (uint32_t) ((uintptr_t) ptr >> 2);   // (the lowest bits are usually zero due to alignment)
+  h *= 2654435761u;   // multiplicative (Fibonacci) hashing
+  h ^= h >> 16;
+  return h & (LRM_HASH_SIZE(ctx) - 1);
+} /* lolanPtrHashSlot */
+
+/**************************************************************************//**
+ * @brief
+ *   Rebuild the data pointer hash index of the LoLaN register map.
+ * @details
+ *   The hash index is an open-addressing (linear probing) table, which
+ *   maps the data pointers to register map indices. It has to be rebuilt
+ *   every time the register map entries are added, removed or moved
+ *   (except for single entries, see lolanPtrHashInsertShift() and
+ *   lolanPtrHashRemoveShift()).
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ ******************************************************************************/
+void lolanPtrHashRebuild(lolan_ctx *ctx)
+{
+  LR_SIZE_T i;
+
+  memset(ctx->ptrHash, 0, LRM_HASH_SIZE(ctx) * sizeof(LR_SIZE_T));
+  for (i = 0; i < ctx->regMapCount; i++)
+    lolanPtrHashInsert(ctx, i);
+} /* lolanPtrHashRebuild */
+
+/**************************************************************************//**
+ * @brief
+ *   Add a register map entry to the data pointer hash index.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] index
+ *   The register map index of the entry.
+ ******************************************************************************/
+void lolanPtrHashInsert(lolan_ctx *ctx, LR_SIZE_T index)
+{
+  uint32_t slot;
+
+  slot = lolanPtrHashSlot(ctx, LRM_DATA(ctx, index));
+  while (ctx->ptrHash[slot] != 0)   // find an empty slot (there is always one, see the size check in lolan.h)
+    slot = (slot + 1) & (LRM_HASH_SIZE(ctx) - 1);
+  ctx->ptrHash[slot] = index + 1;   // store index (+1, zero means empty slot)
+} /* lolanPtrHashInsert */
+
+/**************************************************************************//**
+ * @brief
+ *   Adjust the data pointer hash index after a new entry has been inserted
+ *   into the register map (the following entries were moved by one).
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] index
+ *   The register map index of the new entry.
+ ******************************************************************************/
+void lolanPtrHashInsertShift(lolan_ctx *ctx, LR_SIZE_T index)
+{
+  LR_SIZE_T *hash, *end;
+  size_t k;
+
+  end = ctx->ptrHash + LRM_HASH_SIZE(ctx);
+  for (hash = ctx->ptrHash; hash < end; hash += 8)   // (the size is a multiple of 8)
+    for (k = 0; k < 8; k++)
+      hash[k] += (hash[k] > index);   // (stored as index + 1; branchless to allow vectorization)
+  lolanPtrHashInsert(ctx, index);
+} /* lolanPtrHashInsertShift */
+
+/**************************************************************************//**
+ * @brief
+ *   Adjust the data pointer hash index before an entry is removed from
+ *   the register map (the following entries will be moved by one).
+ * @details
+ *   The slot of the entry is emptied, and the following entries of the
+ *   probe sequence are shifted back (no tombstones are left behind).
+ * @note
+ *   The register map must not be modified yet (the start slots of the
+ *   shifted entries are computed from their data pointers).
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] index
+ *   The register map index of the entry to be removed.
+ ******************************************************************************/
+void lolanPtrHashRemoveShift(lolan_ctx *ctx, LR_SIZE_T index)
+{
+  uint32_t slot, next, home, mask;
+  LR_SIZE_T *hash, *end;
+  size_t k;
+
+  mask = LRM_HASH_SIZE(ctx) - 1;
+  slot = lolanPtrHashSlot(ctx, LRM_DATA(ctx, index));
+  while (ctx->ptrHash[slot] != (LR_SIZE_T) (index + 1))   // (the entry is in the hash index)
+    slot = (slot + 1) & mask;
+  for (;;) {   // backward-shift deletion
+    ctx->ptrHash[slot] = 0;
+    next = slot;
+    do {
+      next = (next + 1) & mask;
+      if (ctx->ptrHash[next] == 0)
+        goto shifted;
+      home = lolanPtrHashSlot(ctx, LRM_DATA(ctx, ctx->ptrHash[next] - 1));
+    } while (((next - home) & mask) < ((next - slot) & mask));   // (its start slot is after the empty slot)
+    ctx->ptrHash[slot] = ctx->ptrHash[next];
+    slot = next;
+  }
+
+shifted:
+  end = ctx->ptrHash + LRM_HASH_SIZE(ctx);
+  for (hash = ctx->ptrHash; hash < end; hash += 8)   // (the size is a multiple of 8)
+    for (k = 0; k < 8; k++)
+      hash[k] -= (hash[k] > index + 1);   // (stored as index + 1; branchless to allow vectorization)
+} /* lolanPtrHashRemoveShift */
+#endif
+
+/**************************************************************************//**
+ * @brief
+ *   Find the first register map entry whose path is not less than the
+ *   specified (partial) path.
+ * @details
+ *   Binary search on the used part of the register map, which is always
+ *   kept sorted by path with the free entries at the end.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] path
+ *   Address of the uint8_t array containing the (partial) path.
+ * @param[in] len
+ *   The number of path elements to compare (0..LOLAN_REGMAP_DEPTH).
+ * @return
+ *   The register map index. (ctx->regMapCount if all entries are less)
+ ******************************************************************************/
+LR_SIZE_T lolanRegMapLowerBound(lolan_ctx *ctx, const uint8_t *path, uint8_t len)
+{
+  size_t lo, hi, mid;
+
+  lo = 0;
+  hi = ctx->regMapCount;
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (memcmp(LRM_P(ctx, mid), path, len) < 0)   // the entry is less than the path
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+} /* lolanRegMapLowerBound */
+
+/**************************************************************************//**
+ * @brief
+ *   Find the first register map entry whose path is greater than the
+ *   specified (partial) path.
+ * @details
+ *   Binary search on the used part of the register map (see
+ *   lolanRegMapLowerBound()). The entries starting with the specified
+ *   partial path are between the lower and the upper bound.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] path
+ *   Address of the uint8_t array containing the (partial) path.
+ * @param[in] len
+ *   The number of path elements to compare (0..LOLAN_REGMAP_DEPTH).
+ * @return
+ *   The register map index. (ctx->regMapCount if no entry is greater)
+ ******************************************************************************/
+LR_SIZE_T lolanRegMapUpperBound(lolan_ctx *ctx, const uint8_t *path, uint8_t len)
+{
+  size_t lo, hi, mid;
+
+  lo = 0;
+  hi = ctx->regMapCount;
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (memcmp(LRM_P(ctx, mid), path, len) <= 0)   // the entry is not greater than the path
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+} /* lolanRegMapUpperBound */
+
+/**************************************************************************//**
+ * @brief
+ *   Initialize an iterator over the LoLaN variables under the specified
+ *   base path.
+ * @details
+ *   As the register map is sorted by path, the variables under a base path
+ *   occupy a contiguous range of it, which is located by binary search.
+ *   With the recursion depth restriction, the too deep variables form
+ *   contiguous runs as well, which are skipped at once, so the iteration
+ *   takes time proportional to the number of variables found (instead of
+ *   the size of the register map).
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[out] it
+ *   Pointer to the iterator to initialize.
+ * @param[in] path
+ *   Address of the uint8_t array containing the (base) path.
+ * @param[in] maxrec
+ *   If true, only the variables reachable from the specified base path
+ *   within LOLAN_REGMAP_RECURSION maximum recursion depth are iterated.
+ ******************************************************************************/
+void lolanSubtreeInit(lolan_ctx *ctx, lolan_SubtreeIterator *it, const uint8_t *path, bool maxrec)
+{
+  it->defLvl = lolanPathDefinitionLevel(NULL, path, NULL, false);
+  if (maxrec && (it->defLvl + LOLAN_REGMAP_RECURSION < LOLAN_REGMAP_DEPTH))
+    it->maxLvl = it->defLvl + LOLAN_REGMAP_RECURSION;
+  else
+    it->maxLvl = LOLAN_REGMAP_DEPTH;   // (no restriction)
+  it->next = lolanRegMapLowerBound(ctx, path, it->defLvl);
+  it->end = lolanRegMapUpperBound(ctx, path, it->defLvl);
+} /* lolanSubtreeInit */
+
+/**************************************************************************//**
+ * @brief
+ *   Get the next LoLaN variable of a subtree iteration
+ *   (see lolanSubtreeInit()).
+ * @note
+ *   The register map must not be modified during the iteration.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] it
+ *   Pointer to the iterator.
+ * @return
+ *   The register map index of the next variable. (LOLAN_REGMAP_SIZE if
+ *   there are no more variables)
+ ******************************************************************************/
+LR_SIZE_T lolanSubtreeNext(lolan_ctx *ctx, lolan_SubtreeIterator *it)
+{
+  LR_SIZE_T i;
+
+  while (it->next < it->end) {
+    i = it->next;
+    if ((it->maxLvl < LOLAN_REGMAP_DEPTH) && (LRM_P(ctx, i)[it->maxLvl] != 0)) {   // maximum recursion level is exceeded
+      /* (the entries with the same path down to the maximum level follow, and are all too deep) */
+      it->next = lolanRegMapUpperBound(ctx, LRM_P(ctx, i), it->maxLvl);
+      continue;
+    }
+    it->next++;
+    return i;
+  }
+  return LOLAN_REGMAP_SIZE;
+} /* lolanSubtreeNext */
+
+#ifdef LOLAN_REGMAP_CONST
+/**************************************************************************//**
+ * @brief
+ *   Compute the seeded hash of a variable path for the perfect hash of
+ *   read-only register maps.
+ * @note
+ *   FOR INTERNAL USE ONLY. (Must be the same as lolan::pathHash() in
+ *   lolan-regmap.hpp.)
+ ******************************************************************************/
+static inline uint32_t lolanPathHash(const uint8_t *path, uint32_t seed)
+{
+  uint32_t h;
+  uint8_t l;
+
+  h = 2166136261u ^ seed;   // FNV-1a
+  for (l = 0; l < LOLAN_REGMAP_DEPTH; l++) {
+    h ^= path[l];
+    h *= 16777619u;
+  }
+  h ^= h >> 16;   // (final mixing, the low bits are used)
+  h *= 0x85EBCA6Bu;
+  h ^= h >> 13;
+  return h;
+} /* lolanPathHash */
+#endif
+
+/**************************************************************************//**
+ * @brief
+ *   Find a LoLaN variable in the register map by path.
+ * @details
+ *   The register map is searched by binary search, a read-only register
+ *   map with path hash is searched by its perfect hash.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] path
+ *   Address of the uint8_t array containing the exact path of the LoLaN
+ *   variable.
+ * @return
+ *   The register map index. (LOLAN_REGMAP_SIZE if not found)
+ ******************************************************************************/
+LR_SIZE_T lolanRegMapFindByPath(lolan_ctx *ctx, const uint8_t *path)
+{
+  LR_SIZE_T i;
+#ifdef LOLAN_REGMAP_CONST
+  const lolan_ConstRegMap *map;
+  uint32_t b;
+#endif
+
+  if (path[0] == 0) return LOLAN_REGMAP_SIZE;   // (no variable with this path, free entries should not match)
+#ifdef LOLAN_REGMAP_CONST
+  map = ctx->constMap;
+  if ((map != NULL) && (map->pathHashSize != 0)) {   // perfect hash of a read-only register map
+    b = lolanPathHash(path, 0) & (map->pathHashBuckets - 1);
+    i = map->pathHash[lolanPathHash(path, map->pathHashDisp[b]) & (map->pathHashSize - 1)];
+    if ((i != 0) && (memcmp(LRM_P(ctx, i-1), path, LOLAN_REGMAP_DEPTH) == 0))   // path found
+      return i - 1;
+    return LOLAN_REGMAP_SIZE;
+  }
+#endif
+  i = lolanRegMapLowerBound(ctx, path, LOLAN_REGMAP_DEPTH);
+  if ((i < ctx->regMapCount) && (memcmp(LRM_P(ctx, i), path, LOLAN_REGMAP_DEPTH) == 0))   // path found
+    return i;
+  return LOLAN_REGMAP_SIZE;
+} /* lolanRegMapFindByPath */
+
+/**************************************************************************//**
+ * @brief
+ *   Find a LoLaN variable in the register map by data pointer.
+ * @details
+ *   The data pointer hash index is used if it is enabled
+ *   (LOLAN_REGMAP_HASH_SIZE), otherwise the register map is scanned.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] ptr
+ *   Address of the variable data.
+ * @return
+ *   The register map index. (LOLAN_REGMAP_SIZE if not found)
+ ******************************************************************************/
+LR_SIZE_T lolanRegMapFindByPtr(lolan_ctx *ctx, const void *ptr)
+{
+#ifdef LOLAN_REGMAP_HASH_SIZE
+  uint32_t slot;
+  LR_SIZE_T i;
+
+#ifdef LOLAN_REGMAP_DYNAMIC
+  if (LRM_HASH_SIZE(ctx) == 0) return LOLAN_REGMAP_SIZE;   // (no memory block yet)
+#endif
+  slot = lolanPtrHashSlot(ctx, ptr);
+  while (ctx->ptrHash[slot] != 0) {   // until an empty slot is reached
+    i = ctx->ptrHash[slot] - 1;
+    if (LRM_DATA(ctx, i) == ptr)   // variable is found by data pointer
+      return i;
+    slot = (slot + 1) & (LRM_HASH_SIZE(ctx) - 1);
+  }
+  return LOLAN_REGMAP_SIZE;
+#else
+  LR_SIZE_T i;
+
+  for (i = 0; i < ctx->regMapCount; i++) {
+    if (LRM_DATA(ctx, i) == ptr)   // variable is found by data pointer
+      return i;
+  }
+  return LOLAN_REGMAP_SIZE;
+#endif
+} /* lolanRegMapFindByPtr */
+
+#ifdef LOLAN_REGMAP_FLAG_BITMAPS
+#if defined(__GNUC__)
+  #define LOLAN_CTZ32(x)  ((uint8_t) __builtin_ctz(x))   // count trailing zeros (x != 0)
+#else
+/**************************************************************************//**
+ * @brief
+ *   Count the trailing zero bits of a non-zero 32-bit word.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static inline uint8_t lolanCtz32(uint32_t x)
+{
+  uint8_t n = 0;
+
+  while ((x & 1) == 0) {
+    x >>= 1;
+    n++;
+  }
+  return n;
+} /* lolanCtz32 */
+  #define LOLAN_CTZ32(x)  lolanCtz32(x)
+#endif
+
+/**************************************************************************//**
+ * @brief
+ *   Get the bitmap index of a tracked flag.
+ * @details
+ *   The tracked flags are the user flags (LOLAN_REGMAP_USER_MASK) and
+ *   LOLAN_REGMAP_AUX_BIT.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ * @return
+ *   The bitmap index, or -1 if the flag is not tracked.
+ ******************************************************************************/
+static inline int8_t lolanFlagBitmapIndex(uint16_t flag)
+{
+  switch (flag) {
+    case LOLAN_REGMAP_REMOTE_UPDATE_BIT:      return 0;
+    case LOLAN_REGMAP_INFORM_REQUEST_BIT:     return 1;
+    case LOLAN_REGMAP_LOCAL_UPDATE_BIT:       return 2;
+    case LOLAN_REGMAP_INFORMSEC_REQUEST_BIT:  return 3;
+    case LOLAN_REGMAP_AUX_BIT:                return 4;
+    default:                                  return -1;
+  }
+} /* lolanFlagBitmapIndex */
+
+#define LOLAN_FLAG_BITMAP_MASK  (LOLAN_REGMAP_USER_MASK | LOLAN_REGMAP_AUX_BIT)   // the tracked flags
+
+/**************************************************************************//**
+ * @brief
+ *   Rebuild the flag bitmaps from the register map.
+ * @details
+ *   The bitmaps have to be rebuilt every time the register map entries
+ *   are added, removed or moved.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ ******************************************************************************/
+void lolanFlagBitmapRebuild(lolan_ctx *ctx)
+{
+  LR_SIZE_T i;
+  uint16_t f;
+  uint16_t bit;
+  size_t k;
+
+  for (k = 0; k < LOLAN_FLAG_BITMAP_COUNT; k++)
+    memset(ctx->flagBitmap[k], 0, LRM_BITMAP_WORDS(ctx) * sizeof(uint32_t));
+  for (i = 0; i < ctx->regMapCount; i++) {
+    f = LRM_FLAGS(ctx, i) & LOLAN_FLAG_BITMAP_MASK;
+    while (f) {
+      bit = f & (~f + 1);   // lowest set flag
+      ctx->flagBitmap[lolanFlagBitmapIndex(bit)][i / 32] |= (uint32_t) 1 << (i % 32);
+      f &= ~bit;
+    }
+  }
+} /* lolanFlagBitmapRebuild */
+
+/**************************************************************************//**
+ * @brief
+ *   Adjust the flag bitmaps after a register map entry has been inserted
+ *   or removed (the following entries were moved by one).
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] index
+ *   The register map index of the inserted/removed entry.
+ * @param[in] insert
+ *   True: an entry has been inserted (without tracked flags),
+ *   false: an entry has been removed.
+ ******************************************************************************/
+void lolanFlagBitmapShift(lolan_ctx *ctx, LR_SIZE_T index, bool insert)
+{
+  uint32_t *b, lowMask;
+  size_t k, n, first;
+
+  first = index / 32;
+  lowMask = ((uint32_t) 1 << (index % 32)) - 1;   // the bits below index in its word are not moved
+  for (k = 0; k < LOLAN_FLAG_BITMAP_COUNT; k++) {
+    b = ctx->flagBitmap[k];
+    if (insert) {   // move the bits up
+      for (n = LRM_BITMAP_WORDS(ctx) - 1; n > first; n--)
+        b[n] = (b[n] << 1) | (b[n-1] >> 31);
+      b[first] = (b[first] & lowMask) | ((b[first] & ~lowMask) << 1);
+    } else {   // move the bits down
+      b[first] = (b[first] & lowMask) | ((b[first] >> 1) & ~lowMask);
+      for (n = first; n + 1 < LRM_BITMAP_WORDS(ctx); n++) {
+        b[n] |= b[n+1] << 31;
+        b[n+1] >>= 1;
       }
     }
-    j--;
-  } while (changed);
-} /* lolan_regMapSort */
+  }
+} /* lolanFlagBitmapShift */
+#endif
+
+/**************************************************************************//**
+ * @brief
+ *   Set flags of a register map entry.
+ * @details
+ *   The flags tracked by the flag bitmaps (LOLAN_REGMAP_FLAG_BITMAPS)
+ *   must be set with this function.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] index
+ *   The register map index.
+ * @param[in] flags
+ *   The flags to be set.
+ ******************************************************************************/
+void lolanFlagSet(lolan_ctx *ctx, LR_SIZE_T index, uint16_t flags)
+{
+#ifdef LOLAN_REGMAP_FLAG_BITMAPS
+  uint16_t f, bit;
+
+  f = flags & LOLAN_FLAG_BITMAP_MASK;
+  while (f) {
+    bit = f & (~f + 1);   // lowest set flag
+    ctx->flagBitmap[lolanFlagBitmapIndex(bit)][index / 32] |= (uint32_t) 1 << (index % 32);
+    f &= ~bit;
+  }
+#endif
+  LRM_FLAGS(ctx, index) |= flags;
+} /* lolanFlagSet */
+
+/**************************************************************************//**
+ * @brief
+ *   Clear flags of a register map entry.
+ * @details
+ *   The flags tracked by the flag bitmaps (LOLAN_REGMAP_FLAG_BITMAPS)
+ *   must be cleared with this function.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] index
+ *   The register map index.
+ * @param[in] flags
+ *   The flags to be cleared.
+ ******************************************************************************/
+void lolanFlagClear(lolan_ctx *ctx, LR_SIZE_T index, uint16_t flags)
+{
+#ifdef LOLAN_REGMAP_FLAG_BITMAPS
+  uint16_t f, bit;
+
+  f = flags & LOLAN_FLAG_BITMAP_MASK;
+  while (f) {
+    bit = f & (~f + 1);   // lowest set flag
+    ctx->flagBitmap[lolanFlagBitmapIndex(bit)][index / 32] &= ~((uint32_t) 1 << (index % 32));
+    f &= ~bit;
+  }
+#endif
+  LRM_FLAGS(ctx, index) &= ~flags;
+} /* lolanFlagClear */
+
+/**************************************************************************//**
+ * @brief
+ *   Clear flags of all register map entries.
+ * @details
+ *   With the flag bitmaps (LOLAN_REGMAP_FLAG_BITMAPS), only the entries
+ *   having the tracked flags are visited.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] flags
+ *   The flags to be cleared.
+ ******************************************************************************/
+void lolanFlagClearAll(lolan_ctx *ctx, uint16_t flags)
+{
+  LR_SIZE_T i;
+#ifdef LOLAN_REGMAP_FLAG_BITMAPS
+  uint16_t f, bit;
+  uint32_t *bitmap, w;
+  size_t n;
+
+  if ((flags & ~LOLAN_FLAG_BITMAP_MASK) == 0) {   // only tracked flags
+    f = flags;
+    while (f) {
+      bit = f & (~f + 1);   // lowest set flag
+      bitmap = ctx->flagBitmap[lolanFlagBitmapIndex(bit)];
+      for (n = 0; n < LRM_BITMAP_WORDS(ctx); n++) {
+        for (w = bitmap[n]; w != 0; w &= w - 1) {   // (w & (w - 1) clears the lowest set bit)
+          i = n * 32 + LOLAN_CTZ32(w);
+          LRM_FLAGS(ctx, i) &= ~bit;
+        }
+        bitmap[n] = 0;
+      }
+      f &= ~bit;
+    }
+    return;
+  }
+#endif
+  for (i = 0; i < ctx->regMapCount; i++)
+    lolanFlagClear(ctx, i, flags);
+} /* lolanFlagClearAll */
+
+/**************************************************************************//**
+ * @brief
+ *   Find the next register map entry where the specified flags are set.
+ * @details
+ *   With the flag bitmaps (LOLAN_REGMAP_FLAG_BITMAPS), if the specified
+ *   flags contain tracked flags, the bitmaps are searched (32 entries
+ *   per step), otherwise the register map is scanned.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] flags
+ *   The flags to search for. (If this parameter specifies multiple flags,
+ *   the entry will be found if all flags are set.)
+ * @param[in] from
+ *   The register map index to start the search from.
+ * @return
+ *   The register map index. (LOLAN_REGMAP_SIZE if not found)
+ ******************************************************************************/
+LR_SIZE_T lolanFlagNext(lolan_ctx *ctx, uint16_t flags, LR_SIZE_T from)
+{
+  LR_SIZE_T i;
+#ifdef LOLAN_REGMAP_FLAG_BITMAPS
+  uint16_t f, bit;
+  uint32_t w;
+  size_t n;
+
+  if ((flags & LOLAN_FLAG_BITMAP_MASK) != 0) {   // tracked flags are specified
+    for (n = from / 32; n < LRM_BITMAP_WORDS(ctx); n++) {
+      w = (n == from / 32) ? ~(uint32_t) 0 << (from % 32) : ~(uint32_t) 0;   // (skip the entries before "from")
+      f = flags & LOLAN_FLAG_BITMAP_MASK;
+      while (f) {   // (all the tracked flags must be set)
+        bit = f & (~f + 1);   // lowest set flag
+        w &= ctx->flagBitmap[lolanFlagBitmapIndex(bit)][n];
+        f &= ~bit;
+      }
+      for ( ; w != 0; w &= w - 1) {   // (w & (w - 1) clears the lowest set bit)
+        i = n * 32 + LOLAN_CTZ32(w);
+        if ((LRM_FLAGS(ctx, i) & flags) == flags)   // (check the untracked flags too)
+          return i;
+      }
+    }
+    return LOLAN_REGMAP_SIZE;
+  }
+#endif
+  for (i = from; i < ctx->regMapCount; i++)
+    if ((LRM_FLAGS(ctx, i) & flags) == flags)
+      return i;
+  return LOLAN_REGMAP_SIZE;
+} /* lolanFlagNext */
 
 /**************************************************************************//**
  * @brief
@@ -289,6 +1251,97 @@ int8_t lolanGetPathFromCbor(uint8_t *path, CborValue *it)
   return LOLAN_RETVAL_YES;
 } /* lolanGetPathFromCbor */
 
+/**************************************************************************//**
+ * @brief
+ *   Decode the value of the zero key CBOR entry, which has to be an
+ *   unsigned integer value or a LoLaN path.
+ * @details
+ *   The CBOR iterator is advanced to the next entry on success.
+ * @param[in,out] it
+ *   Pointer to CborValue (iterator) at the value of the zero key entry.
+ * @param[out] path
+ *   See lolanGetZeroKeyEntryFromPayload().
+ * @param[out] value
+ *   See lolanGetZeroKeyEntryFromPayload().
+ * @param[out] isPath
+ *   See lolanGetZeroKeyEntryFromPayload().
+ * @return
+ *   LOLAN_RETVAL_YES:        The path or integer was extracted successfully.
+ *   LOLAN_RETVAL_GENERROR:   A general error has occurred.
+ *   LOLAN_RETVAL_CBORERROR:  A CBOR error has occurred.
+ ******************************************************************************/
+int8_t lolanGetZeroKeyValueFromCbor(CborValue *it, uint8_t *path, uint16_t *value, bool *isPath)
+{
+  uint64_t u64;
+
+  if (cbor_value_is_container(it)) {   // the next item is a container
+    if (path == NULL) return LOLAN_RETVAL_GENERROR;   // if no path is acceptable -> error
+    if (isPath) *isPath = true;   // it may be a path
+    return lolanGetPathFromCbor(path, it);
+  } else {
+    if (cbor_value_is_unsigned_integer(it)) {   // the next item is an unsigned integer
+      if (value == NULL) return LOLAN_RETVAL_GENERROR;   // if no integer is acceptable -> error
+      if (isPath) *isPath = false;   // it is an integer
+      cbor_value_get_uint64(it, &u64);   // get value
+      *value = (u64 > UINT16_MAX) ? UINT16_MAX : u64;  // the number should be representable on 16-bit
+      if (cbor_value_advance_fixed(it) != CborNoError) return LOLAN_RETVAL_CBORERROR;
+      return LOLAN_RETVAL_YES;
+    } else {
+      DLOG(("\n LoLaN CBOR packet error: zero key entry contains neither path nor uint"));
+      return LOLAN_RETVAL_GENERROR;
+    }
+  }
+} /* lolanGetZeroKeyValueFromCbor */
+
+/**************************************************************************//**
+ * @brief
+ *   Extract the zero key CBOR entry from the root map of a validated
+ *   payload.
+ * @details
+ *   See lolanGetZeroKeyEntryFromPayload().
+ * @param[in] map_cur
+ *   Pointer to the cursor at the first entry of the root map (the cursor
+ *   is not modified).
+ * @param[out] path
+ *   See lolanGetZeroKeyEntryFromPayload().
+ * @param[out] value
+ *   See lolanGetZeroKeyEntryFromPayload().
+ * @param[out] isPath
+ *   See lolanGetZeroKeyEntryFromPayload().
+ * @return
+ *   See lolanGetZeroKeyEntryFromPayload().
+ ******************************************************************************/
+int8_t lolanGetZeroKeyEntryFromCursor(const lolan_CborCursor *map_cur, uint8_t *path, uint16_t *value, bool *isPath)
+{
+  lolan_CborCursor cur;
+  CborParser parser;
+  CborValue it;
+  int key;
+
+  /* find key = 0 */
+  cur = *map_cur;
+  while (!LOLAN_CBOR_AT_END(&cur)) {    // until entries are available in the root map
+    if (!LOLAN_CBOR_IS_INTEGER(&cur)) {  // check key of a key-data pair (must be integer)
+      DLOG(("\n LoLaN CBOR packet error: key has to be integer"));
+      return LOLAN_RETVAL_GENERROR;
+    }
+    key = lolanCborCursorGetInt(&cur);   // get key
+    lolanCborCursorAdvance(&cur);   // advance cursor to data
+    if (LOLAN_CBOR_AT_END(&cur)) {   // unexpected end of root map (no data for key)
+      DLOG(("\n LoLaN CBOR packet error: key must be followed by data"));
+      return LOLAN_RETVAL_GENERROR;
+    }
+    if (key == 0) {   // zero key found
+      if (lolanCborCursorValue(&cur, &parser, &it) != CborNoError) return LOLAN_RETVAL_CBORERROR;
+      return lolanGetZeroKeyValueFromCbor(&it, path, value, isPath);
+    }
+    /* an other key found, advance to the next key */
+    lolanCborCursorAdvance(&cur);
+  }
+
+  return LOLAN_RETVAL_NO;  // at this point no zero key entry was found
+} /* lolanGetZeroKeyEntryFromCursor */
+
 /**************************************************************************//**
  * @brief
  *   Extract the zero key CBOR entry from a LoLaN packet payload, which
@@ -320,72 +1373,33 @@ int8_t lolanGetPathFromCbor(uint8_t *path, CborValue *it)
  *   LOLAN_RETVAL_GENERROR:   A general error has occurred.
  *   LOLAN_RETVAL_CBORERROR:  A CBOR error has occurred.
  ******************************************************************************/
-int8_t lolanGetZeroKeyEntryFromPayload(const lolan_Packet *lp, uint8_t *path, uint16_t *value, bool *isPath)
-{
-  CborParser parser;
-  CborValue it, rit;
-  CborError err;
-  int key;
-  uint64_t u64;
+int8_t lolanGetZeroKeyEntryFromPayload(const lolan_Packet *lp, uint8_t *path, uint16_t *value, bool *isPath)
+{
+  lolan_CborIndex idx;
+  lolan_CborCursor cur, map_cur;
 
-  /* initialize and enter the root container (map) */
-  err = cbor_parser_init(lp->payload, lp->payloadSize, 0, &parser, &it);  // initialize CBOR parser
-  if (err != CborNoError) return LOLAN_RETVAL_CBORERROR;
-  if (cbor_value_get_type(&it) != CborMapType) {   // the root entry must be a CBOR map
+  /* validate the payload and enter the root container (map) */
+  if (lolanCborValidate(&idx, lp->payload, lp->payloadSize) != LOLAN_RETVAL_YES) return LOLAN_RETVAL_CBORERROR;
+  lolanCborCursorRoot(&idx, &cur);
+  if (!LOLAN_CBOR_IS_MAP(&cur)) {   // the root entry must be a CBOR map
     DLOG(("\n LoLaN CBOR packet error: root map not found"));
     return LOLAN_RETVAL_GENERROR;
   }
-  err = cbor_value_enter_container(&it, &rit);   // enter root map
-  if (err != CborNoError) return LOLAN_RETVAL_CBORERROR;
-
-  /* find key = 0 */
-  while (!cbor_value_at_end(&rit)) {    // until entries are available in the root map
-    if (cbor_value_get_type(&rit) != CborIntegerType) {  // check key of a key-data pair (must be integer)
-      DLOG(("\n LoLaN CBOR packet error: key has to be integer"));
-      return LOLAN_RETVAL_GENERROR;
-    }
-    cbor_value_get_int(&rit, &key);   // get key
-    err = cbor_value_advance_fixed(&rit);   // advance iterator to data
-    if (err != CborNoError) return LOLAN_RETVAL_CBORERROR;
-    if (cbor_value_at_end(&rit)) {   // unexpected end of root map (no data for key)
-      DLOG(("\n LoLaN CBOR packet error: key must be followed by data"));
-      return LOLAN_RETVAL_GENERROR;
-    }
-    if (key == 0) {   // zero key found
-      if (cbor_value_is_container(&rit)) {   // the next item is a container
-        if (path == NULL) return LOLAN_RETVAL_GENERROR;   // if no path is acceptable -> error
-        if (isPath) *isPath = true;   // it may be a path
-        return lolanGetPathFromCbor(path, &rit);
-      } else {
-        if (cbor_value_is_unsigned_integer(&rit)) {   // the next item is an unsigned integer
-          if (value == NULL) return LOLAN_RETVAL_GENERROR;   // if no integer is acceptable -> error
-          if (isPath) *isPath = false;   // it is an integer
-          cbor_value_get_uint64(&rit, &u64);   // get value
-          *value = (u64 > UINT16_MAX) ? UINT16_MAX : u64;  // the number should be representable on 16-bit
-          return LOLAN_RETVAL_YES;
-        } else {
-          DLOG(("\n LoLaN CBOR packet error: zero key entry contains neither path nor uint"));
-          return LOLAN_RETVAL_GENERROR;
-        }
-      }
-    }
-    /* an other key found, advance to the next key */
-    err = cbor_value_advance(&rit);
-    if (err != CborNoError) return LOLAN_RETVAL_CBORERROR;
-  }
+  lolanCborCursorEnter(&cur, &map_cur);   // enter root map
 
-  return LOLAN_RETVAL_NO;  // at this point no zero key entry was found
+  return lolanGetZeroKeyEntryFromCursor(&map_cur, path, value, isPath);
 } /* lolanGetZeroKeyEntryFromPayload */
 
 /**************************************************************************//**
  * @brief
  *   Get the next LoLaN variable data from CBOR.
  * @details
- *   This procedure parses the next data from a CBOR stream, and returns it
+ *   This procedure decodes the data at a CBOR cursor, and returns it
  *   with its length and type. Only the types that may represent a LoLaN
- *   variable are allowed. The CBOR iterator will be advanced in all cases.
- * @param[in] it
- *   Pointer to CborValue (iterator).
+ *   variable are allowed. The cursor is not advanced (see
+ *   lolanCborCursorAdvance()).
+ * @param[in] cur
+ *   Pointer to the cursor (in a validated payload).
  * @param[out] data
  *   Address of the buffer which will receive the data.
  * @param[in] data_max
@@ -393,34 +1407,29 @@ int8_t lolanGetZeroKeyEntryFromPayload(const lolan_Packet *lp, uint8_t *path, ui
  *   parameter to 0 if no limitation is required. Otherwise, it must be >=8
  *   (not to break integer and floating-point data).
  * @param[out] data_len
- *   Pointer to a number that receives the actual data length. If this
- *   output is higher than data_max, it means that the end of the data
- *   was discarded.
+ *   Pointer to a number that receives the actual data length.
  * @param[out] type
  *   The type of the data got. It can be one of the lolan_VarType constants.
  * @return
  *   LOLAN_RETVAL_YES: Data got.
- *   LOLAN_RETVAL_GENERROR: An error has occurred.
- *   LOLAN_RETVAL_CBORERROR: A CBOR-related error has occurred.
+ *   LOLAN_RETVAL_GENERROR: An error has occurred (e.g. the type is not
+ *                          allowed, or the string is too long).
  *****************************************************************************/
-int8_t lolanGetDataFromCbor(CborValue *it, uint8_t *data, LV_SIZE_T data_max,
+int8_t lolanGetDataFromCbor(const lolan_CborCursor *cur, uint8_t *data, LV_SIZE_T data_max,
             LV_SIZE_T *data_len, uint8_t *type)
 {
-  CborType ctype;
-  CborError cerr;
+  uint8_t ib;
 
   /* error checking */
   if (data_max != 0 && data_max < 8) return LOLAN_RETVAL_GENERROR;  // (see description of data_max)
 
   /* get data */
-  ctype = cbor_value_get_type(it);   // get CBOR entry type
-  switch (ctype) {
-    case CborIntegerType:   // integer
-      if (cbor_value_is_unsigned_integer(it)) {   // non-negative integer
+  ib = *cur->ptr;   // initial byte of the CBOR item
+  switch (ib >> 5) {   // major type
+    case 0:   // non-negative integer
+      {
         uint64_t val;
-        cbor_value_get_uint64(it, &val);  // decode value
-        cerr = cbor_value_advance_fixed(it);   // advance CBOR iterator
-        if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
+        val = lolanCborCursorGetUint(cur);  // decode value
         /* determine minimum representation width and store value */
         if (val > UINT32_MAX) {   // 64-bit
           *data_len = 8;
@@ -436,11 +1445,12 @@ int8_t lolanGetDataFromCbor(CborValue *it, uint8_t *data, LV_SIZE_T data_max,
           *data = val;
         }
         *type = LOLAN_UINT;
-      } else {   // negative integer
+      }
+      break;
+    case 1:   // negative integer
+      {
         int64_t val;
-        cbor_value_get_int64(it, &val);   // decode value
-        cerr = cbor_value_advance_fixed(it);   // advance CBOR iterator
-        if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
+        val = (int64_t) ~lolanCborCursorGetUint(cur);   // decode value (-1 - argument)
         /* determine minimum representation width and store value */
         if (val > INT32_MAX || val < INT32_MIN) {   // 64-bit
           *data_len = 8;
@@ -458,52 +1468,39 @@ int8_t lolanGetDataFromCbor(CborValue *it, uint8_t *data, LV_SIZE_T data_max,
         *type = LOLAN_INT;
       }
       break;
-    case CborByteStringType:   // byte string, assumed as arbitrary data
-      {
-        size_t len;
-        len = data_max == 0 ? LV_SIZE_MAX : data_max;    // LV_SIZE_MAX = "unlimited size"
-        cerr = cbor_value_copy_byte_string(it, data, &len, it);   // get string (the CBOR iterator is also advanced)
-        if (cerr != CborNoError) return LOLAN_RETVAL_GENERROR;   // may be error if the string is too long
-        *data_len = len;
-        *type = LOLAN_DATA;
-      }
-      break;
-    case CborTextStringType:   // text string
+    case 2:   // byte string, assumed as arbitrary data
+    case 3:   // text string
       {
-        size_t len;
-        len = data_max == 0 ? LV_SIZE_MAX : data_max;    // LV_SIZE_MAX = "unlimited size"
-        cerr = cbor_value_copy_text_string(it, (char *) data, &len, it);   // get string (the CBOR iterator is also advanced)
-        if (cerr != CborNoError) return LOLAN_RETVAL_GENERROR;   // may be error if the string is too long
+        size_t len, max;
+        max = data_max == 0 ? LV_SIZE_MAX : data_max;    // LV_SIZE_MAX = "unlimited size"
+        len = lolanCborCursorStringLength(cur);
+        if (len > max) return LOLAN_RETVAL_GENERROR;   // the string is too long
+        lolanCborCursorCopyString(cur, data, max);   // get string
         *data_len = len;
-        *type = LOLAN_STR;
+        *type = ((ib >> 5) == 2) ? LOLAN_DATA : LOLAN_STR;
       }
       break;
-    case CborFloatType:   // 32-bit floating-point
-      {
+    case 7:   // floating-point (or simple value)
+      if (ib == 0xfa) {   // 32-bit floating-point
+        uint32_t bits;
         float val;
-        cbor_value_get_float(it, &val);   // get value
-        cerr = cbor_value_advance_fixed(it);   // advance CBOR iterator
-        if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-        *((float*) data) = val;   // decode and store value
+        bits = lolanCborCursorGetUint(cur);
+        memcpy(&val, &bits, 4);   // get value
+        *((float*) data) = val;   // store value
         *data_len = 4;
-        *type = LOLAN_FLOAT;
-      }
-      break;
-    case CborDoubleType:
-      {
+      } else if (ib == 0xfb) {   // 64-bit floating-point
+        uint64_t bits;
         double val;
-        cbor_value_get_double(it, &val);   // get value
-        cerr = cbor_value_advance_fixed(it);   // advance CBOR iterator
-        if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-        *((double*) data) = val;   // decode and store value
+        bits = lolanCborCursorGetUint(cur);
+        memcpy(&val, &bits, 8);   // get value
+        *((double*) data) = val;   // store value
         *data_len = 8;
-        *type = LOLAN_FLOAT;
+      } else {   // type not allowed in LoLaN (simple value, half precision floating-point)
+        return LOLAN_RETVAL_GENERROR;
       }
+      *type = LOLAN_FLOAT;
       break;
-    case CborInvalidType:   // invalid CBOR entry
-      return LOLAN_RETVAL_CBORERROR;
-      break;
-    default:   // type not allowed in LoLaN
+    default:   // type not allowed in LoLaN (array, map, tag)
       return LOLAN_RETVAL_GENERROR;
       break;
   }
@@ -511,20 +1508,420 @@ int8_t lolanGetDataFromCbor(CborValue *it, uint8_t *data, LV_SIZE_T data_max,
   return LOLAN_RETVAL_YES;
 } /* lolanGetDataFromCbor */
 
+/**************************************************************************//**
+ * @brief
+ *   Walk the variable entries nested by path in the root map of a
+ *   validated payload.
+ * @details
+ *   The nested maps are processed in a single pass, and the leaf handler
+ *   is called for every entry which is not a map (the data is not
+ *   checked). Zero key entries and incidental entries with >255 keys are
+ *   skipped, maps below LOLAN_REGMAP_DEPTH levels are not entered.
+ *   The legacy style INFORM entries are relative to a base path, their
+ *   path is combined with it.
+ * @param[in] map_cur
+ *   Pointer to the cursor at the first entry of the root map (the cursor
+ *   is not modified).
+ * @param[in] basePath
+ *   Address of the base path array (legacy style INFORM), or NULL if the
+ *   keys contain the full paths.
+ * @param[in] leaf
+ *   Pointer to the handler of the entries. It gets the full path
+ *   (completed with zeros) and the cursor at the data, and it should
+ *   return LOLAN_RETVAL_YES to continue the walk.
+ * @param[in] arg
+ *   User data for the handler.
+ * @return
+ *   LOLAN_RETVAL_YES: All entries processed.
+ *   LOLAN_RETVAL_NO: No entries found.
+ *   LOLAN_RETVAL_GENERROR: Invalid structure (e.g. a key is not an
+ *                          integer).
+ *   Other values: returned by the handler.
+ ******************************************************************************/
+int8_t lolanWalkPayloadMap(const lolan_CborCursor *map_cur, const uint8_t *basePath, lolan_PayloadLeafFunc leaf,
+            void *arg)
+{
+  uint8_t path[LOLAN_REGMAP_DEPTH], cPath[LOLAN_REGMAP_DEPTH];
+  uint8_t i, alevel, defLvl;
+  bool foundSomething;
+  int key;
+  int8_t err;
+
+  lolan_CborCursor cur[LOLAN_REGMAP_DEPTH];
+
+  defLvl = (basePath != NULL) ? lolanPathDefinitionLevel(NULL, basePath, NULL, false) : 0;   // get base path definition level
+  cur[0] = *map_cur;   // (the root map level)
+
+  /* process the nested CBOR structure */
+  foundSomething = false;
+  alevel = 0;  // address level is 0 at this point
+  while (!((alevel == 0) && LOLAN_CBOR_AT_END(&cur[alevel]))) {   // until entries are available in the root map level
+    /* check for end of container */
+    if (LOLAN_CBOR_AT_END(&cur[alevel])) {   // end of map (alevel is always >0 at this point)
+      lolanCborCursorLeave(&cur[alevel-1], &cur[alevel]);   // leave container
+      alevel--;  // decrement current address level
+      continue;
+    }
+    /* extract key */
+    if (!LOLAN_CBOR_IS_INTEGER(&cur[alevel])) return LOLAN_RETVAL_GENERROR;  // check key of a key-data pair (must be integer)
+    key = lolanCborCursorGetInt(&cur[alevel]);   // get key
+    lolanCborCursorAdvance(&cur[alevel]);   // advance cursor to data
+    if (LOLAN_CBOR_AT_END(&cur[alevel])) return LOLAN_RETVAL_GENERROR;   // unexpected end of map (no data for key)
+    /* process key-data pair */
+    if ((key <= 0) || (key > 255)) {   // zero key found, or key can not be a path element
+      /* advance to the next key */
+      lolanCborCursorAdvance(&cur[alevel]);
+    } else {   // other key found
+      path[alevel] = key;  // store path element
+      if (LOLAN_CBOR_IS_MAP(&cur[alevel])) {  // the data is a map -> subpath branch
+        if (alevel < LOLAN_REGMAP_DEPTH-1) {  // entering a lower path level is o.k.
+          lolanCborCursorEnter(&cur[alevel], &cur[alevel+1]);   // enter map
+          alevel++;  // increment current address level
+        } else {  // can not enter a lower path, skip this sub-branch
+          lolanCborCursorAdvance(&cur[alevel]);   // skip map
+        }
+      } else {  // the data is not a map (may be valid data)
+        foundSomething = true;
+        /* assemble path */
+        if (basePath != NULL) {   // legacy style INFORM, need to combine base with path
+          memcpy(cPath, basePath, defLvl);   // copy base part
+          memcpy(cPath + defLvl, path, LOLAN_REGMAP_DEPTH - defLvl);   // copy others
+          for (i = defLvl+alevel+1; i < LOLAN_REGMAP_DEPTH; i++)   // correct path with zeros if needed
+            cPath[i] = 0;
+        } else {   // new style, just copy path
+          memcpy(cPath, path, LOLAN_REGMAP_DEPTH);
+          for (i = alevel+1; i < LOLAN_REGMAP_DEPTH; i++)   // correct path with zeros if needed
+            cPath[i] = 0;
+        }
+        /* pass the data to the handler */
+        err = leaf(arg, cPath, &cur[alevel]);
+        if (err != LOLAN_RETVAL_YES) return err;
+        lolanCborCursorAdvance(&cur[alevel]);   // advance cursor to the next key
+      }
+    }
+  }
+
+  return foundSomething ? LOLAN_RETVAL_YES : LOLAN_RETVAL_NO;
+} /* lolanWalkPayloadMap */
+
+/**************************************************************************//**
+ * @brief
+ *   Walk the variable entries of a LoLaN INFORM payload.
+ * @details
+ *   The zero key entry is checked (the base path of a legacy style
+ *   INFORM, or the status code 299 of a new style INFORM), and the
+ *   entries are passed to the handler, see lolanWalkPayloadMap().
+ * @param[in] map_cur
+ *   Pointer to the cursor at the first entry of the root map of the
+ *   validated payload (the cursor is not modified).
+ * @param[in] leaf
+ *   Pointer to the handler of the entries.
+ * @param[in] arg
+ *   User data for the handler.
+ * @return
+ *   LOLAN_RETVAL_YES: All entries processed.
+ *   LOLAN_RETVAL_NO: No entries found.
+ *   LOLAN_RETVAL_GENERROR: An error has occurred (e.g. invalid INFORM
+ *                          packet).
+ *   LOLAN_RETVAL_CBORERROR: A CBOR-related error has occurred.
+ *   Other values: returned by the handler.
+ ******************************************************************************/
+int8_t lolanWalkInformPayload(const lolan_CborCursor *map_cur, lolan_PayloadLeafFunc leaf, void *arg)
+{
+  uint8_t basePath[LOLAN_REGMAP_DEPTH];
+  uint16_t zeroValue;
+  bool zeroIsPath;
+  int8_t err;
+
+  /* get base path or code from zero key entry */
+  err = lolanGetZeroKeyEntryFromCursor(map_cur, basePath, &zeroValue, &zeroIsPath);
+  switch (err) {
+    case LOLAN_RETVAL_YES:   // zero key entry found
+      if (!zeroIsPath)    // new style INFORM, check number at zero key
+        if (zeroValue != 299) return LOLAN_RETVAL_GENERROR;   // the zero key should contain the status code 299
+      break;
+    case LOLAN_RETVAL_NO:   // no zero key entry
+      /* legacy style INFORM, the base path is the root */
+      memset(basePath, 0, LOLAN_REGMAP_DEPTH);
+      zeroIsPath = true;
+      break;
+    default:   // error
+      return err;
+      break;
+  }
+
+  return lolanWalkPayloadMap(map_cur, zeroIsPath ? basePath : NULL, leaf, arg);
+} /* lolanWalkInformPayload */
+
+/*
+ * Update kernels of lolanVarIndexUpdateFromCbor()
+ *
+ *   Every combination of the LoLaN variable kind (type and size) and the
+ *   CBOR item kind has its own update function (decode, range check,
+ *   store), selected by two table lookups.
+ */
+
+typedef int8_t (*lolanUpdateKernel)(lolan_ctx *ctx, LR_SIZE_T i, const lolan_CborCursor *cur, uint8_t *error);
+
+typedef enum {        // CBOR item kinds of the update kernels
+  LUK_CBOR_UINT,        // non-negative integer
+  LUK_CBOR_NEGINT,      // negative integer
+  LUK_CBOR_BYTES,       // byte string
+  LUK_CBOR_TEXT,        // text string
+  LUK_CBOR_FLOAT,       // single precision floating point
+  LUK_CBOR_DOUBLE,      // double precision floating point
+  LUK_CBOR_KINDS
+} lolanUpdateKernel_cbor;
+
+typedef enum {        // LoLaN variable kinds of the update kernels
+  LUK_VAR_INVALID,      // invalid variable type
+  LUK_VAR_INT8, LUK_VAR_INT16, LUK_VAR_INT32, LUK_VAR_INT64, LUK_VAR_INTX,         // signed integer (X: unsupported size)
+  LUK_VAR_UINT8, LUK_VAR_UINT16, LUK_VAR_UINT32, LUK_VAR_UINT64, LUK_VAR_UINTX,    // unsigned integer (X: unsupported size)
+  LUK_VAR_FLOAT, LUK_VAR_DOUBLE, LUK_VAR_FLOATX,   // floating point (X: unsupported size)
+  LUK_VAR_STR,          // string
+  LUK_VAR_DATA,         // arbitrary data
+  LUK_VAR_KINDS
+} lolanUpdateKernel_var;
+
+/**************************************************************************//**
+ * @brief
+ *   Reject the update of a variable.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] i
+ *   The register map index of the variable.
+ * @param[out] error
+ *   Address of the variable update result (may be NULL).
+ * @param[in] code
+ *   The variable update result (LVUFC_MISMATCH or LVUFC_OUTOFRANGE).
+ * @return
+ *   LOLAN_RETVAL_NO
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static int8_t lolanUpdateReject(lolan_ctx *ctx, LR_SIZE_T i, uint8_t *error, uint8_t code)
+{
+  if (error) *error = code;
+  LRM_FLAGS(ctx, i) |= (code == LVUFC_MISMATCH) ? LOLAN_REGMAP_REMOTE_UPDATE_MISMATCH_BIT
+                                                : LOLAN_REGMAP_REMOTE_UPDATE_OUTOFRANGE_BIT;  // set flag
+  return LOLAN_RETVAL_NO;
+} /* lolanUpdateReject */
+
+/* type mismatch */
+static int8_t lolanUpdateMismatch(lolan_ctx *ctx, LR_SIZE_T i, const lolan_CborCursor *cur, uint8_t *error)
+{
+  (void) cur;
+  return lolanUpdateReject(ctx, i, error, LVUFC_MISMATCH);
+} /* lolanUpdateMismatch */
+
+/* CBOR negative integer to unsigned integer: out of range */
+static int8_t lolanUpdateOutOfRange(lolan_ctx *ctx, LR_SIZE_T i, const lolan_CborCursor *cur, uint8_t *error)
+{
+  (void) cur;
+  return lolanUpdateReject(ctx, i, error, LVUFC_OUTOFRANGE);
+} /* lolanUpdateOutOfRange */
+
+/* CBOR integer to an integer variable of unsupported size */
+static int8_t lolanUpdateBadSize(lolan_ctx *ctx, LR_SIZE_T i, const lolan_CborCursor *cur, uint8_t *error)
+{
+  (void) ctx; (void) i; (void) cur; (void) error;
+  return LOLAN_RETVAL_GENERROR;   // unsupported integer size
+} /* lolanUpdateBadSize */
+
+/* CBOR non-negative integer to integer variable (name, C type, maximum value) */
+#define LOLAN_UPDATE_KERNEL_UINT(name, ctype, max)                                        \
+static int8_t name(lolan_ctx *ctx, LR_SIZE_T i, const lolan_CborCursor *cur, uint8_t *error)  \
+{                                                                                         \
+  uint64_t val;                                                                           \
+                                                                                          \
+  val = lolanCborCursorGetUint(cur);   /* decode value */                                 \
+  if (val > (max)) return lolanUpdateReject(ctx, i, error, LVUFC_OUTOFRANGE);             \
+  *((ctype*) LRM_DATA(ctx, i)) = val;   /* update value */                                \
+  lolanFlagSet(ctx, i, LOLAN_REGMAP_REMOTE_UPDATE_BIT);  /* set flag */                   \
+  return LOLAN_RETVAL_YES;                                                                \
+}
+
+/* CBOR negative integer to signed integer variable (name, C type, minimum and maximum value) */
+#define LOLAN_UPDATE_KERNEL_NEGINT(name, ctype, min, max)                                 \
+static int8_t name(lolan_ctx *ctx, LR_SIZE_T i, const lolan_CborCursor *cur, uint8_t *error)  \
+{                                                                                         \
+  int64_t val;                                                                            \
+                                                                                          \
+  val = (int64_t) ~lolanCborCursorGetUint(cur);   /* decode value (-1 - argument) */     \
+  if ((val > (max)) || (val < (min))) return lolanUpdateReject(ctx, i, error, LVUFC_OUTOFRANGE);  \
+  *((ctype*) LRM_DATA(ctx, i)) = val;   /* update value */                                \
+  lolanFlagSet(ctx, i, LOLAN_REGMAP_REMOTE_UPDATE_BIT);  /* set flag */                   \
+  return LOLAN_RETVAL_YES;                                                                \
+}
+
+LOLAN_UPDATE_KERNEL_UINT(lolanUpdateUintToInt8, int8_t, INT8_MAX)
+LOLAN_UPDATE_KERNEL_UINT(lolanUpdateUintToInt16, int16_t, INT16_MAX)
+LOLAN_UPDATE_KERNEL_UINT(lolanUpdateUintToInt32, int32_t, (uint64_t) INT32_MAX)
+LOLAN_UPDATE_KERNEL_UINT(lolanUpdateUintToInt64, int64_t, (uint64_t) INT64_MAX)
+LOLAN_UPDATE_KERNEL_UINT(lolanUpdateUintToUint8, uint8_t, UINT8_MAX)
+LOLAN_UPDATE_KERNEL_UINT(lolanUpdateUintToUint16, uint16_t, UINT16_MAX)
+LOLAN_UPDATE_KERNEL_UINT(lolanUpdateUintToUint32, uint32_t, UINT32_MAX)
+LOLAN_UPDATE_KERNEL_NEGINT(lolanUpdateNegintToInt8, int8_t, INT8_MIN, INT8_MAX)
+LOLAN_UPDATE_KERNEL_NEGINT(lolanUpdateNegintToInt16, int16_t, INT16_MIN, INT16_MAX)
+LOLAN_UPDATE_KERNEL_NEGINT(lolanUpdateNegintToInt32, int32_t, INT32_MIN, INT32_MAX)
+
+/* CBOR non-negative integer to 64-bit unsigned integer (can not be out of range) */
+static int8_t lolanUpdateUintToUint64(lolan_ctx *ctx, LR_SIZE_T i, const lolan_CborCursor *cur, uint8_t *error)
+{
+  uint64_t val;
+
+  (void) error;
+  val = lolanCborCursorGetUint(cur);   // decode value
+  *((uint64_t*) LRM_DATA(ctx, i)) = val;   // update value
+  lolanFlagSet(ctx, i, LOLAN_REGMAP_REMOTE_UPDATE_BIT);  // set flag
+  return LOLAN_RETVAL_YES;
+} /* lolanUpdateUintToUint64 */
+
+/* CBOR negative integer to 64-bit signed integer (can not be out of range) */
+static int8_t lolanUpdateNegintToInt64(lolan_ctx *ctx, LR_SIZE_T i, const lolan_CborCursor *cur, uint8_t *error)
+{
+  int64_t val;
+
+  (void) error;
+  val = (int64_t) ~lolanCborCursorGetUint(cur);   // decode value (-1 - argument)
+  *((int64_t*) LRM_DATA(ctx, i)) = val;   // update value
+  lolanFlagSet(ctx, i, LOLAN_REGMAP_REMOTE_UPDATE_BIT);  // set flag
+  return LOLAN_RETVAL_YES;
+} /* lolanUpdateNegintToInt64 */
+
+/* CBOR single precision floating point to 4-byte floating point variable */
+static int8_t lolanUpdateFloat(lolan_ctx *ctx, LR_SIZE_T i, const lolan_CborCursor *cur, uint8_t *error)
+{
+  uint32_t bits;
+  float val;
+
+  (void) error;
+  bits = lolanCborCursorGetUint(cur);
+  memcpy(&val, &bits, 4);   // decode value
+  *((float*) LRM_DATA(ctx, i)) = val;   // update value
+  lolanFlagSet(ctx, i, LOLAN_REGMAP_REMOTE_UPDATE_BIT);  // set flag
+  return LOLAN_RETVAL_YES;
+} /* lolanUpdateFloat */
+
+/* CBOR double precision floating point to 8-byte floating point variable */
+static int8_t lolanUpdateDouble(lolan_ctx *ctx, LR_SIZE_T i, const lolan_CborCursor *cur, uint8_t *error)
+{
+  uint64_t bits;
+  double val;
+
+  (void) error;
+  bits = lolanCborCursorGetUint(cur);
+  memcpy(&val, &bits, 8);   // decode value
+  *((double*) LRM_DATA(ctx, i)) = val;   // update value
+  lolanFlagSet(ctx, i, LOLAN_REGMAP_REMOTE_UPDATE_BIT);  // set flag
+  return LOLAN_RETVAL_YES;
+} /* lolanUpdateDouble */
+
+/* CBOR byte or text string to string variable */
+static int8_t lolanUpdateStr(lolan_ctx *ctx, LR_SIZE_T i, const lolan_CborCursor *cur, uint8_t *error)
+{
+  size_t len;
+
+  len = lolanCborCursorStringLength(cur);   // calculate CBOR string length
+  if (LRM_SIZE(ctx, i) < len+1)   // the string is too long (+1: terminating zero should also fit)
+    return lolanUpdateReject(ctx, i, error, LVUFC_OUTOFRANGE);
+  lolanCborCursorCopyString(cur, LRM_DATA(ctx, i), LRM_SIZE(ctx, i));   // update value
+  lolanFlagSet(ctx, i, LOLAN_REGMAP_REMOTE_UPDATE_BIT);  // set flag
+  return LOLAN_RETVAL_YES;
+} /* lolanUpdateStr */
+
+/* CBOR byte string to arbitrary data variable */
+static int8_t lolanUpdateData(lolan_ctx *ctx, LR_SIZE_T i, const lolan_CborCursor *cur, uint8_t *error)
+{
+  size_t len;
+
+  len = lolanCborCursorStringLength(cur);   // calculate CBOR string length
+#ifdef LOLAN_ALLOW_VARLEN_LOLANDATA
+  if (LRM_SIZE(ctx, i) < len || len == 0) {  // length must be non-zero and less-or-equal than variable size
+#else
+  if (LRM_SIZE(ctx, i) != len) {  // arbitrary data should be exactly the same length when setting
+#endif
+    return lolanUpdateReject(ctx, i, error, LVUFC_OUTOFRANGE);
+  }
+  lolanCborCursorCopyString(cur, LRM_DATA(ctx, i), LRM_SIZE(ctx, i));   // update value
+#ifdef LOLAN_ALLOW_VARLEN_LOLANDATA
+  LRM_SIZEACTUAL(ctx, i) = len;   // store actual length
+#endif
+  lolanFlagSet(ctx, i, LOLAN_REGMAP_REMOTE_UPDATE_BIT);  // set flag
+  return LOLAN_RETVAL_YES;
+} /* lolanUpdateData */
+
+/* update kernels by variable kind and CBOR item kind */
+static const lolanUpdateKernel lolanUpdateKernels[LUK_VAR_KINDS][LUK_CBOR_KINDS] = {
+  /*                   UINT                      NEGINT                    BYTES                TEXT                 FLOAT                DOUBLE */
+  /* INVALID */      { lolanUpdateMismatch,      lolanUpdateMismatch,      lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch },
+  /* INT8 */         { lolanUpdateUintToInt8,    lolanUpdateNegintToInt8,  lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch },
+  /* INT16 */        { lolanUpdateUintToInt16,   lolanUpdateNegintToInt16, lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch },
+  /* INT32 */        { lolanUpdateUintToInt32,   lolanUpdateNegintToInt32, lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch },
+  /* INT64 */        { lolanUpdateUintToInt64,   lolanUpdateNegintToInt64, lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch },
+  /* INTX */         { lolanUpdateBadSize,       lolanUpdateBadSize,       lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch },
+  /* UINT8 */        { lolanUpdateUintToUint8,   lolanUpdateOutOfRange,    lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch },
+  /* UINT16 */       { lolanUpdateUintToUint16,  lolanUpdateOutOfRange,    lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch },
+  /* UINT32 */       { lolanUpdateUintToUint32,  lolanUpdateOutOfRange,    lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch },
+  /* UINT64 */       { lolanUpdateUintToUint64,  lolanUpdateOutOfRange,    lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch },
+  /* UINTX */        { lolanUpdateBadSize,       lolanUpdateOutOfRange,    lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch },
+  /* FLOAT */        { lolanUpdateMismatch,      lolanUpdateMismatch,      lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateFloat,    lolanUpdateMismatch },
+  /* DOUBLE */       { lolanUpdateMismatch,      lolanUpdateMismatch,      lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateDouble },
+  /* FLOATX */       { lolanUpdateMismatch,      lolanUpdateMismatch,      lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch },
+  /* STR */          { lolanUpdateMismatch,      lolanUpdateMismatch,      lolanUpdateStr,      lolanUpdateStr,      lolanUpdateMismatch, lolanUpdateMismatch },
+  /* DATA */         { lolanUpdateMismatch,      lolanUpdateMismatch,      lolanUpdateData,     lolanUpdateMismatch, lolanUpdateMismatch, lolanUpdateMismatch },
+};
+
+/* variable kinds by type and size (1, 2, 4, 8, other) */
+static const uint8_t lolanUpdateVarKinds[LOLAN_DATA+1][5] = {
+  { LUK_VAR_INVALID, LUK_VAR_INVALID, LUK_VAR_INVALID, LUK_VAR_INVALID, LUK_VAR_INVALID },
+  { LUK_VAR_INT8,    LUK_VAR_INT16,   LUK_VAR_INT32,   LUK_VAR_INT64,   LUK_VAR_INTX },      // LOLAN_INT
+  { LUK_VAR_UINT8,   LUK_VAR_UINT16,  LUK_VAR_UINT32,  LUK_VAR_UINT64,  LUK_VAR_UINTX },     // LOLAN_UINT
+  { LUK_VAR_FLOATX,  LUK_VAR_FLOATX,  LUK_VAR_FLOAT,   LUK_VAR_DOUBLE,  LUK_VAR_FLOATX },    // LOLAN_FLOAT
+  { LUK_VAR_STR,     LUK_VAR_STR,     LUK_VAR_STR,     LUK_VAR_STR,     LUK_VAR_STR },       // LOLAN_STR
+  { LUK_VAR_DATA,    LUK_VAR_DATA,    LUK_VAR_DATA,    LUK_VAR_DATA,    LUK_VAR_DATA },      // LOLAN_DATA
+};
+
+/* size classes of the variable kinds (index: size in bytes, up to 8) */
+static const uint8_t lolanUpdateSizeClasses[9] = { 4, 0, 1, 4, 2, 4, 4, 4, 3 };
+
+/**************************************************************************//**
+ * @brief
+ *   Get the update kernel variable kind of a LoLaN variable.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] i
+ *   The register map index of the variable.
+ * @return
+ *   The variable kind (row of lolanUpdateKernels).
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static inline uint8_t lolanUpdateVarKind(lolan_ctx *ctx, LR_SIZE_T i)
+{
+  uint16_t type;
+  LV_SIZE_T size;
+
+  type = LRM_FLAGS(ctx, i) & LOLAN_REGMAP_TYPE_MASK;
+  size = LRM_SIZE(ctx, i);
+  if (type > LOLAN_DATA) return LUK_VAR_INVALID;
+  return lolanUpdateVarKinds[type][(size <= 8) ? lolanUpdateSizeClasses[size] : 4];
+} /* lolanUpdateVarKind */
+
 /**************************************************************************//**
  * @brief
  *   Update a single LoLaN variable from CBOR.
  * @details
- *   This subroutine reads the next CBOR item and tries to update the LoLaN
- *   variable specified by path with the data. The CBOR iterator will
- *   be advanced in all cases.
+ *   This subroutine decodes the CBOR item at a cursor and tries to update
+ *   the LoLaN variable specified by path with the data. The cursor is not
+ *   advanced (see lolanCborCursorAdvance()).
  * @param[in] ctx
  *   Pointer to the LoLaN context variable.
  * @param[in] path
  *   Address of the uint8_t array containing the path of the LoLaN
  *   variable to update.
- * @param[in] it
- *   Pointer to CborValue (iterator).
+ * @param[in] cur
+ *   Pointer to the cursor (in a validated payload).
  * @param[out] error
  *   Address of the uint8_t variable that receives the variable update
  *   result. Set this parameter to null if this output is not required.
@@ -550,319 +1947,102 @@ int8_t lolanGetDataFromCbor(CborValue *it, uint8_t *data, LV_SIZE_T data_max,
  *   LOLAN_RETVAL_GENERROR:  A general error has occurred.
  *   LOLAN_RETVAL_CBORERROR:  A CBOR error has occurred.
  ******************************************************************************/
-int8_t lolanVarUpdateFromCbor(lolan_ctx *ctx, const uint8_t *path, CborValue *it, uint8_t *error)
+int8_t lolanVarUpdateFromCbor(lolan_ctx *ctx, const uint8_t *path, const lolan_CborCursor *cur, uint8_t *error)
 {
   LR_SIZE_T i;
-  bool found;
-
-  CborType type;
-  CborError cerr;
 
   /* searching for the variable by path */
-  found = false;
-  for (i = 0; i < LOLAN_REGMAP_SIZE; i++)
-    if ( (memcmp(ctx->regMap[i].p, path, LOLAN_REGMAP_DEPTH) == 0) &&   // path found
-         (ctx->regMap[i].p[0] != 0)                       ) {   // register map entry is valid
-      found = true;
-      break;
-    }
-  if (!found) {  // variable not found
-    cerr = cbor_value_advance(it);   // advance CBOR iterator
-    if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
+  i = lolanRegMapFindByPath(ctx, path);
+  if (i >= LOLAN_REGMAP_SIZE) {  // variable not found
     if (error) *error = LVUFC_NOTFOUND;
     return LOLAN_RETVAL_NO;
   }
 
+  return lolanVarIndexUpdateFromCbor(ctx, i, cur, error);
+} /* lolanVarUpdateFromCbor */
+
+/**************************************************************************//**
+ * @brief
+ *   Update a single LoLaN variable specified by its register map index
+ *   from CBOR.
+ * @details
+ *   Same as lolanVarUpdateFromCbor(), but the variable is already found
+ *   (the error output is never LVUFC_NOTFOUND).
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] i
+ *   The register map index of the variable to update.
+ * @param[in] cur
+ *   Pointer to the cursor (in a validated payload).
+ * @param[out] error
+ *   Address of the uint8_t variable that receives the variable update
+ *   result (see lolanVarUpdateFromCbor()). May be NULL.
+ * @return
+ *   See lolanVarUpdateFromCbor().
+ ******************************************************************************/
+int8_t lolanVarIndexUpdateFromCbor(lolan_ctx *ctx, LR_SIZE_T i, const lolan_CborCursor *cur, uint8_t *error)
+{
+  lolanUpdateKernel_cbor kind;
+
   /* flags */
-  ctx->regMap[i].flags &= ~(LOLAN_REGMAP_REMOTE_UPDATE_OUTOFRANGE_BIT + LOLAN_REGMAP_REMOTE_UPDATE_MISMATCH_BIT
+  lolanFlagClear(ctx, i, LOLAN_REGMAP_REMOTE_UPDATE_OUTOFRANGE_BIT + LOLAN_REGMAP_REMOTE_UPDATE_MISMATCH_BIT
            + LOLAN_REGMAP_REMOTE_UPDATE_BIT);   // clear flags
-  ctx->regMap[i].flags |= LOLAN_REGMAP_AUX_BIT;  // set auxiliary flag
+  lolanFlagSet(ctx, i, LOLAN_REGMAP_AUX_BIT);  // set auxiliary flag
 
   /* check for read-only */
-  if (ctx->regMap[i].flags & LOLAN_REGMAP_REMOTE_READONLY_BIT) {  // read-only
-    cerr = cbor_value_advance(it);   // advance CBOR iterator
-    if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
+  if (LRM_FLAGS(ctx, i) & LOLAN_REGMAP_REMOTE_READONLY_BIT) {  // read-only
     if (error) *error = LVUFC_READONLY;
     return LOLAN_RETVAL_NO;
   }
 
-  /* check the CBOR item type and update LoLaN variable if possible */
-  type = cbor_value_get_type(it);
-  switch (type) {
-    case CborIntegerType:
-      if (cbor_value_is_unsigned_integer(it)) {   // non-negative integer
-        uint64_t val;
-        cbor_value_get_uint64(it, &val);  // decode value
-        cerr = cbor_value_advance_fixed(it);   // advance CBOR iterator
-        if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-        switch (ctx->regMap[i].flags & LOLAN_REGMAP_TYPE_MASK) {  // type checking
-          case LOLAN_INT:   // the CBOR item is a non-negative integer, the LoLaN variable is a signed integer
-            switch (ctx->regMap[i].size) {
-              case 1:  // 8-bit signed
-                if (val > INT8_MAX) {   // out of range
-                  if (error) *error = LVUFC_OUTOFRANGE;
-                  ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_OUTOFRANGE_BIT;  // set flag
-                  return LOLAN_RETVAL_NO;
-                }
-                *((int8_t*) ctx->regMap[i].data) = val;   // update value
-                ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_BIT;  // set flag
-                break;
-              case 2:  // 16-bit signed
-                if (val > INT16_MAX) {   // out of range
-                  if (error) *error = LVUFC_OUTOFRANGE;
-                  ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_OUTOFRANGE_BIT;  // set flag
-                  return LOLAN_RETVAL_NO;
-                }
-                *((int16_t*) ctx->regMap[i].data) = val;   // update value
-                ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_BIT;  // set flag
-                break;
-              case 4:  // 32-bit signed
-                if (val > (uint64_t) INT32_MAX) {   // out of range
-                  if (error) *error = LVUFC_OUTOFRANGE;
-                  ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_OUTOFRANGE_BIT;  // set flag
-                  return LOLAN_RETVAL_NO;
-                }
-                *((int32_t*) ctx->regMap[i].data) = val;   // update value
-                ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_BIT;  // set flag
-                break;
-              case 8:  // 64-bit signed
-                if (val > (uint64_t) INT64_MAX) {   // out of range
-                  if (error) *error = LVUFC_OUTOFRANGE;
-                  ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_OUTOFRANGE_BIT;  // set flag
-                  return LOLAN_RETVAL_NO;
-                }
-                *((int64_t*) ctx->regMap[i].data) = val;   // update value
-                ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_BIT;  // set flag
-                break;
-              default:   // (unlikely)
-                return LOLAN_RETVAL_GENERROR;   // unsupported integer size
-                break;
-            }
-            break;
-          case LOLAN_UINT:   // the CBOR item is a non-negative integer, the LoLaN variable is an unsigned integer
-            switch (ctx->regMap[i].size) {
-              case 1:  // 8-bit unsigned
-                if (val > UINT8_MAX) {   // out of range
-                  if (error) *error = LVUFC_OUTOFRANGE;
-                  ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_OUTOFRANGE_BIT;  // set flag
-                  return LOLAN_RETVAL_NO;
-                }
-                *((uint8_t*) ctx->regMap[i].data) = val;   // update value
-                ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_BIT;  // set flag
-                break;
-              case 2:  // 16-bit unsigned
-                if (val > UINT16_MAX) {   // out of range
-                  if (error) *error = LVUFC_OUTOFRANGE;
-                  ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_OUTOFRANGE_BIT;  // set flag
-                  return LOLAN_RETVAL_NO;
-                }
-                *((uint16_t*) ctx->regMap[i].data) = val;   // update value
-                ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_BIT;  // set flag
-                break;
-              case 4:  // 32-bit unsigned
-                if (val > UINT32_MAX) {   // out of range
-                  if (error) *error = LVUFC_OUTOFRANGE;
-                  ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_OUTOFRANGE_BIT;  // set flag
-                  return LOLAN_RETVAL_NO;
-                }
-                *((uint32_t*) ctx->regMap[i].data) = val;   // update value
-                ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_BIT;  // set flag
-                break;
-              case 8:  // 64-bit unsigned
-                /* (can not be out of range) */
-                *((uint64_t*) ctx->regMap[i].data) = val;   // update value
-                ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_BIT;  // set flag
-                break;
-              default:   // (unlikely)
-                return LOLAN_RETVAL_GENERROR;   // unsupported integer size
-                break;
-            }
-            break;
-          default:   // type mismatch
-            if (error) *error = LVUFC_MISMATCH;
-            ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_MISMATCH_BIT;  // set flag
-            return LOLAN_RETVAL_NO;
-            break;
-        }
-      } else {   // negative integer
-        int64_t val;
-        cbor_value_get_int64(it, &val);   // decode value
-        cerr = cbor_value_advance_fixed(it);   // advance CBOR iterator
-        if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-        switch (ctx->regMap[i].flags & LOLAN_REGMAP_TYPE_MASK) {  // type checking
-          case LOLAN_INT:   // the CBOR item is a negative integer, the LoLaN variable is a signed integer
-            switch (ctx->regMap[i].size) {
-              case 1:  // 8-bit signed
-                if ((val > INT8_MAX) || (val < INT8_MIN)) {   // out of range
-                  if (error) *error = LVUFC_OUTOFRANGE;
-                  ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_OUTOFRANGE_BIT;  // set flag
-                  return LOLAN_RETVAL_NO;
-                }
-                *((int8_t*) ctx->regMap[i].data) = val;   // update value
-                ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_BIT;  // set flag
-                break;
-              case 2:  // 16-bit signed
-                if ((val > INT16_MAX) || (val < INT16_MIN)) {   // out of range
-                  if (error) *error = LVUFC_OUTOFRANGE;
-                  ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_OUTOFRANGE_BIT;  // set flag
-                  return LOLAN_RETVAL_NO;
-                }
-                *((int16_t*) ctx->regMap[i].data) = val;   // update value
-                ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_BIT;  // set flag
-                break;
-              case 4:  // 32-bit signed
-                if ((val > INT32_MAX) || (val < INT32_MIN)) {   // out of range
-                  if (error) *error = LVUFC_OUTOFRANGE;
-                  ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_OUTOFRANGE_BIT;  // set flag
-                  return LOLAN_RETVAL_NO;
-                }
-                *((int32_t*) ctx->regMap[i].data) = val;   // update value
-                ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_BIT;  // set flag
-                break;
-              case 8:  // 64-bit signed
-                /* (can not be out of range) */
-                *((int64_t*) ctx->regMap[i].data) = val;   // update value
-                ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_BIT;  // set flag
-                break;
-              default:   // (unlikely)
-                return LOLAN_RETVAL_GENERROR;   // unsupported integer size
-                break;
-            }
-            break;
-          case LOLAN_UINT:   // the CBOR item is a negative integer, the LoLaN variable is an unsigned integer
-            /* out of range */
-            if (error) *error = LVUFC_OUTOFRANGE;
-            ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_OUTOFRANGE_BIT;  // set flag
-            return LOLAN_RETVAL_NO;
-            break;
-          default:   // type mismatch
-            if (error) *error = LVUFC_MISMATCH;
-            ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_MISMATCH_BIT;  // set flag
-            return LOLAN_RETVAL_NO;
-            break;
-        }
-      }
+  /* select the update kernel by the CBOR item type */
+  switch (*cur->ptr >> 5) {   // major type
+    case 0:
+      kind = LUK_CBOR_UINT;
       break;
-    case CborByteStringType:
-      if ((ctx->regMap[i].flags & LOLAN_REGMAP_TYPE_MASK) == LOLAN_STR) {   // type checking: string?
-        size_t len;
-        cerr = cbor_value_calculate_string_length(it, &len);   // calculate CBOR string length
-        if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-        if (ctx->regMap[i].size < len+1) {  // the string is too long (+1: terminating zero should also fit)
-          cerr = cbor_value_advance(it);   // advance CBOR iterator
-          if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-          if (error) *error = LVUFC_OUTOFRANGE;
-          ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_OUTOFRANGE_BIT;  // set flag
-          return LOLAN_RETVAL_NO;
-        }
-        len = ctx->regMap[i].size;
-        cbor_value_copy_byte_string(it, ctx->regMap[i].data, &len, it);   // update value (the CBOR iterator is also advanced)
-        ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_BIT;  // set flag
-      } else if ((ctx->regMap[i].flags & LOLAN_REGMAP_TYPE_MASK) == LOLAN_DATA) {   // type checking: arbitrary data?
-        size_t len;
-        cerr = cbor_value_calculate_string_length(it, &len);   // calculate CBOR string length
-        if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-#ifdef LOLAN_ALLOW_VARLEN_LOLANDATA
-        if (ctx->regMap[i].size < len || len == 0) {  // length must be non-zero and less-or-equal than variable size
-#else
-        if (ctx->regMap[i].size != len) {  // arbitrary data should be exactly the same length when setting
-#endif
-          cerr = cbor_value_advance(it);   // advance CBOR iterator
-          if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-          if (error) *error = LVUFC_OUTOFRANGE;
-          ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_OUTOFRANGE_BIT;  // set flag
-          return LOLAN_RETVAL_NO;
-        }
-        len = ctx->regMap[i].size;
-        cbor_value_copy_byte_string(it, ctx->regMap[i].data, &len, it);   // update value (the CBOR iterator is also advanced)
-#ifdef LOLAN_ALLOW_VARLEN_LOLANDATA
-        ctx->regMap[i].sizeActual = len;   // store actual length
-#endif
-        ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_BIT;  // set flag
-      } else {   // type mismatch
-        cerr = cbor_value_advance(it);   // advance CBOR iterator
-        if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-        if (error) *error = LVUFC_MISMATCH;
-        ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_MISMATCH_BIT;  // set flag
-        return LOLAN_RETVAL_NO;
-      }
+    case 1:
+      kind = LUK_CBOR_NEGINT;
       break;
-    case CborTextStringType:
-      if ((ctx->regMap[i].flags & LOLAN_REGMAP_TYPE_MASK) == LOLAN_STR) {   // type checking
-        size_t len;
-        cerr = cbor_value_calculate_string_length(it, &len);   // calculate CBOR string length
-        if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-        if (ctx->regMap[i].size < len+1) {  // the string is too long (+1: terminating zero should also fit)
-          cerr = cbor_value_advance(it);   // advance CBOR iterator
-          if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-          if (error) *error = LVUFC_OUTOFRANGE;
-          ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_OUTOFRANGE_BIT;  // set flag
-          return LOLAN_RETVAL_NO;
-        }
-        len = ctx->regMap[i].size;
-        cbor_value_copy_text_string(it, ctx->regMap[i].data, &len, it);   // update value (the CBOR iterator is also advanced)
-        ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_BIT;  // set flag
-      } else {   // type mismatch
-        cerr = cbor_value_advance(it);   // advance CBOR iterator
-        if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-        if (error) *error = LVUFC_MISMATCH;
-        ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_MISMATCH_BIT;  // set flag
-        return LOLAN_RETVAL_NO;
-      }
+    case 2:
+      kind = LUK_CBOR_BYTES;
       break;
-    case CborFloatType:
-      if ( ((ctx->regMap[i].flags & LOLAN_REGMAP_TYPE_MASK) == LOLAN_FLOAT)
-                && (ctx->regMap[i].size == 4) )   {   // type checking
-        float val;
-        cbor_value_get_float(it, &val);   // get value
-        cerr = cbor_value_advance_fixed(it);   // advance CBOR iterator
-        if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-        *((float*) ctx->regMap[i].data) = val;   // update value
-        ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_BIT;  // set flag
-      } else {   // type mismatch (single and double precision floating point are treated as different types)
-        cerr = cbor_value_advance_fixed(it);   // advance CBOR iterator
-        if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-        if (error) *error = LVUFC_MISMATCH;
-        ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_MISMATCH_BIT;  // set flag
-        return LOLAN_RETVAL_NO;
-      }
+    case 3:
+      kind = LUK_CBOR_TEXT;
       break;
-    case CborDoubleType:
-      if ( ((ctx->regMap[i].flags & LOLAN_REGMAP_TYPE_MASK) == LOLAN_FLOAT)
-                && (ctx->regMap[i].size == 8) )   {   // type checking
-        double val;
-        cbor_value_get_double(it, &val);   // get value
-        cerr = cbor_value_advance_fixed(it);   // advance CBOR iterator
-        if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-        *((double*) ctx->regMap[i].data) = val;   // update value
-        ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_BIT;  // set flag
-      } else {   // type mismatch (single and double precision floating point are treated as different types)
-        cerr = cbor_value_advance_fixed(it);   // advance CBOR iterator
-        if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-        if (error) *error = LVUFC_MISMATCH;
-        ctx->regMap[i].flags |= LOLAN_REGMAP_REMOTE_UPDATE_MISMATCH_BIT;  // set flag
-        return LOLAN_RETVAL_NO;
+    case 7:
+      if (*cur->ptr == 0xfa) {
+        kind = LUK_CBOR_FLOAT;
+      } else if (*cur->ptr == 0xfb) {
+        kind = LUK_CBOR_DOUBLE;
+      } else {   // simple value or half precision floating-point (not allowed in LoLaN)
+        return LOLAN_RETVAL_GENERROR;
       }
       break;
-    case CborInvalidType:   // invalid CBOR entry
-      return LOLAN_RETVAL_CBORERROR;
-      break;
     default:   // type not allowed in LoLaN
       return LOLAN_RETVAL_GENERROR;
       break;
   }
 
-  return LOLAN_RETVAL_YES;
-} /* lolanVarUpdateFromCbor */
+  /* update the LoLaN variable if possible (check type and range, set flags) */
+  return lolanUpdateKernels[lolanUpdateVarKind(ctx, i)][kind](ctx, i, cur, error);
+} /* lolanVarIndexUpdateFromCbor */
 
 /**************************************************************************//**
  * @brief
  *   Update a bunch of LoLaN variables nested by path from CBOR.
  * @details
  *   This subroutine processes the nested path structure in CBOR
- *   which resides in the specified LoLaN packet, and tries to update the
- *   LoLaN variables specified by paths with the corresponding data.
- *   The zero key CBOR entry will be skipped.
+ *   (the entries of the root map of a LoLaN packet payload), and tries to
+ *   update the LoLaN variables specified by paths with the corresponding
+ *   data. The zero key CBOR entry will be skipped.
+ *   The status codes of the affected variables can be encoded in the same
+ *   pass, nested by path (see lolanVarFlagToCbor() with statusCodeInstead).
+ *   This output is valid only if the paths of the affected variables are
+ *   in increasing order in the CBOR data (each variable at most once),
+ *   otherwise the unsorted field of the info output is set, and the status
+ *   codes should be encoded by the LOLAN_REGMAP_AUX_BIT flags. If the
+ *   status codes do not fit in the encoder buffer, the encoding is stopped
+ *   (the updates are continued).
  *
  *   Example of variables with nested path structure:
  *
@@ -890,9 +2070,13 @@ int8_t lolanVarUpdateFromCbor(lolan_ctx *ctx, const uint8_t *path, CborValue *it
  *   See lolanVarUpdateFromCbor() for more details.
  * @param[in] ctx
  *   Pointer to the LoLaN context variable.
- * @param[in] lp
- *   Pointer to a LoLaN packet structure, whose payload contains the nested
- *   path structure in CBOR format.
+ * @param[in,out] map_cur
+ *   Pointer to the cursor of the root map of the validated payload
+ *   (entered, and advanced to the entry where the processing is started).
+ * @param[in] status
+ *   Pointer to the CBOR encoder which receives the status codes (the
+ *   nested maps are encoded as top-level items, the caller should put
+ *   them into a map). Set to NULL if this output is not required.
  * @param[out] info
  *   Address of a structure that will be filled with information about the
  *   successfulness of the action.
@@ -907,6 +2091,11 @@ int8_t lolanVarUpdateFromCbor(lolan_ctx *ctx, const uint8_t *path, CborValue *it
  *     The CBOR data specifies variable(s) whose path length exceeds the
  *     register map depth of the current implementation. These entries
  *     were ignored.
+ *    statuses
+ *     The number of status codes encoded.
+ *    unsorted
+ *     The status codes are not encoded because the affected variables are
+ *     not in increasing path order.
  *   (Total success: found = updated, notfound = 0, toodeep = false)
  * @return
  *   LOLAN_RETVAL_YES:  The action was completed (the end of the nested path
@@ -915,51 +2104,43 @@ int8_t lolanVarUpdateFromCbor(lolan_ctx *ctx, const uint8_t *path, CborValue *it
  *   LOLAN_RETVAL_GENERROR:  A general error has occurred.
  *   LOLAN_RETVAL_CBORERROR:  A CBOR error has occurred.
  ******************************************************************************/
-int8_t lolanVarBunchUpdateFromCbor(lolan_ctx *ctx, const lolan_Packet *lp,
+int8_t lolanVarBunchUpdateFromCbor(lolan_ctx *ctx, lolan_CborCursor *map_cur, CborEncoder *status,
                lolan_BunchUpdateOutputStruct *info)
 {
-  uint8_t path[LOLAN_REGMAP_DEPTH];
+  uint8_t path[LOLAN_REGMAP_DEPTH], last_path[LOLAN_REGMAP_DEPTH];
   uint8_t i, alevel;
+  LR_SIZE_T index;
   int key;
   int8_t err;
   uint8_t exterr;
+  bool statusFull;
+  lolanVarToCborNestedPath_state stv;
 
-  CborParser parser;
-  CborValue root_it, it[LOLAN_REGMAP_DEPTH];
-  CborError cerr;
+  lolan_CborCursor cur[LOLAN_REGMAP_DEPTH];
 
-  /* initialize and enter the root container (map) */
-  cerr = cbor_parser_init(lp->payload, lp->payloadSize, 0, &parser, &root_it);  // initialize CBOR parser
-  if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-  if (cbor_value_get_type(&root_it) != CborMapType) {   // the root entry must be a CBOR map
-    DLOG(("\n LoLaN CBOR packet error: root map not found"));
-    return LOLAN_RETVAL_GENERROR;
-  }
-  cerr = cbor_value_enter_container(&root_it, &it[0]);   // enter root map
-  if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
+  cur[0] = *map_cur;   // (the root map level)
 
   /* zero the info output structure */
   memset(info, 0, sizeof(lolan_BunchUpdateOutputStruct));
+  statusFull = false;
 
   /* process the nested CBOR structure */
   alevel = 0;  // address level is 0 at this point
-  while (!((alevel == 0) && cbor_value_at_end(&it[alevel]))) {   // until entries are available in the root map level
+  while (!((alevel == 0) && LOLAN_CBOR_AT_END(&cur[alevel]))) {   // until entries are available in the root map level
     /* check for end of container */
-    if (cbor_value_at_end(&it[alevel])) {   // end of map (alevel is always >0 at this point)
-      cerr = cbor_value_leave_container(&it[alevel-1], &it[alevel]);   // leave container
+    if (LOLAN_CBOR_AT_END(&cur[alevel])) {   // end of map (alevel is always >0 at this point)
+      lolanCborCursorLeave(&cur[alevel-1], &cur[alevel]);   // leave container
       alevel--;  // decrement current address level
-      if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
       continue;
     }
     /* extract key */
-    if (cbor_value_get_type(&it[alevel]) != CborIntegerType) {  // check key of a key-data pair (must be integer)
+    if (!LOLAN_CBOR_IS_INTEGER(&cur[alevel])) {  // check key of a key-data pair (must be integer)
       DLOG(("\n LoLaN CBOR packet error: key has to be integer"));
       return LOLAN_RETVAL_GENERROR;
     }
-    cbor_value_get_int(&it[alevel], &key);   // get key
-    cerr = cbor_value_advance_fixed(&it[alevel]);   // advance iterator to data
-    if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
-    if (cbor_value_at_end(&it[alevel])) {   // unexpected end of map (no data for key)
+    key = lolanCborCursorGetInt(&cur[alevel]);   // get key
+    lolanCborCursorAdvance(&cur[alevel]);   // advance cursor to data
+    if (LOLAN_CBOR_AT_END(&cur[alevel])) {   // unexpected end of map (no data for key)
       DLOG(("\n LoLaN CBOR packet error: key must be followed by data"));
       return LOLAN_RETVAL_GENERROR;
     }
@@ -967,44 +2148,62 @@ int8_t lolanVarBunchUpdateFromCbor(lolan_ctx *ctx, const lolan_Packet *lp,
     if ((key <= 0) || (key > 255)) {   // zero key found, or key can not be a path element
       if (key != 0) info->invalid_keys++;  // update statistics
       /* advance to the next key */
-      cerr = cbor_value_advance(&it[alevel]);
-      if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
+      lolanCborCursorAdvance(&cur[alevel]);
     } else {   // other key found
       path[alevel] = key;  // store path element
-      if (cbor_value_get_type(&it[alevel]) == CborMapType) {  // the data is a map -> subpath branch
+      if (LOLAN_CBOR_IS_MAP(&cur[alevel])) {  // the data is a map -> subpath branch
         if (alevel < LOLAN_REGMAP_DEPTH-1) {  // entering a lower path level is o.k.
-          cerr = cbor_value_enter_container(&it[alevel], &it[alevel+1]);   // enter map
-          if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
+          lolanCborCursorEnter(&cur[alevel], &cur[alevel+1]);   // enter map
           alevel++;  // increment current address level
         } else {  // can not enter a lower path, skip this sub-branch
           info->toodeep = true;  // set indicator
-          cerr = cbor_value_advance(&it[alevel]);   // skip map
-          if (cerr != CborNoError) return LOLAN_RETVAL_CBORERROR;
+          lolanCborCursorAdvance(&cur[alevel]);   // skip map
         }
       } else {  // the data is not a map (may be valid data)
         for (i = alevel+1; i < LOLAN_REGMAP_DEPTH; i++)   // correct path with zeros if needed
           path[i] = 0;
-        err = lolanVarUpdateFromCbor(ctx, path, &it[alevel], &exterr);   // update LoLaN variable
-        switch (err) {
-          case LOLAN_RETVAL_YES:   // successfully updated
-            info->found++;   // update statistics
-            info->updated++;
-            break;
-          case LOLAN_RETVAL_NO:  // no update
-            if (exterr == LVUFC_NOTFOUND) {   // variable not found
-              info->notfound++;  // update statistics
-            } else {
-              info->found++;  // update statistics
-            }
-            break;
-          default:  // other errors
-            DLOG(("\n Error during lolanVarUpdateFromCbor()."));
-            return err;
-            break;
+        index = lolanRegMapFindByPath(ctx, path);   // searching for the variable by path
+        if (index >= LOLAN_REGMAP_SIZE) {   // variable not found
+          info->notfound++;  // update statistics
+          lolanCborCursorAdvance(&cur[alevel]);   // skip the data
+          continue;
+        }
+        err = lolanVarIndexUpdateFromCbor(ctx, index, &cur[alevel], &exterr);   // update LoLaN variable
+        if ((err != LOLAN_RETVAL_YES) && (err != LOLAN_RETVAL_NO)) {   // other errors
+          DLOG(("\n Error during lolanVarIndexUpdateFromCbor()."));
+          return err;
         }
+        lolanCborCursorAdvance(&cur[alevel]);   // advance to the next key
+        info->found++;   // update statistics
+        if (err == LOLAN_RETVAL_YES)
+          info->updated++;
+        /* encode the status code of the variable */
+        if ((status == NULL) || info->unsorted)
+          continue;
+        if ((info->found > 1) && (memcmp(path, last_path, LOLAN_REGMAP_DEPTH) <= 0)) {   // not after the previous variable (checked with a full buffer as well)
+          info->unsorted = true;
+          continue;
+        }
+        memcpy(last_path, path, LOLAN_REGMAP_DEPTH);
+        if (statusFull)
+          continue;
+        err = lolanVarToCborNestedPath(ctx, &stv, index, (info->statuses == 0) ? status : NULL,
+                (info->statuses == 0) ? LVTCNPAUX_INITIAL : LVTCNPAUX_NORMAL_FIT, true);
+        if (err == LOLAN_RETVAL_MEMERROR) {   // the encoder buffer is full (nothing was encoded)
+          statusFull = true;
+          continue;
+        }
+        if (err != LOLAN_RETVAL_YES) return err;
+        info->statuses++;
       }
     }
   }
+  *map_cur = cur[0];   // (at the end of the root map)
+
+  if ((info->statuses > 0) && !info->unsorted) {
+    err = lolanVarToCborNestedPath(ctx, &stv, 0, status, LVTCNPAUX_FINALIZE, true);   // finalize the status codes
+    if (err != LOLAN_RETVAL_YES) return err;
+  }
 
   return LOLAN_RETVAL_YES;  // done
 } /* lolanVarBunchUpdateFromCbor */
@@ -1172,39 +2371,152 @@ int8_t lolanVarDataToCbor(uint8_t *data, LV_SIZE_T data_len, lolan_VarType type,
 int8_t lolanVarToCbor(lolan_ctx *ctx, const uint8_t *path, LR_SIZE_T index, CborEncoder *encoder)
 {
   LR_SIZE_T i;
-  bool found;
 
   if (path) {   // path is assigned
     /* search for a variable with the specified path */
-    found = false;
-    for (i = 0; i < LOLAN_REGMAP_SIZE; i++) {
-      if ( (memcmp(ctx->regMap[i].p, path, LOLAN_REGMAP_DEPTH) == 0) &&    // variable found
-           (ctx->regMap[i].p[0] != 0)                       )  {   // register map entry is valid
-         found = true;
-         break;
-      }
-    }
-    if (!found) return LOLAN_RETVAL_GENERROR;   // no variable found
+    i = lolanRegMapFindByPath(ctx, path);
+    if (i >= LOLAN_REGMAP_SIZE) return LOLAN_RETVAL_GENERROR;   // no variable found
   } else {  // path is unassigned
     i = index;
-    if ((i >= LOLAN_REGMAP_SIZE) || (ctx->regMap[i].p[0] == 0))   // error
+    if ((i >= LOLAN_REGMAP_SIZE) || (LRM_P(ctx, i)[0] == 0))   // error
       return LOLAN_RETVAL_GENERROR;
   }
 
   /* encode variable */
 #ifdef LOLAN_ALLOW_VARLEN_LOLANDATA
-  if ((ctx->regMap[i].flags & LOLAN_REGMAP_TYPE_MASK) == LOLAN_DATA) {    // LOLAN_DATA with variable length option
-    return lolanVarDataToCbor(ctx->regMap[i].data, ctx->regMap[i].sizeActual, LOLAN_DATA, encoder);
+  if ((LRM_FLAGS(ctx, i) & LOLAN_REGMAP_TYPE_MASK) == LOLAN_DATA) {    // LOLAN_DATA with variable length option
+    return lolanVarDataToCbor(LRM_DATA(ctx, i), LRM_SIZEACTUAL(ctx, i), LOLAN_DATA, encoder);
   } else {   // other variable type
-    return lolanVarDataToCbor(ctx->regMap[i].data, ctx->regMap[i].size,
-                       ctx->regMap[i].flags & LOLAN_REGMAP_TYPE_MASK, encoder);
+    return lolanVarDataToCbor(LRM_DATA(ctx, i), LRM_SIZE(ctx, i),
+                       LRM_FLAGS(ctx, i) & LOLAN_REGMAP_TYPE_MASK, encoder);
   }
 #else
-  return lolanVarDataToCbor(ctx->regMap[i].data, ctx->regMap[i].size,
-                     ctx->regMap[i].flags & LOLAN_REGMAP_TYPE_MASK, encoder);
+  return lolanVarDataToCbor(LRM_DATA(ctx, i), LRM_SIZE(ctx, i),
+                     LRM_FLAGS(ctx, i) & LOLAN_REGMAP_TYPE_MASK, encoder);
 #endif
   } /* lolanVarToCbor */
 
+/**************************************************************************//**
+ * @brief
+ *   Compute the size of a CBOR unsigned integer (or the head of a
+ *   string).
+ ******************************************************************************/
+uint8_t lolanCborUintSize(uint64_t value)
+{
+  if (value < 24) return 1;
+  if (value <= UINT8_MAX) return 2;
+  if (value <= UINT16_MAX) return 3;
+  if (value <= UINT32_MAX) return 5;
+  return 9;
+} /* lolanCborUintSize */
+
+/**************************************************************************//**
+ * @brief
+ *   Compute the size of a LoLaN variable encoded to CBOR.
+ * @details
+ *   The size is exactly the same as the output of lolanVarToCbor(), so it
+ *   can be checked whether the variable fits before encoding it.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] index
+ *   The register map index of the variable.
+ * @return
+ *   The size in bytes, zero if the variable can not be encoded (unsupported
+ *   type or size).
+ ******************************************************************************/
+size_t lolanVarCborSize(lolan_ctx *ctx, LR_SIZE_T index)
+{
+  const uint8_t *data;
+  LV_SIZE_T size;
+  int64_t value;
+  uint64_t uvalue;
+  size_t len;
+
+  data = LRM_DATA(ctx, index);
+  size = LRM_SIZE(ctx, index);
+  switch (LRM_FLAGS(ctx, index) & LOLAN_REGMAP_TYPE_MASK) {
+    case LOLAN_INT:   // signed integer (a negative value is encoded as -1-value)
+      switch (size) {
+        case 1:  value = *((int8_t*) data);   break;
+        case 2:  value = *((int16_t*) data);  break;
+        case 4:  value = *((int32_t*) data);  break;
+        case 8:  value = *((int64_t*) data);  break;
+        default: return 0;
+      }
+      return lolanCborUintSize((value < 0) ? ~((uint64_t) value) : (uint64_t) value);
+    case LOLAN_UINT:   // unsigned integer
+      switch (size) {
+        case 1:  uvalue = *((uint8_t*) data);   break;
+        case 2:  uvalue = *((uint16_t*) data);  break;
+        case 4:  uvalue = *((uint32_t*) data);  break;
+        case 8:  uvalue = *((uint64_t*) data);  break;
+        default: return 0;
+      }
+      return lolanCborUintSize(uvalue);
+    case LOLAN_FLOAT:   // floating point (not converted to half precision)
+      return ((size == 4) || (size == 8)) ? 1 + size : 0;
+    case LOLAN_STR:   // text string
+      len = strlen((const char*) data);
+      if (len > size) len = size;
+      return lolanCborUintSize(len) + len;
+    case LOLAN_DATA:   // byte string
+#ifdef LOLAN_ALLOW_VARLEN_LOLANDATA
+      size = LRM_SIZEACTUAL(ctx, index);
+#endif
+      return lolanCborUintSize(size) + size;
+    default:
+      return 0;
+  }
+} /* lolanVarCborSize */
+
+/**************************************************************************//**
+ * @brief
+ *   Compute the size of a LoLaN variable encoded to CBOR with nested path
+ *   items after the previously encoded variable.
+ * @details
+ *   The size includes closing the maps of the previous variable which are
+ *   not shared, the keys and the maps of the path, and the value (see
+ *   lolanVarToCborNestedPath()). The maps of the variable itself are not
+ *   closed (the closing needs defLvl-1 bytes).
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] index
+ *   The register map index of the variable.
+ * @param[in] defLvl
+ *   The definition level of the path of the variable.
+ * @param[in] lastPath
+ *   The path of the previous variable.
+ * @param[in] lastDefLvl
+ *   The definition level of the previous variable (0: no previous
+ *   variable).
+ * @param[in] statusCodeInstead
+ *   If true, the size of the status code is computed instead of the value.
+ * @return
+ *   The size in bytes, zero if the variable can not be encoded.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ ******************************************************************************/
+static size_t lolanNestedPathItemSize(lolan_ctx *ctx, LR_SIZE_T index, uint8_t defLvl,
+           const uint8_t *lastPath, uint8_t lastDefLvl, bool statusCodeInstead)
+{
+  const uint8_t *path;
+  size_t size, vsize;
+  uint8_t i, j;
+
+  vsize = statusCodeInstead ? lolanCborUintSize(getLolanSetStatusCodeForVariable(ctx, index))
+                            : lolanVarCborSize(ctx, index);
+  if (vsize == 0) return 0;
+
+  path = LRM_P(ctx, index);
+  for (i = 0; (i < lastDefLvl) && (path[i] == lastPath[i]); i++)   // the first mismatching path level
+    ;
+  size = (lastDefLvl > i + 1) ? lastDefLvl - 1 - i : 0;   // closing the maps of the previous variable (break bytes)
+  size += lolanCborUintSize(path[i]);   // key
+  for (j = i + 1; j < defLvl; j++)
+    size += 1 + lolanCborUintSize(path[j]);   // indefinite length map and key
+  return size + vsize;
+} /* lolanNestedPathItemSize */
+
 /**************************************************************************//**
  * @brief
  *   Encode a LoLaN variable to CBOR with nested path items.
@@ -1225,105 +2537,107 @@ int8_t lolanVarToCbor(lolan_ctx *ctx, const uint8_t *path, LR_SIZE_T index, Cbor
  *   in order to avoid fragmentation of groups. (If the variables in the
  *   register map are sorted by path, the index of the variable to encode
  *   should be always bigger than the index of the recently encoded one.)
- *   Description of additional features:
- *     action = LVTCNPAUX_BACKUP
- *       (parameter "encoder" is not required)
- *       Back-up internal static variables to the storage specified by
- *       "index" (0 or 1).
- *     action = LVTCNPAUX_RESTORE
- *       (parameter "encoder" is not required)
- *       Restore internal static variables from the storage specified by
- *       "index" (0 or 1).
+ *   The state of the encoding is stored in the structure pointed by "stv"
+ *   (no static variables are used, so different encodings can be done at
+ *   the same time, e.g. in multiple threads).
+ *   With action = LVTCNPAUX_INITIAL or LVTCNPAUX_NORMAL_FIT the exact size
+ *   of the variable is computed before encoding it (see
+ *   lolanNestedPathItemSize()): if the variable and the closing of all maps
+ *   would not fit in the buffer, LOLAN_RETVAL_MEMERROR is returned and
+ *   nothing is encoded (the encoding can be finalized with the previous
+ *   variables). With LVTCNPAUX_NORMAL the encoder itself detects the full
+ *   buffer (the partial tree can not be finalized then).
+ * @param[in,out] stv
+ *   Pointer to the state of the encoding (caller-owned, it is initialized
+ *   with action = LVTCNPAUX_INITIAL).
  * @param[in] index
  *   Index is the register map index of the variable to encode.
  *   (It has special meaning in some cases.)
  * @note
  *   FOR INTERNAL USE ONLY.
  ******************************************************************************/
-static int8_t lolanVarToCborNestedPath(lolan_ctx *ctx, LR_SIZE_T index, CborEncoder *encoder,
-           lolanVarToCborNestedPath_aux action, bool statusCodeInstead)
-{
-  static struct {
-    CborEncoder nested_enc[LOLAN_REGMAP_DEPTH];
-    uint8_t last_path[LOLAN_REGMAP_DEPTH];
-    uint8_t last_defLvl;
-  } stv, stvbak[2];
+static int8_t lolanVarToCborNestedPath(lolan_ctx *ctx, lolanVarToCborNestedPath_state *stv, LR_SIZE_T index,
+           CborEncoder *encoder, lolanVarToCborNestedPath_aux action, bool statusCodeInstead)
+{
   uint8_t *path;
   CborError cerr;
   int8_t err;
   uint8_t i, j, defLvl;
+  size_t size;
 
-  path = ctx->regMap[index].p;   // (just for better readibility)
+  path = LRM_P(ctx, index);   // (just for better readibility)
   switch (action) {
     case LVTCNPAUX_INITIAL:
-      stv.nested_enc[0] = *encoder;   // save the initial CBOR encoder struct
       defLvl = lolanPathDefinitionLevel(ctx, path, NULL, false);  // get definition level for path
       if (defLvl == 0) return LOLAN_RETVAL_GENERROR;
-      cerr = cbor_encode_uint(&stv.nested_enc[0], path[0]);   // encode the first path element as key
+      size = lolanNestedPathItemSize(ctx, index, defLvl, NULL, 0, statusCodeInstead);
+      if (size == 0) return LOLAN_RETVAL_GENERROR;   // (unsupported variable)
+      if (size + defLvl - 1 > LOLAN_CBOR_REMAINING(encoder)) return LOLAN_RETVAL_MEMERROR;   // does not fit (with the closing of the maps)
+      stv->nested_enc[0] = *encoder;   // save the initial CBOR encoder struct
+      cerr = cbor_encode_uint(&stv->nested_enc[0], path[0]);   // encode the first path element as key
       if (cerr != CborNoError) return (cerr == CborErrorOutOfMemory) ? LOLAN_RETVAL_MEMERROR : LOLAN_RETVAL_CBORERROR;
       for (i = 1; i < defLvl; i++) {   // create nested CBOR maps
-        cerr = cbor_encoder_create_map(&stv.nested_enc[i-1], &stv.nested_enc[i], CborIndefiniteLength);   // create map for path level
+        cerr = cbor_encoder_create_map(&stv->nested_enc[i-1], &stv->nested_enc[i], CborIndefiniteLength);   // create map for path level
         if (cerr != CborNoError) return (cerr == CborErrorOutOfMemory) ? LOLAN_RETVAL_MEMERROR : LOLAN_RETVAL_CBORERROR;
-        cerr = cbor_encode_uint(&stv.nested_enc[i], path[i]);   // encode the path element as key
+        cerr = cbor_encode_uint(&stv->nested_enc[i], path[i]);   // encode the path element as key
         if (cerr != CborNoError) return (cerr == CborErrorOutOfMemory) ? LOLAN_RETVAL_MEMERROR : LOLAN_RETVAL_CBORERROR;
       }
       if (!statusCodeInstead) {  // variable data
-        err = lolanVarToCbor(ctx, NULL, index, &stv.nested_enc[defLvl-1]);   // encode the LoLaN variable itself
+        err = lolanVarToCbor(ctx, NULL, index, &stv->nested_enc[defLvl-1]);   // encode the LoLaN variable itself
         if (err != LOLAN_RETVAL_YES) return err;
       } else {   // status code
-        cerr = cbor_encode_uint(&stv.nested_enc[defLvl-1], getLolanSetStatusCodeForVariable(ctx, index));  // encode status code
+        cerr = cbor_encode_uint(&stv->nested_enc[defLvl-1], getLolanSetStatusCodeForVariable(ctx, index));  // encode status code
         if (cerr != CborNoError) return (cerr == CborErrorOutOfMemory) ? LOLAN_RETVAL_MEMERROR : LOLAN_RETVAL_CBORERROR;
       }
-      memcpy(stv.last_path, path, LOLAN_REGMAP_DEPTH);   // store the path as last path
-      stv.last_defLvl = defLvl;   // store the definition level as last path's def. level
+      memcpy(stv->last_path, path, LOLAN_REGMAP_DEPTH);   // store the path as last path
+      stv->last_defLvl = defLvl;   // store the definition level as last path's def. level
       break;
     case LVTCNPAUX_NORMAL:
+    case LVTCNPAUX_NORMAL_FIT:
       defLvl = lolanPathDefinitionLevel(ctx, path, NULL, false);  // get definition level for path
       if (defLvl == 0) return LOLAN_RETVAL_GENERROR;
-      for (i = 0; i < stv.last_defLvl; i++) {   // compare the path to the previous
-        if (path[i] != stv.last_path[i]) {   // mismatch
+      if (action == LVTCNPAUX_NORMAL_FIT) {
+        size = lolanNestedPathItemSize(ctx, index, defLvl, stv->last_path, stv->last_defLvl, statusCodeInstead);
+        if (size == 0) return LOLAN_RETVAL_GENERROR;   // (unsupported variable)
+        if (size + defLvl - 1 > LOLAN_CBOR_REMAINING(&stv->nested_enc[stv->last_defLvl-1]))   // does not fit (with the closing of the maps)
+          return LOLAN_RETVAL_MEMERROR;
+      }
+      for (i = 0; i < stv->last_defLvl; i++) {   // compare the path to the previous
+        if (path[i] != stv->last_path[i]) {   // mismatch
           /* revert to the last matching level */
-          for (j = stv.last_defLvl-1; j > i; j--) {
-            cerr = cbor_encoder_close_container(&stv.nested_enc[j-1], &stv.nested_enc[j]);   // close map assigned to the path level
+          for (j = stv->last_defLvl-1; j > i; j--) {
+            cerr = cbor_encoder_close_container(&stv->nested_enc[j-1], &stv->nested_enc[j]);   // close map assigned to the path level
             if (cerr != CborNoError) return (cerr == CborErrorOutOfMemory) ? LOLAN_RETVAL_MEMERROR : LOLAN_RETVAL_CBORERROR;
           }
           break;
         }
       }
       /* (now i contains the first mismatching path level) */
-      cerr = cbor_encode_uint(&stv.nested_enc[i], path[i]);   // encode the first different path element as key
+      cerr = cbor_encode_uint(&stv->nested_enc[i], path[i]);   // encode the first different path element as key
       if (cerr != CborNoError) return (cerr == CborErrorOutOfMemory) ? LOLAN_RETVAL_MEMERROR : LOLAN_RETVAL_CBORERROR;
       for (j = i+1; j < defLvl; j++) {   // create nested CBOR maps
-        cerr = cbor_encoder_create_map(&stv.nested_enc[j-1], &stv.nested_enc[j], CborIndefiniteLength);   // create map for path level
+        cerr = cbor_encoder_create_map(&stv->nested_enc[j-1], &stv->nested_enc[j], CborIndefiniteLength);   // create map for path level
         if (cerr != CborNoError) return (cerr == CborErrorOutOfMemory) ? LOLAN_RETVAL_MEMERROR : LOLAN_RETVAL_CBORERROR;
-        cerr = cbor_encode_uint(&stv.nested_enc[j], path[j]);   // encode the path element as key
+        cerr = cbor_encode_uint(&stv->nested_enc[j], path[j]);   // encode the path element as key
         if (cerr != CborNoError) return (cerr == CborErrorOutOfMemory) ? LOLAN_RETVAL_MEMERROR : LOLAN_RETVAL_CBORERROR;
       }
       if (!statusCodeInstead) {  // variable data
-        err = lolanVarToCbor(ctx, NULL, index, &stv.nested_enc[defLvl-1]);   // encode the LoLaN variable itself
+        err = lolanVarToCbor(ctx, NULL, index, &stv->nested_enc[defLvl-1]);   // encode the LoLaN variable itself
         if (err != LOLAN_RETVAL_YES) return err;
       } else {   // status code
-        cerr = cbor_encode_uint(&stv.nested_enc[defLvl-1], getLolanSetStatusCodeForVariable(ctx, index));  // encode status code
+        cerr = cbor_encode_uint(&stv->nested_enc[defLvl-1], getLolanSetStatusCodeForVariable(ctx, index));  // encode status code
         if (cerr != CborNoError) return (cerr == CborErrorOutOfMemory) ? LOLAN_RETVAL_MEMERROR : LOLAN_RETVAL_CBORERROR;
       }
-      memcpy(stv.last_path, path, LOLAN_REGMAP_DEPTH);   // store the path as last path
-      stv.last_defLvl = defLvl;   // store the definition level as last path's def. level
+      memcpy(stv->last_path, path, LOLAN_REGMAP_DEPTH);   // store the path as last path
+      stv->last_defLvl = defLvl;   // store the definition level as last path's def. level
       break;
     case LVTCNPAUX_FINALIZE:
       /* close all open maps */
-      for (i = stv.last_defLvl-1; i > 0; i--) {
-        cerr = cbor_encoder_close_container(&stv.nested_enc[i-1], &stv.nested_enc[i]);   // close map
+      for (i = stv->last_defLvl-1; i > 0; i--) {
+        cerr = cbor_encoder_close_container(&stv->nested_enc[i-1], &stv->nested_enc[i]);   // close map
         if (cerr != CborNoError) return (cerr == CborErrorOutOfMemory) ? LOLAN_RETVAL_MEMERROR : LOLAN_RETVAL_CBORERROR;
       }
-      *encoder = stv.nested_enc[0];   // output the updated CBOR encoder struct
-      break;
-    case LVTCNPAUX_BACKUP:
-      /* back-up all static variables to save internal state */
-      stvbak[index] = stv;
-      break;
-    case LVTCNPAUX_RESTORE:
-      /* restore internal state */
-      stv = stvbak[index];
+      *encoder = stv->nested_enc[0];   // output the updated CBOR encoder struct
       break;
   }
 
@@ -1374,30 +2688,26 @@ static int8_t lolanVarToCborNestedPath(lolan_ctx *ctx, LR_SIZE_T index, CborEnco
 int8_t lolanVarBranchToCbor(lolan_ctx *ctx, const uint8_t *path, CborEncoder *encoder)
 {
   LR_SIZE_T i;
-  uint8_t defLvl;
+  lolan_SubtreeIterator st;
+  lolanVarToCborNestedPath_state stv;
   bool first;
   int8_t err;
 
-  defLvl = lolanPathDefinitionLevel(ctx, path, NULL, false);  // get definition level for path
+  lolanSubtreeInit(ctx, &st, path, true);   // variables for the specified subpath within the maximum recursion level
 
   first = true;
-  for (i = 0; i < LOLAN_REGMAP_SIZE; i++) {
-    if ((memcmp(ctx->regMap[i].p, path, defLvl) == 0)  // variable found for the specified subpath
-         && (ctx->regMap[i].p[0] != 0)) {              // (not a free entry)
-      if (lolanPathDefinitionLevel(ctx, ctx->regMap[i].p, NULL, false) > defLvl + LOLAN_REGMAP_RECURSION)  // maximum recursion level is exceeded
-        continue;
-      if (first) {
-        err = lolanVarToCborNestedPath(ctx, i, encoder, LVTCNPAUX_INITIAL, false);  // initializing CBOR tree and add the first item
-        if (err != LOLAN_RETVAL_YES) return err;
-        first = false;
-      } else {
-        err = lolanVarToCborNestedPath(ctx, i, NULL, LVTCNPAUX_NORMAL, false);   // add the current item to the CBOR tree
-        if (err != LOLAN_RETVAL_YES) return err;
-      }
+  while ((i = lolanSubtreeNext(ctx, &st)) < LOLAN_REGMAP_SIZE) {
+    if (first) {
+      err = lolanVarToCborNestedPath(ctx, &stv, i, encoder, LVTCNPAUX_INITIAL, false);  // initializing CBOR tree and add the first item
+      if (err != LOLAN_RETVAL_YES) return err;
+      first = false;
+    } else {
+      err = lolanVarToCborNestedPath(ctx, &stv, i, NULL, LVTCNPAUX_NORMAL, false);   // add the current item to the CBOR tree
+      if (err != LOLAN_RETVAL_YES) return err;
     }
   }
   if (!first) {   // at least one variable was found
-    err = lolanVarToCborNestedPath(ctx, 0, encoder, LVTCNPAUX_FINALIZE, false);   // finalize CBOR tree
+    err = lolanVarToCborNestedPath(ctx, &stv, 0, encoder, LVTCNPAUX_FINALIZE, false);   // finalize CBOR tree
     if (err != LOLAN_RETVAL_YES) return err;
     return LOLAN_RETVAL_YES;
   } else {   // no variable was found
@@ -1459,49 +2769,32 @@ int8_t lolanVarFlagToCbor(lolan_ctx *ctx, uint16_t flags, CborEncoder *encoder,
              bool auxflagset, bool statusCodeInstead)
 {
   LR_SIZE_T i;
+  lolanVarToCborNestedPath_state stv;
   bool first;
   int8_t err;
 
   first = true;
-  for (i = 0; i < LOLAN_REGMAP_SIZE; i++) {
-    if ( ((ctx->regMap[i].flags & flags) == flags)      // variable found with the specified flags
-         && (ctx->regMap[i].p[0] != 0) ) {              // (not a free entry)
-      if (first) {   // the first item
-        // initialize CBOR tree and add the first item
-        err = lolanVarToCborNestedPath(ctx, i, encoder, LVTCNPAUX_INITIAL, statusCodeInstead);
-        if (err != LOLAN_RETVAL_YES) return err;
-        first = false;
-      } else {   // other items
-        lolanVarToCborNestedPath(ctx, 0, NULL, LVTCNPAUX_BACKUP, false);   // backup internal state of lolanVarToCborNestedPath() to storage 0
-        // add the current item to the CBOR tree
-        err = lolanVarToCborNestedPath(ctx, i, NULL, LVTCNPAUX_NORMAL, statusCodeInstead);
-        if (err != LOLAN_RETVAL_YES) {   // fail
-          if (err == LOLAN_RETVAL_MEMERROR) {   // out of memory error (CBOR buffer is full)
-            lolanVarToCborNestedPath(ctx, 0, NULL, LVTCNPAUX_RESTORE, false);   // restore internal state of lolanVarToCborNestedPath() from storage 0
-            break;   // stop encoding
-          } else return err;   // other error
-        }
-        // (successfully added)
-        lolanVarToCborNestedPath(ctx, 1, NULL, LVTCNPAUX_BACKUP, false);   // backup internal state of lolanVarToCborNestedPath() to storage 1
-        err = lolanVarToCborNestedPath(ctx, 0, encoder, LVTCNPAUX_FINALIZE, statusCodeInstead);   // try to finalize (needed only for "fit in the buffer?" test, will be undone)
-        if (err != LOLAN_RETVAL_YES) {   // fail
-          if (err == LOLAN_RETVAL_MEMERROR) {   // out of memory error (CBOR buffer is full)
-            lolanVarToCborNestedPath(ctx, 0, NULL, LVTCNPAUX_RESTORE, false);   // restore internal state of lolanVarToCborNestedPath() from storage 0
-            // (the last variable encoding was undone)
-            break;   // stop encoding
-         } else return err;   // other error
-        }
-        // (successfully finalized)
-        lolanVarToCborNestedPath(ctx, 1, NULL, LVTCNPAUX_RESTORE, false);   // restore internal state of lolanVarToCborNestedPath() from storage 1
-        // (the finalization was undone)
+  for (i = lolanFlagNext(ctx, flags, 0); i < LOLAN_REGMAP_SIZE; i = lolanFlagNext(ctx, flags, i+1)) {   // variables found with the specified flags
+    if (first) {   // the first item
+      // initialize CBOR tree and add the first item
+      err = lolanVarToCborNestedPath(ctx, &stv, i, encoder, LVTCNPAUX_INITIAL, statusCodeInstead);
+      if (err != LOLAN_RETVAL_YES) return err;
+      first = false;
+    } else {   // other items
+      // add the current item to the CBOR tree (if it fits with the finalization)
+      err = lolanVarToCborNestedPath(ctx, &stv, i, NULL, LVTCNPAUX_NORMAL_FIT, statusCodeInstead);
+      if (err != LOLAN_RETVAL_YES) {   // fail
+        if (err == LOLAN_RETVAL_MEMERROR)   // the CBOR buffer is full (nothing was encoded)
+          break;   // stop encoding
+        else return err;   // other error
       }
-      if (auxflagset)
-        ctx->regMap[i].flags |= LOLAN_REGMAP_AUX_BIT;   // set the auxiliary flag
     }
+    if (auxflagset)
+      lolanFlagSet(ctx, i, LOLAN_REGMAP_AUX_BIT);   // set the auxiliary flag
   }
   if (!first) {   // at least one variable was found
     // finalize CBOR tree
-    err = lolanVarToCborNestedPath(ctx, 0, encoder, LVTCNPAUX_FINALIZE, statusCodeInstead);
+    err = lolanVarToCborNestedPath(ctx, &stv, 0, encoder, LVTCNPAUX_FINALIZE, statusCodeInstead);
     if (err != LOLAN_RETVAL_YES) return err;
     return LOLAN_RETVAL_YES;
   } else {   // no variable was found
@@ -1509,30 +2802,3 @@ int8_t lolanVarFlagToCbor(lolan_ctx *ctx, uint16_t flags, CborEncoder *encoder,
   }
 } /* lolanVarFlagToCbor */
 
-/**************************************************************************//**
- * @brief
- *   Calculate the CRC16 of the specified data.
- * @param[in] data
- *   Starting address of the data.
- * @param[in] size
- *   Size of the data in bytes.
- * @return
- *   The CRC16 value.
- *****************************************************************************/
-uint16_t lolan_CRC_calc(const uint8_t *data, size_t size)
-{
-  uint16_t crc, q;
-  uint8_t c;
-  size_t i;
-
-  crc = 0;
-  for (i = 0; i < size; i++) {
-    c = data[i];
-    q = (crc ^ c) & 0x0f;
-    crc = (crc >> 4) ^ (q * 0x1081);
-    q = (crc ^ (c >> 4)) & 0xf;
-    crc = (crc >> 4) ^ (q * 0x1081);
-  }
-  return ((crc << 8) & 0xFF00) | ((crc >> 8) & 0x00FF);   // swap bytes
-} /* lolan_CRC_calc */
-
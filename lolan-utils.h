@@ -27,28 +27,118 @@ typedef struct {
   LR_SIZE_T notfound;
   bool toodeep;
   LR_SIZE_T invalid_keys;
+  LR_SIZE_T statuses;
+  bool unsorted;
 } lolan_BunchUpdateOutputStruct;
 
+#ifdef LOLAN_REGMAP_CONST   // true if the register map can not be modified
+  #define LOLAN_REGMAP_IS_CONST(ctx)  ((ctx)->constMap != NULL)
+#else
+  #define LOLAN_REGMAP_IS_CONST(ctx)  false
+#endif
+
+#define LOLAN_CBOR_REMAINING(enc)  ((size_t) ((enc)->end - (enc)->data.ptr))   // free space in the buffer of a CBOR encoder (no error occurred on it)
+
+typedef struct {        // iterator over the variables under a base path
+  uint8_t defLvl;       // definition level of the base path
+  uint8_t maxLvl;       // maximum definition level of the variables
+  LR_SIZE_T next;       // next register map index to check
+  LR_SIZE_T end;        // register map index after the subtree range
+} lolan_SubtreeIterator;
+
+#define LOLAN_CBOR_MAX_NESTING  (LOLAN_REGMAP_DEPTH + 8)   // maximum nesting of the containers in a validated CBOR payload
+#define LOLAN_CBOR_INDEFINITE   SIZE_MAX   // (lolan_CborCursor.remaining in an indefinite length container)
+
+typedef struct {        // container index of a validated CBOR payload (see lolanCborValidate())
+  const uint8_t *data;  // first byte of the payload
+  const uint8_t *end;   // end of the payload
+  LP_SIZE_T count;      // number of indexed containers (the first ones in the order of their heads)
+  LP_SIZE_T skip[LOLAN_CBOR_INDEX_SIZE];   // offset after the container (by container ordinal)
+  LP_SIZE_T next[LOLAN_CBOR_INDEX_SIZE];   // ordinal of the first container after the container
+} lolan_CborIndex;
+
+typedef struct {        // unchecked cursor over a validated CBOR payload
+  const lolan_CborIndex *idx;
+  const uint8_t *ptr;   // current item
+  size_t remaining;     // number of items left in the container (LOLAN_CBOR_INDEFINITE: until the break byte)
+  LP_SIZE_T ord;        // ordinal of the next container head at or after ptr
+} lolan_CborCursor;
+
+#define LOLAN_CBOR_AT_END(cur)      (((cur)->remaining == LOLAN_CBOR_INDEFINITE) ? (*(cur)->ptr == 0xff) : ((cur)->remaining == 0))
+#define LOLAN_CBOR_IS_INTEGER(cur)  (*(cur)->ptr < 0x40)   // (major type 0 or 1)
+#define LOLAN_CBOR_IS_MAP(cur)      ((*(cur)->ptr & 0xe0) == 0xa0)
+
+typedef int8_t (*lolan_PayloadLeafFunc)(void *arg, const uint8_t *path, const lolan_CborCursor *cur);   // handler of lolanWalkPayloadMap()
+
 
 extern bool lolanIsPathValid(const uint8_t *path);
 extern uint8_t lolanPathDefinitionLevel(lolan_ctx *ctx, const uint8_t *path, LR_SIZE_T *occurrences, bool occ_maxrec);
 extern LR_SIZE_T lolanVarFlagCount(lolan_ctx *ctx, uint16_t flags, bool *dlbpsame, uint8_t *defLevel, uint8_t *bpath);
 
 extern void lolan_regMapSort(lolan_ctx *ctx);
+#ifdef LOLAN_REGMAP_HASH_SIZE
+extern void lolanPtrHashRebuild(lolan_ctx *ctx);
+extern void lolanPtrHashInsert(lolan_ctx *ctx, LR_SIZE_T index);
+extern void lolanPtrHashInsertShift(lolan_ctx *ctx, LR_SIZE_T index);
+extern void lolanPtrHashRemoveShift(lolan_ctx *ctx, LR_SIZE_T index);
+#endif
+extern void lolanRegMapMove(lolan_ctx *ctx, LR_SIZE_T dst, LR_SIZE_T src, LR_SIZE_T n);
+extern void lolanRegMapClear(lolan_ctx *ctx, LR_SIZE_T from, LR_SIZE_T n);
+#ifdef LOLAN_DUPFILTER_SOURCES
+extern bool lolanDupFilterCheck(lolan_ctx *ctx, const lolan_Packet *pak, lolan_Packet *reply, int8_t *result);
+extern void lolanDupFilterStore(lolan_ctx *ctx, const lolan_Packet *pak, const lolan_Packet *reply);
+#endif
+#ifdef LOLAN_REGMAP_DYNAMIC
+extern size_t lolanRegMapLayout(lolan_ctx *ctx, uint8_t *mem, LR_SIZE_T capacity, bool ramOnly);
+#endif
+extern int8_t lolanRegMapReserve(lolan_ctx *ctx, size_t required);
+extern void lolanRegMapSortRange(lolan_ctx *ctx, LR_SIZE_T from, LR_SIZE_T to);
+extern void lolanRegMapSortRangeByPtr(lolan_ctx *ctx, LR_SIZE_T from, LR_SIZE_T to);
+extern LR_SIZE_T lolanRegMapLowerBound(lolan_ctx *ctx, const uint8_t *path, uint8_t len);
+extern LR_SIZE_T lolanRegMapUpperBound(lolan_ctx *ctx, const uint8_t *path, uint8_t len);
+extern void lolanSubtreeInit(lolan_ctx *ctx, lolan_SubtreeIterator *it, const uint8_t *path, bool maxrec);
+extern LR_SIZE_T lolanSubtreeNext(lolan_ctx *ctx, lolan_SubtreeIterator *it);
+extern LR_SIZE_T lolanRegMapFindByPath(lolan_ctx *ctx, const uint8_t *path);
+extern LR_SIZE_T lolanRegMapFindByPtr(lolan_ctx *ctx, const void *ptr);
+#ifdef LOLAN_REGMAP_FLAG_BITMAPS
+extern void lolanFlagBitmapRebuild(lolan_ctx *ctx);
+extern void lolanFlagBitmapShift(lolan_ctx *ctx, LR_SIZE_T index, bool insert);
+#endif
+extern void lolanFlagSet(lolan_ctx *ctx, LR_SIZE_T index, uint16_t flags);
+extern void lolanFlagClear(lolan_ctx *ctx, LR_SIZE_T index, uint16_t flags);
+extern void lolanFlagClearAll(lolan_ctx *ctx, uint16_t flags);
+extern LR_SIZE_T lolanFlagNext(lolan_ctx *ctx, uint16_t flags, LR_SIZE_T from);
+
+extern int8_t lolanCborValidate(lolan_CborIndex *idx, const uint8_t *data, size_t size);
+extern void lolanCborCursorRoot(const lolan_CborIndex *idx, lolan_CborCursor *cur);
+extern int lolanCborCursorGetInt(const lolan_CborCursor *cur);
+extern uint64_t lolanCborCursorGetUint(const lolan_CborCursor *cur);
+extern size_t lolanCborCursorStringLength(const lolan_CborCursor *cur);
+extern void lolanCborCursorCopyString(const lolan_CborCursor *cur, uint8_t *buf, size_t size);
+extern const uint8_t *lolanCborCursorStringChunk(const lolan_CborCursor *cur, const uint8_t **pos, size_t *len);
+extern void lolanCborCursorAdvance(lolan_CborCursor *cur);
+extern void lolanCborCursorEnter(const lolan_CborCursor *cur, lolan_CborCursor *child);
+extern void lolanCborCursorLeave(lolan_CborCursor *cur, const lolan_CborCursor *child);
+extern CborError lolanCborCursorValue(const lolan_CborCursor *cur, CborParser *parser, CborValue *value);
 
 extern int8_t lolanGetPathFromCbor(uint8_t *path, CborValue *it);
+extern int8_t lolanGetZeroKeyValueFromCbor(CborValue *it, uint8_t *path, uint16_t *value, bool *isPath);
+extern int8_t lolanGetZeroKeyEntryFromCursor(const lolan_CborCursor *map_cur, uint8_t *path, uint16_t *value, bool *isPath);
 extern int8_t lolanGetZeroKeyEntryFromPayload(const lolan_Packet *lp, uint8_t *path, uint16_t *value, bool *isPath);
-extern int8_t lolanGetDataFromCbor(CborValue *it, uint8_t *data, LV_SIZE_T data_max, LV_SIZE_T *data_len, uint8_t *type);
-extern int8_t lolanVarUpdateFromCbor(lolan_ctx *ctx, const uint8_t *path, CborValue *it, uint8_t *error);
-extern int8_t lolanVarBunchUpdateFromCbor(lolan_ctx *ctx, const lolan_Packet *lp, lolan_BunchUpdateOutputStruct *info);
+extern int8_t lolanGetDataFromCbor(const lolan_CborCursor *cur, uint8_t *data, LV_SIZE_T data_max, LV_SIZE_T *data_len, uint8_t *type);
+extern int8_t lolanWalkPayloadMap(const lolan_CborCursor *map_cur, const uint8_t *basePath, lolan_PayloadLeafFunc leaf, void *arg);
+extern int8_t lolanWalkInformPayload(const lolan_CborCursor *map_cur, lolan_PayloadLeafFunc leaf, void *arg);
+extern int8_t lolanVarUpdateFromCbor(lolan_ctx *ctx, const uint8_t *path, const lolan_CborCursor *cur, uint8_t *error);
+extern int8_t lolanVarIndexUpdateFromCbor(lolan_ctx *ctx, LR_SIZE_T i, const lolan_CborCursor *cur, uint8_t *error);
+extern int8_t lolanVarBunchUpdateFromCbor(lolan_ctx *ctx, lolan_CborCursor *map_cur, CborEncoder *status, lolan_BunchUpdateOutputStruct *info);
 
 extern int8_t createCborUintDataSimple(CborEncoder *encoder, uint64_t key, uint64_t value, bool container);
 extern int8_t lolanVarDataToCbor(uint8_t *data, LV_SIZE_T data_len, lolan_VarType type, CborEncoder *encoder);
 extern int8_t lolanVarToCbor(lolan_ctx *ctx, const uint8_t *path, LR_SIZE_T index, CborEncoder *encoder);
+extern uint8_t lolanCborUintSize(uint64_t value);
+extern size_t lolanVarCborSize(lolan_ctx *ctx, LR_SIZE_T index);
 extern int8_t lolanVarBranchToCbor(lolan_ctx *ctx, const uint8_t *path, CborEncoder *encoder);
 extern int8_t lolanVarFlagToCbor(lolan_ctx *ctx, uint16_t flags, CborEncoder *encoder, bool auxflagset, bool statusCodeInstead);
 
-extern uint16_t lolan_CRC_calc(const uint8_t *data, size_t size);
-
 
 #endif /* LOLAN_UTILS_H_ */
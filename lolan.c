@@ -16,6 +16,14 @@
 /**************************************************************************//**
  * @brief
  *   Initialize the specified LoLaN context variable.
+ * @note
+ *   With LOLAN_REGMAP_DYNAMIC, the register map is allocated on demand
+ *   (same as lolan_initEx() with zero capacity), lolan_free() has to be
+ *   called to release it.
+ * @note
+ *   The library has no global state: different contexts can be used at the
+ *   same time from multiple threads (a context itself must not be used by
+ *   more threads at the same time).
  * @param[in] ctx
  *   Pointer to a LoLaN context variable.
  * @param[in] initial_address
@@ -23,11 +31,186 @@
  *****************************************************************************/
 void lolan_init(lolan_ctx *ctx, uint16_t initial_address)
 {
+#ifndef LOLAN_REGMAP_DYNAMIC
   memset(ctx, 0, sizeof(lolan_ctx));
   ctx->myAddress = initial_address;
   ctx->packetCounter = 1;
+#else
+  lolan_initEx(ctx, initial_address, 0, NULL);
+#endif
 } /* lolan_init */
 
+#ifdef LOLAN_REGMAP_DYNAMIC
+/**************************************************************************//**
+ * @brief
+ *   Initialize the specified LoLaN context variable with a register map
+ *   of the specified capacity.
+ * @details
+ *   If a memory block is supplied, the register map is stored there and
+ *   its capacity is fixed. The block must be at least
+ *   lolan_regMapMemSize(capacity) bytes long and aligned to 8 bytes, and
+ *   it must be kept while the context is used.
+ *   Otherwise the register map is allocated with LOLAN_MALLOC() and it
+ *   grows on demand (up to LOLAN_REGMAP_SIZE entries) when new variables
+ *   are registered.
+ * @param[in] ctx
+ *   Pointer to a LoLaN context variable.
+ * @param[in] initial_address
+ *   The initial 16-bit LoLaN address for this context.
+ * @param[in] capacity
+ *   The (initial) number of register map entries (maximum:
+ *   LOLAN_REGMAP_SIZE).
+ * @param[in] mem
+ *   The memory block for the register map. (NULL: allocate)
+ * @return
+ *   LOLAN_RETVAL_YES if the action was successful,
+ *   otherwise LOLAN_RETVAL_GENERROR (the context is initialized with an
+ *   empty register map).
+ *****************************************************************************/
+int8_t lolan_initEx(lolan_ctx *ctx, uint16_t initial_address, LR_SIZE_T capacity, void *mem)
+{
+  size_t size;
+
+  memset(ctx, 0, sizeof(lolan_ctx));
+  ctx->myAddress = initial_address;
+  ctx->packetCounter = 1;
+  ctx->regMapOwned = (mem == NULL);
+  if (capacity > LOLAN_REGMAP_SIZE) return LOLAN_RETVAL_GENERROR;
+  if (mem == NULL)
+    return lolanRegMapReserve(ctx, capacity);
+
+  size = lolanRegMapLayout(NULL, NULL, capacity, false);
+  memset(mem, 0, size);   // (free entries)
+  lolanRegMapLayout(ctx, mem, capacity, false);
+  ctx->regMapMem = mem;
+  return LOLAN_RETVAL_YES;
+} /* lolan_initEx */
+
+/**************************************************************************//**
+ * @brief
+ *   Release the register map of the specified LoLaN context variable.
+ * @details
+ *   All LoLaN variables are removed. The memory block is freed with
+ *   LOLAN_FREE() if it was allocated by LoLaN, a register map allocated
+ *   on demand can be used again after this call.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ *****************************************************************************/
+void lolan_free(lolan_ctx *ctx)
+{
+  if (ctx->regMapOwned)
+    LOLAN_FREE(ctx->regMapMem);
+  ctx->regMapMem = NULL;
+  ctx->regMapCount = 0;
+#ifdef LOLAN_REGMAP_CONST
+  ctx->constMap = NULL;
+#endif
+  lolanRegMapLayout(ctx, NULL, 0, false);
+} /* lolan_free */
+
+/**************************************************************************//**
+ * @brief
+ *   Get the size of the memory block needed for a register map.
+ * @param[in] capacity
+ *   Number of register map entries.
+ * @return
+ *   The size of the memory block for lolan_initEx() in bytes.
+ *****************************************************************************/
+size_t lolan_regMapMemSize(LR_SIZE_T capacity)
+{
+  return lolanRegMapLayout(NULL, NULL, capacity, false);
+} /* lolan_regMapMemSize */
+#endif
+
+#ifdef LOLAN_REGMAP_CONST
+/**************************************************************************//**
+ * @brief
+ *   Initialize the specified LoLaN context variable with a read-only
+ *   register map.
+ * @details
+ *   The paths, sizes and data pointers of the read-only register map are
+ *   used in place (e.g. from flash memory), nothing is sorted at startup.
+ *   Only the fields modified at runtime (flags, actual sizes, tags) and
+ *   the data pointer hash index are stored in the memory block, which
+ *   must be at least lolan_constRegMapMemSize() bytes long and aligned
+ *   to 8 bytes. Variables can not be registered or removed.
+ *   The tables must be sorted and valid: generated by lolan-regmap.hpp
+ *   (validated at build time), or checked with lolan_checkRegMap().
+ *   With LOLAN_REGMAP_HASH_SIZE, duplicate data pointers are detected
+ *   here (lolan-regmap.hpp checks them only in small tables).
+ * @param[in] ctx
+ *   Pointer to a LoLaN context variable.
+ * @param[in] initial_address
+ *   The initial 16-bit LoLaN address for this context.
+ * @param[in] map
+ *   The read-only register map (must be kept while the context is used).
+ * @param[in] mem
+ *   The memory block. (NULL: allocate with LOLAN_MALLOC(), see
+ *   lolan_free())
+ * @return
+ *   LOLAN_RETVAL_YES if the action was successful,
+ *   otherwise LOLAN_RETVAL_GENERROR (the context is initialized with an
+ *   empty register map).
+ *****************************************************************************/
+int8_t lolan_initConst(lolan_ctx *ctx, uint16_t initial_address, const lolan_ConstRegMap *map, void *mem)
+{
+  size_t size;
+#ifdef LOLAN_REGMAP_HASH_SIZE
+  LR_SIZE_T i;
+#endif
+
+  memset(ctx, 0, sizeof(lolan_ctx));
+  ctx->myAddress = initial_address;
+  ctx->packetCounter = 1;
+  size = lolanRegMapLayout(NULL, NULL, map->count, true);
+  if ((mem == NULL) && (size > 0)) {
+    mem = LOLAN_MALLOC(size);
+    if (mem == NULL) return LOLAN_RETVAL_GENERROR;
+    ctx->regMapOwned = true;
+  }
+  if (size > 0) memset(mem, 0, size);
+  lolanRegMapLayout(ctx, mem, map->count, true);
+  ctx->regMapMem = mem;
+  ctx->constMap = map;
+  ctx->regMapP = (lolan_RegMapPath*) map->p;   // (the read-only arrays are never written)
+  ctx->regMapSize = (LV_SIZE_T*) map->size;
+  ctx->regMapData = (void**) map->data;
+  ctx->regMapCount = map->count;
+  if (map->count > 0) {
+    memcpy(ctx->regMapFlags, map->flags, map->count * sizeof(uint16_t));
+#ifdef LOLAN_ALLOW_VARLEN_LOLANDATA
+    memcpy(ctx->regMapSizeActual, map->size, map->count * sizeof(LV_SIZE_T));   // actual data size is the same as variable size by default
+#endif
+  }
+#ifdef LOLAN_REGMAP_HASH_SIZE
+  for (i = 0; i < map->count; i++) {   // build the data pointer hash index (the memory block is zeroed)
+    if (lolanRegMapFindByPtr(ctx, LRM_DATA(ctx, i)) < LOLAN_REGMAP_SIZE) {   // duplicate data pointer
+      lolan_free(ctx);
+      return LOLAN_RETVAL_GENERROR;
+    }
+    lolanPtrHashInsert(ctx, i);
+  }
+#endif
+#ifdef LOLAN_REGMAP_FLAG_BITMAPS
+  lolanFlagBitmapRebuild(ctx);
+#endif
+  return LOLAN_RETVAL_YES;
+} /* lolan_initConst */
+
+/**************************************************************************//**
+ * @brief
+ *   Get the size of the memory block needed for a read-only register map.
+ * @param[in] map
+ *   The read-only register map.
+ * @return
+ *   The size of the memory block for lolan_initConst() in bytes.
+ *****************************************************************************/
+size_t lolan_constRegMapMemSize(const lolan_ConstRegMap *map)
+{
+  return lolanRegMapLayout(NULL, NULL, map->count, true);
+} /* lolan_constRegMapMemSize */
+#endif
+
 /**************************************************************************//**
  * @brief
  *   Set new address for the LoLaN context.
@@ -44,6 +227,92 @@ void lolan_setAddress(lolan_ctx *ctx, uint16_t new_address)
   ctx->packetCounter = 1;
 } /* lolan_setAddress */
 
+/**************************************************************************//**
+ * @brief
+ *   Check the parameters of a new LoLaN variable (except the conflicts
+ *   with the register map).
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ * @return
+ *   True if the variable size and path are acceptable.
+ *****************************************************************************/
+static bool lolan_isVarDefValid(const uint8_t *path, lolan_VarType vType, LV_SIZE_T size)
+{
+  /* check variable size */
+  if (size == 0) return false;  // zero size is not acceptable
+  switch (vType) {
+    case LOLAN_INT:
+    case LOLAN_UINT:
+      if ((size != 1) && (size != 2) && (size != 4) && (size != 8))   // unsupported integer number size
+        return false;
+      break;
+    case LOLAN_FLOAT:
+      if ((size != 4) && (size != 8))   // unsupported floating point number size
+        return false;
+      break;
+    default:
+      break;
+  }
+  /* check the specified path for formal error */
+  if (!lolanIsPathValid(path) || path[0] == 0) return false;
+  return true;
+} /* lolan_isVarDefValid */
+
+/**************************************************************************//**
+ * @brief
+ *   Check whether the path of a new LoLaN variable conflicts with the
+ *   variables in the register map.
+ * @details
+ *   Conflicts:
+ *      the specified path already exists
+ *      the specified path is the base path of existing variable(s),
+ *       e.g. add (1,2,2) then add (1,2,0)
+ *      a base path of the specified path (at any level) is an existing
+ *       variable, e.g. add (1,2,0) then add (1,2,2), or add (1,0,0) then
+ *       add (1,2,2)
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ * @return
+ *   True if there is a conflict.
+ *****************************************************************************/
+static bool lolan_isPathConflicting(lolan_ctx *ctx, const uint8_t *path)
+{
+  uint8_t defLvl, lvl, parent[LOLAN_REGMAP_DEPTH];
+  LR_SIZE_T i;
+
+  defLvl = lolanPathDefinitionLevel(NULL, path, NULL, false);   // get the definition level
+  /* the variables with the specified (base) path are the first ones not less than the path */
+  i = lolanRegMapLowerBound(ctx, path, LOLAN_REGMAP_DEPTH);
+  if ((i < ctx->regMapCount) && (memcmp(LRM_P(ctx, i), path, defLvl) == 0))
+    return true;
+  memset(parent, 0, LOLAN_REGMAP_DEPTH);
+  for (lvl = 1; lvl < defLvl; lvl++) {   // the base paths (same as the adjacency check of lolan_regVarBatch())
+    parent[lvl-1] = path[lvl-1];
+    if (lolanRegMapFindByPath(ctx, parent) < LOLAN_REGMAP_SIZE)
+      return true;
+  }
+  return false;
+} /* lolan_isPathConflicting */
+
+/**************************************************************************//**
+ * @brief
+ *   Fill a register map entry for a new LoLaN variable.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ *****************************************************************************/
+static void lolan_fillRegMapEntry(lolan_ctx *ctx, LR_SIZE_T i, const uint8_t *path, lolan_VarType vType,
+                                  void *ptr, LV_SIZE_T size, bool readOnly)
+{
+  lolanRegMapClear(ctx, i, 1);
+  memcpy(LRM_P(ctx, i), path, LOLAN_REGMAP_DEPTH);
+  LRM_FLAGS(ctx, i) = vType + (readOnly ? LOLAN_REGMAP_REMOTE_READONLY_BIT : 0);
+  LRM_DATA(ctx, i) = ptr;
+  LRM_SIZE(ctx, i) = size;
+#ifdef LOLAN_ALLOW_VARLEN_LOLANDATA
+  LRM_SIZEACTUAL(ctx, i) = size;   // actual data size is the same as variable size by default
+#endif
+} /* lolan_fillRegMapEntry */
+
 /**************************************************************************//**
  * @brief
  *   Register a new LoLaN variable.
@@ -51,6 +320,8 @@ void lolan_setAddress(lolan_ctx *ctx, uint16_t new_address)
  *   Create a new entry in the LoLaN register map for a new variable.
  *   The actual data stays resident on the specified address (no copying),
  *   the LoLaN system handles it by pointer and size only.
+ *   The new entry is inserted directly to its sorted position. To register
+ *   a large number of variables at once, use lolan_regVarBatch().
  * @param[in] ctx
  *   Pointer to the LoLaN context variable.
  * @param[in] path
@@ -76,58 +347,120 @@ void lolan_setAddress(lolan_ctx *ctx, uint16_t new_address)
 int8_t lolan_regVar(lolan_ctx *ctx, const uint8_t *path, lolan_VarType vType, void *ptr,
                     LV_SIZE_T size, bool readOnly)
 {
+  LR_SIZE_T i;
+
+  if (LOLAN_REGMAP_IS_CONST(ctx)) return LOLAN_RETVAL_GENERROR;   // (read-only register map)
+  if (!lolan_isVarDefValid(path, vType, size)) return LOLAN_RETVAL_GENERROR;
+  if (lolanRegMapFindByPtr(ctx, ptr) < LOLAN_REGMAP_SIZE)   // the specified address is already mapped to an other LoLaN variable
+    return LOLAN_RETVAL_GENERROR;
+  if (lolan_isPathConflicting(ctx, path)) return LOLAN_RETVAL_GENERROR;
+  if (lolanRegMapReserve(ctx, (size_t) ctx->regMapCount + 1) != LOLAN_RETVAL_YES)   // the register map is full
+    return LOLAN_RETVAL_GENERROR;
+
+  /* insert the new entry to its sorted position */
+  i = lolanRegMapLowerBound(ctx, path, LOLAN_REGMAP_DEPTH);
+  lolanRegMapMove(ctx, i+1, i, ctx->regMapCount - i);
+  lolan_fillRegMapEntry(ctx, i, path, vType, ptr, size, readOnly);
+  ctx->regMapCount++;
+#ifdef LOLAN_REGMAP_HASH_SIZE
+  lolanPtrHashInsertShift(ctx, i);   // the following register map indices are changed
+#endif
+#ifdef LOLAN_REGMAP_FLAG_BITMAPS
+  lolanFlagBitmapShift(ctx, i, true);
+#endif
+  return LOLAN_RETVAL_YES;
+} /* lolan_regVar */
+
+/**************************************************************************//**
+ * @brief
+ *   Register multiple new LoLaN variables at once.
+ * @details
+ *   The variable definitions are validated, appended to the register map,
+ *   and the register map is sorted only once. This is the preferred way
+ *   to register a large number of variables (e.g. at startup).
+ *   The rules are the same as for lolan_regVar(). Within the table,
+ *   a path must not be the same as or the base path of an other one.
+ *   The action is atomic: if any of the definitions is invalid, no variable
+ *   will be registered.
+ * @note
+ *   Without LOLAN_REGMAP_HASH_SIZE, the data pointers are checked against
+ *   the already registered variables by linear search.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @param[in] vars
+ *   Array of the variable definitions (in any order).
+ * @param[in] count
+ *   Number of the variable definitions.
+ * @param[out] errorIndex
+ *   If assigned (not NULL), the index of the first invalid definition will
+ *   be output here in case of error. (The output is count if the register
+ *   map is full, or if a conflict within the table is found after sorting.)
+ * @return
+ *   LOLAN_RETVAL_YES if the action was successful,
+ *   otherwise LOLAN_RETVAL_GENERROR.
+ *****************************************************************************/
+int8_t lolan_regVarBatch(lolan_ctx *ctx, const lolan_VarDef *vars, LR_SIZE_T count,
+                         LR_SIZE_T *errorIndex)
+{
+  LR_SIZE_T i, j, base, staged;
   uint8_t defLvl;
-  LR_SIZE_T i, occ;
 
-  /* check variable size */
-  if (size == 0) return LOLAN_RETVAL_GENERROR;  // zero size is not acceptable
-  switch (vType) {
-    case LOLAN_INT:
-    case LOLAN_UINT:
-      if ((size != 1) && (size != 2) && (size != 4) && (size != 8))   // unsupported integer number size
-        return LOLAN_RETVAL_GENERROR;
-      break;
-    case LOLAN_FLOAT:
-      if ((size != 4) && (size != 8))   // unsupported floating point number size
-        return LOLAN_RETVAL_GENERROR;
-      break;
-  }
-  /* check the specified path for formal error */
-  if (!lolanIsPathValid(path) || path[0] == 0) return LOLAN_RETVAL_GENERROR;
-  /* check for duplicates */
-  for (i = 0; i < LOLAN_REGMAP_SIZE; i++) {
-    if (memcmp(ctx->regMap[i].p, path, LOLAN_REGMAP_DEPTH) == 0)   // the specified path already exists
-      return LOLAN_RETVAL_GENERROR;
-    if (ctx->regMap[i].data == ptr)   // the specified address is already mapped to an other LoLaN variable
-      return LOLAN_RETVAL_GENERROR;
+  if (LOLAN_REGMAP_IS_CONST(ctx)) return LOLAN_RETVAL_GENERROR;   // (read-only register map)
+  base = ctx->regMapCount;
+  staged = 0;
+  i = count;
+  if (lolanRegMapReserve(ctx, (size_t) base + count) != LOLAN_RETVAL_YES) goto error;   // the register map is full
+
+  /* validate the definitions and stage them in the free part of the register map */
+  for (i = 0; i < count; i++) {
+    if ( !lolan_isVarDefValid(vars[i].p, vars[i].vType, vars[i].size)
+         || (lolanRegMapFindByPtr(ctx, vars[i].data) < LOLAN_REGMAP_SIZE)
+         || lolan_isPathConflicting(ctx, vars[i].p) )
+      goto error;
+    lolan_fillRegMapEntry(ctx, base+i, vars[i].p, vars[i].vType, vars[i].data,
+                          vars[i].size, vars[i].readOnly);
+#ifdef LOLAN_REGMAP_HASH_SIZE
+    lolanPtrHashInsert(ctx, base+i);   // (the staged entries are also found by the duplicate check)
+#endif
+    staged++;
   }
-  /* check for other invalid cases */
-  defLvl = lolanPathDefinitionLevel(ctx, path, &occ, false);   // get the definition level and occurrences for it
-  if (occ > 0) return LOLAN_RETVAL_GENERROR;   // e.g. add (1,2,2) then add (1,2,0)
-  if (defLvl > 1) {
-    for (i = 0; i < LOLAN_REGMAP_SIZE; i++) {
-      if (memcmp(ctx->regMap[i].p, path, defLvl-1) == 0)
-        if (ctx->regMap[i].p[defLvl-1] == 0)
-          return LOLAN_RETVAL_GENERROR;    // e.g. add (1,2,0) then add (1,2,2)
-    }
+
+  i = count;   // (the table index is not known after sorting)
+#ifndef LOLAN_REGMAP_HASH_SIZE
+  /* check for duplicate addresses within the table (after sorting, they are adjacent) */
+  lolanRegMapSortRangeByPtr(ctx, base, base+count);
+  for (j = base+1; j < base+count; j++)
+    if (LRM_DATA(ctx, j-1) == LRM_DATA(ctx, j)) goto error;
+#endif
+  /* check for conflicting paths within the table (after sorting, they are adjacent) */
+  lolanRegMapSortRange(ctx, base, base+count);
+  for (j = base+1; j < base+count; j++) {
+    defLvl = lolanPathDefinitionLevel(NULL, LRM_P(ctx, j-1), NULL, false);
+    if (memcmp(LRM_P(ctx, j-1), LRM_P(ctx, j), defLvl) == 0)   // same path or base path of the next one
+      goto error;
   }
-  /* search for a free register map entry for the new variable */
-  for (i = 0; i < LOLAN_REGMAP_SIZE; i++) {
-    if (ctx->regMap[i].p[0] == 0) {   // free entry found
-      memcpy(ctx->regMap[i].p, path, LOLAN_REGMAP_DEPTH);
-      ctx->regMap[i].flags = vType + (readOnly ? LOLAN_REGMAP_REMOTE_READONLY_BIT : 0);
-      ctx->regMap[i].data = ptr;
-      ctx->regMap[i].size = size;
-#ifdef LOLAN_ALLOW_VARLEN_LOLANDATA
-      ctx->regMap[i].sizeActual = size;   // actual data size is the same as variable size by default
+
+  /* merge the new entries */
+  ctx->regMapCount = base + count;
+  lolanRegMapSortRange(ctx, 0, ctx->regMapCount);
+#ifdef LOLAN_REGMAP_HASH_SIZE
+  lolanPtrHashRebuild(ctx);   // the register map indices are changed
+#endif
+#ifdef LOLAN_REGMAP_FLAG_BITMAPS
+  lolanFlagBitmapRebuild(ctx);
+#endif
+  return LOLAN_RETVAL_YES;
+
+error:
+  if (errorIndex != NULL) *errorIndex = i;
+  if (staged > 0) {   // drop the staged entries
+    lolanRegMapClear(ctx, base, staged);
+#ifdef LOLAN_REGMAP_HASH_SIZE
+    lolanPtrHashRebuild(ctx);
 #endif
-      lolan_regMapSort(ctx);   // sort the register map by path
-      return LOLAN_RETVAL_YES;
-    }
   }
-  /* the register map is full */
   return LOLAN_RETVAL_GENERROR;
-} /* lolan_regVar */
+} /* lolan_regVarBatch */
 
 /**************************************************************************//**
  * @brief
@@ -151,22 +484,17 @@ int8_t lolan_isVarUpdated(lolan_ctx *ctx, const void *ptr, bool clearFlag)
 {
   LR_SIZE_T i;
 
-  for (i = 0; i < LOLAN_REGMAP_SIZE; i++) {
-    if (ctx->regMap[i].p[0] != 0) {   // (skip free entries)
-      if (ctx->regMap[i].data == ptr) {    // variable is found by data pointer
-        if (ctx->regMap[i].flags & LOLAN_REGMAP_REMOTE_UPDATE_BIT) {   // check remote update flag
-          if (clearFlag) {
-            ctx->regMap[i].flags &= ~(LOLAN_REGMAP_REMOTE_UPDATE_BIT);
-          }
-          return LOLAN_RETVAL_YES;
-        } else {
-          return LOLAN_RETVAL_NO;
-        }
-      }
+  i = lolanRegMapFindByPtr(ctx, ptr);   // find variable by data pointer
+  if (i >= LOLAN_REGMAP_SIZE)   // no variable mapped to the specified address was found
+    return LOLAN_RETVAL_GENERROR;
+  if (LRM_FLAGS(ctx, i) & LOLAN_REGMAP_REMOTE_UPDATE_BIT) {   // check remote update flag
+    if (clearFlag) {
+      lolanFlagClear(ctx, i, LOLAN_REGMAP_REMOTE_UPDATE_BIT);
     }
+    return LOLAN_RETVAL_YES;
+  } else {
+    return LOLAN_RETVAL_NO;
   }
-  /* no variable mapped to the specified address was found */
-  return LOLAN_RETVAL_GENERROR;
 } /* lolan_isVarUpdated */
 
 /**************************************************************************//**
@@ -197,17 +525,14 @@ int8_t lolan_processUpdated(lolan_ctx *ctx, bool clearFlag, lpuCallback callback
   bool found;
 
   found = false;
-  for (i = 0; i < LOLAN_REGMAP_SIZE; i++) {
-    if (ctx->regMap[i].p[0] != 0) {   // (skip free entries)
-      if (ctx->regMap[i].flags & LOLAN_REGMAP_REMOTE_UPDATE_BIT) {   // check remote update flag
-        if (clearFlag) {
-          ctx->regMap[i].flags &= ~(LOLAN_REGMAP_REMOTE_UPDATE_BIT);
-        }
-        found = true;
-        if (callback != NULL) {   // callback function is specified
-          (*callback)(ctx->regMap[i].data);   // invoke callback function
-        }
-      }
+  for (i = lolanFlagNext(ctx, LOLAN_REGMAP_REMOTE_UPDATE_BIT, 0); i < LOLAN_REGMAP_SIZE;
+       i = lolanFlagNext(ctx, LOLAN_REGMAP_REMOTE_UPDATE_BIT, i+1)) {   // variables with remote update flag
+    if (clearFlag) {
+      lolanFlagClear(ctx, i, LOLAN_REGMAP_REMOTE_UPDATE_BIT);
+    }
+    found = true;
+    if (callback != NULL) {   // callback function is specified
+      (*callback)(LRM_DATA(ctx, i));   // invoke callback function
     }
   }
   /* indicate the presence of updated variables */
@@ -234,17 +559,21 @@ int8_t lolan_rmVar(lolan_ctx *ctx, const void *ptr)
 {
   LR_SIZE_T i;
 
-  for (i = 0; i < LOLAN_REGMAP_SIZE; i++) {
-    if (ctx->regMap[i].p[0] != 0) {   // (skip free entries)
-      if (ctx->regMap[i].data == ptr) {   // variable is found by data pointer
-        memset(ctx->regMap[i].p, 0, LOLAN_REGMAP_DEPTH);   // invalidate path
-        ctx->regMap[i].flags = 0;    // invalidate flags (variable type)
-        return LOLAN_RETVAL_YES;
-      }
-    }
-  }
-  /* no variable mapped to the specified address was found */
-  return LOLAN_RETVAL_GENERROR;
+  if (LOLAN_REGMAP_IS_CONST(ctx)) return LOLAN_RETVAL_GENERROR;   // (read-only register map)
+  i = lolanRegMapFindByPtr(ctx, ptr);   // find variable by data pointer
+  if (i >= LOLAN_REGMAP_SIZE)   // no variable mapped to the specified address was found
+    return LOLAN_RETVAL_GENERROR;
+#ifdef LOLAN_REGMAP_HASH_SIZE
+  lolanPtrHashRemoveShift(ctx, i);   // the following register map indices will be changed
+#endif
+  /* remove the entry, keeping the free entries at the end of the register map */
+  ctx->regMapCount--;
+  lolanRegMapMove(ctx, i, i+1, ctx->regMapCount - i);
+  lolanRegMapClear(ctx, ctx->regMapCount, 1);   // invalidate path, flags (variable type) and data
+#ifdef LOLAN_REGMAP_FLAG_BITMAPS
+  lolanFlagBitmapShift(ctx, i, false);
+#endif
+  return LOLAN_RETVAL_YES;
 } /* lolan_rmVar */
 
 /**************************************************************************//**
@@ -266,16 +595,11 @@ int8_t lolan_setFlag(lolan_ctx *ctx, const void *ptr, uint16_t flags)
 {
   LR_SIZE_T i;
 
-  for (i = 0; i < LOLAN_REGMAP_SIZE; i++) {
-    if (ctx->regMap[i].p[0] != 0) {   // (skip free entries)
-      if (ctx->regMap[i].data == ptr) {    // variable is found by data pointer
-        ctx->regMap[i].flags |= (flags & LOLAN_REGMAP_USER_MASK);      // set flags (only user flags can be modified)
-        return LOLAN_RETVAL_YES;
-      }
-    }
-  }
-  /* no variable mapped to the specified address was found */
-  return LOLAN_RETVAL_GENERROR;
+  i = lolanRegMapFindByPtr(ctx, ptr);   // find variable by data pointer
+  if (i >= LOLAN_REGMAP_SIZE)   // no variable mapped to the specified address was found
+    return LOLAN_RETVAL_GENERROR;
+  lolanFlagSet(ctx, i, flags & LOLAN_REGMAP_USER_MASK);      // set flags (only user flags can be modified)
+  return LOLAN_RETVAL_YES;
 } /* lolan_setFlag */
 
 /**************************************************************************//**
@@ -293,15 +617,10 @@ uint16_t lolan_getFlag(lolan_ctx *ctx, const void *ptr)
 {
   LR_SIZE_T i;
 
-  for (i = 0; i < LOLAN_REGMAP_SIZE; i++) {
-    if (ctx->regMap[i].p[0] != 0) {   // (skip free entries)
-      if (ctx->regMap[i].data == ptr) {    // variable is found by data pointer
-        return ctx->regMap[i].flags;      // return flags
-      }
-    }
-  }
-  /* no variable mapped to the specified address was found */
-  return 0;
+  i = lolanRegMapFindByPtr(ctx, ptr);   // find variable by data pointer
+  if (i >= LOLAN_REGMAP_SIZE)   // no variable mapped to the specified address was found
+    return 0;
+  return LRM_FLAGS(ctx, i);      // return flags
 } /* lolan_getFlag */
 
 /**************************************************************************//**
@@ -324,21 +643,13 @@ int8_t lolan_clearFlag(lolan_ctx *ctx, const void *ptr, uint16_t flags)
   LR_SIZE_T i;
 
   if (ptr != NULL) {   // variable pointer is specified
-    for (i = 0; i < LOLAN_REGMAP_SIZE; i++) {
-      if (ctx->regMap[i].p[0] != 0) {    // (skip free entries)
-        if (ctx->regMap[i].data == ptr) {    // variable is found by data pointer
-          ctx->regMap[i].flags &= ~(flags & LOLAN_REGMAP_USER_MASK);   // clear flags (only user flags can be modified)
-          return LOLAN_RETVAL_YES;
-        }
-      }
-    }
-    /* no variable mapped to the specified address was found */
-    return LOLAN_RETVAL_GENERROR;
+    i = lolanRegMapFindByPtr(ctx, ptr);   // find variable by data pointer
+    if (i >= LOLAN_REGMAP_SIZE)   // no variable mapped to the specified address was found
+      return LOLAN_RETVAL_GENERROR;
+    lolanFlagClear(ctx, i, flags & LOLAN_REGMAP_USER_MASK);   // clear flags (only user flags can be modified)
+    return LOLAN_RETVAL_YES;
   } else {   // clear flags for all
-    for (i = 0; i < LOLAN_REGMAP_SIZE; i++) {
-      if (ctx->regMap[i].p[0] != 0)    // (skip free entries)
-        ctx->regMap[i].flags &= ~(flags & LOLAN_REGMAP_USER_MASK);   // clear flags (only user flags can be modified)
-    }
+    lolanFlagClearAll(ctx, flags & LOLAN_REGMAP_USER_MASK);   // clear flags (only user flags can be modified)
     return LOLAN_RETVAL_YES;
   }
 } /* lolan_clearFlag */
@@ -360,15 +671,10 @@ LOLAN_VARIABLE_TAG_TYPE* lolan_getTagPtr(lolan_ctx *ctx, const void *ptr)
 {
   LR_SIZE_T i;
 
-  for (i = 0; i < LOLAN_REGMAP_SIZE; i++) {
-    if (ctx->regMap[i].p[0] != 0) {   // (skip free entries)
-      if (ctx->regMap[i].data == ptr) {    // variable is found by data pointer
-        return &(ctx->regMap[i].tag);      // return flags
-      }
-    }
-  }
-  /* no variable mapped to the specified address was found */
-  return NULL;
+  i = lolanRegMapFindByPtr(ctx, ptr);   // find variable by data pointer
+  if (i >= LOLAN_REGMAP_SIZE)   // no variable mapped to the specified address was found
+    return NULL;
+  return &(LRM_TAG(ctx, i));      // return tag pointer
 } /* lolan_getTagPtr */
 #endif
 
@@ -378,6 +684,12 @@ LOLAN_VARIABLE_TAG_TYPE* lolan_getTagPtr(lolan_ctx *ctx, const void *ptr)
  * @note
  *   Accessing register map entries directly is only recommended for
  *   LoLaN experts! (:
+ * @note
+ *   With LOLAN_REGMAP_FLAG_BITMAPS, the user flags must not be modified
+ *   directly through the register map entry (e.g. LRM_FLAGS()), because
+ *   the flag bitmaps would not follow the change, and the variable would
+ *   be missed by lolan_processUpdated() and the INFORM functions. Use
+ *   lolan_setFlag() and lolan_clearFlag() instead.
  * @param[in] ctx
  *   Pointer to the LoLaN context variable.
  * @param[in] isPath
@@ -398,19 +710,53 @@ LR_SIZE_T lolan_getIndex(lolan_ctx *ctx, bool isPath, const void *ptr_or_path,
 {
   LR_SIZE_T i;
 
-  for (i = 0; i < LOLAN_REGMAP_SIZE; i++) {
-    if (ctx->regMap[i].p[0] != 0) {    // (skip free entries)
-      if (    (!isPath && (ctx->regMap[i].data == ptr_or_path))     // variable is found by data pointer
-           || ( isPath && (memcmp(ctx->regMap[i].p, ptr_or_path, LOLAN_REGMAP_DEPTH) == 0)) ) {   // variable is found by path
-        if (errorOut != NULL) *errorOut = false;
+  if (!isPath) {   // search by data pointer
+    i = lolanRegMapFindByPtr(ctx, ptr_or_path);
+    if (errorOut != NULL) *errorOut = (i >= LOLAN_REGMAP_SIZE);
+    return i;
+  }
+  i = lolanRegMapFindByPath(ctx, ptr_or_path);   // search by path
+  if (errorOut != NULL) *errorOut = (i >= LOLAN_REGMAP_SIZE);
+  return i;
+} /* lolan_getIndex */
+
+/**************************************************************************//**
+ * @brief
+ *   Check the consistency of the register map.
+ * @details
+ *   Every entry must be a valid variable definition (see lolan_regVar()),
+ *   the entries must be sorted by path without conflicts, and every
+ *   variable must be found by its path and data pointer.
+ *   This is intended for register map tables supplied by the application
+ *   (see lolan_initConst()). Without LOLAN_REGMAP_HASH_SIZE, the data
+ *   pointers are checked by linear search.
+ * @param[in] ctx
+ *   Pointer to the LoLaN context variable.
+ * @return
+ *   The register map index of the first invalid entry.
+ *   (ctx->regMapCount if the register map is consistent)
+ *****************************************************************************/
+LR_SIZE_T lolan_checkRegMap(lolan_ctx *ctx)
+{
+  LR_SIZE_T i;
+  uint8_t defLvl;
+
+  for (i = 0; i < ctx->regMapCount; i++) {
+    if (!lolan_isVarDefValid(LRM_P(ctx, i), (lolan_VarType) (LRM_FLAGS(ctx, i) & LOLAN_REGMAP_TYPE_MASK),
+                             LRM_SIZE(ctx, i)))
+      return i;
+    if (i > 0) {   // (conflicting paths are adjacent)
+      defLvl = lolanPathDefinitionLevel(NULL, LRM_P(ctx, i-1), NULL, false);
+      if ( (memcmp(LRM_P(ctx, i-1), LRM_P(ctx, i), LOLAN_REGMAP_DEPTH) >= 0)   // not sorted
+           || (memcmp(LRM_P(ctx, i-1), LRM_P(ctx, i), defLvl) == 0) )   // base path of this one
         return i;
-      }
     }
+    if ( (lolanRegMapFindByPath(ctx, LRM_P(ctx, i)) != i)
+         || (lolanRegMapFindByPtr(ctx, LRM_DATA(ctx, i)) != i) )   // (duplicate data pointer)
+      return i;
   }
-  /* no variable mapped to the specified address / with the specified path was found */
-  if (errorOut != NULL) *errorOut = true;
-  return LOLAN_REGMAP_SIZE;
-} /* lolan_getIndex */
+  return ctx->regMapCount;
+} /* lolan_checkRegMap */
 
 #ifdef LOLAN_ALLOW_VARLEN_LOLANDATA
 
@@ -436,18 +782,15 @@ int8_t lolan_setDataActualLength(lolan_ctx *ctx, const void *ptr, LV_SIZE_T len)
 {
   LR_SIZE_T i;
 
-  for (i = 0; i < LOLAN_REGMAP_SIZE; i++) {
-    if (ctx->regMap[i].p[0] != 0) {   // (skip free entries)
-      if (ctx->regMap[i].data == ptr) {    // variable is found by data pointer
-        if ((ctx->regMap[i].flags & LOLAN_REGMAP_TYPE_MASK) != LOLAN_DATA) break;  // only for DATA type
-        if (ctx->regMap[i].size < len || len == 0) break;  // actual size cannot be greater than variable size, and cannot be zero
-        ctx->regMap[i].sizeActual = len;
-        return LOLAN_RETVAL_YES;
-      }
-    }
-  }
-  /* no variable mapped to the specified address was found */
-  return LOLAN_RETVAL_GENERROR;
+  i = lolanRegMapFindByPtr(ctx, ptr);   // find variable by data pointer
+  if (i >= LOLAN_REGMAP_SIZE)   // no variable mapped to the specified address was found
+    return LOLAN_RETVAL_GENERROR;
+  if ((LRM_FLAGS(ctx, i) & LOLAN_REGMAP_TYPE_MASK) != LOLAN_DATA)   // only for DATA type
+    return LOLAN_RETVAL_GENERROR;
+  if (LRM_SIZE(ctx, i) < len || len == 0)   // actual size cannot be greater than variable size, and cannot be zero
+    return LOLAN_RETVAL_GENERROR;
+  LRM_SIZEACTUAL(ctx, i) = len;
+  return LOLAN_RETVAL_YES;
 } /* lolan_setDataActualLength */
 
 /**************************************************************************//**
@@ -465,16 +808,12 @@ LV_SIZE_T lolan_getDataActualLength(lolan_ctx *ctx, const void *ptr)
 {
   LR_SIZE_T i;
 
-  for (i = 0; i < LOLAN_REGMAP_SIZE; i++) {
-    if (ctx->regMap[i].p[0] != 0) {   // (skip free entries)
-      if (ctx->regMap[i].data == ptr) {    // variable is found by data pointer
-        if ((ctx->regMap[i].flags & LOLAN_REGMAP_TYPE_MASK) != LOLAN_DATA) break;  // only for DATA type
-        return ctx->regMap[i].sizeActual;
-      }
-    }
-  }
-  /* no variable mapped to the specified address was found */
-  return 0;
+  i = lolanRegMapFindByPtr(ctx, ptr);   // find variable by data pointer
+  if (i >= LOLAN_REGMAP_SIZE)   // no variable mapped to the specified address was found
+    return 0;
+  if ((LRM_FLAGS(ctx, i) & LOLAN_REGMAP_TYPE_MASK) != LOLAN_DATA)   // only for DATA type
+    return 0;
+  return LRM_SIZEACTUAL(ctx, i);
 } /* lolan_getDataActualLength */
 
 #endif /* ifdef LOLAN_ALLOW_VARLEN_LOLANDATA */
@@ -496,6 +835,34 @@ void lolan_resetPacket(lolan_Packet *lp)
   lp->routingRequested = false;
 } /* lolan_resetPacket */
 
+/**************************************************************************//**
+ * @brief
+ *   Construct the header of a packet (binary representation).
+ * @param[in] lp
+ *   Pointer to the source LoLaN packet structure.
+ * @param[out] buf
+ *   Memory address of the destination buffer (LOLAN_PACKET_HEADER_SIZE
+ *   bytes).
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ *****************************************************************************/
+static void lolanCreatePacketHeader(const lolan_Packet *lp, uint8_t *buf)
+{
+  buf[0] = lp->packetType;
+  buf[0] |= lp->multiPart << 3;
+  if (lp->ackRequired)        buf[0] |= 0x20;
+  buf[1] = 0x74;    // IEEE 802.15.4 protocol version = 3
+  if (lp->securityEnabled)    buf[1] |= 0x08;
+  if (lp->routingRequested)   buf[1] |= 0x80;
+
+  buf[2] = lp->packetCounter;
+
+  buf[3] = (lp->fromId)      & 0xFF;
+  buf[4] = (lp->fromId >> 8) & 0xFF;
+  buf[5] = (lp->toId)        & 0xFF;
+  buf[6] = (lp->toId >> 8)   & 0xFF;
+} /* lolanCreatePacketHeader */
+
 /**************************************************************************//**
  * @brief
  *   Output the binary representation of a LoLaN packet to the specified
@@ -535,19 +902,7 @@ int8_t lolan_createPacket(const lolan_Packet *lp, uint8_t *buf,
   }
 
   /* construct the packet header */
-  buf[0] = lp->packetType;
-  buf[0] |= lp->multiPart << 3;
-  if (lp->ackRequired)        buf[0] |= 0x20;
-  buf[1] = 0x74;    // IEEE 802.15.4 protocol version = 3
-  if (lp->securityEnabled)    buf[1] |= 0x08;
-  if (lp->routingRequested)   buf[1] |= 0x80;
-
-  buf[2] = lp->packetCounter;
-
-  buf[3] = (lp->fromId)      & 0xFF;
-  buf[4] = (lp->fromId >> 8) & 0xFF;
-  buf[5] = (lp->toId)        & 0xFF;
-  buf[6] = (lp->toId >> 8)   & 0xFF;
+  lolanCreatePacketHeader(lp, buf);
 
   /* copy the packet payload */
   memcpy(&(buf[7]), lp->payload, lp->payloadSize);
@@ -564,6 +919,111 @@ int8_t lolan_createPacket(const lolan_Packet *lp, uint8_t *buf,
   return LOLAN_RETVAL_YES;
 } /* lolan_createPacket */
 
+/**************************************************************************//**
+ * @brief
+ *   Output the binary representation of a LoLaN packet as segments.
+ * @details
+ *   The packet is described by three segments (header, payload and CRC),
+ *   which are to be transmitted in order: only the header and the CRC are
+ *   generated, the payload is not copied (the payload segment points to
+ *   the payload of the packet structure). The CRC is calculated across
+ *   the header and the payload.
+ * @param[in] lp
+ *   Pointer to the source LoLaN packet structure.
+ * @param[out] header
+ *   Buffer for the header (LOLAN_PACKET_HEADER_SIZE bytes).
+ * @param[out] crc
+ *   Buffer for the CRC (LOLAN_PACKET_CRC_SIZE bytes). May be NULL if
+ *   withCRC is false.
+ * @param[out] seg
+ *   Array of 3 segments which receives the header, the payload and the
+ *   CRC segment (the size of the CRC segment is 0 if withCRC is false).
+ * @param[in] withCRC
+ *   Calculates the checksum (CRC16) of the packet if true.
+ * @return
+ *   LOLAN_RETVAL_YES:       The segments are filled.
+ *   LOLAN_RETVAL_GENERROR:  The packet is too long.
+ *****************************************************************************/
+int8_t lolan_createPacketSegments(const lolan_Packet *lp, uint8_t *header, uint8_t *crc,
+                lolan_Segment *seg, bool withCRC)
+{
+  uint16_t crc16;
+
+  /* error check */
+  if (LOLAN_PACKET_HEADER_SIZE + lp->payloadSize + (withCRC ? LOLAN_PACKET_CRC_SIZE : 0) > LOLAN_MAX_PACKET_SIZE)
+    return LOLAN_RETVAL_GENERROR;
+
+  lolanCreatePacketHeader(lp, header);
+  seg[0].data = header;
+  seg[0].size = LOLAN_PACKET_HEADER_SIZE;
+  seg[1].data = lp->payload;
+  seg[1].size = lp->payloadSize;
+  seg[2].data = crc;
+  seg[2].size = 0;
+
+  /* compute CRC if needed */
+  if (withCRC) {
+    crc16 = lolan_CRC_update(lolan_CRC_init(), header, LOLAN_PACKET_HEADER_SIZE);
+    crc16 = lolan_CRC_final(lolan_CRC_update(crc16, lp->payload, lp->payloadSize));
+    crc[0] = (crc16 >> 8) & 0xFF;
+    crc[1] =  crc16       & 0xFF;
+    seg[2].size = LOLAN_PACKET_CRC_SIZE;
+  }
+
+  return LOLAN_RETVAL_YES;
+} /* lolan_createPacketSegments */
+
+/**************************************************************************//**
+ * @brief
+ *   Output the binary representation of a LoLaN packet around its payload.
+ * @details
+ *   The payload of the packet structure should be generated in a frame
+ *   buffer after a reserved header area (lp->payload should be set to
+ *   LOLAN_PACKET_PAYLOAD(frame) before the payload is generated, e.g. by
+ *   lolan_processGet() or lolan_createInform()). The header is written in
+ *   front of the payload and the CRC after it, so the complete packet is
+ *   created in the frame buffer without copying the payload.
+ * @note
+ *   IMPORTANT: the frame buffer (starting at lp->payload -
+ *   LOLAN_PACKET_HEADER_SIZE) should have a minimum size of
+ *   LOLAN_MAX_PACKET_SIZE!
+ * @param[in] lp
+ *   Pointer to the source LoLaN packet structure.
+ * @param[out] outputSize
+ *   Pointer to a number variable which receives the size of the packet
+ *   in the frame buffer.
+ * @param[in] withCRC
+ *   Appends a software calculated checksum (CRC16) to the packet if true.
+ * @return
+ *   Starting address of the packet (the frame buffer), or NULL if the
+ *   packet is too long.
+ *****************************************************************************/
+uint8_t* lolan_createPacketInPlace(const lolan_Packet *lp, size_t *outputSize, bool withCRC)
+{
+  uint8_t *buf = lp->payload - LOLAN_PACKET_HEADER_SIZE;
+  size_t size;
+  uint16_t crc16;
+
+  /* error check */
+  size = LOLAN_PACKET_HEADER_SIZE + lp->payloadSize;
+  if (size + (withCRC ? LOLAN_PACKET_CRC_SIZE : 0) > LOLAN_MAX_PACKET_SIZE)
+    return NULL;
+
+  /* construct the packet header */
+  lolanCreatePacketHeader(lp, buf);
+
+  /* compute CRC if needed */
+  if (withCRC) {
+    crc16 = lolan_CRC_calc(buf, size);
+    buf[size++] = (crc16 >> 8) & 0xFF;
+    buf[size++] =  crc16       & 0xFF;
+  }
+
+  *outputSize = size;   // output the size information
+
+  return buf;
+} /* lolan_createPacketInPlace */
+
 /**************************************************************************//**
  * @brief
  *   Parse a packet header (binary representation), and fill a LoLaN
@@ -590,11 +1050,45 @@ void lolan_parsePacketHeader(const uint8_t *pak, lolan_Packet *lp)
 
 /**************************************************************************//**
  * @brief
- *   Parse a packet (binary representation), and fill a LoLaN packet
- *   structure from it (if LoLaN).
+ *   Check the length and the frame version of a packet.
+ * @param[in] pak
+ *   The starting address of the input data (packet).
+ * @param[in] pak_len
+ *   Length of the input data (packet) in bytes.
+ * @return
+ *   LOLAN_RETVAL_YES:       The packet may be a LoLaN packet.
+ *   LOLAN_RETVAL_NO:        Not a LoLaN packet.
+ *   LOLAN_RETVAL_GENERROR:  The packet is too long.
  * @note
- *   IMPORTANT: lp->payload has to point to a buffer with a minimum size
- *   of LOLAN_PACKET_MAX_PAYLOAD_SIZE!
+ *   FOR INTERNAL USE ONLY.
+ *****************************************************************************/
+static int8_t lolanPacketCheck(const uint8_t *pak, size_t pak_len)
+{
+  if (pak_len < 9)  // packet is too short
+    return LOLAN_RETVAL_NO;
+  if (pak_len > LOLAN_MAX_PACKET_SIZE)  // packet is too long
+    return LOLAN_RETVAL_GENERROR;
+  if (((pak[1] >> 4) & 0x03) != 3)   // checking 802.15.4 FRAME version
+    return LOLAN_RETVAL_NO;
+  return LOLAN_RETVAL_YES;
+} /* lolanPacketCheck */
+
+/**************************************************************************//**
+ * @brief
+ *   Parse a packet (binary representation) without copying the payload.
+ * @details
+ *   Same as lolan_parsePacket(), but lp->payload is set to point to the
+ *   payload inside the input data (view mode), so no payload buffer is
+ *   needed. The packet structure can be passed to lolan_processGet(),
+ *   lolan_processSet() and the lolan_simpleProcessXxx() functions, they
+ *   do not modify the payload of the input packet.
+ * @note
+ *   IMPORTANT: the payload of the packet structure is valid only as long
+ *   as the input data is unchanged (the receive buffer must not be reused
+ *   or freed while the packet is processed), and it must be treated as
+ *   read-only. The payload buffer of a reply packet must not overlap with
+ *   the input data. lp->payload is not changed if LOLAN_RETVAL_YES is not
+ *   returned.
  * @param[in] pak
  *   The starting address of the input data (packet).
  * @param[in] pak_len
@@ -606,22 +1100,20 @@ void lolan_parsePacketHeader(const uint8_t *pak, lolan_Packet *lp)
  *   LOLAN_RETVAL_NO:        Not a LoLaN packet.
  *   LOLAN_RETVAL_GENERROR:  An error has occurred. (e.g. CRC error)
  *****************************************************************************/
-int8_t lolan_parsePacket(const uint8_t *pak, size_t pak_len, lolan_Packet *lp)
+int8_t lolan_parsePacketView(const uint8_t *pak, size_t pak_len, lolan_Packet *lp)
 {
   uint16_t crc16;
+  int8_t retval;
 
   /* error check */
-  if (pak_len < 9)  // packet is too short
-    return LOLAN_RETVAL_NO;
-  if (pak_len > LOLAN_MAX_PACKET_SIZE)  // packet is too long
-    return LOLAN_RETVAL_GENERROR;
-  if (((pak[1] >> 4) & 0x03) != 3)   // checking 802.15.4 FRAME version
-    return LOLAN_RETVAL_NO;
+  retval = lolanPacketCheck(pak, pak_len);
+  if (retval != LOLAN_RETVAL_YES)
+    return retval;
 
   /* extract header */
   lolan_parsePacketHeader(pak, lp);
 
-  /* check CRC and extract payload */
+  /* check CRC and set the payload */
   crc16 = lolan_CRC_calc(pak, pak_len);
   if (crc16 != 0) {
     DLOG(("\n lolan_parsePacket(): CRC error"));
@@ -629,10 +1121,266 @@ int8_t lolan_parsePacket(const uint8_t *pak, size_t pak_len, lolan_Packet *lp)
     return LOLAN_RETVAL_GENERROR;
   }
   lp->payloadSize = pak_len - 9;
-  memcpy(lp->payload, &(pak[7]), lp->payloadSize);
+  lp->payload = (uint8_t*) &(pak[7]);   // (points into the input data)
 
   DLOG(("\n LoLaN packet t:%d s:%d ps:%d from:%d to:%d enc:%d", lp->packetType, pak_len,
         lp->payloadSize, lp->fromId, lp->toId, lp->securityEnabled));
 
   return LOLAN_RETVAL_YES;   // done
+} /* lolan_parsePacketView */
+
+/**************************************************************************//**
+ * @brief
+ *   Parse a packet (binary representation), and fill a LoLaN packet
+ *   structure from it (if LoLaN).
+ * @note
+ *   IMPORTANT: lp->payload has to point to a buffer with a minimum size
+ *   of LOLAN_PACKET_MAX_PAYLOAD_SIZE! (See lolan_parsePacketView() for
+ *   parsing without a payload buffer.)
+ * @param[in] pak
+ *   The starting address of the input data (packet).
+ * @param[in] pak_len
+ *   Length of the input data (packet) in bytes.
+ * @param[out] lp
+ *   Pointer to a LoLaN packet structure which will receive data.
+ * @return
+ *   LOLAN_RETVAL_YES:       LoLaN packet found, everything went o.k.
+ *   LOLAN_RETVAL_NO:        Not a LoLaN packet.
+ *   LOLAN_RETVAL_GENERROR:  An error has occurred. (e.g. CRC error)
+ *****************************************************************************/
+int8_t lolan_parsePacket(const uint8_t *pak, size_t pak_len, lolan_Packet *lp)
+{
+  uint8_t *buf = lp->payload;
+  int8_t retval;
+
+  retval = lolan_parsePacketView(pak, pak_len, lp);
+  if (retval == LOLAN_RETVAL_YES) {   // extract payload
+    memcpy(buf, lp->payload, lp->payloadSize);
+    lp->payload = buf;
+  }
+  return retval;
 } /* lolan_parsePacket */
+
+/**************************************************************************//**
+ * @brief
+ *   Decode SLIP escape sequences in place.
+ * @param[in,out] data
+ *   Starting address of the data (without the terminating END byte).
+ * @param[in] size
+ *   Size of the encoded data in bytes.
+ * @return
+ *   Size of the decoded data in bytes.
+ * @note
+ *   FOR INTERNAL USE ONLY.
+ *****************************************************************************/
+static size_t lolanSlipDecode(uint8_t *data, size_t size)
+{
+  uint8_t *r = data, *w = data, *end = data + size;
+
+  while ((r < end) && (*r != LOLAN_SLIP_ESC))   // (nothing to move before the first escape)
+    r++;
+  w = r;
+  while (r < end) {
+    if ((*r == LOLAN_SLIP_ESC) && (r + 1 < end)) {
+      r++;
+      if (*r == LOLAN_SLIP_ESC_END)
+        *w = LOLAN_SLIP_END;
+      else if (*r == LOLAN_SLIP_ESC_ESC)
+        *w = LOLAN_SLIP_ESC;
+      else
+        *w = *r;   // (invalid escape sequence, the CRC check will fail)
+    } else {
+      *w = *r;
+    }
+    r++;
+    w++;
+  }
+  return w - data;
+} /* lolanSlipDecode */
+
+/**************************************************************************//**
+ * @brief
+ *   Parse multiple packets from a buffer.
+ * @details
+ *   Splits the buffer into frames, and fills a LoLaN packet structure for
+ *   each frame in view mode (see lolan_parsePacketView()). The frames are
+ *   checked and the CRCs are calculated in one pass, then the headers of
+ *   the valid packets are extracted in a separate loop.
+ *   A packet structure and a status are returned for each frame (also for
+ *   the invalid ones, their payload is NULL): the status is the return
+ *   value of lolan_parsePacket() for the frame.
+ *   Processing stops at an incomplete frame at the end of the buffer, or
+ *   when maxCount frames are processed; *consumed tells where to continue.
+ *   Empty SLIP frames (e.g. a leading END byte) are skipped.
+ * @note
+ *   IMPORTANT: the payloads point into the buffer (see the lifetime rules
+ *   at lolan_parsePacketView()). SLIP frames are decoded in place, so the
+ *   buffer is modified up to *consumed.
+ * @param[in,out] buf
+ *   The starting address of the input data (frames).
+ * @param[in] len
+ *   Length of the input data in bytes.
+ * @param[in] framing
+ *   Framing of the packets in the buffer.
+ * @param[out] lps
+ *   Array of LoLaN packet structures (at least maxCount).
+ * @param[out] status
+ *   Array which receives the status of the frames (at least maxCount):
+ *   LOLAN_RETVAL_YES (LoLaN packet), LOLAN_RETVAL_NO (not a LoLaN packet)
+ *   or LOLAN_RETVAL_GENERROR (e.g. CRC error).
+ * @param[in] maxCount
+ *   Maximum number of frames to process.
+ * @param[out] consumed
+ *   Pointer to a variable which receives the number of bytes processed
+ *   (the size of the complete frames). May be NULL.
+ * @return
+ *   Number of frames processed (packet structures and statuses filled).
+ *****************************************************************************/
+size_t lolan_parsePackets(uint8_t *buf, size_t len, lolan_Framing framing, lolan_Packet *lps,
+                int8_t *status, size_t maxCount, size_t *consumed)
+{
+  size_t pos = 0, n = 0, i;
+  size_t start, flen, hlen;
+  const uint8_t *end;
+  int8_t st;
+
+  /* split the frames, check them and calculate the CRCs */
+  hlen = (framing == LOLAN_FRAMING_LEN16) ? 2 : 1;   // size of the length prefix
+  while ((n < maxCount) && (pos < len)) {
+    if (framing == LOLAN_FRAMING_SLIP) {
+      end = memchr(&buf[pos], LOLAN_SLIP_END, len - pos);
+      if (end == NULL)   // incomplete frame
+        break;
+      start = pos;
+      flen = lolanSlipDecode(&buf[pos], end - &buf[pos]);
+      pos = end - buf + 1;
+      if (flen == 0)   // empty frame
+        continue;
+    } else {
+      if (len - pos < hlen)   // incomplete frame
+        break;
+      flen = (hlen == 2) ? (buf[pos] | (buf[pos + 1] << 8)) : buf[pos];
+      if (len - pos - hlen < flen)   // incomplete frame
+        break;
+      start = pos + hlen;
+      pos = start + flen;
+    }
+
+    st = lolanPacketCheck(&buf[start], flen);
+    if ((st == LOLAN_RETVAL_YES) && (lolan_CRC_update(lolan_CRC_init(), &buf[start], flen) != 0))
+      st = LOLAN_RETVAL_GENERROR;   // CRC error
+    status[n] = st;
+    if (st == LOLAN_RETVAL_YES) {
+      lps[n].payload = &buf[start + 7];   // (points into the buffer)
+      lps[n].payloadSize = flen - 9;
+    } else {
+      lps[n].payload = NULL;
+      lps[n].payloadSize = 0;
+    }
+    n++;
+  }
+  if (consumed != NULL)
+    *consumed = pos;
+
+  /* extract the headers */
+  for (i = 0; i < n; i++) {
+    if (status[i] == LOLAN_RETVAL_YES)
+      lolan_parsePacketHeader(lps[i].payload - 7, &lps[i]);
+  }
+
+  return n;
+} /* lolan_parsePackets */
+
+/**************************************************************************//**
+ * @brief
+ *   Initialize a packet parser.
+ * @details
+ *   The packet parser processes the packet data as it is received (e.g.
+ *   byte by byte from a serial line): the CRC is updated and the header
+ *   is extracted on the fly, so the packet is validated as soon as its
+ *   end is detected (see lolan_packetParserEnd()).
+ * @param[out] pp
+ *   Pointer to the packet parser.
+ *****************************************************************************/
+void lolan_packetParserInit(lolan_PacketParser *pp)
+{
+  pp->length = 0;
+  pp->crc = lolan_CRC_init();
+} /* lolan_packetParserInit */
+
+/**************************************************************************//**
+ * @brief
+ *   Feed received packet data to a packet parser.
+ * @details
+ *   The data of a packet may be fed in any number of parts. The data
+ *   exceeding LOLAN_MAX_PACKET_SIZE is dropped (the packet will be
+ *   refused by lolan_packetParserEnd()).
+ * @param[in,out] pp
+ *   Pointer to the packet parser.
+ * @param[in] data
+ *   Starting address of the received data (without framing/escaping).
+ * @param[in] size
+ *   Size of the received data in bytes.
+ *****************************************************************************/
+void lolan_packetParserPush(lolan_PacketParser *pp, const uint8_t *data, size_t size)
+{
+  size_t n;
+
+  n = (pp->length < LOLAN_MAX_PACKET_SIZE) ? LOLAN_MAX_PACKET_SIZE - pp->length : 0;   // free space in the buffer
+  if (n > size)
+    n = size;
+  if (n > 0) {
+    memcpy(&pp->frame[pp->length], data, n);
+    pp->crc = lolan_CRC_update(pp->crc, data, n);
+    if ((pp->length < 7) && (pp->length + n >= 7))   // the header is complete
+      lolan_parsePacketHeader(pp->frame, &pp->header);
+  }
+  pp->length += size;
+} /* lolan_packetParserPush */
+
+/**************************************************************************//**
+ * @brief
+ *   Finish a packet in a packet parser.
+ * @details
+ *   Validates the packet received by the packet parser (the CRC has been
+ *   already calculated), and fills a LoLaN packet structure from it. The
+ *   packet parser is made ready for the next packet.
+ * @note
+ *   IMPORTANT: the payload of the packet structure points into the buffer
+ *   of the packet parser (view mode, see lolan_parsePacketView()), so it
+ *   is valid only until new data is fed to the packet parser.
+ * @param[in,out] pp
+ *   Pointer to the packet parser.
+ * @param[out] lp
+ *   Pointer to a LoLaN packet structure which will receive data.
+ * @return
+ *   LOLAN_RETVAL_YES:       LoLaN packet found, everything went o.k.
+ *   LOLAN_RETVAL_NO:        Not a LoLaN packet.
+ *   LOLAN_RETVAL_GENERROR:  An error has occurred. (e.g. CRC error)
+ *****************************************************************************/
+int8_t lolan_packetParserEnd(lolan_PacketParser *pp, lolan_Packet *lp)
+{
+  size_t pak_len = pp->length;
+  uint16_t crc16 = pp->crc;
+  int8_t retval;
+
+  lolan_packetParserInit(pp);   // (ready for the next packet, the buffer is kept)
+
+  /* error check */
+  retval = lolanPacketCheck(pp->frame, pak_len);
+  if (retval != LOLAN_RETVAL_YES)
+    return retval;
+  if (crc16 != 0) {
+    DLOG(("\n lolan_packetParserEnd(): CRC error"));
+    return LOLAN_RETVAL_GENERROR;
+  }
+
+  *lp = pp->header;
+  lp->payloadSize = pak_len - 9;
+  lp->payload = &(pp->frame[7]);   // (points into the buffer of the parser)
+
+  DLOG(("\n LoLaN packet t:%d s:%d ps:%d from:%d to:%d enc:%d", lp->packetType, pak_len,
+        lp->payloadSize, lp->fromId, lp->toId, lp->securityEnabled));
+
+  return LOLAN_RETVAL_YES;   // done
+} /* lolan_packetParserEnd */
@@ -12,13 +12,23 @@
 #include "lolan_config.h"
 
 
-#define LOLAN_VERSION      111    // LoLaN version number
+#define LOLAN_VERSION      112    // LoLaN version number
 
 
 /* common defines */
 #define LOLAN_PACKET_MAX_PAYLOAD_SIZE  (LOLAN_MAX_PACKET_SIZE - 9)   // maximum size of LoLaN packet payload (do not modify!)
+#define LOLAN_PACKET_HEADER_SIZE       7   // size of the packet header (do not modify!)
+#define LOLAN_PACKET_CRC_SIZE          2   // size of the packet CRC (do not modify!)
+#define LOLAN_PACKET_PAYLOAD(frame)    ((frame) + LOLAN_PACKET_HEADER_SIZE)   // payload in a frame buffer (see lolan_createPacketInPlace())
 #define LOLAN_BROADCAST_ADDRESS                    0xFFFF   // address for broadcast
 
+#ifndef LOLAN_SLIP_END   // SLIP special characters (see lolan_parsePackets())
+  #define LOLAN_SLIP_END       0x7D
+  #define LOLAN_SLIP_ESC       0xDB
+  #define LOLAN_SLIP_ESC_END   0xDC
+  #define LOLAN_SLIP_ESC_ESC   0xDD
+#endif
+
 /* size defines */
 #if LOLAN_REGMAP_SIZE <= UINT8_MAX   // integer type to represent register map size
   #define LR_SIZE_T    uint8_t   // 8-bit
@@ -37,12 +47,92 @@
   #define LV_SIZE_MAX  UINT32_MAX
 #endif
 
+#ifdef LOLAN_REGMAP_HASH_SIZE   // pointer hash index size check
+  #if (LOLAN_REGMAP_HASH_SIZE & (LOLAN_REGMAP_HASH_SIZE - 1)) || (LOLAN_REGMAP_HASH_SIZE <= LOLAN_REGMAP_SIZE) || (LOLAN_REGMAP_HASH_SIZE < 8)
+    #error "LOLAN_REGMAP_HASH_SIZE must be a power of 2 (at least 8) and greater than LOLAN_REGMAP_SIZE"
+  #endif
+#endif
+
+#ifdef LOLAN_REGMAP_FLAG_BITMAPS   // flag bitmap sizes
+  #define LOLAN_FLAG_BITMAP_COUNT   5    // number of flags tracked (see lolanFlagBitmapIndex())
+  #define LOLAN_FLAG_BITMAP_WORDS   ((LOLAN_REGMAP_SIZE + 31) / 32)
+#endif
+
+#ifndef LOLAN_REGMAP_DYNAMIC   // register map array declaration
+  #define LOLAN_REGMAP_ARRAY(type, name)  type name[LOLAN_REGMAP_SIZE]   // fixed size (in the context)
+#else
+  #define LOLAN_REGMAP_ARRAY(type, name)  type *name   // runtime size (see lolan_initEx())
+  #ifndef LOLAN_MALLOC   // memory allocator of the register map
+    #define LOLAN_MALLOC(size)  malloc(size)
+    #define LOLAN_FREE(ptr)     free(ptr)
+  #endif
+#endif
+
+#ifdef LOLAN_REGMAP_CONST   // read-only register map tables
+  #if !defined(LOLAN_REGMAP_DYNAMIC) || !defined(LOLAN_REGMAP_SOA)
+    #error "LOLAN_REGMAP_CONST requires LOLAN_REGMAP_DYNAMIC and LOLAN_REGMAP_SOA"
+  #endif
+#endif
+
+#ifndef LOLAN_CBOR_INDEX_SIZE   // container index of the received payloads
+  #define LOLAN_CBOR_INDEX_SIZE   32
+#endif
+#if LOLAN_CBOR_INDEX_SIZE < 1
+  #error "LOLAN_CBOR_INDEX_SIZE must be at least 1"
+#endif
+
+#ifndef LOLAN_CRC_TABLES   // CRC16 calculation method
+  #define LOLAN_CRC_TABLES   0
+#endif
+#if (LOLAN_CRC_TABLES != 0) && (LOLAN_CRC_TABLES != 1) && (LOLAN_CRC_TABLES != 8)
+  #error "LOLAN_CRC_TABLES must be 0, 1 or 8"
+#endif
+
+#ifdef LOLAN_MULTIPART_MAX_SIZE   // multipart reassembly
+  #ifndef LOLAN_MULTIPART_SLOTS
+    #define LOLAN_MULTIPART_SLOTS   2
+  #endif
+  #if LOLAN_MULTIPART_MAX_SIZE > LOLAN_MAX_PACKET_SIZE   // largest payload size to be represented
+    #define LOLAN_MAX_PAYLOAD_SIZE_ALL   LOLAN_MULTIPART_MAX_SIZE
+  #endif
+#endif
+#ifdef LOLAN_DUPFILTER_SOURCES   // duplicate request filter
+  #ifndef LOLAN_DUPFILTER_REPLY_SIZE
+    #define LOLAN_DUPFILTER_REPLY_SIZE   LOLAN_PACKET_MAX_PAYLOAD_SIZE
+  #endif
+  #if LOLAN_DUPFILTER_REPLY_SIZE > LOLAN_PACKET_MAX_PAYLOAD_SIZE
+    #error "LOLAN_DUPFILTER_REPLY_SIZE must not exceed LOLAN_PACKET_MAX_PAYLOAD_SIZE"
+  #endif
+  #define LOLAN_DUPFILTER_WINDOW   32   // number of packet counters tracked before the newest one (bits of lolan_DupFilterEntry.window)
+#endif
+
+#ifdef LOLAN_PENDING_SIZE   // pending request table
+  #ifndef LOLAN_PENDING_DESTS
+    #define LOLAN_PENDING_DESTS   LOLAN_PENDING_SIZE
+  #endif
+  #if (LOLAN_PENDING_SIZE & (LOLAN_PENDING_SIZE - 1)) || (LOLAN_PENDING_SIZE < 8) || (LOLAN_PENDING_SIZE > 65536)
+    #error "LOLAN_PENDING_SIZE must be a power of 2 (8..65536)"
+  #endif
+  #if (LOLAN_PENDING_DESTS & (LOLAN_PENDING_DESTS - 1)) || (LOLAN_PENDING_DESTS < 8) || (LOLAN_PENDING_DESTS > 65536)
+    #error "LOLAN_PENDING_DESTS must be a power of 2 (8..65536)"
+  #endif
+#endif
+#ifdef LOLAN_PREPARED_INFORM_SIZE   // prepared INFORM
+  #if LOLAN_PREPARED_INFORM_SIZE < 1
+    #error "LOLAN_PREPARED_INFORM_SIZE must be at least 1"
+  #endif
+#endif
+
+#ifndef LOLAN_MAX_PAYLOAD_SIZE_ALL
+  #define LOLAN_MAX_PAYLOAD_SIZE_ALL   LOLAN_MAX_PACKET_SIZE
+#endif
+
 #ifndef LP_SIZE_T   // integer type to represent packet & payload size
-  #if LOLAN_MAX_PACKET_SIZE <= UINT8_MAX
+  #if LOLAN_MAX_PAYLOAD_SIZE_ALL <= UINT8_MAX
     #define LP_SIZE_T    uint8_t
-  #elif LOLAN_MAX_PACKET_SIZE <= UINT16_MAX
+  #elif LOLAN_MAX_PAYLOAD_SIZE_ALL <= UINT16_MAX
     #define LP_SIZE_T    uint16_t
-  #elif LOLAN_MAX_PACKET_SIZE <= UINT32_MAX
+  #elif LOLAN_MAX_PAYLOAD_SIZE_ALL <= UINT32_MAX
     #define LP_SIZE_T    uint32_t
   #endif
 #endif
@@ -102,6 +192,12 @@ typedef enum {
   LOLAN_CONTROL_DEBUGMSG_PACKET = 16
 } lolan_ControlPacketType;
 
+typedef enum {
+  LOLAN_FRAMING_LEN8 = 0,    // each frame is preceded by its length (1 byte)
+  LOLAN_FRAMING_LEN16 = 1,   // each frame is preceded by its length (2 bytes, little-endian)
+  LOLAN_FRAMING_SLIP = 2     // SLIP encoded frames, each terminated by LOLAN_SLIP_END
+} lolan_Framing;
+
 // LoLaN packet
 typedef struct {
   lolan_PacketType packetType;
@@ -116,6 +212,162 @@ typedef struct {
   LP_SIZE_T payloadSize;
 } lolan_Packet;
 
+// segment of a packet (see lolan_createPacketSegments())
+typedef struct {
+  const uint8_t *data;
+  size_t size;
+} lolan_Segment;
+
+// multipart fragmenter (see lolan_fragmenterInit())
+typedef struct {
+  lolan_Packet packet;    // header of the fragments
+  const uint8_t *data;    // payload to be sent
+  size_t size;            // size of the payload
+  size_t offset;          // size of the payload already sent
+  size_t count;           // number of fragments already sent
+  LP_SIZE_T fragmentSize; // maximum payload size of a fragment
+} lolan_Fragmenter;
+
+#ifdef LOLAN_MULTIPART_MAX_SIZE
+// multipart reassembly table (see lolan_reassemblyInit())
+typedef struct {
+  bool used;
+  uint16_t fromId;                         // key: sender and packet counter
+  uint8_t packetCounter;
+  uint32_t time;                           // time of the last fragment
+  LP_SIZE_T size;                          // size of the payload received
+  uint8_t data[LOLAN_MULTIPART_MAX_SIZE];  // payload received
+} lolan_ReassemblySlot;
+
+typedef struct {
+  lolan_ReassemblySlot slot[LOLAN_MULTIPART_SLOTS];
+  uint32_t timeout;                        // timeout of an incomplete payload (0: no timeout)
+} lolan_Reassembly;
+#endif
+
+#ifdef LOLAN_DUPFILTER_SOURCES
+// duplicate request filter entry of a sender (see lolan_processGet(), lolan_processSet())
+typedef struct {
+  bool used;
+  uint16_t fromId;                 // sender
+  uint8_t lastCounter;             // newest packet counter processed
+  uint32_t window;                 // packet counters processed before lastCounter (bit n: lastCounter - 1 - n)
+  uint32_t lastUse;                // for replacement (value of lolan_ctx.dupFilterClock)
+  lolan_PacketType requestType;    // type of the request with lastCounter
+  uint16_t requestCRC;             // CRC of the payload of the request with lastCounter
+  bool replyCached;                // the reply to the request with lastCounter is stored
+  LP_SIZE_T replySize;
+  uint8_t reply[LOLAN_DUPFILTER_REPLY_SIZE];   // payload of the reply
+} lolan_DupFilterEntry;
+#endif
+
+#ifdef LOLAN_TX_SLOTS
+// transmit engine callbacks (see lolan_txInit(), lolan_txSubmit())
+typedef void (*lolan_TxSendFunc)(void *arg, const lolan_Packet *lp);
+typedef void (*lolan_TxDoneFunc)(void *arg, const lolan_Packet *request, const lolan_Packet *ack, int8_t status);
+
+typedef enum {
+  LOLAN_TXS_FREE = 0,
+  LOLAN_TXS_QUEUED,                // waiting for a free place in the window of its destination
+  LOLAN_TXS_INFLIGHT               // sent, waiting for the ACK
+} lolan_TxState;
+
+// transmit engine request slot
+typedef struct {
+  lolan_TxState state;
+  uint32_t seq;                    // submission order (for queued requests)
+  uint32_t deadline;               // time of the next retransmission
+  uint32_t rto;                    // current retransmission timeout
+  uint8_t tries;                   // number of transmissions
+  lolan_TxDoneFunc done;           // completion callback
+  void *doneArg;
+  lolan_Packet packet;             // request (payload points to data)
+  uint8_t data[LOLAN_PACKET_MAX_PAYLOAD_SIZE];
+} lolan_TxSlot;
+
+// ACK/retransmit engine for GET & SET requests (see lolan_txInit())
+typedef struct {
+  lolan_TxSlot slot[LOLAN_TX_SLOTS];
+  lolan_TxSendFunc send;           // packet output
+  void *sendArg;
+  uint32_t timeout;                // initial retransmission timeout
+  uint8_t maxTries;                // maximum number of transmissions of a request
+  uint8_t window;                  // maximum number of requests in flight per destination
+  uint32_t seq;                    // submission counter
+} lolan_TxEngine;
+#endif
+
+#ifdef LOLAN_PENDING_SIZE
+// pending request completion callback (see lolan_pendingAdd())
+typedef void (*lolan_PendingFunc)(void *arg, const lolan_Packet *ack, int8_t status);
+
+typedef struct {
+  bool used;
+  uint16_t toId;                   // key: destination and packet counter
+  uint8_t packetCounter;
+  uint32_t time;                   // time of lolan_pendingAdd()
+  lolan_PendingFunc done;
+  void *doneArg;
+} lolan_PendingEntry;
+
+typedef struct {
+  bool used;
+  uint16_t toId;
+  uint8_t packetCounter;           // next packet counter for the destination
+  uint16_t pending;                // number of pending requests to the destination
+  uint32_t lastUse;                // for replacement (value of lolan_PendingTable.destClock)
+} lolan_PendingDest;
+
+// pending request table of a master (see lolan_pendingInit())
+typedef struct {
+  lolan_PendingEntry entry[LOLAN_PENDING_SIZE];   // open-addressing hash table of the requests
+  lolan_PendingDest dest[LOLAN_PENDING_DESTS];    // open-addressing hash table of the destinations
+  uint32_t count;                  // number of pending requests
+  uint32_t destCount;              // number of destinations
+  uint32_t destClock;              // incremented on each use of a destination
+} lolan_PendingTable;
+#endif
+
+#ifdef LOLAN_PREPARED_INFORM_SIZE
+// variable of a prepared INFORM
+typedef struct {
+  const void *data;                // variable data
+  LP_SIZE_T offset;                // offset of the value in the payload (initial byte of the CBOR data item)
+  uint8_t type;                    // variable type (LOLAN_INT, LOLAN_UINT or LOLAN_FLOAT)
+  uint8_t size;                    // size in bytes
+} lolan_PreparedVar;
+
+// INFORM of a fixed set of variables encoded in advance (see lolan_prepareInform())
+typedef struct {
+  lolan_PreparedVar var[LOLAN_PREPARED_INFORM_SIZE];   // variables (sorted by path)
+  LR_SIZE_T count;                 // number of variables (0: not prepared)
+  LP_SIZE_T payloadSize;
+  uint8_t payload[LOLAN_PACKET_MAX_PAYLOAD_SIZE];   // INFORM payload
+} lolan_PreparedInform;
+#endif
+
+// JSON output buffer (see lolan_jsonBufferInit(), lolan_cborToJson(), lolan_packetToJson())
+typedef struct lolan_JsonBuffer lolan_JsonBuffer;
+typedef bool (*lolan_JsonGrowFunc)(void *arg, lolan_JsonBuffer *jb, size_t size);
+
+struct lolan_JsonBuffer {
+  char *buf;                       // JSON text (zero terminated)
+  size_t size;                     // size of the buffer
+  size_t len;                      // length of the text (the conversions append to it)
+  lolan_JsonGrowFunc grow;         // enlarges the buffer to at least size bytes, keeping the text (NULL: fixed size)
+  void *growArg;
+};
+
+#define LOLAN_JSON_BYTES_HEX   0x01   // byte strings in hexadecimal (base16) instead of base64url (flag of lolan_cborToJson(), lolan_packetToJson())
+
+// LoLaN packet parser (packet data received in parts, see lolan_packetParserPush())
+typedef struct {
+  uint8_t frame[LOLAN_MAX_PACKET_SIZE];   // packet data received
+  size_t length;                          // number of bytes received (more than the buffer size on overflow)
+  uint16_t crc;                           // CRC of the bytes received (see lolan_CRC_update())
+  lolan_Packet header;                    // packet header (valid if at least 7 bytes are received)
+} lolan_PacketParser;
+
 typedef struct {
   uint8_t p[LOLAN_REGMAP_DEPTH];    // LoLaN variable path
   uint16_t flags;                   // flags (e.g. variable type)
@@ -129,15 +381,113 @@ typedef struct {
 #endif
 } lolan_RegMap;
 
+typedef uint8_t lolan_RegMapPath[LOLAN_REGMAP_DEPTH];   // LoLaN variable path (structure-of-arrays layout)
+
+#ifdef LOLAN_REGMAP_CONST
+typedef struct {                    // register map in read-only memory (see lolan_initConst() and lolan-regmap.hpp)
+  LR_SIZE_T count;                  // number of variables
+  const lolan_RegMapPath *p;        // variable paths (sorted in ascending order)
+  const uint16_t *flags;            // initial flags (variable type, LOLAN_REGMAP_REMOTE_READONLY_BIT, user flags)
+  const LV_SIZE_T *size;            // variable sizes in bytes
+  void * const *data;               // variable data pointers
+  uint32_t pathHashSize;            // number of path hash slots (power of 2, 0: no path hash)
+  uint32_t pathHashBuckets;         // number of path hash buckets (power of 2)
+  const LR_SIZE_T *pathHash;        // path hash slots (register map index + 1, 0: empty slot)
+  const uint16_t *pathHashDisp;     // path hash seeds of the buckets
+} lolan_ConstRegMap;
+
+/* read-only register map from arrays (without path hash) */
+#define LOLAN_CONST_REGMAP(p, flags, size, data) \
+  { sizeof(p) / sizeof((p)[0]), (p), (flags), (size), (data), 0, 0, NULL, NULL }
+#endif
+
+typedef struct {                    // LoLaN variable definition for lolan_regVarBatch()
+  uint8_t p[LOLAN_REGMAP_DEPTH];    // LoLaN variable path
+  lolan_VarType vType;              // variable type
+  void *data;                       // variable data
+  LV_SIZE_T size;                   // size in bytes
+  bool readOnly;                    // remotely read-only
+} lolan_VarDef;
+
 typedef struct {
   uint16_t myAddress;   // our LoLaN address in the context
   uint8_t packetCounter;    // counter for automatically generated packets (INFORM, reply to SET & GET)
-  lolan_RegMap regMap[LOLAN_REGMAP_SIZE];
+#ifndef LOLAN_REGMAP_SOA
+  LOLAN_REGMAP_ARRAY(lolan_RegMap, regMap);
+#else   // structure-of-arrays layout (the fields of lolan_RegMap in separate arrays)
+  LOLAN_REGMAP_ARRAY(lolan_RegMapPath, regMapP);
+  LOLAN_REGMAP_ARRAY(uint16_t, regMapFlags);
+  LOLAN_REGMAP_ARRAY(LV_SIZE_T, regMapSize);
+#ifdef LOLAN_ALLOW_VARLEN_LOLANDATA
+  LOLAN_REGMAP_ARRAY(LV_SIZE_T, regMapSizeActual);
+#endif
+  LOLAN_REGMAP_ARRAY(void*, regMapData);
+#ifdef LOLAN_VARIABLE_TAG_TYPE
+  LOLAN_REGMAP_ARRAY(LOLAN_VARIABLE_TAG_TYPE, regMapTag);
+#endif
+#endif
+  LR_SIZE_T regMapCount;    // number of used register map entries
+#ifdef LOLAN_REGMAP_DYNAMIC
+  LR_SIZE_T regMapCapacity;   // number of register map entries in the memory block
+  void *regMapMem;            // memory block of the register map (NULL: no entries yet)
+  bool regMapOwned;           // the memory block is allocated by LoLaN (it grows on demand, see lolan_free())
+#endif
+#ifdef LOLAN_REGMAP_CONST
+  const lolan_ConstRegMap *constMap;   // read-only register map (NULL: none, the register map can be modified)
+#endif
+#ifdef LOLAN_REGMAP_HASH_SIZE
+#ifndef LOLAN_REGMAP_DYNAMIC
+  LR_SIZE_T ptrHash[LOLAN_REGMAP_HASH_SIZE];   // data pointer hash index (register map index + 1, 0: empty slot)
+#else
+  LR_SIZE_T *ptrHash;         // data pointer hash index (register map index + 1, 0: empty slot)
+  uint32_t ptrHashSize;       // number of hash index slots (power of 2, greater than regMapCapacity)
+#endif
+#endif
+#ifdef LOLAN_REGMAP_FLAG_BITMAPS
+#ifndef LOLAN_REGMAP_DYNAMIC
+  uint32_t flagBitmap[LOLAN_FLAG_BITMAP_COUNT][LOLAN_FLAG_BITMAP_WORDS];   // bitmaps of the tracked flags (bit n: register map index n)
+#else
+  uint32_t *flagBitmap[LOLAN_FLAG_BITMAP_COUNT];   // bitmaps of the tracked flags (bit n: register map index n)
+#endif
+#endif
+#ifdef LOLAN_DUPFILTER_SOURCES
+  lolan_DupFilterEntry dupFilter[LOLAN_DUPFILTER_SOURCES];   // duplicate request filter (one entry per sender)
+  uint32_t dupFilterClock;    // incremented on each use of a duplicate filter entry
+#endif
 //  void (*replyDeviceCallbackFunc)(uint8_t *buf, uint8_t size);    // (future plans)
 //  uint8_t networkKey[16];
 //  uint8_t nodeIV[16];
 } lolan_ctx;
 
+/* register map field accessors (lvalues) for both register map layouts
+   (with LOLAN_REGMAP_FLAG_BITMAPS, the flags must be modified by lolan_setFlag()/lolan_clearFlag() only) */
+#ifndef LOLAN_REGMAP_SOA
+  #define LRM_P(ctx, i)           ((ctx)->regMap[i].p)
+  #define LRM_FLAGS(ctx, i)       ((ctx)->regMap[i].flags)
+  #define LRM_SIZE(ctx, i)        ((ctx)->regMap[i].size)
+  #define LRM_SIZEACTUAL(ctx, i)  ((ctx)->regMap[i].sizeActual)
+  #define LRM_DATA(ctx, i)        ((ctx)->regMap[i].data)
+  #define LRM_TAG(ctx, i)         ((ctx)->regMap[i].tag)
+#else
+  #define LRM_P(ctx, i)           ((ctx)->regMapP[i])
+  #define LRM_FLAGS(ctx, i)       ((ctx)->regMapFlags[i])
+  #define LRM_SIZE(ctx, i)        ((ctx)->regMapSize[i])
+  #define LRM_SIZEACTUAL(ctx, i)  ((ctx)->regMapSizeActual[i])
+  #define LRM_DATA(ctx, i)        ((ctx)->regMapData[i])
+  #define LRM_TAG(ctx, i)         ((ctx)->regMapTag[i])
+#endif
+
+/* register map sizes of a context */
+#ifndef LOLAN_REGMAP_DYNAMIC
+  #define LRM_CAPACITY(ctx)       LOLAN_REGMAP_SIZE
+  #define LRM_HASH_SIZE(ctx)      LOLAN_REGMAP_HASH_SIZE
+  #define LRM_BITMAP_WORDS(ctx)   LOLAN_FLAG_BITMAP_WORDS
+#else
+  #define LRM_CAPACITY(ctx)       ((ctx)->regMapCapacity)
+  #define LRM_HASH_SIZE(ctx)      ((ctx)->ptrHashSize)
+  #define LRM_BITMAP_WORDS(ctx)   (((size_t) (ctx)->regMapCapacity + 31) / 32)
+#endif
+
 
 /**************************************************************************//**
  * @brief
@@ -164,10 +514,21 @@ typedef void (*lspiCallback)(uint8_t *path, uint8_t *data, LV_SIZE_T dataLen, lo
 
 
 extern void lolan_init(lolan_ctx *ctx, uint16_t initial_address);
+#ifdef LOLAN_REGMAP_DYNAMIC
+extern int8_t lolan_initEx(lolan_ctx *ctx, uint16_t initial_address, LR_SIZE_T capacity, void *mem);
+extern void lolan_free(lolan_ctx *ctx);
+extern size_t lolan_regMapMemSize(LR_SIZE_T capacity);
+#endif
+#ifdef LOLAN_REGMAP_CONST
+extern int8_t lolan_initConst(lolan_ctx *ctx, uint16_t initial_address, const lolan_ConstRegMap *map, void *mem);
+extern size_t lolan_constRegMapMemSize(const lolan_ConstRegMap *map);
+#endif
 extern void lolan_setAddress(lolan_ctx *ctx, uint16_t new_address);
 
 extern int8_t lolan_regVar(lolan_ctx *ctx, const uint8_t *path, lolan_VarType vType, void *ptr,
                            LV_SIZE_T size, bool readOnly);
+extern int8_t lolan_regVarBatch(lolan_ctx *ctx, const lolan_VarDef *vars, LR_SIZE_T count,
+                                LR_SIZE_T *errorIndex);
 extern int8_t lolan_isVarUpdated(lolan_ctx *ctx, const void *ptr, bool clearFlag);
 extern int8_t lolan_processUpdated(lolan_ctx *ctx, bool clearFlag, lpuCallback callback);
 extern int8_t lolan_rmVar(lolan_ctx *ctx, const void *ptr);
@@ -178,6 +539,7 @@ extern int8_t lolan_clearFlag(lolan_ctx *ctx, const void *ptr, uint16_t flags);
 extern LOLAN_VARIABLE_TAG_TYPE* lolan_getTagPtr(lolan_ctx *ctx, const void *ptr);
 #endif
 extern LR_SIZE_T lolan_getIndex(lolan_ctx *ctx, bool isPath, const void *ptr_or_path, bool *errorOut);
+extern LR_SIZE_T lolan_checkRegMap(lolan_ctx *ctx);
 
 #ifdef LOLAN_ALLOW_VARLEN_LOLANDATA
 extern int8_t lolan_setDataActualLength(lolan_ctx *ctx, const void *ptr, LV_SIZE_T len);
@@ -187,24 +549,78 @@ extern LV_SIZE_T lolan_getDataActualLength(lolan_ctx *ctx, const void *ptr);
 extern void lolan_resetPacket(lolan_Packet *lp);
 extern int8_t lolan_createPacket(const lolan_Packet *lp, uint8_t *buf, size_t maxSize,
                 size_t *outputSize, bool withCRC);
+extern int8_t lolan_createPacketSegments(const lolan_Packet *lp, uint8_t *header, uint8_t *crc,
+                lolan_Segment *seg, bool withCRC);
+extern uint8_t* lolan_createPacketInPlace(const lolan_Packet *lp, size_t *outputSize, bool withCRC);
 extern void lolan_parsePacketHeader(const uint8_t *pak, lolan_Packet *lp);
 extern int8_t lolan_parsePacket(const uint8_t *pak, size_t pak_len, lolan_Packet *lp);
+extern int8_t lolan_parsePacketView(const uint8_t *pak, size_t pak_len, lolan_Packet *lp);
+extern size_t lolan_parsePackets(uint8_t *buf, size_t len, lolan_Framing framing, lolan_Packet *lps,
+                int8_t *status, size_t maxCount, size_t *consumed);
+extern void lolan_packetParserInit(lolan_PacketParser *pp);
+extern void lolan_packetParserPush(lolan_PacketParser *pp, const uint8_t *data, size_t size);
+extern int8_t lolan_packetParserEnd(lolan_PacketParser *pp, lolan_Packet *lp);
+
+extern uint16_t lolan_CRC_init(void);
+extern uint16_t lolan_CRC_update(uint16_t crc, const uint8_t *data, size_t size);
+extern uint16_t lolan_CRC_final(uint16_t crc);
+extern uint16_t lolan_CRC_calc(const uint8_t *data, size_t size);
+
+extern int8_t lolan_processGet(lolan_ctx *ctx, const lolan_Packet *pak, lolan_Packet *reply);
+extern int8_t lolan_processSet(lolan_ctx *ctx, const lolan_Packet *pak, lolan_Packet *reply);
+extern int8_t lolan_processGetEx(lolan_ctx *ctx, const lolan_Packet *pak, lolan_Packet *reply,
+                LP_SIZE_T plSizeOverride);
 
-extern int8_t lolan_processGet(lolan_ctx *ctx, lolan_Packet *pak, lolan_Packet *reply);
-extern int8_t lolan_processSet(lolan_ctx *ctx, lolan_Packet *pak, lolan_Packet *reply);
+extern void lolan_fragmenterInit(lolan_Fragmenter *fr, const lolan_Packet *lp, const uint8_t *data,
+                size_t size, LP_SIZE_T fragmentSize);
+extern int8_t lolan_fragmenterNext(lolan_Fragmenter *fr, lolan_Packet *lp);
+#ifdef LOLAN_MULTIPART_MAX_SIZE
+extern void lolan_reassemblyInit(lolan_Reassembly *ra, uint32_t timeout);
+extern int8_t lolan_reassemblyPush(lolan_Reassembly *ra, const lolan_Packet *lp, uint32_t now,
+                lolan_Packet *out);
+#endif
+
+#ifdef LOLAN_TX_SLOTS
+extern void lolan_txInit(lolan_TxEngine *tx, lolan_TxSendFunc send, void *sendArg,
+                uint32_t timeout, uint8_t maxTries, uint8_t window);
+extern int8_t lolan_txSubmit(lolan_TxEngine *tx, const lolan_Packet *lp, uint32_t now,
+                lolan_TxDoneFunc done, void *doneArg);
+extern int8_t lolan_txAck(lolan_TxEngine *tx, const lolan_Packet *ack, uint32_t now);
+extern uint32_t lolan_txPoll(lolan_TxEngine *tx, uint32_t now);
+#endif
+
+#ifdef LOLAN_PENDING_SIZE
+extern void lolan_pendingInit(lolan_PendingTable *pt);
+extern int8_t lolan_pendingAdd(lolan_PendingTable *pt, lolan_Packet *lp, uint32_t now,
+                lolan_PendingFunc done, void *doneArg);
+extern int8_t lolan_pendingAck(lolan_PendingTable *pt, const lolan_Packet *ack);
+extern int8_t lolan_pendingCancel(lolan_PendingTable *pt, uint16_t toId, uint8_t packetCounter);
+extern uint32_t lolan_pendingExpire(lolan_PendingTable *pt, uint32_t now, uint32_t timeout);
+#endif
 
 extern int8_t lolan_createGet(lolan_ctx *ctx, lolan_Packet *pak, uint8_t *path);
 extern int8_t lolan_createInform(lolan_ctx *ctx, lolan_Packet *pak, bool multi);
 extern int8_t lolan_createInformEx(lolan_ctx *ctx, lolan_Packet *pak, bool multi,
                 bool secondary, LP_SIZE_T plSizeOverride, bool payloadOnly);
+#ifdef LOLAN_PREPARED_INFORM_SIZE
+extern int8_t lolan_prepareInform(lolan_ctx *ctx, lolan_PreparedInform *pi, const void * const *vars,
+                LR_SIZE_T count);
+extern int8_t lolan_createPreparedInform(lolan_ctx *ctx, const lolan_PreparedInform *pi, lolan_Packet *pak,
+                bool payloadOnly);
+#endif
 
 extern int8_t lolan_simpleCreateSet(lolan_ctx *ctx, lolan_Packet *pak, const uint8_t *path,
                 uint8_t *data, LV_SIZE_T data_len, lolan_VarType type);
-extern int8_t lolan_simpleProcessAck(lolan_Packet *pak, uint8_t *data, LV_SIZE_T data_max,
+extern int8_t lolan_simpleProcessAck(const lolan_Packet *pak, uint8_t *data, LV_SIZE_T data_max,
                 LV_SIZE_T *data_len, uint8_t *type, bool *zerokey);
-extern int8_t lolan_simpleExtractFromInform(lolan_Packet *pak, const uint8_t *path, uint8_t *data,
+extern int8_t lolan_simpleExtractFromInform(const lolan_Packet *pak, const uint8_t *path, uint8_t *data,
                 LV_SIZE_T data_max, LV_SIZE_T *data_len, uint8_t *type);
-extern int8_t lolan_simpleProcessInform(lolan_Packet *pak, uint8_t *buffer, LV_SIZE_T bufSize,
+extern int8_t lolan_simpleProcessInform(const lolan_Packet *pak, uint8_t *buffer, LV_SIZE_T bufSize,
                 lspiCallback callback);
 
+extern void lolan_jsonBufferInit(lolan_JsonBuffer *jb, char *buf, size_t size, lolan_JsonGrowFunc grow,
+                void *growArg);
+extern int8_t lolan_cborToJson(const uint8_t *data, size_t size, lolan_JsonBuffer *jb, uint8_t flags);
+extern int8_t lolan_packetToJson(const lolan_Packet *pak, lolan_JsonBuffer *jb, uint8_t flags);
+
 #endif /* LOLAN_H_ */
@@ -12,6 +12,22 @@
 #define LOLAN_REGMAP_SIZE	       20    // the maximum number of registers to be mapped (maximum: 65535)
 #define LOLAN_REGMAP_DEPTH       3     // depth of register paths
 #define LOLAN_VARSIZE_BITS       8     // variable size storage bits (8, 16, 32  /default: 8/)
+// #define LOLAN_REGMAP_HASH_SIZE   64    // size of the data pointer hash index (power of 2, >= 8, > LOLAN_REGMAP_SIZE; do not define to disable this feature)
+// #define LOLAN_REGMAP_FLAG_BITMAPS       // define this to track the update/request flags of the variables in bitmaps (5 bits per register map entry; the flags must be modified by lolan_setFlag()/lolan_clearFlag() only)
+// #define LOLAN_REGMAP_SOA                // define this to store the register map fields in separate arrays (structure-of-arrays layout)
+// #define LOLAN_REGMAP_DYNAMIC            // define this to allocate the register map at runtime (see lolan_initEx(), LOLAN_REGMAP_SIZE is the maximum capacity)
+// #define LOLAN_MALLOC(size)  malloc(size)   // memory allocator for LOLAN_REGMAP_DYNAMIC (default: malloc/free)
+// #define LOLAN_FREE(ptr)     free(ptr)
+// #define LOLAN_MULTIPART_MAX_SIZE 1024  // maximum payload size of a reassembled multipart packet (do not define to disable multipart reassembly)
+// #define LOLAN_MULTIPART_SLOTS    2     // number of multipart packets reassembled at the same time (default: 2)
+// #define LOLAN_DUPFILTER_SOURCES  4     // number of senders tracked by the duplicate request filter (do not define to disable this feature)
+// #define LOLAN_DUPFILTER_REPLY_SIZE 64  // maximum payload size of a cached reply for retransmitted requests (default: LOLAN_PACKET_MAX_PAYLOAD_SIZE; a retransmitted SET with a larger reply is not answered)
+// #define LOLAN_TX_SLOTS           8     // number of requests handled by the ACK/retransmit engine (do not define to disable this feature)
+// #define LOLAN_PENDING_SIZE       256   // number of slots of the pending request table (power of 2, 8..65536; at most 3/4 is used; do not define to disable this feature)
+// #define LOLAN_PENDING_DESTS      64    // number of destinations with own packet counter in the pending request table (power of 2, 8..65536; at most 3/4 is used, then an idle one is replaced  /default: LOLAN_PENDING_SIZE/)
+// #define LOLAN_PREPARED_INFORM_SIZE 16  // maximum number of variables in a prepared INFORM (see lolan_prepareInform(); do not define to disable this feature)
+// #define LOLAN_CBOR_INDEX_SIZE    32    // number of CBOR containers of a received payload skipped in constant time (see lolanCborValidate()  /default: 32/)
+// #define LOLAN_CRC_TABLES         8     // number of CRC16 lookup tables (0: no tables, 1: byte-wise (512 bytes), 8: slice-by-8 (4 kB)  /default: 0/)
 #define LOLAN_VARIABLE_TAG_TYPE  int   // type of auxiliary field in the LoLaN register map structure (do not define to disable this feature)
 // #define LP_SIZE_T                (unsigned char)   // specify integer type to represent LoLaN packet & payload size (undef to auto-select)
 
@@ -9,7 +9,7 @@ class SlipPacketizer
 	std::vector<uint8_t>	decodeBuffer;
 	std::vector<uint8_t>	encodeBuffer;
 
-	uint8_t prev_in;	// previous input char
+	uint8_t prev_in = 0;	// previous input char
 
     void finishEncode() {
 	encodeBuffer.push_back(SLIP_END);
@@ -64,4 +64,27 @@ class SlipPacketizer
 	return 0;
     }
 
+    // decode one byte without buffering
+    // return 1 if packet finished, 0 if a data byte is decoded into *out, -1 otherwise
+    int decodeByte(uint8_t in, uint8_t *out) {
+	if (prev_in==SLIP_ESC) {
+	    prev_in=0;
+	    if (in == SLIP_ESC_END) {
+		*out=SLIP_END;
+		return 0;
+	    } else if (in == SLIP_ESC_ESC) {
+		*out=SLIP_ESC;
+		return 0;
+	    }
+	}
+	prev_in=in;
+	if (in == SLIP_END) {
+	    return 1;
+	} else if (in == SLIP_ESC) {
+	    return -1;
+	}
+	*out=in;
+	return 0;
+    }
+
 };
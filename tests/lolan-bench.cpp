@@ -0,0 +1,980 @@
+/**
+ * LoLaN benchmark
+ *
+ * Measures the execution time of the LoLaN library functions.
+ * The results depend on lolan_config.h (e.g. LOLAN_REGMAP_SIZE,
+ * LOLAN_REGMAP_HASH_SIZE), build the library with a large register map
+ * for meaningful numbers.
+ *
+ * The parallel encoding with multiple contexts is also measured (its
+ * output is checked by lolan-test).
+ *
+ * usage: lolan-bench [variable count]
+ **/
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern "C" {
+#include <lolan_config.h>
+#include <lolan.h>
+#include <cbor.h>
+#include <cborjson.h>
+}
+#ifdef LOLAN_REGMAP_CONST
+#include <lolan-regmap.hpp>
+#endif
+
+static lolan_ctx lctx;
+static std::vector<uint32_t> vars;
+static std::vector<lolan_VarDef> defs;
+
+typedef std::chrono::steady_clock bclock;
+
+static double elapsedUs(bclock::time_point start)
+{
+  return std::chrono::duration<double, std::micro>(bclock::now() - start).count();
+}
+
+static void report(const char *name, double us, size_t ops)
+{
+  printf("%-40s %12.1f us  %10.3f us/op\n", name, us, us / (ops ? ops : 1));
+}
+
+// (re)initialize the context with an empty register map
+static void resetCtx()
+{
+#ifdef LOLAN_REGMAP_DYNAMIC
+  lolan_free(&lctx);
+#endif
+  lolan_init(&lctx, 1);
+}
+
+// create variable definitions with unique full-depth paths in random order
+static void createDefs(size_t count)
+{
+  vars.assign(count, 0);
+  defs.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    lolan_VarDef &d = defs[i];
+    size_t n = i;
+    memset(&d, 0, sizeof(d));
+    for (int l = LOLAN_REGMAP_DEPTH - 1; l >= 0; l--) {
+      d.p[l] = 1 + (n % 250);
+      n /= 250;
+    }
+    d.vType = LOLAN_UINT;
+    d.data = &vars[i];
+    d.size = sizeof(uint32_t);
+    d.readOnly = false;
+  }
+  std::shuffle(defs.begin(), defs.end(), std::mt19937(12345));
+}
+
+static void benchRegister(size_t count)
+{
+  bclock::time_point start;
+
+  resetCtx();
+  start = bclock::now();
+  for (size_t i = 0; i < count; i++) {
+    const lolan_VarDef &d = defs[i];
+    if (lolan_regVar(&lctx, d.p, d.vType, d.data, d.size, d.readOnly) != LOLAN_RETVAL_YES) {
+      printf("lolan_regVar failed at %zu\n", i);
+      exit(1);
+    }
+  }
+  report("lolan_regVar (one by one)", elapsedUs(start), count);
+
+  resetCtx();
+  start = bclock::now();
+  if (lolan_regVarBatch(&lctx, defs.data(), count, NULL) != LOLAN_RETVAL_YES) {
+    printf("lolan_regVarBatch failed\n");
+    exit(1);
+  }
+  report("lolan_regVarBatch", elapsedUs(start), count);
+}
+
+static void benchLookup(size_t count, size_t iterations)
+{
+  bclock::time_point start;
+  std::vector<size_t> order(iterations);
+  std::mt19937 rng(54321);
+  volatile LR_SIZE_T sink = 0;
+
+  resetCtx();
+  lolan_regVarBatch(&lctx, defs.data(), count, NULL);
+  for (size_t i = 0; i < iterations; i++)
+    order[i] = rng() % count;
+
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++)
+    sink += lolan_getIndex(&lctx, true, defs[order[i]].p, NULL);
+  report("lolan_getIndex (by path, random)", elapsedUs(start), iterations);
+
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++)
+    sink += lolan_getIndex(&lctx, false, defs[order[i]].data, NULL);
+  report("lolan_getIndex (by pointer, random)", elapsedUs(start), iterations);
+}
+
+static void benchGet(size_t count, const char *name, const uint8_t *path, size_t iterations)
+{
+  bclock::time_point start;
+  lolan_Packet req, reply;
+  uint8_t reqPayload[LOLAN_PACKET_MAX_PAYLOAD_SIZE], replyPayload[LOLAN_PACKET_MAX_PAYLOAD_SIZE];
+
+  resetCtx();
+  lolan_regVarBatch(&lctx, defs.data(), count, NULL);
+  lolan_resetPacket(&req);
+  req.payload = reqPayload;
+  if (lolan_createGet(&lctx, &req, (uint8_t*) path) != LOLAN_RETVAL_YES) {
+    printf("lolan_createGet failed\n");
+    exit(1);
+  }
+  req.toId = 1;
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    lolan_resetPacket(&reply);
+    reply.payload = replyPayload;
+    lolan_processGet(&lctx, &req, &reply);
+  }
+  report(name, elapsedUs(start), iterations);
+}
+
+static void benchParse(size_t count, const uint8_t *path, size_t iterations)
+{
+  bclock::time_point start;
+  lolan_Packet req, lp, reply;
+  uint8_t payload[LOLAN_PACKET_MAX_PAYLOAD_SIZE], replyPayload[LOLAN_PACKET_MAX_PAYLOAD_SIZE];
+  uint8_t frame[LOLAN_MAX_PACKET_SIZE];
+  size_t frameSize = 0;
+
+  resetCtx();
+  lolan_regVarBatch(&lctx, defs.data(), count, NULL);
+  lolan_resetPacket(&req);
+  req.payload = payload;
+  lolan_createGet(&lctx, &req, (uint8_t*) path);
+  req.toId = 1;
+  if (lolan_createPacket(&req, frame, sizeof(frame), &frameSize, true) != LOLAN_RETVAL_YES) {
+    printf("lolan_createPacket failed\n");
+    exit(1);
+  }
+
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    lp.payload = payload;
+    lolan_parsePacket(frame, frameSize, &lp);
+    lolan_resetPacket(&reply);
+    reply.payload = replyPayload;
+    lolan_processGet(&lctx, &lp, &reply);
+  }
+  report("lolan_parsePacket + processGet", elapsedUs(start), iterations);
+
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    lolan_parsePacketView(frame, frameSize, &lp);
+    lolan_resetPacket(&reply);
+    reply.payload = replyPayload;
+    lolan_processGet(&lctx, &lp, &reply);
+  }
+  report("lolan_parsePacketView + processGet", elapsedUs(start), iterations);
+}
+
+static void benchCreate(size_t count, const uint8_t *path, size_t iterations)
+{
+  bclock::time_point start;
+  lolan_Packet req, reply;
+  uint8_t reqPayload[LOLAN_PACKET_MAX_PAYLOAD_SIZE], replyPayload[LOLAN_PACKET_MAX_PAYLOAD_SIZE];
+  uint8_t frame[LOLAN_MAX_PACKET_SIZE], out[LOLAN_MAX_PACKET_SIZE];
+  uint8_t header[LOLAN_PACKET_HEADER_SIZE], crc[LOLAN_PACKET_CRC_SIZE];
+  lolan_Segment seg[3];
+  size_t size = 0;
+  volatile size_t sink = 0;
+  char name[64];
+
+  resetCtx();
+  lolan_regVarBatch(&lctx, defs.data(), count, NULL);
+  lolan_resetPacket(&req);
+  req.payload = reqPayload;
+  lolan_createGet(&lctx, &req, (uint8_t*) path);
+  req.toId = 1;
+  lolan_resetPacket(&reply);
+  reply.payload = LOLAN_PACKET_PAYLOAD(frame);   // (the reply is generated in the frame buffer)
+  lolan_processGet(&lctx, &req, &reply);
+  memcpy(replyPayload, reply.payload, reply.payloadSize);
+
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    reply.payload = replyPayload;
+    lolan_createPacket(&reply, out, sizeof(out), &size, true);
+    sink += size;
+  }
+  snprintf(name, sizeof(name), "lolan_createPacket (%d bytes)", (int) reply.payloadSize);
+  report(name, elapsedUs(start), iterations);
+
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    lolan_createPacketSegments(&reply, header, crc, seg, true);
+    sink += seg[2].size;
+  }
+  snprintf(name, sizeof(name), "lolan_createPacketSegments (%d bytes)", (int) reply.payloadSize);
+  report(name, elapsedUs(start), iterations);
+
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    reply.payload = LOLAN_PACKET_PAYLOAD(frame);
+    sink += (size_t) lolan_createPacketInPlace(&reply, &size, true);
+  }
+  snprintf(name, sizeof(name), "lolan_createPacketInPlace (%d bytes)", (int) reply.payloadSize);
+  report(name, elapsedUs(start), iterations);
+}
+
+static void benchParseBurst(size_t frames, size_t iterations)
+{
+  bclock::time_point start;
+  lolan_Packet pak;
+  std::vector<lolan_Packet> lps(frames);
+  std::vector<int8_t> status(frames);
+  std::vector<uint8_t> buf, work;
+  uint8_t payload[LOLAN_PACKET_MAX_PAYLOAD_SIZE];
+  size_t size = 0, pos = 0, consumed = 0;
+  volatile size_t sink = 0;
+  char name[64];
+
+  for (size_t f = 0; f < frames; f++) {   // length-prefixed frames (2 bytes)
+    lolan_resetPacket(&pak);
+    pak.packetType = LOLAN_PAK_INFORM;
+    pak.fromId = f;
+    pak.toId = 1;
+    pak.payload = payload;
+    pak.payloadSize = std::min(f % 32, (size_t) LOLAN_PACKET_MAX_PAYLOAD_SIZE);   // (short tag frames)
+    memset(payload, f, pak.payloadSize);
+    buf.resize(pos + 2 + LOLAN_MAX_PACKET_SIZE);
+    lolan_createPacket(&pak, &buf[pos + 2], LOLAN_MAX_PACKET_SIZE, &size, true);
+    buf[pos] = size & 0xFF;
+    buf[pos + 1] = size >> 8;
+    pos += 2 + size;
+  }
+  buf.resize(pos);
+
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    for (pos = 0; pos < buf.size(); pos += 2 + size) {
+      size = buf[pos] | (buf[pos + 1] << 8);
+      sink += lolan_parsePacketView(&buf[pos + 2], size, &pak);
+    }
+  }
+  snprintf(name, sizeof(name), "lolan_parsePacketView (%zu frames)", frames);
+  report(name, elapsedUs(start), iterations);
+
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++)
+    sink += lolan_parsePackets(buf.data(), buf.size(), LOLAN_FRAMING_LEN16, lps.data(), status.data(),
+                               frames, &consumed);
+  snprintf(name, sizeof(name), "lolan_parsePackets (%zu frames)", frames);
+  report(name, elapsedUs(start), iterations);
+  if (std::count(status.begin(), status.end(), LOLAN_RETVAL_YES) != (long) frames) {
+    printf("lolan_parsePackets failed\n");
+    exit(1);
+  }
+}
+
+static void benchInform(size_t count, size_t updated, size_t iterations)
+{
+  bclock::time_point start;
+  lolan_Packet pak;
+  uint8_t payload[LOLAN_PACKET_MAX_PAYLOAD_SIZE];
+  char name[64];
+
+  resetCtx();
+  lolan_regVarBatch(&lctx, defs.data(), count, NULL);
+  for (size_t i = 0; i < count; i++)
+    lolan_setFlag(&lctx, defs[i].data, LOLAN_REGMAP_INFORM_REQUEST_BIT);
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    for (size_t j = 0; j < updated; j++)
+      lolan_setFlag(&lctx, defs[(i + j * 7) % count].data, LOLAN_REGMAP_LOCAL_UPDATE_BIT);
+    do {
+      lolan_resetPacket(&pak);
+      pak.payload = payload;
+    } while (lolan_createInform(&lctx, &pak, true) == LOLAN_RETVAL_YES);
+  }
+  snprintf(name, sizeof(name), "lolan_createInform (%zu updated)", updated);
+  report(name, elapsedUs(start), iterations);
+
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++)
+    lolan_processUpdated(&lctx, true, NULL);
+  report("lolan_processUpdated (none updated)", elapsedUs(start), iterations);
+}
+
+#ifdef LOLAN_PREPARED_INFORM_SIZE
+// INFORM of the same n variables in every cycle: lolan_createInform() vs. prepared INFORM
+static void benchPreparedInform(size_t count, size_t n, size_t iterations)
+{
+  bclock::time_point start;
+  static lolan_PreparedInform pi;
+  std::vector<const void*> sel;
+  lolan_Packet pak;
+  uint8_t payload[LOLAN_PACKET_MAX_PAYLOAD_SIZE];
+  char name[64];
+
+  n = std::min(std::min(n, count), (size_t) LOLAN_PREPARED_INFORM_SIZE);
+  resetCtx();
+  lolan_regVarBatch(&lctx, defs.data(), count, NULL);
+  for (size_t j = 0; j < n; j++) {
+    sel.push_back(defs[j].data);
+    lolan_setFlag(&lctx, defs[j].data, LOLAN_REGMAP_INFORM_REQUEST_BIT);
+  }
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    for (size_t j = 0; j < n; j++) {
+      (*(uint32_t*) defs[j].data)++;
+      lolan_setFlag(&lctx, defs[j].data, LOLAN_REGMAP_LOCAL_UPDATE_BIT);
+    }
+    do {
+      lolan_resetPacket(&pak);
+      pak.payload = payload;
+    } while (lolan_createInform(&lctx, &pak, true) == LOLAN_RETVAL_YES);
+  }
+  snprintf(name, sizeof(name), "lolan_createInform (%zu fixed)", n);
+  report(name, elapsedUs(start), iterations);
+
+  if (lolan_prepareInform(&lctx, &pi, sel.data(), n) != LOLAN_RETVAL_YES) {
+    printf("lolan_prepareInform failed\n");
+    exit(1);
+  }
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    for (size_t j = 0; j < n; j++)
+      (*(uint32_t*) defs[j].data)++;
+    pak.payload = payload;
+    lolan_createPreparedInform(&lctx, &pi, &pak, false);
+  }
+  snprintf(name, sizeof(name), "lolan_createPreparedInform (%zu fixed)", n);
+  report(name, elapsedUs(start), iterations);
+}
+#endif
+
+// New Style SET payload for the first n variables (sorted by path)
+static size_t createSetPayload(uint8_t *buf, size_t size, size_t n)
+{
+  std::vector<const lolan_VarDef*> sorted;
+  CborEncoder enc, map[LOLAN_REGMAP_DEPTH];
+  const uint8_t *prev = NULL;
+  int open = 0, l;
+
+  for (size_t i = 0; i < n; i++)
+    sorted.push_back(&defs[i]);
+  std::sort(sorted.begin(), sorted.end(), [](const lolan_VarDef *a, const lolan_VarDef *b) {
+    return memcmp(a->p, b->p, LOLAN_REGMAP_DEPTH) < 0; });
+  cbor_encoder_init(&enc, buf, size, 0);
+  cbor_encoder_create_map(&enc, &map[0], CborIndefiniteLength);
+  cbor_encode_uint(&map[0], 0);
+  cbor_encode_uint(&map[0], 1);   // New Style SET
+  for (size_t i = 0; i < n; i++) {   // (full depth paths)
+    const uint8_t *p = sorted[i]->p;
+    for (l = 0; (l < open) && (p[l] == prev[l]); l++)
+      ;
+    for ( ; open > l; open--)
+      cbor_encoder_close_container(&map[open - 1], &map[open]);
+    for ( ; open < LOLAN_REGMAP_DEPTH - 1; open++) {
+      cbor_encode_uint(&map[open], p[open]);
+      cbor_encoder_create_map(&map[open], &map[open + 1], CborIndefiniteLength);
+    }
+    cbor_encode_uint(&map[open], p[LOLAN_REGMAP_DEPTH - 1]);
+    cbor_encode_uint(&map[open], 1000 + i);
+    prev = p;
+  }
+  for ( ; open > 0; open--)
+    cbor_encoder_close_container(&map[open - 1], &map[open]);
+  cbor_encoder_close_container(&enc, &map[0]);
+  if (cbor_encoder_get_extra_bytes_needed(&enc) != 0) {
+    printf("SET payload too long\n");
+    exit(1);
+  }
+  return cbor_encoder_get_buffer_size(&enc, buf);
+}
+
+static void benchSet(size_t count, size_t n, size_t iterations)
+{
+  bclock::time_point start;
+  lolan_Packet req, reply;
+  uint8_t reqPayload[LOLAN_PACKET_MAX_PAYLOAD_SIZE], replyPayload[LOLAN_PACKET_MAX_PAYLOAD_SIZE];
+  char name[64];
+
+  n = std::min(n, count);
+  resetCtx();
+  lolan_regVarBatch(&lctx, defs.data(), count, NULL);
+  lolan_resetPacket(&req);
+  req.packetType = LOLAN_PAK_SET;
+  req.toId = 1;
+  req.payload = reqPayload;
+  req.payloadSize = createSetPayload(reqPayload, sizeof(reqPayload), n);
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    req.packetCounter = i;   // (not a retransmission)
+    lolan_resetPacket(&reply);
+    reply.payload = replyPayload;
+    if (lolan_processSet(&lctx, &req, &reply) != LOLAN_RETVAL_YES) {
+      printf("lolan_processSet failed\n");
+      exit(1);
+    }
+  }
+  snprintf(name, sizeof(name), "lolan_processSet (new style, %zu vars)", n);
+  report(name, elapsedUs(start), iterations);
+}
+
+// SET of 8 variables of the same type and size (paths: (240 + kind, 1..8)), for all integer and float widths (fewer
+// variables with a small register map)
+static void benchSetWidths(size_t iterations)
+{
+  static const struct {
+    lolan_VarType type;
+    LV_SIZE_T size;
+    const char *name;
+  } kinds[] = {
+    { LOLAN_INT, 1, "int8" }, { LOLAN_INT, 2, "int16" }, { LOLAN_INT, 4, "int32" }, { LOLAN_INT, 8, "int64" },
+    { LOLAN_UINT, 1, "uint8" }, { LOLAN_UINT, 2, "uint16" }, { LOLAN_UINT, 4, "uint32" }, { LOLAN_UINT, 8, "uint64" },
+    { LOLAN_FLOAT, 4, "float" }, { LOLAN_FLOAT, 8, "double" }
+  };
+  static uint64_t data[10][8];
+  bclock::time_point start;
+  lolan_Packet req, reply;
+  uint8_t reqPayload[LOLAN_PACKET_MAX_PAYLOAD_SIZE], replyPayload[LOLAN_PACKET_MAX_PAYLOAD_SIZE];
+  CborEncoder enc, map, array;
+  size_t n = std::min((size_t) 8, (size_t) LOLAN_REGMAP_SIZE / 10);   // (variables per kind)
+  char name[64];
+
+  if (n == 0) {
+    printf("lolan_processSet (widths): skipped, register map too small\n");
+    return;
+  }
+  resetCtx();
+  for (size_t k = 0; k < 10; k++) {
+    for (size_t j = 0; j < n; j++) {
+      uint8_t path[LOLAN_REGMAP_DEPTH] = { 0 };
+      path[0] = 240 + k;
+      path[1] = 1 + j;
+      if (lolan_regVar(&lctx, path, kinds[k].type, &data[k][j], kinds[k].size, false) != LOLAN_RETVAL_YES) {
+        printf("lolan_regVar (%s) failed at %zu\n", kinds[k].name, j + 1);
+        exit(1);
+      }
+    }
+  }
+  for (size_t k = 0; k < 10; k++) {
+    cbor_encoder_init(&enc, reqPayload, sizeof(reqPayload), 0);   // Old Style SET: base path (240 + k)
+    cbor_encoder_create_map(&enc, &map, 1 + n);
+    cbor_encode_uint(&map, 0);
+    cbor_encoder_create_array(&map, &array, 1);
+    cbor_encode_uint(&array, 240 + k);
+    cbor_encoder_close_container(&map, &array);
+    for (size_t j = 0; j < n; j++) {
+      cbor_encode_uint(&map, 1 + j);
+      if (kinds[k].type == LOLAN_FLOAT) {
+        if (kinds[k].size == 4)
+          cbor_encode_float(&map, 0.5f + j);
+        else
+          cbor_encode_double(&map, 0.25 + j);
+      } else {
+        int64_t v = (int64_t) 1 << (8 * kinds[k].size - 2 - (j % 4) * kinds[k].size);   // different CBOR widths
+        if ((kinds[k].type == LOLAN_INT) && (j % 2))
+          cbor_encode_int(&map, -v);
+        else
+          cbor_encode_uint(&map, v);
+      }
+    }
+    cbor_encoder_close_container(&enc, &map);
+    lolan_resetPacket(&req);
+    req.packetType = LOLAN_PAK_SET;
+    req.toId = 1;
+    req.payload = reqPayload;
+    req.payloadSize = cbor_encoder_get_buffer_size(&enc, reqPayload);
+    start = bclock::now();
+    for (size_t i = 0; i < iterations; i++) {
+      req.packetCounter = i;   // (not a retransmission)
+      lolan_resetPacket(&reply);
+      reply.payload = replyPayload;
+      if (lolan_processSet(&lctx, &req, &reply) != LOLAN_RETVAL_YES) {
+        printf("lolan_processSet (%s) failed\n", kinds[k].name);
+        exit(1);
+      }
+    }
+    for (size_t j = 0; j < n; j++) {
+      if (!(lolan_getFlag(&lctx, &data[k][j]) & LOLAN_REGMAP_REMOTE_UPDATE_BIT)) {
+        printf("lolan_processSet (%s): variable %zu not updated\n", kinds[k].name, j + 1);
+        exit(1);
+      }
+    }
+    snprintf(name, sizeof(name), "lolan_processSet (%zu x %s)", n, kinds[k].name);
+    report(name, elapsedUs(start), iterations);
+  }
+}
+
+// SET of one variable behind data of unknown paths (skipped without decoding), processing of the INFORM of n variables
+// and extracting its last variable
+static size_t informEntries;
+static uint8_t *informLast;   // (path of the last entry is copied here, if not NULL)
+static void informCallback(uint8_t *path, uint8_t *data, LV_SIZE_T dataLen, lolan_VarType dataType)
+{
+  (void) data;
+  (void) dataLen;
+  (void) dataType;
+  informEntries++;
+  if (informLast != NULL)
+    memcpy(informLast, path, LOLAN_REGMAP_DEPTH);
+}
+
+static void benchReceive(size_t count, size_t n, size_t iterations)
+{
+  static uint8_t blob[200];
+  bclock::time_point start;
+  lolan_Packet req, reply;
+  uint8_t reqPayload[LOLAN_PACKET_MAX_PAYLOAD_SIZE], replyPayload[LOLAN_PACKET_MAX_PAYLOAD_SIZE];
+  uint8_t data[64], last[LOLAN_REGMAP_DEPTH];
+  CborEncoder enc, map[LOLAN_REGMAP_DEPTH + 1];
+  size_t blobSize, entries;
+  char name[64];
+
+  n = std::min(n, count);
+  resetCtx();
+  lolan_regVarBatch(&lctx, defs.data(), count, NULL);
+  blobSize = std::min(sizeof(blob), (size_t) LOLAN_PACKET_MAX_PAYLOAD_SIZE / 4 - 16);
+  cbor_encoder_init(&enc, reqPayload, sizeof(reqPayload), 0);
+  cbor_encoder_create_map(&enc, &map[0], CborIndefiniteLength);
+  cbor_encode_uint(&map[0], 0);
+  cbor_encode_uint(&map[0], 1);   // New Style SET
+  for (size_t k = 0; k < 3; k++) {   // (no variables at 251..253)
+    cbor_encode_uint(&map[0], 251 + k);
+    cbor_encoder_create_map(&map[0], &map[1], 2);
+    cbor_encode_uint(&map[1], 1);
+    cbor_encode_byte_string(&map[1], blob, blobSize);
+    cbor_encode_uint(&map[1], 2);
+    cbor_encoder_create_map(&map[1], &map[2], 1);
+    cbor_encode_uint(&map[2], 1);
+    cbor_encode_byte_string(&map[2], blob, blobSize / 2);
+    cbor_encoder_close_container(&map[1], &map[2]);
+    cbor_encoder_close_container(&map[0], &map[1]);
+  }
+  for (int l = 0; l < LOLAN_REGMAP_DEPTH - 1; l++) {
+    cbor_encode_uint(&map[l], defs[0].p[l]);
+    cbor_encoder_create_map(&map[l], &map[l + 1], 1);
+  }
+  cbor_encode_uint(&map[LOLAN_REGMAP_DEPTH - 1], defs[0].p[LOLAN_REGMAP_DEPTH - 1]);
+  cbor_encode_uint(&map[LOLAN_REGMAP_DEPTH - 1], 1000);
+  for (int l = LOLAN_REGMAP_DEPTH - 1; l > 0; l--)
+    cbor_encoder_close_container(&map[l - 1], &map[l]);
+  cbor_encoder_close_container(&enc, &map[0]);
+  if (cbor_encoder_get_extra_bytes_needed(&enc) != 0) {
+    printf("SET payload too long\n");
+    exit(1);
+  }
+  lolan_resetPacket(&req);
+  req.packetType = LOLAN_PAK_SET;
+  req.toId = 1;
+  req.payload = reqPayload;
+  req.payloadSize = cbor_encoder_get_buffer_size(&enc, reqPayload);
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    req.packetCounter = i;   // (not a retransmission)
+    lolan_resetPacket(&reply);
+    reply.payload = replyPayload;
+    if (lolan_processSet(&lctx, &req, &reply) != LOLAN_RETVAL_YES) {
+      printf("lolan_processSet failed\n");
+      exit(1);
+    }
+  }
+  snprintf(name, sizeof(name), "lolan_processSet (skipped data, %zu bytes)", (size_t) req.payloadSize);
+  report(name, elapsedUs(start), iterations);
+
+  for (size_t j = 0; j < n; j++)
+    lolan_setFlag(&lctx, defs[j].data, LOLAN_REGMAP_INFORM_REQUEST_BIT | LOLAN_REGMAP_LOCAL_UPDATE_BIT);
+  lolan_resetPacket(&req);
+  req.payload = reqPayload;
+  if (lolan_createInform(&lctx, &req, true) != LOLAN_RETVAL_YES) {
+    printf("lolan_createInform failed\n");
+    exit(1);
+  }
+  informEntries = 0;
+  informLast = last;   // (the variable at the end of the INFORM, not all n may fit in it)
+  lolan_simpleProcessInform(&req, data, sizeof(data), informCallback);
+  informLast = NULL;
+  entries = informEntries;
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    informEntries = 0;
+    if ((lolan_simpleProcessInform(&req, data, sizeof(data), informCallback) != LOLAN_RETVAL_YES) ||
+        (informEntries != entries)) {
+      printf("lolan_simpleProcessInform failed\n");
+      exit(1);
+    }
+  }
+  snprintf(name, sizeof(name), "lolan_simpleProcessInform (%zu vars)", entries);
+  report(name, elapsedUs(start), iterations);
+
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    LV_SIZE_T len;
+    uint8_t type;
+    if (lolan_simpleExtractFromInform(&req, last, data, sizeof(data), &len, &type) != LOLAN_RETVAL_YES) {
+      printf("lolan_simpleExtractFromInform failed\n");
+      exit(1);
+    }
+  }
+  snprintf(name, sizeof(name), "lolan_simpleExtractFromInform (last of %zu)", entries);
+  report(name, elapsedUs(start), iterations);
+}
+
+// conversion of an INFORM (mixed variable types) to JSON: tinycbor into a FILE* vs. lolan_cborToJson() into a growable
+// buffer
+static bool jsonGrow(void *arg, lolan_JsonBuffer *jb, size_t size)
+{
+  size_t newSize = std::max(size, 2 * jb->size);
+  char *buf = (char *) realloc(jb->buf, newSize);
+
+  (void) arg;
+  if (buf == NULL)
+    return false;
+  jb->buf = buf;
+  jb->size = newSize;
+  return true;
+}
+
+static void benchJson(size_t iterations)
+{
+  static int32_t ints[8];
+  static uint32_t uints[8];
+  static float floats[8];
+  static double doubles[8];
+  static char strs[8][16];
+  static char fileBuf[4096];
+  bclock::time_point start;
+  lolan_Packet pak;
+  uint8_t payload[LOLAN_PACKET_MAX_PAYLOAD_SIZE];
+  lolan_JsonBuffer jb;
+  CborParser parser;
+  CborValue it;
+  FILE *f;
+  double us;
+  char name[64];
+
+  resetCtx();
+  for (size_t j = 0; j < 8; j++) {
+    uint8_t path[LOLAN_REGMAP_DEPTH] = { 0 };
+    path[1] = 1 + j;
+    ints[j] = -1000 * (int32_t) j - 7;
+    uints[j] = 100000 * j + 3;
+    floats[j] = 20.5f + 0.1f * j;
+    doubles[j] = 47.49 + 0.001 * j;
+    snprintf(strs[j], sizeof(strs[j]), "sensor-%zu", j);
+    path[0] = 220;
+    lolan_regVar(&lctx, path, LOLAN_INT, &ints[j], sizeof(ints[j]), false);
+    path[0] = 221;
+    lolan_regVar(&lctx, path, LOLAN_UINT, &uints[j], sizeof(uints[j]), false);
+    path[0] = 222;
+    lolan_regVar(&lctx, path, LOLAN_FLOAT, &floats[j], sizeof(floats[j]), false);
+    path[0] = 223;
+    lolan_regVar(&lctx, path, LOLAN_FLOAT, &doubles[j], sizeof(doubles[j]), false);
+    path[0] = 224;
+    lolan_regVar(&lctx, path, LOLAN_STR, strs[j], sizeof(strs[j]), false);
+  }
+  for (size_t j = 0; j < lctx.regMapCount; j++)
+    lolan_setFlag(&lctx, LRM_DATA(&lctx, j), LOLAN_REGMAP_INFORM_REQUEST_BIT | LOLAN_REGMAP_LOCAL_UPDATE_BIT);
+  lolan_resetPacket(&pak);
+  pak.payload = payload;
+  if (lolan_createInform(&lctx, &pak, true) != LOLAN_RETVAL_YES) {
+    printf("lolan_createInform failed\n");
+    exit(1);
+  }
+
+  f = fmemopen(fileBuf, sizeof(fileBuf), "w");
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    rewind(f);
+    if ((cbor_parser_init(pak.payload, pak.payloadSize, 0, &parser, &it) != CborNoError) ||
+        (cbor_value_to_json_advance(f, &it, CborConvertStringifyMapKeys) != CborNoError) || (fflush(f) != 0)) {
+      printf("cbor_value_to_json_advance failed\n");
+      exit(1);
+    }
+  }
+  us = elapsedUs(start);
+  snprintf(name, sizeof(name), "cbor_value_to_json_advance (%zu bytes)", (size_t) pak.payloadSize);
+  report(name, us, iterations);
+  printf("%-40s %12.1f MB/s\n", "", iterations * pak.payloadSize / us);
+  fclose(f);
+
+  lolan_jsonBufferInit(&jb, NULL, 0, jsonGrow, NULL);
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    jb.len = 0;
+    if (lolan_cborToJson(pak.payload, pak.payloadSize, &jb, 0) != LOLAN_RETVAL_YES) {
+      printf("lolan_cborToJson failed\n");
+      exit(1);
+    }
+  }
+  us = elapsedUs(start);
+  snprintf(name, sizeof(name), "lolan_cborToJson (%zu bytes)", (size_t) pak.payloadSize);
+  report(name, us, iterations);
+  printf("%-40s %12.1f MB/s\n", "", iterations * pak.payloadSize / us);
+
+  pak.packetType = LOLAN_PAK_INFORM;
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    jb.len = 0;
+    if (lolan_packetToJson(&pak, &jb, 0) != LOLAN_RETVAL_YES) {
+      printf("lolan_packetToJson failed\n");
+      exit(1);
+    }
+  }
+  us = elapsedUs(start);
+  snprintf(name, sizeof(name), "lolan_packetToJson (%zu bytes)", (size_t) pak.payloadSize);
+  report(name, us, iterations);
+  printf("%-40s %12.1f MB/s\n", "", iterations * pak.payloadSize / us);
+  free(jb.buf);
+}
+
+static void benchCRC(size_t bytes)
+{
+  static const size_t sizes[] = { 9, 16, 32, 64, 128, 256 };
+  std::vector<uint8_t> data(256);
+  std::mt19937 rng(13579);
+  bclock::time_point start;
+  volatile uint16_t sink = 0;
+  char name[64];
+  double us;
+
+  for (size_t i = 0; i < data.size(); i++)
+    data[i] = rng();
+  for (size_t size : sizes) {
+    size_t iterations = bytes / size;
+    start = bclock::now();
+    for (size_t i = 0; i < iterations; i++)
+      sink += lolan_CRC_calc(data.data(), size);
+    us = elapsedUs(start);
+    snprintf(name, sizeof(name), "lolan_CRC_calc (%zu bytes, tables: %d)", size, LOLAN_CRC_TABLES);
+    report(name, us, iterations);
+    printf("%-40s %12.1f MB/s\n", "", iterations * size / us);
+  }
+}
+
+#ifdef LOLAN_REGMAP_CONST
+// read-only register map of 256 variables built at compile time
+#define CONST_VAR_COUNT  256
+static uint32_t constVars[CONST_VAR_COUNT];
+
+struct ConstDefs {
+  lolan_VarDef d[CONST_VAR_COUNT];
+};
+
+static constexpr ConstDefs createConstDefs()
+{
+  ConstDefs r{};
+  for (size_t i = 0; i < CONST_VAR_COUNT; i++) {
+    size_t k = (i * 97) % CONST_VAR_COUNT;   // (not in path order)
+    r.d[i].p[0] = 1 + k / 16;
+    r.d[i].p[1] = 1 + k % 16;
+    r.d[i].vType = LOLAN_UINT;
+    r.d[i].data = &constVars[i];
+    r.d[i].size = sizeof(uint32_t);
+    r.d[i].readOnly = false;
+  }
+  return r;
+}
+
+static constexpr ConstDefs constDefs = createConstDefs();
+static constexpr auto constTable = lolan::makeConstRegMap(constDefs.d);
+static constexpr lolan_ConstRegMap constRegMap = constTable.regMap();
+
+static void benchConst(size_t iterations)
+{
+  bclock::time_point start;
+  std::vector<size_t> order(iterations);
+  std::mt19937 rng(54321);
+  volatile LR_SIZE_T sink = 0;
+  const size_t inits = 10000;
+
+  for (size_t i = 0; i < iterations; i++)
+    order[i] = rng() % CONST_VAR_COUNT;
+
+  start = bclock::now();
+  for (size_t i = 0; i < inits; i++) {
+    resetCtx();
+    lolan_regVarBatch(&lctx, constDefs.d, CONST_VAR_COUNT, NULL);
+  }
+  report("lolan_init + regVarBatch (256 vars)", elapsedUs(start), inits);
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++)
+    sink += lolan_getIndex(&lctx, true, constDefs.d[order[i]].p, NULL);
+  report("lolan_getIndex (by path, 256 vars)", elapsedUs(start), iterations);
+
+  start = bclock::now();
+  for (size_t i = 0; i < inits; i++) {
+    lolan_free(&lctx);
+    lolan_initConst(&lctx, 1, &constRegMap, NULL);
+  }
+  report("lolan_initConst (256 vars)", elapsedUs(start), inits);
+  if (lolan_checkRegMap(&lctx) != CONST_VAR_COUNT) {
+    printf("lolan_checkRegMap failed\n");
+    exit(1);
+  }
+  start = bclock::now();
+  for (size_t i = 0; i < iterations; i++)
+    sink += lolan_getIndex(&lctx, true, constDefs.d[order[i]].p, NULL);
+  report("lolan_getIndex (by path, const, 256 vars)", elapsedUs(start), iterations);
+  lolan_free(&lctx);
+}
+#endif
+
+// encode a branch GET reply and the INFORM packets of the updated variables
+static void encodeReplies(lolan_ctx *ctx, const lolan_Packet *req, size_t updated, size_t round,
+                          std::vector<uint8_t> &out)
+{
+  lolan_Packet pak;
+  uint8_t payload[LOLAN_PACKET_MAX_PAYLOAD_SIZE];
+
+  out.clear();
+  lolan_resetPacket(&pak);
+  pak.payload = payload;
+  if (lolan_processGet(ctx, req, &pak) == LOLAN_RETVAL_YES)
+    out.insert(out.end(), payload, payload + pak.payloadSize);
+  for (size_t j = 0; j < updated; j++)
+    lolan_setFlag(ctx, defs[(round + j * 7) % defs.size()].data, LOLAN_REGMAP_LOCAL_UPDATE_BIT);
+  for (;;) {
+    lolan_resetPacket(&pak);
+    pak.payload = payload;
+    if (lolan_createInform(ctx, &pak, true) != LOLAN_RETVAL_YES)
+      break;
+    out.insert(out.end(), payload, payload + pak.payloadSize);
+  }
+}
+
+// contexts encoding in parallel threads (the output is compared to a single thread by lolan-test)
+static void benchThreads(size_t count, const uint8_t *path, size_t threads, size_t iterations)
+{
+  bclock::time_point start;
+  std::vector<lolan_ctx> ctxs(threads);
+  std::vector<std::thread> workers;
+  lolan_Packet req;
+  uint8_t reqPayload[LOLAN_PACKET_MAX_PAYLOAD_SIZE];
+  size_t updated = std::min(count, (size_t) 8);
+  char name[64];
+
+  for (size_t t = 0; t < threads; t++) {
+    lolan_init(&ctxs[t], 1);
+    lolan_regVarBatch(&ctxs[t], defs.data(), count, NULL);
+    for (size_t i = 0; i < count; i++)
+      lolan_setFlag(&ctxs[t], defs[i].data, LOLAN_REGMAP_INFORM_REQUEST_BIT);
+  }
+  lolan_resetPacket(&req);
+  req.payload = reqPayload;
+  if (lolan_createGet(&ctxs[0], &req, (uint8_t*) path) != LOLAN_RETVAL_YES) {
+    printf("lolan_createGet failed\n");
+    exit(1);
+  }
+  req.toId = 1;
+
+  start = bclock::now();
+  for (size_t t = 0; t < threads; t++) {
+    workers.push_back(std::thread([&, t] {
+      std::vector<uint8_t> out;
+      for (size_t i = 0; i < iterations; i++)
+        encodeReplies(&ctxs[t], &req, updated, i, out);
+    }));
+  }
+  for (size_t t = 0; t < threads; t++)
+    workers[t].join();
+  snprintf(name, sizeof(name), "GET + INFORM (%zu threads)", threads);
+  report(name, elapsedUs(start), threads * iterations);
+
+  for (size_t t = 0; t < threads; t++) {
+#ifdef LOLAN_REGMAP_DYNAMIC
+    lolan_free(&ctxs[t]);
+#endif
+  }
+}
+
+#ifdef LOLAN_REGMAP_DYNAMIC
+// many small contexts with their register maps in one memory block
+static void benchContexts(size_t contexts, size_t perContext)
+{
+  bclock::time_point start;
+  std::vector<lolan_ctx> ctxs(contexts);
+  size_t memSize = lolan_regMapMemSize(perContext);   // (multiple of 8)
+  std::vector<uint64_t> arena(contexts * memSize / sizeof(uint64_t));
+  char name[64];
+
+  start = bclock::now();
+  for (size_t c = 0; c < contexts; c++) {
+    lolan_initEx(&ctxs[c], c + 1, perContext, (uint8_t*) arena.data() + c * memSize);
+    if (lolan_regVarBatch(&ctxs[c], defs.data(), perContext, NULL) != LOLAN_RETVAL_YES) {
+      printf("lolan_regVarBatch failed\n");
+      exit(1);
+    }
+  }
+  snprintf(name, sizeof(name), "lolan_initEx (%zu contexts, %zu vars)", contexts, perContext);
+  report(name, elapsedUs(start), contexts);
+  printf("memory per context: %zu bytes (context: %zu, register map: %zu)\n",
+         sizeof(lolan_ctx) + memSize, sizeof(lolan_ctx), memSize);
+}
+#endif
+
+int main(int argc, char** argv)
+{
+  size_t count = LOLAN_REGMAP_SIZE;
+
+  if (argc > 1)
+    count = std::min((size_t) atoi(argv[1]), (size_t) LOLAN_REGMAP_SIZE);
+  printf("LoLaN benchmark (version: %d, variables: %zu, register map size: %d)\n",
+         LOLAN_VERSION, count, LOLAN_REGMAP_SIZE);
+
+  createDefs(count);
+  benchRegister(count);
+
+  benchLookup(count, 1000000);
+
+  uint8_t path[LOLAN_REGMAP_DEPTH] = { 0 };
+  memcpy(path, defs[0].p, LOLAN_REGMAP_DEPTH);
+  benchGet(count, "lolan_processGet (single variable)", path, 10000);
+  path[LOLAN_REGMAP_DEPTH - 1] = 0;
+  benchGet(count, "lolan_processGet (branch)", path, 10000);
+  memcpy(path, defs[0].p, LOLAN_REGMAP_DEPTH);
+  benchParse(count, path, 10000);
+  benchParseBurst(64, 10000);
+  path[LOLAN_REGMAP_DEPTH - 1] = 0;
+  benchCreate(count, path, 1000000);
+
+  benchInform(count, 1, 10000);
+  benchInform(count, 8, 10000);
+#ifdef LOLAN_PREPARED_INFORM_SIZE
+  benchPreparedInform(count, 8, 100000);
+#endif
+
+  benchSet(count, 1, 100000);
+  benchSet(count, 8, 100000);
+  benchSetWidths(100000);
+  benchReceive(count, 32, 100000);
+  benchJson(100000);
+
+  benchCRC(10000000);
+
+  path[LOLAN_REGMAP_DEPTH - 1] = 0;
+  benchThreads(count, path, 4, 10000);
+
+#ifdef LOLAN_REGMAP_DYNAMIC
+  benchContexts(1000, std::min(count, (size_t) 16));
+#endif
+#ifdef LOLAN_REGMAP_CONST
+  benchConst(1000000);
+#endif
+
+  return 0;
+}
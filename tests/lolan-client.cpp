@@ -32,16 +32,22 @@
 
 #include "json.hpp"
 #include "Slip.hpp"
+extern "C" {
 #include <lolan_config.h>
 #include <lolan.h>
+}
 
 #define BAUDRATE B115200
 
+#ifdef LOLAN_TX_SLOTS	// requests are retransmitted by the ACK/retransmit engine
+#define TX_TIMEOUT_MS	200	// initial retransmission timeout
+#define TX_MAX_TRIES	5
+#define TX_WINDOW	4	// requests in flight per node
+#endif
+
 bool quit=false;
 
 void sendToTTyBin(int fd,uint8_t *bp, int s) {
-    int w;
-
 /*    while (s>0) {
 	w = write(fd,bp,s);
 	tcflush(fd, TCIOFLUSH);
@@ -55,84 +61,89 @@ void sendToTTyBin(int fd,uint8_t *bp, int s) {
 //    tcflush(fd, TCIOFLUSH);
 }
 
-uint16_t CRC_calc(uint8_t *val, uint8_t size)
-{
-    uint16_t crc;
-    uint16_t q;
-    uint8_t c;
-    crc = 0;
-    for (int i = 0; i < size; i++)
-    {
-        c = val[i];
-        q = (crc ^ c) & 0x0f;
-        crc = (crc >> 4) ^ (q * 0x1081);
-        q = (crc ^ (c >> 4)) & 0xf;
-        crc = (crc >> 4) ^ (q * 0x1081);
-    }
-    return (uint8_t) crc << 8 | (uint8_t) (crc >> 8);
-}
-
-void llSendPacket(int fd,lolan_Packet *lp)
+void llSendPacket(int fd,const lolan_Packet *lp)
 {
-    uint8_t txp[LOLAN_MAX_PACKET_SIZE];
-    memset(txp,0,LOLAN_MAX_PACKET_SIZE);
-
-    txp[0] = lp->packetType;
-    if (lp->securityEnabled) { txp[0]|=0x08; }
-    if (lp->framePending) { txp[0]|=0x10; }
-    if (lp->ackRequired) { txp[0]|=0x20;}
-    txp[1]=0x74; // 802.15.4 protocol version=3
-    txp[2] = lp->packetCounter;
-    uint16_t *fromId = ((uint16_t *) &txp[3]);
-    uint16_t *toId = ((uint16_t *) &txp[5]);
-    *fromId = lp->fromId;
-    *toId =  lp->toId;
-    memcpy(&(txp[7]),lp->payload,lp->payloadSize);
-    uint16_t crc16 = CRC_calc(txp,7+lp->payloadSize);
-
-    txp[7+lp->payloadSize] = (crc16>>8)&0xFF;
-    txp[7+lp->payloadSize+1] = crc16&0xFF;
-
+    uint8_t header[LOLAN_PACKET_HEADER_SIZE];
+    uint8_t crc[LOLAN_PACKET_CRC_SIZE];
+    lolan_Segment seg[3];
     SlipPacketizer slp;
-    slp.encode(txp,7+lp->payloadSize+2);
+
+    if (lolan_createPacketSegments(lp,header,crc,seg,true) != LOLAN_RETVAL_YES) {
+	return;
+    }
 
     std::cout << "\n<=[ ";
-    for (int i=0;i<7+lp->payloadSize+2;i++) {
-	printf("%02X ",txp[i]);
+    for (auto& it : seg) {	// (SLIP encoded directly from the segments)
+	for (size_t i=0;i<it.size;i++) {
+	    slp.feedEncode(it.data[i]);
+	    printf("%02X ",it.data[i]);
+	}
     }
+    slp.finishEncode();
     std::cout << "]";
 
     sendToTTyBin(fd,(uint8_t *) &(slp.encodeBuffer[0]),slp.encodeBuffer.size());
 }
 
 lolan_ctx lctx;
+
+#ifdef LOLAN_TX_SLOTS
+lolan_TxEngine txe;	// (used by the main thread only)
+
+uint32_t nowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void txSend(void *arg,const lolan_Packet *lp)
+{
+    llSendPacket(*(int *) arg,lp);
+}
+
+void txDone(void *arg,const lolan_Packet *request,const lolan_Packet *ack,int8_t status)
+{
+    (void) arg;
+    if (status != LOLAN_RETVAL_YES) {
+	std::cout << "\n no reply from " << request->toId << std::flush;
+    } else {
+	std::cout << "\n reply caught" << std::flush;
+	std::vector<uint8_t> v_cbor(ack->payload,ack->payload+ack->payloadSize);
+	nlohmann::json j_from_cbor = nlohmann::json::from_cbor(v_cbor);
+	std::cout << " cbor="<<j_from_cbor << std::flush;
+    }
+    quit=true;
+}
+#endif
+
 std::mutex dequeMutex;
 std::mutex lctxMutex;
-std::deque<std::vector<uint8_t>> lpQueue;
+struct RxPacket {	// packet validated by the reader thread
+    lolan_Packet lp;
+    std::vector<uint8_t> payload;
+};
+std::deque<RxPacket> lpQueue;
 
 void readTTy(int fd)
 {
     SlipPacketizer slp;
-    uint8_t byte;
+    lolan_PacketParser pp;
+    RxPacket rx;
+    uint8_t byte, data;
     int bytesRead;
 
+    lolan_packetParserInit(&pp);
     while (quit==false) {
 	bytesRead = read(fd, &byte, 1);
 	if (bytesRead==1) {
-    	    if (slp.feedDecode(byte) == 1) {
-    		if (slp.decodeBuffer.size() > 0) {
-		    if (slp.decodeBuffer.at(0)=='{') { // this is an ASCII packet, now we ignore
-		    } else {
-//			std::cout << "\n=>[ ";
-//			for (int i=0;i<slp.decodeBuffer.size();i++) {
-//	    		    printf("%02X ",(uint8_t) slp.decodeBuffer.at(i));
-//			}
-//			std::cout << "]";
-			std::lock_guard<std::mutex> lock( dequeMutex );
-			lpQueue.push_back(slp.decodeBuffer);
-		    }
+	    int r = slp.decodeByte(byte,&data);
+	    if (r == 0) {
+		lolan_packetParserPush(&pp,&data,1);	// CRC and header are processed as the bytes arrive
+	    } else if (r == 1) {
+		if (lolan_packetParserEnd(&pp,&rx.lp) == LOLAN_RETVAL_YES) { // (ASCII packets are ignored)
+		    rx.payload.assign(rx.lp.payload,rx.lp.payload+rx.lp.payloadSize);
+		    std::lock_guard<std::mutex> lock( dequeMutex );
+		    lpQueue.push_back(rx);
 		}
-		slp.decodeBuffer.clear();
 	    }
 	} else {
 	    usleep(10);
@@ -195,6 +206,9 @@ int main(int argc, char** argv) {
     usleep(10000);
 
     lolan_init(&lctx,11);
+#ifdef LOLAN_TX_SLOTS
+    lolan_txInit(&txe,txSend,&fd,TX_TIMEOUT_MS,TX_MAX_TRIES,TX_WINDOW);
+#endif
 
     std::thread readerThread = std::thread( [&]{ readTTy(fd); } );
 
@@ -205,33 +219,39 @@ int main(int argc, char** argv) {
     lp.toId = toAddress;
     lp.packetCounter=1;
     if (cmd=="GET") {
-	lp.packetType = LOLAN_GET;
+	lp.packetType = LOLAN_PAK_GET;
     } else if (cmd=="SET") {
-	lp.packetType = LOLAN_SET;
+	lp.packetType = LOLAN_PAK_SET;
     } else if (cmd=="INFORM") {
-	lp.packetType = LOLAN_INFORM;
+	lp.packetType = LOLAN_PAK_INFORM;
     }
 
-    if ((lp.packetType == LOLAN_GET)||(lp.packetType == LOLAN_SET)||(lp.packetType == LOLAN_INFORM)) {
+    if ((lp.packetType == LOLAN_PAK_GET)||(lp.packetType == LOLAN_PAK_SET)||(lp.packetType == LOLAN_PAK_INFORM)) {
 	nlohmann::json j = nlohmann::json::parse(cbor);
 	std::vector<std::uint8_t> v_cbor = nlohmann::json::to_cbor(j);
 
 	lp.payload = &(v_cbor[0]);
 	lp.payloadSize = v_cbor.size();
+#ifdef LOLAN_TX_SLOTS
+	if (lp.packetType == LOLAN_PAK_INFORM) {
+	    llSendPacket(fd,&lp);
+	} else if (lolan_txSubmit(&txe,&lp,nowMs(),txDone,NULL) != LOLAN_RETVAL_YES) {	// (retransmitted until the ACK is caught)
+	    std::cerr << "request not sent" << std::endl;
+	    quit=true;
+	}
+#else
 	llSendPacket(fd,&lp);
+#endif
     }
 
-    usleep(100000);
-
-    auto start = std::chrono::steady_clock::now();
     bool sleep=false;
 
     while (quit==false) {
-	std::vector<uint8_t> lpbuff;
+	RxPacket rx;
 	{
     	    std::lock_guard<std::mutex> lock( dequeMutex );
     	    if (lpQueue.size()>0) {
-		lpbuff = lpQueue.front();
+		rx = lpQueue.front();
 		lpQueue.pop_front();
 		sleep = false;
     	    } else {
@@ -240,39 +260,38 @@ int main(int argc, char** argv) {
 	}
  
 	if (sleep) {
+#ifdef LOLAN_TX_SLOTS
+	    lolan_txPoll(&txe,nowMs());
+#endif
     	    usleep(10);
 	} else {
+	    lolan_Packet rlp = rx.lp;	// (validated by the reader thread)
+	    rlp.payload = rx.payload.data();
     	    std::cout << "\n=>[ ";
-    	    uint8_t buff[130];
-    	    uint8_t *b = buff;
-    	    for (auto& it : lpbuff) {
-		*b = it;
-		printf("%02X ",*b);
-		b++;
-    	    }
+	    for (auto& it : rx.payload) {
+		printf("%02X ",it);
+	    }
     	    std::cout << "]";
-	    lolan_Packet rlp;
-	    memset(&rlp,0,sizeof(lolan_Packet));
-	    rlp.payload=(uint8_t *) malloc(LOLAN_MAX_PACKET_SIZE);
-            if (lolan_parsePacket(&lctx,buff,lpbuff.size(),&rlp)==1) {
-		if ((rlp.packetType==ACK_PACKET) && (rlp.fromId == lp.toId) && (rlp.toId == lp.fromId) && (rlp.packetCounter==lp.packetCounter)) {
-		    std::cout << "\n reply caught" << std::flush;
-		    std::vector<uint8_t> v_cbor;
-		    v_cbor.resize(rlp.payloadSize);
-		    v_cbor.assign(rlp.payload,rlp.payload+rlp.payloadSize);
-		    nlohmann::json j_from_cbor = nlohmann::json::from_cbor(v_cbor);
-		    std::cout << " cbor="<<j_from_cbor << std::flush;
-		    quit=true;
-		} else if ((cmd=="INFORM")&&(rlp.packetType == LOLAN_INFORM)) {
-		    std::cout << "\n inform caught from " << rlp.fromId << std::flush;
-		    std::vector<uint8_t> v_cbor;
-		    v_cbor.resize(rlp.payloadSize);
-		    v_cbor.assign(rlp.payload,rlp.payload+rlp.payloadSize);
-		    nlohmann::json j_from_cbor = nlohmann::json::from_cbor(v_cbor);
-		    std::cout << " cbor="<<j_from_cbor << std::flush;
-		}
+#ifdef LOLAN_TX_SLOTS
+	    bool replied = (lolan_txAck(&txe,&rlp,nowMs()) == LOLAN_RETVAL_YES);	// (reply printed by txDone())
+#else
+	    bool replied = (rlp.packetType==LOLAN_PAK_ACK) && (rlp.fromId == lp.toId) && (rlp.toId == lp.fromId) && (rlp.packetCounter==lp.packetCounter);
+	    if (replied) {
+		std::cout << "\n reply caught" << std::flush;
+		std::vector<uint8_t> v_cbor(rlp.payload,rlp.payload+rlp.payloadSize);
+		nlohmann::json j_from_cbor = nlohmann::json::from_cbor(v_cbor);
+		std::cout << " cbor="<<j_from_cbor << std::flush;
+		quit=true;
+	    }
+#endif
+	    if (!replied && (cmd=="INFORM")&&(rlp.packetType == LOLAN_PAK_INFORM)) {
+		std::cout << "\n inform caught from " << rlp.fromId << std::flush;
+		std::vector<uint8_t> v_cbor;
+		v_cbor.resize(rlp.payloadSize);
+		v_cbor.assign(rlp.payload,rlp.payload+rlp.payloadSize);
+		nlohmann::json j_from_cbor = nlohmann::json::from_cbor(v_cbor);
+		std::cout << " cbor="<<j_from_cbor << std::flush;
 	    }
-	    free(rlp.payload);
 	}
     }
 
@@ -32,8 +32,10 @@
 #include <mutex>
 
 #include "Slip.hpp"
+extern "C" {
 #include <lolan_config.h>
 #include <lolan.h>
+}
 
 #define BAUDRATE B115200
 
@@ -43,7 +45,11 @@ lolan_ctx lctx;
 const uint8_t nodeName_path[LOLAN_REGMAP_DEPTH] = {1,1,0};
 const uint8_t testInt_path[LOLAN_REGMAP_DEPTH] = {1,2,0};
 std::mutex dequeMutex;
-std::deque<std::vector<uint8_t>> lpQueue;
+struct RxPacket {	// packet validated by the reader thread
+    lolan_Packet lp;
+    std::vector<uint8_t> payload;
+};
+std::deque<RxPacket> lpQueue;
 
 char nodeName[40] = "LoLaN test node";
 uint16_t testInt = 11;
@@ -63,52 +69,26 @@ void sendToTTyBin(int fd,uint8_t *bp, int s) {
 //    tcflush(fd, TCIOFLUSH);
 }
 
-uint16_t CRC_calc(uint8_t *val, uint8_t size)
-{
-    uint16_t crc;
-    uint16_t q;
-    uint8_t c;
-    crc = 0;
-    for (int i = 0; i < size; i++)
-    {
-        c = val[i];
-        q = (crc ^ c) & 0x0f;
-        crc = (crc >> 4) ^ (q * 0x1081);
-        q = (crc ^ (c >> 4)) & 0xf;
-        crc = (crc >> 4) ^ (q * 0x1081);
-    }
-    return (uint8_t) crc << 8 | (uint8_t) (crc >> 8);
-}
-
 
 void llSendPacket(int fd,lolan_Packet *lp)
 {
-    uint8_t txp[LOLAN_MAX_PACKET_SIZE];
-    memset(txp,0,LOLAN_MAX_PACKET_SIZE);
-
-    txp[0] = lp->packetType;
-    if (lp->securityEnabled) { txp[0]|=0x08; }
-    if (lp->framePending) { txp[0]|=0x10; }
-    if (lp->ackRequired) { txp[0]|=0x20;}
-    txp[1]=0x74; // 802.15.4 protocol version=3
-    txp[2] = lp->packetCounter;
-    uint16_t *fromId = ((uint16_t *) &txp[3]);
-    uint16_t *toId = ((uint16_t *) &txp[5]);
-    *fromId = lp->fromId;
-    *toId =  lp->toId;
-    memcpy(&(txp[7]),lp->payload,lp->payloadSize);
-    uint16_t crc16 = CRC_calc(txp,7+lp->payloadSize);
-
-    txp[7+lp->payloadSize] = (crc16>>8)&0xFF;
-    txp[7+lp->payloadSize+1] = crc16&0xFF;
-
+    uint8_t header[LOLAN_PACKET_HEADER_SIZE];
+    uint8_t crc[LOLAN_PACKET_CRC_SIZE];
+    lolan_Segment seg[3];
     SlipPacketizer slp;
-    slp.encode(txp,7+lp->payloadSize+2);
+
+    if (lolan_createPacketSegments(lp,header,crc,seg,true) != LOLAN_RETVAL_YES) {
+	return;
+    }
 
     std::cout << "\n<=[ ";
-    for (int i=0;i<7+lp->payloadSize+2;i++) {
-	printf("%02X ",txp[i]);
+    for (auto& it : seg) {	// (SLIP encoded directly from the segments)
+	for (size_t i=0;i<it.size;i++) {
+	    slp.feedEncode(it.data[i]);
+	    printf("%02X ",it.data[i]);
+	}
     }
+    slp.finishEncode();
     std::cout << "]\n";
 
     sendToTTyBin(fd,(uint8_t *) &(slp.encodeBuffer[0]),slp.encodeBuffer.size());
@@ -123,27 +103,30 @@ static long get_ms(void) {
 void readTTy(int fd)
 {
     SlipPacketizer slp;
-    char byte;
+    lolan_PacketParser pp;
+    RxPacket rx;
+    uint8_t byte, data;
     int bytesRead;
 
+    lolan_packetParserInit(&pp);
     while (1) {
 	bytesRead = read(fd, &byte, 1);
 	if (bytesRead == 1) {
-	    if (slp.feedDecode(byte) == 1) {
-		if (slp.decodeBuffer.size() > 0) {
-		    if (slp.decodeBuffer.at(0)=='{') { // this is an ASCII packet, now we ignore
-		    } else {
-			std::cout << "=>[ ";
-			for (int i=0;i<slp.decodeBuffer.size();i++) {
-			    printf("%02X ",(uint8_t) slp.decodeBuffer.at(i));
-			}
-			std::cout << "]\n";
-			std::lock_guard<std::mutex> lock( dequeMutex );
-			lpQueue.push_back(slp.decodeBuffer);
+	    int r = slp.decodeByte(byte,&data);
+	    if (r == 0) {
+		lolan_packetParserPush(&pp,&data,1);	// CRC and header are processed as the bytes arrive
+	    } else if (r == 1) {
+		if (lolan_packetParserEnd(&pp,&rx.lp) == LOLAN_RETVAL_YES) { // (ASCII packets are ignored)
+		    rx.payload.assign(rx.lp.payload,rx.lp.payload+rx.lp.payloadSize);
+		    std::cout << "=>[ ";
+		    for (auto& it : rx.payload) {
+			printf("%02X ",it);
 		    }
+		    std::cout << "]\n";
+		    std::lock_guard<std::mutex> lock( dequeMutex );
+		    lpQueue.push_back(rx);
 		}
-    		slp.decodeBuffer.clear();
-    	    }
+	    }
 	} else {
     	    usleep(10);
 	}
@@ -154,7 +137,7 @@ void readTTy(int fd)
     }
 }
 
-int main(int argc, char** argv) {
+int main() {
     int fd=0;
     fd = open("/dev/ptmx", O_RDWR | O_NOCTTY | O_SYNC);
     if (fd == -1) {
@@ -198,8 +181,8 @@ int main(int argc, char** argv) {
     usleep(10000);
 
     lolan_init(&lctx,1);
-    lolan_regVar(&lctx,nodeName_path,LOLAN_STR,nodeName,40);
-    lolan_regVar(&lctx,testInt_path,LOLAN_INT,(int16_t *) &testInt,2);
+    lolan_regVar(&lctx,nodeName_path,LOLAN_STR,nodeName,40,false);
+    lolan_regVar(&lctx,testInt_path,LOLAN_INT,(int16_t *) &testInt,2,false);
     lolan_setFlag(&lctx,&testInt,LOLAN_REGMAP_INFORM_REQUEST_BIT);
 
     std::thread readerThread = std::thread( [&]{ readTTy(fd); } );
@@ -209,11 +192,11 @@ int main(int argc, char** argv) {
     long last_ms = get_ms();
 
     while (quit==false) {
-	std::vector<uint8_t> lpbuff;
+	RxPacket rx;
 	{
 	    std::lock_guard<std::mutex> lock( dequeMutex );
 	    if (lpQueue.size()>0) {
-		lpbuff = lpQueue.front();
+		rx = lpQueue.front();
 		lpQueue.pop_front();
 		sleep = false;
 	    } else {
@@ -229,7 +212,7 @@ int main(int argc, char** argv) {
 	    lolan_Packet informPacket;
 	    memset(&informPacket,0,sizeof(lolan_Packet));
 	    informPacket.payload = (uint8_t *) malloc(LOLAN_MAX_PACKET_SIZE);
-	    if (lolan_processInform(&lctx,&informPacket)) {
+	    while (lolan_createInform(&lctx,&informPacket,false) == LOLAN_RETVAL_YES) {	// (until all variables are reported)
 		llSendPacket(fd,&informPacket);
 	    }
 	    free(informPacket.payload);
@@ -240,41 +223,31 @@ int main(int argc, char** argv) {
 	if (sleep) {
 	    usleep(10);
 	} else {
-	    uint8_t buff[LOLAN_MAX_PACKET_SIZE];
-	    uint8_t *b = buff;
-	    for (auto& it : lpbuff) {
-		*b = it;
-		b++;
-    	    }
-	    lolan_Packet lp;
-	    memset(&lp,0,sizeof(lolan_Packet));
-	    lp.payload = (uint8_t *) malloc(LOLAN_MAX_PACKET_SIZE);
-            if (lolan_parsePacket(&lctx,buff,lpbuff.size(),&lp)==1) {
-		if (lctx.myAddress == lp.toId) {
-		    if (lp.packetType == LOLAN_GET) {
-			lolan_Packet replyPacket;
-			memset(&replyPacket,0,sizeof(lolan_Packet));
-			replyPacket.payload = (uint8_t *) malloc(LOLAN_MAX_PACKET_SIZE);
-			if (lolan_processGet(&lctx,&lp,&replyPacket)) {
-			    llSendPacket(fd,&replyPacket);
-			}
-			free(replyPacket.payload);
-		    } else if (lp.packetType == LOLAN_SET) {
-			lolan_Packet replyPacket;
-			memset(&replyPacket,0,sizeof(lolan_Packet));
-			replyPacket.payload = (uint8_t *) malloc(LOLAN_MAX_PACKET_SIZE);
-			if (lolan_processSet(&lctx,&lp,&replyPacket)) {
-			    llSendPacket(fd,&replyPacket);
-			}
-			free(replyPacket.payload);
-
-			if (lolan_regVarUpdated(&lctx,&testInt,1)) {
-			    std::cout << "testInt updated value=" << testInt << "\n";
-			}
+	    lolan_Packet lp = rx.lp;	// (validated by the reader thread)
+	    lp.payload = rx.payload.data();
+	    if (lctx.myAddress == lp.toId) {
+		if (lp.packetType == LOLAN_PAK_GET) {
+		    lolan_Packet replyPacket;
+		    memset(&replyPacket,0,sizeof(lolan_Packet));
+		    replyPacket.payload = (uint8_t *) malloc(LOLAN_MAX_PACKET_SIZE);
+		    if (lolan_processGet(&lctx,&lp,&replyPacket) == LOLAN_RETVAL_YES) {
+			llSendPacket(fd,&replyPacket);
+		    }
+		    free(replyPacket.payload);
+		} else if (lp.packetType == LOLAN_PAK_SET) {
+		    lolan_Packet replyPacket;
+		    memset(&replyPacket,0,sizeof(lolan_Packet));
+		    replyPacket.payload = (uint8_t *) malloc(LOLAN_MAX_PACKET_SIZE);
+		    if (lolan_processSet(&lctx,&lp,&replyPacket) == LOLAN_RETVAL_YES) {
+			llSendPacket(fd,&replyPacket);
+		    }
+		    free(replyPacket.payload);
+
+		    if (lolan_isVarUpdated(&lctx,&testInt,true) == LOLAN_RETVAL_YES) {
+			std::cout << "testInt updated value=" << testInt << "\n";
 		    }
 		}
 	    }
-	    free(lp.payload);
 	}
     }
 
@@ -0,0 +1,2849 @@
+/**
+ * LoLaN module tests
+ *
+ * Host-side checks of the register map and of the optional LoLaN
+ * modules enabled in lolan_config.h (the disabled modules are skipped).
+ * Build the library with the modules to be tested, e.g. with
+ * LOLAN_MULTIPART_MAX_SIZE defined. The internal functions are declared
+ * in lolan-utils.h, build from the source directory (see Makefile.linux).
+ *
+ * usage: lolan-test
+ **/
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern "C" {
+#include <lolan_config.h>
+#include <lolan.h>
+#include <cbor.h>
+#include "lolan-utils.h"
+}
+
+static unsigned checks, failures;
+
+#define CHECK(cond)  do {                                      \
+    checks++;                                                  \
+    if (!(cond)) {                                             \
+      failures++;                                              \
+      printf("FAILED (line %d): %s\n", __LINE__, #cond);       \
+    }                                                          \
+  } while (0)
+
+/* register map: the results of the lookups are compared with a linear scan of a model */
+#define RM_POOL  ((LOLAN_REGMAP_SIZE < 96) ? LOLAN_REGMAP_SIZE + 8 : 104)   // (more variables than the register map holds)
+#define RM_FLAGS  (LOLAN_REGMAP_USER_MASK | LOLAN_REGMAP_AUX_BIT | LOLAN_REGMAP_REMOTE_READONLY_BIT | LOLAN_REGMAP_TYPE_MASK)
+
+struct RmVar {          // registered variable of the model
+  std::vector<uint8_t> p;
+  uint32_t *data;
+  uint16_t flags;
+};
+
+static lolan_ctx rctx;
+static uint32_t rmPool[RM_POOL];      // variable data
+static std::vector<RmVar> rmModel;    // (sorted by path)
+static size_t rmCapacity;             // register map capacity
+static uint32_t rmRnd = 4321;
+
+static uint32_t rmRandom()
+{
+  rmRnd = rmRnd * 1103515245u + 12345u;
+  return rmRnd >> 8;
+}
+
+static uint8_t rmDefLvl(const uint8_t *p)
+{
+  uint8_t l;
+
+  for (l = 0; (l < LOLAN_REGMAP_DEPTH) && (p[l] != 0); l++)
+    ;
+  return l;
+}
+
+// random path (1..4 at each level, sometimes invalid)
+static std::vector<uint8_t> rmPath()
+{
+  std::vector<uint8_t> p(LOLAN_REGMAP_DEPTH, 0);
+  uint8_t l, dl;
+
+  dl = 1 + rmRandom() % LOLAN_REGMAP_DEPTH;
+  for (l = 0; l < dl; l++)
+    p[l] = 1 + rmRandom() % 4;
+  if (rmRandom() % 32 == 0)
+    p[rmRandom() % LOLAN_REGMAP_DEPTH] = 0;   // (invalid unless it is after the last level)
+  return p;
+}
+
+static bool rmPathValid(const std::vector<uint8_t> &p)
+{
+  return (p[0] != 0) && (std::count(p.begin() + rmDefLvl(p.data()), p.end(), 0) == LOLAN_REGMAP_DEPTH - rmDefLvl(p.data()));
+}
+
+// true if the path is the same as or the base path of an other one (or vice versa)
+static bool rmConflict(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b)
+{
+  return memcmp(a.data(), b.data(), std::min(rmDefLvl(a.data()), rmDefLvl(b.data()))) == 0;
+}
+
+static RmVar *rmFind(const uint32_t *data)
+{
+  for (auto &v : rmModel)
+    if (v.data == data) return &v;
+  return NULL;
+}
+
+static void rmAdd(const std::vector<uint8_t> &p, uint32_t *data, bool readOnly)
+{
+  rmModel.push_back(RmVar{ p, data, (uint16_t) (LOLAN_UINT | (readOnly ? LOLAN_REGMAP_REMOTE_READONLY_BIT : 0)) });
+  std::sort(rmModel.begin(), rmModel.end(), [](const RmVar &a, const RmVar &b) {
+    return memcmp(a.p.data(), b.p.data(), LOLAN_REGMAP_DEPTH) < 0;
+  });
+}
+
+// compare the register map and every lookup with the model
+static void rmCheck()
+{
+  LR_SIZE_T i, k, expected;
+  lolan_SubtreeIterator st;
+  std::vector<LR_SIZE_T> found, scan;
+  uint8_t path[LOLAN_REGMAP_DEPTH], len, l, maxLvl;
+  bool err;
+
+  CHECK(rctx.regMapCount == rmModel.size());
+  if (rctx.regMapCount != rmModel.size()) return;
+  CHECK(lolan_checkRegMap(&rctx) == rctx.regMapCount);
+  for (i = 0; i < rctx.regMapCount; i++) {
+    CHECK(memcmp(LRM_P(&rctx, i), rmModel[i].p.data(), LOLAN_REGMAP_DEPTH) == 0);
+    CHECK(LRM_DATA(&rctx, i) == rmModel[i].data);
+    CHECK((LRM_FLAGS(&rctx, i) & RM_FLAGS) == rmModel[i].flags);
+    CHECK(lolanRegMapFindByPtr(&rctx, rmModel[i].data) == i);
+    CHECK(lolanRegMapFindByPath(&rctx, rmModel[i].p.data()) == i);
+    CHECK((lolan_getIndex(&rctx, true, rmModel[i].p.data(), &err) == i) && !err);
+    CHECK((lolan_getIndex(&rctx, false, rmModel[i].data, &err) == i) && !err);
+  }
+  for (k = 0; k < RM_POOL; k++)
+    if (rmFind(&rmPool[k]) == NULL)
+      CHECK(lolanRegMapFindByPtr(&rctx, &rmPool[k]) == LOLAN_REGMAP_SIZE);
+
+  /* lower and upper bounds of partial paths */
+  for (k = 0; k < 8; k++) {
+    for (l = 0; l < LOLAN_REGMAP_DEPTH; l++)
+      path[l] = rmRandom() % 6;
+    len = rmRandom() % (LOLAN_REGMAP_DEPTH + 1);
+    for (i = 0; (i < rctx.regMapCount) && (memcmp(rmModel[i].p.data(), path, len) < 0); i++)
+      ;
+    CHECK(lolanRegMapLowerBound(&rctx, path, len) == i);
+    for (; (i < rctx.regMapCount) && (memcmp(rmModel[i].p.data(), path, len) <= 0); i++)
+      ;
+    CHECK(lolanRegMapUpperBound(&rctx, path, len) == i);
+    if (lolanRegMapFindByPath(&rctx, path) < LOLAN_REGMAP_SIZE)
+      CHECK(std::any_of(rmModel.begin(), rmModel.end(), [&](const RmVar &v) {
+        return memcmp(v.p.data(), path, LOLAN_REGMAP_DEPTH) == 0;
+      }));
+  }
+
+  /* subtrees (with and without the recursion depth restriction) */
+  for (k = 0; k < 8; k++) {
+    memset(path, 0, LOLAN_REGMAP_DEPTH);
+    len = rmRandom() % LOLAN_REGMAP_DEPTH;
+    for (l = 0; l < len; l++)
+      path[l] = 1 + rmRandom() % 4;
+    for (int maxrec = 0; maxrec < 2; maxrec++) {
+      maxLvl = (maxrec && (len + LOLAN_REGMAP_RECURSION < LOLAN_REGMAP_DEPTH)) ? len + LOLAN_REGMAP_RECURSION : LOLAN_REGMAP_DEPTH;
+      scan.clear();
+      for (i = 0; i < rctx.regMapCount; i++)
+        if ((memcmp(rmModel[i].p.data(), path, len) == 0) && ((maxLvl == LOLAN_REGMAP_DEPTH) || (rmModel[i].p[maxLvl] == 0)))
+          scan.push_back(i);
+      found.clear();
+      lolanSubtreeInit(&rctx, &st, path, maxrec);
+      while ((i = lolanSubtreeNext(&rctx, &st)) < LOLAN_REGMAP_SIZE)
+        found.push_back(i);
+      CHECK(found == scan);
+      CHECK((lolanPathDefinitionLevel(&rctx, path, &i, maxrec) == len) && (i == scan.size()));
+    }
+  }
+
+  /* flags */
+  static const uint16_t flagSets[] = {
+    LOLAN_REGMAP_REMOTE_UPDATE_BIT, LOLAN_REGMAP_INFORM_REQUEST_BIT, LOLAN_REGMAP_LOCAL_UPDATE_BIT,
+    LOLAN_REGMAP_INFORMSEC_REQUEST_BIT, LOLAN_REGMAP_AUX_BIT, LOLAN_REGMAP_REMOTE_READONLY_BIT,
+    LOLAN_REGMAP_INFORM_REQUEST_BIT | LOLAN_REGMAP_LOCAL_UPDATE_BIT,
+    LOLAN_REGMAP_AUX_BIT | LOLAN_REGMAP_REMOTE_UPDATE_BIT | LOLAN_REGMAP_REMOTE_READONLY_BIT
+  };
+  for (uint16_t f : flagSets) {
+    scan.clear();
+    for (i = 0; i < rctx.regMapCount; i++)
+      if ((rmModel[i].flags & f) == f)
+        scan.push_back(i);
+    found.clear();
+    for (i = lolanFlagNext(&rctx, f, 0); i < LOLAN_REGMAP_SIZE; i = lolanFlagNext(&rctx, f, i+1))
+      found.push_back(i);
+    CHECK(found == scan);
+    CHECK(lolanVarFlagCount(&rctx, f, NULL, NULL, NULL) == scan.size());
+    k = rmRandom() % (rctx.regMapCount + 1);
+    expected = (std::lower_bound(scan.begin(), scan.end(), k) != scan.end()) ? *std::lower_bound(scan.begin(), scan.end(), k) : LOLAN_REGMAP_SIZE;
+    CHECK(lolanFlagNext(&rctx, f, k) == expected);
+  }
+}
+
+// random register, remove, batch, flag and sort operations
+static void rmRun(unsigned ops)
+{
+  LR_SIZE_T i, j, n, errorIndex;
+  lolan_VarDef defs[6];
+  uint8_t tmp[LOLAN_REGMAP_DEPTH];
+  uint32_t *data;
+  uint16_t f;
+  bool ok;
+
+  for (unsigned op = 0; op < ops; op++) {
+    switch (rmRandom() % 8) {
+      case 0:   // register
+      case 1:
+      case 2: {
+        std::vector<uint8_t> p = rmPath();
+        bool readOnly = (rmRandom() % 4 == 0);
+        data = &rmPool[rmRandom() % RM_POOL];
+        ok = rmPathValid(p) && (rmFind(data) == NULL) && (rmModel.size() < rmCapacity);
+        for (auto &v : rmModel)
+          ok = ok && !rmConflict(v.p, p);
+        CHECK(lolan_regVar(&rctx, p.data(), LOLAN_UINT, data, sizeof(*data), readOnly) == (ok ? LOLAN_RETVAL_YES : LOLAN_RETVAL_GENERROR));
+        if (ok) rmAdd(p, data, readOnly);
+        break;
+      }
+      case 3:   // remove
+      case 4:
+        data = &rmPool[rmRandom() % RM_POOL];
+        ok = (rmFind(data) != NULL);
+        CHECK(lolan_rmVar(&rctx, data) == (ok ? LOLAN_RETVAL_YES : LOLAN_RETVAL_GENERROR));
+        if (ok) rmModel.erase(rmModel.begin() + (rmFind(data) - rmModel.data()));
+        break;
+      case 5: {   // batch (atomic)
+        n = 1 + rmRandom() % 6;
+        std::vector<std::vector<uint8_t> > paths;
+        ok = (rmModel.size() + n <= rmCapacity);
+        for (i = 0; i < n; i++) {
+          paths.push_back(rmPath());
+          memcpy(defs[i].p, paths[i].data(), LOLAN_REGMAP_DEPTH);
+          defs[i].vType = LOLAN_UINT;
+          defs[i].data = &rmPool[rmRandom() % RM_POOL];
+          defs[i].size = sizeof(uint32_t);
+          defs[i].readOnly = (i == 0);
+          ok = ok && rmPathValid(paths[i]) && (rmFind((uint32_t *) defs[i].data) == NULL);
+          for (auto &v : rmModel)
+            ok = ok && !rmConflict(v.p, paths[i]);
+          for (j = 0; j < i; j++)
+            ok = ok && !rmConflict(paths[j], paths[i]) && (defs[j].data != defs[i].data);
+        }
+        errorIndex = 0;
+        CHECK(lolan_regVarBatch(&rctx, defs, n, &errorIndex) == (ok ? LOLAN_RETVAL_YES : LOLAN_RETVAL_GENERROR));
+        if (ok) {
+          for (i = 0; i < n; i++)
+            rmAdd(paths[i], (uint32_t *) defs[i].data, defs[i].readOnly);
+        } else {
+          CHECK(errorIndex <= n);
+        }
+        break;
+      }
+      case 6:   // flags
+        if (rmModel.empty()) break;
+        i = rmRandom() % rmModel.size();
+        f = (rmRandom() & 0xffff);
+        switch (rmRandom() % 4) {
+          case 0:
+            CHECK(lolan_setFlag(&rctx, rmModel[i].data, f) == LOLAN_RETVAL_YES);
+            rmModel[i].flags |= f & LOLAN_REGMAP_USER_MASK;
+            break;
+          case 1:
+            CHECK(lolan_clearFlag(&rctx, rmModel[i].data, f) == LOLAN_RETVAL_YES);
+            rmModel[i].flags &= ~(f & LOLAN_REGMAP_USER_MASK);
+            break;
+          case 2:
+            if (rmRandom() % 4 == 0) {
+              CHECK(lolan_clearFlag(&rctx, NULL, f) == LOLAN_RETVAL_YES);   // (all variables)
+              for (auto &v : rmModel)
+                v.flags &= ~(f & LOLAN_REGMAP_USER_MASK);
+            }
+            break;
+          default:
+            if (f & 1) {
+              lolanFlagSet(&rctx, i, LOLAN_REGMAP_AUX_BIT);
+              rmModel[i].flags |= LOLAN_REGMAP_AUX_BIT;
+            } else if (f & 2) {
+              lolanFlagClearAll(&rctx, LOLAN_REGMAP_AUX_BIT);
+              for (auto &v : rmModel)
+                v.flags &= ~LOLAN_REGMAP_AUX_BIT;
+            }
+            break;
+        }
+        CHECK(lolan_getFlag(&rctx, rmModel[i].data) == (LRM_FLAGS(&rctx, i)));
+        break;
+      default:   // scramble the entries and sort them again
+        for (n = 0; (rctx.regMapCount > 1) && (n < 4); n++) {
+          i = rmRandom() % rctx.regMapCount;
+          j = rmRandom() % rctx.regMapCount;
+          memcpy(tmp, LRM_P(&rctx, i), LOLAN_REGMAP_DEPTH);
+          memcpy(LRM_P(&rctx, i), LRM_P(&rctx, j), LOLAN_REGMAP_DEPTH);
+          memcpy(LRM_P(&rctx, j), tmp, LOLAN_REGMAP_DEPTH);
+          std::swap(LRM_FLAGS(&rctx, i), LRM_FLAGS(&rctx, j));
+          std::swap(LRM_SIZE(&rctx, i), LRM_SIZE(&rctx, j));
+#ifdef LOLAN_ALLOW_VARLEN_LOLANDATA
+          std::swap(LRM_SIZEACTUAL(&rctx, i), LRM_SIZEACTUAL(&rctx, j));
+#endif
+          std::swap(LRM_DATA(&rctx, i), LRM_DATA(&rctx, j));
+#ifdef LOLAN_VARIABLE_TAG_TYPE
+          std::swap(LRM_TAG(&rctx, i), LRM_TAG(&rctx, j));
+#endif
+        }
+        lolan_regMapSort(&rctx);
+        break;
+    }
+    rmCheck();
+  }
+}
+
+static void testRegMap()
+{
+  /* fixed capacity (a full register map refuses the new variables) */
+#ifdef LOLAN_REGMAP_DYNAMIC
+  lolan_free(&rctx);
+#endif
+  lolan_init(&rctx, 1);
+  rmModel.clear();
+  rmCapacity = LOLAN_REGMAP_SIZE;
+  rmRun(3000);
+
+#ifdef LOLAN_REGMAP_DYNAMIC
+  /* allocated register map growing on demand */
+  lolan_free(&rctx);
+  CHECK(lolan_initEx(&rctx, 1, LOLAN_REGMAP_SIZE + 1, NULL) == LOLAN_RETVAL_GENERROR);
+  lolan_free(&rctx);
+  CHECK(lolan_initEx(&rctx, 1, 2, NULL) == LOLAN_RETVAL_YES);
+  rmModel.clear();
+  rmRun(3000);
+  lolan_free(&rctx);
+  CHECK(rctx.regMapCount == 0);
+
+  /* register map in a supplied memory block */
+  std::vector<uint64_t> mem((lolan_regMapMemSize(12) + 7) / 8);
+  CHECK(lolan_initEx(&rctx, 1, 12, mem.data()) == LOLAN_RETVAL_YES);
+  rmModel.clear();
+  rmCapacity = 12;
+  rmRun(2000);
+  lolan_free(&rctx);
+#endif
+
+#ifdef LOLAN_REGMAP_CONST
+  /* read-only register map (the variables of the model) */
+  static lolan_ctx cctx;
+  std::vector<uint16_t> flags;
+  std::vector<LV_SIZE_T> size;
+  std::vector<void *> data;
+  LR_SIZE_T i;
+
+  lolan_free(&rctx);
+  lolan_init(&rctx, 1);
+  rmModel.clear();
+  rmCapacity = LOLAN_REGMAP_SIZE;
+  rmRun(500);
+  std::vector<lolan_RegMapPath> p(rmModel.size() + 1);
+  for (i = 0; i < rmModel.size(); i++) {
+    memcpy(p[i], rmModel[i].p.data(), LOLAN_REGMAP_DEPTH);
+    flags.push_back(rmModel[i].flags & ~LOLAN_REGMAP_AUX_BIT);
+    size.push_back(sizeof(uint32_t));
+    data.push_back(rmModel[i].data);
+  }
+  lolan_ConstRegMap map = { (LR_SIZE_T) rmModel.size(), p.data(), flags.data(), size.data(), data.data(), 0, 0, NULL, NULL };
+  std::vector<uint64_t> cmem((lolan_constRegMapMemSize(&map) + 7) / 8 + 1);
+  CHECK(lolan_initConst(&cctx, 1, &map, cmem.data()) == LOLAN_RETVAL_YES);
+  CHECK(lolan_checkRegMap(&cctx) == cctx.regMapCount);
+  for (i = 0; i < rmModel.size(); i++) {
+    CHECK(lolanRegMapFindByPath(&cctx, rmModel[i].p.data()) == i);
+    CHECK(lolanRegMapFindByPtr(&cctx, rmModel[i].data) == i);
+    CHECK(lolan_setFlag(&cctx, rmModel[i].data, LOLAN_REGMAP_INFORM_REQUEST_BIT) == LOLAN_RETVAL_YES);
+  }
+  CHECK(lolanVarFlagCount(&cctx, LOLAN_REGMAP_INFORM_REQUEST_BIT, NULL, NULL, NULL) == rmModel.size());
+  for (i = 0; (i < RM_POOL) && (rmFind(&rmPool[i]) != NULL); i++)
+    ;
+  memset(p[rmModel.size()], 0, LOLAN_REGMAP_DEPTH);
+  p[rmModel.size()][0] = 200;   // (no conflict)
+  CHECK(lolan_regVar(&cctx, p[rmModel.size()], LOLAN_UINT, &rmPool[i], sizeof(uint32_t), false) == LOLAN_RETVAL_GENERROR);
+  if (!rmModel.empty())
+    CHECK(lolan_rmVar(&cctx, rmModel[0].data) == LOLAN_RETVAL_GENERROR);
+  lolan_free(&cctx);
+
+  /* duplicate data pointer */
+  if (rmModel.size() > 1) {
+    data[1] = data[0];
+#ifdef LOLAN_REGMAP_HASH_SIZE
+    CHECK(lolan_initConst(&cctx, 1, &map, cmem.data()) == LOLAN_RETVAL_GENERROR);
+#else
+    CHECK(lolan_initConst(&cctx, 1, &map, cmem.data()) == LOLAN_RETVAL_YES);
+    CHECK(lolan_checkRegMap(&cctx) < cctx.regMapCount);
+#endif
+    lolan_free(&cctx);
+  }
+  lolan_free(&rctx);
+#endif
+}
+
+/* packets: serialization and parsing are compared with a reference encoding */
+static uint32_t pkRnd = 777;
+
+static uint32_t pkRandom()
+{
+  pkRnd = pkRnd * 1103515245u + 12345u;
+  return pkRnd >> 8;
+}
+
+// bitwise CRC16 (CCITT, reflected 0x8408, the result is byte-swapped like lolan_CRC_calc())
+static uint16_t pkCrc(const uint8_t *data, size_t size)
+{
+  uint16_t crc = 0;
+
+  while (size--) {
+    crc ^= *data++;
+    for (int b = 0; b < 8; b++)
+      crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : (crc >> 1);
+  }
+  return (uint16_t) ((crc << 8) | (crc >> 8));
+}
+
+// random packet (the payload has many SLIP special characters)
+static lolan_Packet pkRandomPacket(std::vector<uint8_t> &payload, size_t maxPayload)
+{
+  static const uint8_t special[] = { LOLAN_SLIP_END, LOLAN_SLIP_ESC, LOLAN_SLIP_ESC_END, LOLAN_SLIP_ESC_ESC };
+  lolan_Packet lp;
+
+  lolan_resetPacket(&lp);
+  lp.packetType = (lolan_PacketType) (pkRandom() % 8);
+  lp.multiPart = (lolan_MultiPart) (pkRandom() % 4);
+  lp.securityEnabled = pkRandom() & 1;
+  lp.ackRequired = pkRandom() & 1;
+  lp.routingRequested = pkRandom() & 1;
+  lp.packetCounter = pkRandom();
+  lp.fromId = pkRandom();
+  lp.toId = pkRandom();
+  payload.resize(pkRandom() % (maxPayload + 1));
+  for (auto &b : payload)
+    b = (pkRandom() % 4 == 0) ? special[pkRandom() % 4] : pkRandom();
+  lp.payload = payload.data();
+  lp.payloadSize = payload.size();
+  return lp;
+}
+
+// reference encoding of a packet (header, payload, CRC16 big-endian)
+static std::vector<uint8_t> pkEncode(const lolan_Packet &lp, bool withCRC)
+{
+  std::vector<uint8_t> buf;
+  uint16_t crc;
+
+  buf.push_back(lp.packetType | (lp.multiPart << 3) | (lp.ackRequired ? 0x20 : 0));
+  buf.push_back(0x74 | (lp.securityEnabled ? 0x08 : 0) | (lp.routingRequested ? 0x80 : 0));
+  buf.push_back(lp.packetCounter);
+  buf.push_back(lp.fromId & 0xFF);
+  buf.push_back(lp.fromId >> 8);
+  buf.push_back(lp.toId & 0xFF);
+  buf.push_back(lp.toId >> 8);
+  buf.insert(buf.end(), lp.payload, lp.payload + lp.payloadSize);
+  if (withCRC) {
+    crc = pkCrc(buf.data(), buf.size());
+    buf.push_back(crc >> 8);
+    buf.push_back(crc & 0xFF);
+  }
+  return buf;
+}
+
+static bool pkSame(const lolan_Packet &a, const lolan_Packet &b)
+{
+  return (a.packetType == b.packetType) && (a.multiPart == b.multiPart)
+         && (a.securityEnabled == b.securityEnabled) && (a.ackRequired == b.ackRequired)
+         && (a.routingRequested == b.routingRequested) && (a.packetCounter == b.packetCounter)
+         && (a.fromId == b.fromId) && (a.toId == b.toId) && (a.payloadSize == b.payloadSize)
+         && (memcmp(a.payload, b.payload, a.payloadSize) == 0);
+}
+
+static std::vector<uint8_t> pkSlip(const std::vector<uint8_t> &frame)
+{
+  std::vector<uint8_t> out;
+
+  for (uint8_t b : frame) {
+    if (b == LOLAN_SLIP_END) {
+      out.push_back(LOLAN_SLIP_ESC);
+      out.push_back(LOLAN_SLIP_ESC_END);
+    } else if (b == LOLAN_SLIP_ESC) {
+      out.push_back(LOLAN_SLIP_ESC);
+      out.push_back(LOLAN_SLIP_ESC_ESC);
+    } else {
+      out.push_back(b);
+    }
+  }
+  out.push_back(LOLAN_SLIP_END);
+  return out;
+}
+
+// the statuses of a frame by lolan_parsePacketView(), lolan_parsePacket() and the packet parser must agree
+static int8_t pkParseAll(const std::vector<uint8_t> &frame, lolan_Packet *out)
+{
+  static uint8_t payloadBuf[LOLAN_PACKET_MAX_PAYLOAD_SIZE];
+  static lolan_PacketParser pp;
+  lolan_Packet view, copy, pushed;
+  int8_t st, st2, st3;
+  size_t i, n;
+
+  lolan_resetPacket(&view);
+  st = lolan_parsePacketView(frame.data(), frame.size(), &view);
+  copy.payload = payloadBuf;
+  st2 = lolan_parsePacket(frame.data(), frame.size(), &copy);
+  lolan_packetParserInit(&pp);
+  for (i = 0; i < frame.size(); i += n) {   // (in random parts, often byte by byte)
+    n = 1 + ((pkRandom() % 2) ? 0 : pkRandom() % 16);
+    lolan_packetParserPush(&pp, &frame[i], std::min(n, frame.size() - i));
+  }
+  st3 = lolan_packetParserEnd(&pp, &pushed);
+  CHECK((st == st2) && (st == st3));
+  if (st == LOLAN_RETVAL_YES) {
+    CHECK(view.payload == &frame[7]);
+    CHECK(copy.payload == payloadBuf);
+    CHECK(pkSame(view, copy) && pkSame(view, pushed));
+    *out = view;
+  }
+  return st;
+}
+
+static void testPacket()
+{
+  static uint8_t buf[LOLAN_MAX_PACKET_SIZE], header[LOLAN_PACKET_HEADER_SIZE], crc[LOLAN_PACKET_CRC_SIZE];
+  static uint8_t frame[LOLAN_MAX_PACKET_SIZE];
+  std::vector<uint8_t> payload, ref, seq;
+  lolan_Packet lp, out;
+  lolan_Segment seg[3];
+  uint16_t c;
+  size_t size, i, k, cut;
+  uint8_t *p;
+
+  /* CRC16 (check value of "123456789", incremental calculation in parts) */
+  CHECK(lolan_CRC_calc((const uint8_t *) "123456789", 9) == 0x8921);
+  CHECK(pkCrc((const uint8_t *) "123456789", 9) == 0x8921);
+  CHECK(lolan_CRC_calc(NULL, 0) == 0);
+  for (k = 0; k < 200; k++) {
+    seq.resize(pkRandom() % 300);
+    for (auto &b : seq)
+      b = pkRandom();
+    CHECK(lolan_CRC_calc(seq.data(), seq.size()) == pkCrc(seq.data(), seq.size()));
+    c = lolan_CRC_init();
+    for (i = 0; i < seq.size(); i += size) {
+      size = std::min((size_t) (pkRandom() % 20), seq.size() - i);
+      c = lolan_CRC_update(c, &seq[i], size);
+    }
+    CHECK(lolan_CRC_final(c) == pkCrc(seq.data(), seq.size()));
+  }
+
+  /* serialization and parsing round trip */
+  for (k = 0; k < 500; k++) {
+    lp = pkRandomPacket(payload, LOLAN_PACKET_MAX_PAYLOAD_SIZE);
+    ref = pkEncode(lp, true);
+    CHECK((lolan_createPacket(&lp, buf, 0, &size, true) == LOLAN_RETVAL_YES) && (size == ref.size())
+          && (memcmp(buf, ref.data(), size) == 0));
+    CHECK(lolan_CRC_calc(buf, size) == 0);   // (CRC over the complete packet)
+
+    CHECK(lolan_createPacketSegments(&lp, header, crc, seg, true) == LOLAN_RETVAL_YES);
+    seq.clear();
+    for (i = 0; i < 3; i++)
+      seq.insert(seq.end(), seg[i].data, seg[i].data + seg[i].size);
+    CHECK(seq == ref);
+    CHECK(seg[1].data == lp.payload);   // (not copied)
+    CHECK(lolan_createPacketSegments(&lp, header, NULL, seg, false) == LOLAN_RETVAL_YES);
+    CHECK((seg[2].size == 0) && (memcmp(seg[0].data, ref.data(), LOLAN_PACKET_HEADER_SIZE) == 0));
+    CHECK((lolan_createPacket(&lp, buf, 0, &size, false) == LOLAN_RETVAL_YES) && (size == ref.size() - 2));
+
+    out = lp;
+    out.payload = LOLAN_PACKET_PAYLOAD(frame);
+    memcpy(out.payload, payload.data(), payload.size());
+    p = lolan_createPacketInPlace(&out, &size, true);
+    CHECK((p == frame) && (size == ref.size()) && (memcmp(frame, ref.data(), size) == 0));
+
+    CHECK(pkParseAll(ref, &out) == LOLAN_RETVAL_YES);
+    CHECK(pkSame(out, lp));
+
+    /* corrupted packet */
+    i = pkRandom() % ref.size();
+    c = 1 << (pkRandom() % 8);
+    ref[i] ^= c;
+    CHECK(pkParseAll(ref, &out) == (((i == 1) && (c & 0x30)) ? LOLAN_RETVAL_NO : LOLAN_RETVAL_GENERROR));   // (frame version or CRC error)
+  }
+
+  /* short, too long and non-LoLaN frames */
+  lp = pkRandomPacket(payload, 0);
+  ref = pkEncode(lp, true);
+  CHECK(pkParseAll(std::vector<uint8_t>(ref.begin(), ref.end() - 1), &out) == LOLAN_RETVAL_NO);
+  ref[1] ^= 0x10;   // (frame version)
+  CHECK(pkParseAll(ref, &out) == LOLAN_RETVAL_NO);
+  lp = pkRandomPacket(payload, LOLAN_PACKET_MAX_PAYLOAD_SIZE);
+  payload.resize(LOLAN_PACKET_MAX_PAYLOAD_SIZE + 1);
+  lp.payload = payload.data();
+  lp.payloadSize = payload.size();
+  CHECK(lolan_createPacket(&lp, buf, 0, &size, true) == LOLAN_RETVAL_GENERROR);
+  CHECK(lolan_createPacketSegments(&lp, header, crc, seg, true) == LOLAN_RETVAL_GENERROR);
+  CHECK(pkParseAll(pkEncode(lp, true), &out) == LOLAN_RETVAL_GENERROR);
+  lp.payloadSize--;
+  CHECK(lolan_createPacket(&lp, buf, lp.payloadSize + 8, &size, true) == LOLAN_RETVAL_GENERROR);   // (maxSize)
+  CHECK(lolan_createPacket(&lp, buf, lp.payloadSize + 9, &size, true) == LOLAN_RETVAL_YES);
+
+  /* multiple packets in a buffer (every framing, parsed in two calls at every split point) */
+  for (int framing = LOLAN_FRAMING_LEN8; framing <= LOLAN_FRAMING_SLIP; framing++) {
+    std::vector<std::vector<uint8_t> > payloads(6);
+    std::vector<lolan_Packet> packets;
+    std::vector<int8_t> statuses;
+    std::vector<uint8_t> stream;
+
+    if (framing == LOLAN_FRAMING_SLIP)
+      stream.push_back(LOLAN_SLIP_END);   // (empty frame)
+    for (i = 0; i < payloads.size(); i++) {
+      lp = pkRandomPacket(payloads[i], std::min(LOLAN_PACKET_MAX_PAYLOAD_SIZE, 255 - 9));
+      ref = pkEncode(lp, true);
+      statuses.push_back(LOLAN_RETVAL_YES);
+      if (i == 2) {   // CRC error
+        ref[ref.size() - 1] ^= 0x40;
+        statuses.back() = LOLAN_RETVAL_GENERROR;
+      } else if (i == 4) {   // not a LoLaN packet
+        ref.resize(5);
+        statuses.back() = LOLAN_RETVAL_NO;
+      }
+      packets.push_back(lp);
+      if (framing == LOLAN_FRAMING_SLIP) {
+        seq = pkSlip(ref);
+      } else {
+        seq.assign(1, ref.size() & 0xFF);
+        if (framing == LOLAN_FRAMING_LEN16)
+          seq.push_back(ref.size() >> 8);
+        seq.insert(seq.end(), ref.begin(), ref.end());
+      }
+      stream.insert(stream.end(), seq.begin(), seq.end());
+    }
+
+    for (cut = 0; cut <= stream.size(); cut++) {
+      std::vector<uint8_t> work(stream);
+      lolan_Packet lps[8];
+      int8_t status[8];
+      size_t n, consumed, consumed2;
+
+      n = lolan_parsePackets(work.data(), cut, (lolan_Framing) framing, lps, status, 8, &consumed);
+      CHECK(consumed <= cut);
+      n += lolan_parsePackets(&work[consumed], work.size() - consumed, (lolan_Framing) framing, &lps[n],
+                              &status[n], 8 - n, &consumed2);
+      CHECK((n == packets.size()) && (consumed + consumed2 == work.size()));
+      for (i = 0; (i < n) && (i < packets.size()); i++) {
+        CHECK(status[i] == statuses[i]);
+        if (status[i] == LOLAN_RETVAL_YES)
+          CHECK(pkSame(lps[i], packets[i]) && (lps[i].payload >= work.data()) && (lps[i].payload < work.data() + work.size()));
+        else
+          CHECK(lps[i].payload == NULL);
+      }
+    }
+
+    /* maxCount */
+    std::vector<uint8_t> work(stream);
+    lolan_Packet lps[2];
+    int8_t status[2];
+    size_t consumed;
+    CHECK(lolan_parsePackets(work.data(), work.size(), (lolan_Framing) framing, lps, status, 2, &consumed) == 2);
+    CHECK((consumed < work.size()) && pkSame(lps[0], packets[0]) && pkSame(lps[1], packets[1]));
+  }
+}
+
+/* SET: the update kernels are compared with the rules of the former type/size switch (decoded by tinycbor),
+   the single-pass New Style reply with the status codes encoded by lolanVarFlagToCbor() afterwards */
+#define ST_VARS  ((LOLAN_REGMAP_SIZE < 100) ? LOLAN_REGMAP_SIZE : 100)
+#define ST_UPDATE_FLAGS  (LOLAN_REGMAP_REMOTE_UPDATE_BIT | LOLAN_REGMAP_REMOTE_UPDATE_MISMATCH_BIT | LOLAN_REGMAP_REMOTE_UPDATE_OUTOFRANGE_BIT)
+
+struct StVar {          // variable of the SET tests
+  std::vector<uint8_t> p;
+  uint8_t type;
+  LV_SIZE_T size;
+  bool readOnly;
+};
+
+struct StEntry {        // leaf of a SET request (a path longer than LOLAN_REGMAP_DEPTH is too deep)
+  std::vector<uint16_t> path;
+  std::vector<uint8_t> item;
+};
+
+static lolan_ctx sctx, kctx;
+static uint64_t stData[ST_VARS][2];   // variable data (the bytes after a variable are checked as well)
+static std::vector<StVar> stVars;
+static uint32_t stRnd = 99;
+
+static uint32_t stRandom()
+{
+  stRnd = stRnd * 1103515245u + 12345u;
+  return stRnd >> 8;
+}
+
+static uint64_t stRandom64()
+{
+  uint64_t v = ((uint64_t) stRandom() << 40) ^ ((uint64_t) stRandom() << 20) ^ stRandom();
+
+  return v >> (stRandom() % 64);   // (any width)
+}
+
+// CBOR head in the shortest form
+static void stHead(std::vector<uint8_t> &b, uint8_t major, uint64_t arg)
+{
+  int n;
+
+  major <<= 5;
+  if (arg < 24) {
+    b.push_back(major | arg);
+    return;
+  }
+  n = (arg <= UINT8_MAX) ? 1 : (arg <= UINT16_MAX) ? 2 : (arg <= UINT32_MAX) ? 4 : 8;
+  b.push_back(major | ((n == 1) ? 24 : (n == 2) ? 25 : (n == 4) ? 26 : 27));
+  for (int k = n - 1; k >= 0; k--)
+    b.push_back(arg >> (8 * k));
+}
+
+static std::vector<uint8_t> stFloat(float f)
+{
+  std::vector<uint8_t> b(1, 0xfa);
+  uint32_t bits;
+
+  memcpy(&bits, &f, 4);
+  for (int k = 3; k >= 0; k--)
+    b.push_back(bits >> (8 * k));
+  return b;
+}
+
+static std::vector<uint8_t> stDouble(double d)
+{
+  std::vector<uint8_t> b(1, 0xfb);
+  uint64_t bits;
+
+  memcpy(&bits, &d, 8);
+  for (int k = 7; k >= 0; k--)
+    b.push_back(bits >> (8 * k));
+  return b;
+}
+
+static std::vector<uint8_t> stString(uint8_t major, size_t len)
+{
+  std::vector<uint8_t> b;
+
+  stHead(b, major, len);
+  for (size_t k = 0; k < len; k++)
+    b.push_back('a' + stRandom() % 26);
+  return b;
+}
+
+// CBOR items of every kind (integer widths at the range limits, strings at the size limits, not allowed items)
+static std::vector<std::vector<uint8_t> > stItems()
+{
+  static const uint64_t args[] = { 0, 1, 23, 24, 0x7f, 0x80, 0xff, 0x100, 0x7fff, 0x8000, 0xffff, 0x10000,
+      0x7fffffff, 0x80000000, 0xffffffff, 0x100000000, 0x7fffffffffffffff, 0x8000000000000000, UINT64_MAX };
+  std::vector<std::vector<uint8_t> > items;
+  std::vector<uint8_t> b;
+
+  for (uint64_t a : args) {
+    for (uint8_t major = 0; major < 2; major++) {
+      b.clear();
+      stHead(b, major, a);
+      items.push_back(b);
+    }
+  }
+  items.push_back({ 0x18, 0x05 });   // (not in the shortest form)
+  items.push_back({ 0x3b, 0, 0, 0, 0, 0, 0, 0, 0x7f });
+  items.push_back(stFloat(1.5f));
+  items.push_back(stFloat(-1e30f));
+  items.push_back(stDouble(2.25));
+  items.push_back(stDouble(-1e300));
+  for (size_t len : { 0, 1, 3, 4, 5, 8, 9, 10 }) {
+    items.push_back(stString(2, len));
+    items.push_back(stString(3, len));
+  }
+  items.push_back({ 0x5f, 0x42, 1, 2, 0x41, 3, 0x40, 0x41, 4, 0xff });   // (chunked strings)
+  items.push_back({ 0x7f, 0x61, 'x', 0x63, 'y', 'z', 'w', 0xff });
+  items.push_back({ 0x5f, 0xff });
+  items.push_back({ 0xf9, 0x3c, 0x00 });   // (not allowed in LoLaN)
+  items.push_back({ 0xf4 });
+  items.push_back({ 0xf6 });
+  items.push_back({ 0xf8, 0x20 });
+  items.push_back({ 0x82, 0x01, 0x02 });
+  items.push_back({ 0xa1, 0x01, 0x02 });
+  items.push_back({ 0xc1, 0x01 });
+  return items;
+}
+
+static void stStore(uint8_t *data, LV_SIZE_T size, uint64_t bits)
+{
+  uint8_t v8 = bits;
+  uint16_t v16 = bits;
+  uint32_t v32 = bits;
+
+  switch (size) {
+    case 1:  memcpy(data, &v8, 1);    break;
+    case 2:  memcpy(data, &v16, 2);   break;
+    case 4:  memcpy(data, &v32, 4);   break;
+    case 8:  memcpy(data, &bits, 8);  break;
+  }
+}
+
+// expected update of a variable by a CBOR item (the rules of the former lolanVarUpdateFromCbor())
+static int8_t stExpected(uint8_t type, LV_SIZE_T size, bool readOnly, const uint8_t *item, size_t itemSize,
+                         uint8_t *data, uint8_t *error, LV_SIZE_T *actual)
+{
+  CborParser parser;
+  CborValue it;
+  uint64_t u;
+  int64_t v;
+  size_t len, n;
+  bool intSize;
+
+  if (readOnly) {
+    *error = LVUFC_READONLY;
+    return LOLAN_RETVAL_NO;
+  }
+  intSize = (size == 1) || (size == 2) || (size == 4) || (size == 8);
+  *error = LVUFC_MISMATCH;
+  cbor_parser_init(item, itemSize, 0, &parser, &it);
+  switch (cbor_value_get_type(&it)) {
+    case CborIntegerType:
+      cbor_value_get_raw_integer(&it, &u);
+      if (cbor_value_is_unsigned_integer(&it)) {
+        if ((type != LOLAN_INT) && (type != LOLAN_UINT)) return LOLAN_RETVAL_NO;
+        if (!intSize) return LOLAN_RETVAL_GENERROR;
+        if ((type == LOLAN_INT) ? (u > (UINT64_MAX >> (65 - 8 * size))) : ((size < 8) && (u >> (8 * size)))) {
+          *error = LVUFC_OUTOFRANGE;
+          return LOLAN_RETVAL_NO;
+        }
+        stStore(data, size, u);
+      } else {
+        v = (int64_t) ~u;   // (as cbor_value_get_int64())
+        if (type == LOLAN_UINT) {
+          *error = LVUFC_OUTOFRANGE;
+          return LOLAN_RETVAL_NO;
+        }
+        if (type != LOLAN_INT) return LOLAN_RETVAL_NO;
+        if (!intSize) return LOLAN_RETVAL_GENERROR;
+        if ((size < 8) && ((v < -((int64_t) 1 << (8 * size - 1))) || (v >= ((int64_t) 1 << (8 * size - 1))))) {
+          *error = LVUFC_OUTOFRANGE;
+          return LOLAN_RETVAL_NO;
+        }
+        stStore(data, size, v);
+      }
+      return LOLAN_RETVAL_YES;
+    case CborFloatType:
+      if ((type != LOLAN_FLOAT) || (size != 4)) return LOLAN_RETVAL_NO;
+      stStore(data, 4, ((uint32_t) item[1] << 24) | ((uint32_t) item[2] << 16) | (item[3] << 8) | item[4]);
+      return LOLAN_RETVAL_YES;
+    case CborDoubleType:
+      if ((type != LOLAN_FLOAT) || (size != 8)) return LOLAN_RETVAL_NO;
+      u = 0;
+      for (int k = 1; k <= 8; k++)
+        u = (u << 8) | item[k];
+      stStore(data, 8, u);
+      return LOLAN_RETVAL_YES;
+    case CborTextStringType:
+    case CborByteStringType:
+      if ((type != LOLAN_STR) && ((type != LOLAN_DATA) || cbor_value_is_text_string(&it))) return LOLAN_RETVAL_NO;
+      cbor_value_calculate_string_length(&it, &len);
+#ifdef LOLAN_ALLOW_VARLEN_LOLANDATA
+      if ((type == LOLAN_STR) ? (size < len + 1) : ((size < len) || (len == 0))) {
+#else
+      if ((type == LOLAN_STR) ? (size < len + 1) : (size != len)) {
+#endif
+        *error = LVUFC_OUTOFRANGE;
+        return LOLAN_RETVAL_NO;
+      }
+      n = size;
+      if (cbor_value_is_text_string(&it))
+        cbor_value_copy_text_string(&it, (char *) data, &n, NULL);
+      else
+        cbor_value_copy_byte_string(&it, data, &n, NULL);
+      if (type == LOLAN_DATA)
+        *actual = n;
+      return LOLAN_RETVAL_YES;
+    default:   // (not allowed in LoLaN)
+      return LOLAN_RETVAL_GENERROR;
+  }
+}
+
+// every variable kind with every CBOR item
+static void testUpdateKernels()
+{
+  static const struct { uint8_t type; LV_SIZE_T size, regSize; } kinds[] = {
+    { LOLAN_INT, 1, 1 }, { LOLAN_INT, 2, 2 }, { LOLAN_INT, 4, 4 }, { LOLAN_INT, 8, 8 }, { LOLAN_INT, 3, 4 },
+    { LOLAN_UINT, 1, 1 }, { LOLAN_UINT, 2, 2 }, { LOLAN_UINT, 4, 4 }, { LOLAN_UINT, 8, 8 }, { LOLAN_UINT, 3, 4 },
+    { LOLAN_FLOAT, 4, 4 }, { LOLAN_FLOAT, 8, 8 }, { LOLAN_FLOAT, 2, 4 },   // (unsupported sizes set after the registration)
+    { LOLAN_STR, 1, 1 }, { LOLAN_STR, 4, 4 }, { LOLAN_STR, 9, 9 },
+    { LOLAN_DATA, 1, 1 }, { LOLAN_DATA, 4, 4 }, { LOLAN_DATA, 9, 9 } };
+  const size_t nk = sizeof(kinds) / sizeof(kinds[0]) < LOLAN_REGMAP_SIZE ? sizeof(kinds) / sizeof(kinds[0]) : LOLAN_REGMAP_SIZE;
+  std::vector<std::vector<uint8_t> > items = stItems();
+  uint64_t data[sizeof(kinds) / sizeof(kinds[0])][2];
+  uint8_t path[LOLAN_REGMAP_DEPTH] = { 0 };
+  uint8_t expData[16], err, expErr;
+  LV_SIZE_T expActual;
+  lolan_CborIndex idx;
+  lolan_CborCursor cur;
+  LR_SIZE_T i;
+  int8_t ret, exp;
+
+#ifdef LOLAN_REGMAP_DYNAMIC
+  lolan_free(&kctx);
+#endif
+  lolan_init(&kctx, 1);
+  for (size_t k = 0; k < nk; k++) {
+    path[0] = 1;
+    path[1] = k + 1;
+    CHECK(lolan_regVar(&kctx, path, (lolan_VarType) kinds[k].type, data[k], kinds[k].regSize, false) == LOLAN_RETVAL_YES);
+    LRM_SIZE(&kctx, lolanRegMapFindByPtr(&kctx, data[k])) = kinds[k].size;
+  }
+
+  for (size_t k = 0; k < nk; k++) {
+    i = lolanRegMapFindByPtr(&kctx, data[k]);
+    for (const std::vector<uint8_t> &item : items) {
+      CHECK(lolanCborValidate(&idx, item.data(), item.size()) == LOLAN_RETVAL_YES);
+      for (int readOnly = 0; readOnly < 2; readOnly++) {
+        if (readOnly)
+          lolanFlagSet(&kctx, i, LOLAN_REGMAP_REMOTE_READONLY_BIT);
+        else
+          lolanFlagClear(&kctx, i, LOLAN_REGMAP_REMOTE_READONLY_BIT);
+        lolanFlagClear(&kctx, i, LOLAN_REGMAP_AUX_BIT);
+        lolanFlagSet(&kctx, i, ST_UPDATE_FLAGS);   // (cleared by the update)
+        memset(data[k], 0xa5, sizeof(data[k]));
+        memcpy(expData, data[k], sizeof(expData));
+#ifdef LOLAN_ALLOW_VARLEN_LOLANDATA
+        LRM_SIZEACTUAL(&kctx, i) = 1;
+#endif
+        expActual = 1;
+        exp = stExpected(kinds[k].type, kinds[k].size, readOnly, item.data(), item.size(), expData, &expErr, &expActual);
+        lolanCborCursorRoot(&idx, &cur);
+        err = 0;
+        ret = lolanVarIndexUpdateFromCbor(&kctx, i, &cur, &err);
+        CHECK(ret == exp);
+        CHECK(memcmp(data[k], expData, sizeof(expData)) == 0);
+        if (ret == LOLAN_RETVAL_GENERROR)
+          continue;   // (the request is refused)
+        if (ret == LOLAN_RETVAL_NO)
+          CHECK(err == expErr);
+        CHECK((LRM_FLAGS(&kctx, i) & (ST_UPDATE_FLAGS | LOLAN_REGMAP_AUX_BIT)) == (LOLAN_REGMAP_AUX_BIT
+              | ((ret == LOLAN_RETVAL_YES) ? LOLAN_REGMAP_REMOTE_UPDATE_BIT : 0)
+              | (((ret == LOLAN_RETVAL_NO) && (err == LVUFC_MISMATCH)) ? LOLAN_REGMAP_REMOTE_UPDATE_MISMATCH_BIT : 0)
+              | (((ret == LOLAN_RETVAL_NO) && (err == LVUFC_OUTOFRANGE)) ? LOLAN_REGMAP_REMOTE_UPDATE_OUTOFRANGE_BIT : 0)));
+#ifdef LOLAN_ALLOW_VARLEN_LOLANDATA
+        CHECK(LRM_SIZEACTUAL(&kctx, i) == expActual);
+#endif
+      }
+    }
+  }
+}
+
+// (re)initialize the SET test context: INT/UINT/FLOAT/STR/DATA variables under (1..3, x) and (4, x, y)
+static void stCtx()
+{
+  static const struct { uint8_t type; LV_SIZE_T size; } kinds[] = {
+    { LOLAN_INT, 1 }, { LOLAN_INT, 2 }, { LOLAN_INT, 4 }, { LOLAN_INT, 8 },
+    { LOLAN_UINT, 1 }, { LOLAN_UINT, 2 }, { LOLAN_UINT, 4 }, { LOLAN_UINT, 8 },
+    { LOLAN_FLOAT, 4 }, { LOLAN_FLOAT, 8 }, { LOLAN_STR, 8 }, { LOLAN_DATA, 4 } };
+  uint8_t path[LOLAN_REGMAP_DEPTH];
+  StVar v;
+
+#ifdef LOLAN_REGMAP_DYNAMIC
+  lolan_free(&sctx);
+#endif
+  lolan_init(&sctx, 1);
+  stVars.clear();
+  for (size_t j = 0; j < ST_VARS; j++) {
+    if (j < ST_VARS / 2)
+      v.p = { (uint8_t) (1 + j % 3), (uint8_t) (20 + j) };
+    else
+      v.p = { 4, (uint8_t) (1 + (j - ST_VARS / 2) / 4), (uint8_t) (1 + j % 4) };
+    v.type = kinds[j % 12].type;
+    v.size = kinds[j % 12].size;
+    v.readOnly = (j % 7 == 3);
+    memset(path, 0, sizeof(path));
+    memcpy(path, v.p.data(), v.p.size());
+    memset(stData[j], 0, sizeof(stData[j]));
+    CHECK(lolan_regVar(&sctx, path, (lolan_VarType) v.type, stData[j], v.size, v.readOnly) == LOLAN_RETVAL_YES);
+    stVars.push_back(v);
+  }
+}
+
+// variable of the path (ST_VARS if not found)
+static size_t stFind(const std::vector<uint16_t> &path)
+{
+  for (size_t j = 0; j < stVars.size(); j++)
+    if (std::equal(stVars[j].p.begin(), stVars[j].p.end(), path.begin(), path.end()))
+      return j;
+  return ST_VARS;
+}
+
+// new value of a variable: mostly of its own type, or any allowed CBOR item
+static std::vector<uint8_t> stValue(size_t j, const std::vector<std::vector<uint8_t> > &items, bool small)
+{
+  std::vector<uint8_t> b;
+
+  if (small) {   // (1 byte)
+    stHead(b, stRandom() % 2, stRandom() % 24);
+    return b;
+  }
+  if (stRandom() % 3 == 0) {
+    do {
+      b = items[stRandom() % items.size()];
+    } while ((b[0] >= 0x80) && (b[0] != 0xfa) && (b[0] != 0xfb));   // (no GENERROR)
+    return b;
+  }
+  switch (stVars[j].type) {
+    case LOLAN_INT:
+      stHead(b, stRandom() % 2, stRandom64() >> (64 - 8 * stVars[j].size + 1));
+      break;
+    case LOLAN_UINT:
+      stHead(b, 0, stRandom64() >> (64 - 8 * stVars[j].size));
+      break;
+    case LOLAN_FLOAT:
+      b = (stVars[j].size == 4) ? stFloat(stRandom() / 7.0f) : stDouble(stRandom() / 7.0);
+      break;
+    case LOLAN_STR:
+      b = stString(2 + stRandom() % 2, stRandom() % 8);
+      break;
+    default:
+      b = stString(2, stVars[j].size);
+      break;
+  }
+  return b;
+}
+
+// New Style SET request payload (consecutive entries with a common path prefix share the nested maps)
+static std::vector<uint8_t> stNewStyle(const std::vector<StEntry> &entries, bool zeroFirst)
+{
+  std::vector<uint8_t> b(1, 0xbf);
+  std::vector<uint16_t> open;   // keys of the open nested maps
+  size_t lvl;
+
+  if (zeroFirst) {
+    b.push_back(0x00);
+    b.push_back(0x01);
+  }
+  for (const StEntry &e : entries) {
+    lvl = 0;
+    while ((lvl < open.size()) && (lvl + 1 < e.path.size()) && (open[lvl] == e.path[lvl]))
+      lvl++;
+    for (; open.size() > lvl; open.pop_back())
+      b.push_back(0xff);
+    while (open.size() + 1 < e.path.size()) {
+      stHead(b, 0, e.path[open.size()]);
+      b.push_back(0xbf);
+      open.push_back(e.path[open.size()]);
+    }
+    stHead(b, 0, e.path.back());
+    b.insert(b.end(), e.item.begin(), e.item.end());
+  }
+  for (; !open.empty(); open.pop_back())
+    b.push_back(0xff);
+  if (!zeroFirst) {
+    b.push_back(0x00);
+    b.push_back(0x01);
+  }
+  b.push_back(0xff);
+  return b;
+}
+
+static lolan_Packet stPacket(std::vector<uint8_t> &payload)
+{
+  static uint8_t packetCounter;   // (a new request for the duplicate request filter)
+  lolan_Packet lp;
+
+  lolan_resetPacket(&lp);
+  lp.packetType = LOLAN_PAK_SET;
+  lp.packetCounter = ++packetCounter;
+  lp.fromId = 2;
+  lp.toId = 1;
+  lp.payload = payload.data();
+  lp.payloadSize = payload.size();
+  return lp;
+}
+
+static uint16_t stMainCode(bool problems, size_t found, size_t updated)
+{
+  if (problems)
+    return (updated == 0) ? 471 : 470;
+  return (found == 0) ? 204 : (found == 1) ? 200 : 207;
+}
+
+// the variable updates of a request applied to a copy of the variable data
+static void stApply(const std::vector<StEntry> &entries, uint64_t (*data)[2], size_t *found, size_t *updated, uint16_t *codes)
+{
+  uint8_t err;
+  LV_SIZE_T actual;
+  size_t j;
+  int8_t ret;
+
+  for (size_t e = 0; e < entries.size(); e++) {
+    codes[e] = 404;
+    j = stFind(entries[e].path);
+    if (j == ST_VARS)
+      continue;
+    (*found)++;
+    ret = stExpected(stVars[j].type, stVars[j].size, stVars[j].readOnly, entries[e].item.data(), entries[e].item.size(),
+                     (uint8_t *) data[j], &err, &actual);
+    codes[e] = (ret == LOLAN_RETVAL_YES) ? 200 : (err == LVUFC_READONLY) ? 405 : (err == LVUFC_MISMATCH) ? 472 : 473;
+    if (ret == LOLAN_RETVAL_YES)
+      (*updated)++;
+  }
+}
+
+// random New Style SET requests: sorted or shuffled, with unknown paths, invalid keys and too deep maps
+static void stNewStyleRun(unsigned requests, bool many)
+{
+  std::vector<std::vector<uint8_t> > items = stItems();
+  std::vector<StEntry> entries;
+  std::vector<uint8_t> payload, buf(LOLAN_PACKET_MAX_PAYLOAD_SIZE), reply(LOLAN_PACKET_MAX_PAYLOAD_SIZE);
+  std::vector<uint16_t> codes;
+  static uint64_t expData[ST_VARS][2];
+  size_t found, updated, notfound, invalid, statusSize;
+  bool toodeep, sorted;
+  lolan_Packet lp, rp;
+  CborEncoder enc;
+  int8_t ret;
+
+  for (unsigned r = 0; r < requests; r++) {
+    /* request entries */
+    entries.clear();
+    sorted = (stRandom() % 2 == 0);
+    for (size_t j = 0; j < ST_VARS; j++) {
+      if (many || (stRandom() % 8 == 0))
+        entries.push_back({ std::vector<uint16_t>(stVars[j].p.begin(), stVars[j].p.end()), stValue(j, items, many) });
+    }
+    if (!many) {
+      if (stRandom() % 3 == 0)
+        entries.push_back({ { (uint16_t) (1 + stRandom() % 3), (uint16_t) (200 + stRandom() % 50) }, stValue(0, items, false) });
+      if (stRandom() % 3 == 0)
+        entries.push_back({ { 4, (uint16_t) (1 + stRandom() % 30), 9 }, stValue(0, items, false) });
+      if (stRandom() % 4 == 0)
+        entries.push_back({ { 7 }, stValue(0, items, false) });
+      if (stRandom() % 4 == 0)
+        entries.push_back({ { 300 }, stValue(0, items, false) });   // (invalid key)
+      if (stRandom() % 4 == 0)
+        entries.push_back({ std::vector<uint16_t>(LOLAN_REGMAP_DEPTH + 1, 5), stValue(0, items, false) });   // (too deep)
+    }
+    if (sorted) {
+      std::sort(entries.begin(), entries.end(), [](const StEntry &a, const StEntry &b) {
+        std::vector<uint16_t> pa(a.path), pb(b.path);
+        pa.resize(LOLAN_REGMAP_DEPTH + 1);
+        pb.resize(LOLAN_REGMAP_DEPTH + 1);
+        return pa < pb;
+      });
+      if (many && (stRandom() % 2 == 0)) {   // a variable before the previous ones (after the status codes are full)
+        size_t k = stRandom() % 4;
+        entries.push_back(entries[k]);
+        entries.erase(entries.begin() + k);
+      }
+    } else {
+      for (size_t k = entries.size(); k > 1; k--)
+        std::swap(entries[k - 1], entries[stRandom() % k]);
+    }
+    payload = stNewStyle(entries, stRandom() % 2 == 0);
+    while (payload.size() > LOLAN_PACKET_MAX_PAYLOAD_SIZE) {   // (does not fit in a packet)
+      entries.erase(entries.begin() + entries.size() / 2);
+      payload = stNewStyle(entries, stRandom() % 2 == 0);
+    }
+
+    /* expected updates */
+    memcpy(expData, stData, sizeof(stData));
+    found = updated = notfound = invalid = 0;
+    toodeep = false;
+    codes.assign(entries.size(), 0);
+    stApply(entries, expData, &found, &updated, codes.data());
+    for (const StEntry &e : entries) {
+      if (e.path.size() > LOLAN_REGMAP_DEPTH)
+        toodeep = true;
+      else if (e.path[0] > 255)
+        invalid++;
+      else if (stFind(e.path) == ST_VARS)
+        notfound++;
+    }
+
+    /* single-pass reply */
+    lp = stPacket(payload);
+    rp.payload = reply.data();
+    ret = lolan_processSet(&sctx, &lp, &rp);
+    CHECK(ret == LOLAN_RETVAL_YES);
+    if (ret != LOLAN_RETVAL_YES)
+      continue;
+    CHECK(memcmp(stData, expData, sizeof(stData)) == 0);
+    CHECK((rp.packetType == LOLAN_PAK_ACK) && (rp.packetCounter == lp.packetCounter) && (rp.toId == lp.fromId));
+
+    /* two-pass reply: the status codes by the AUX flags (in the same space) */
+    buf.assign(LOLAN_PACKET_MAX_PAYLOAD_SIZE, 0);
+    buf[0] = 0xbf;
+    buf[1] = 0x00;
+    std::vector<uint8_t> head;
+    stHead(head, 0, stMainCode(invalid || toodeep || notfound || (found > updated), found, updated));
+    memcpy(&buf[2], head.data(), head.size());
+    cbor_encoder_init(&enc, &buf[2 + head.size()], LOLAN_PACKET_MAX_PAYLOAD_SIZE - 5 - 1, 0);
+    ret = lolanVarFlagToCbor(&sctx, LOLAN_REGMAP_AUX_BIT, &enc, false, true);
+    CHECK((ret == LOLAN_RETVAL_YES) || ((ret == LOLAN_RETVAL_NO) && (found == 0)));
+    statusSize = (ret == LOLAN_RETVAL_YES) ? cbor_encoder_get_buffer_size(&enc, &buf[2 + head.size()]) : 0;
+    buf[2 + head.size() + statusSize] = 0xff;
+    buf.resize(2 + head.size() + statusSize + 1);
+    if (!(invalid || toodeep || notfound || (found > updated)) && LOLAN_SET_SHORT_REPLY_IF_OK)
+      buf = { 0xbf, 0x00, 0x18, 200, 0xff };
+    CHECK(std::vector<uint8_t>(rp.payload, rp.payload + rp.payloadSize) == buf);
+  }
+}
+
+// Old Style SET requests of a base path (the reply is encoded here, in the order of the request)
+static void stOldStyleRun(unsigned requests)
+{
+  std::vector<std::vector<uint8_t> > items = stItems();
+  std::vector<StEntry> entries;
+  std::vector<uint8_t> base, payload, expected, reply(LOLAN_PACKET_MAX_PAYLOAD_SIZE);
+  std::vector<uint16_t> codes;
+  static uint64_t expData[ST_VARS][2];
+  size_t found, updated, n;
+  bool problems, zeroFirst;
+  lolan_Packet lp, rp;
+  size_t j;
+
+  for (unsigned r = 0; r < requests; r++) {
+    /* a base path with its variables (and unknown keys) */
+    j = stRandom() % ST_VARS;
+    base.assign(stVars[j].p.begin(), stVars[j].p.end() - 1);
+    entries.clear();
+    for (n = stRandom() % 10; n > 0; n--) {
+      std::vector<uint16_t> path(base.begin(), base.end());
+      j = stRandom() % ST_VARS;
+      path.push_back((stRandom() % 5 == 0) ? 1 + stRandom() % 255 : stVars[j].p.back());
+      entries.push_back({ path, stValue((stFind(path) == ST_VARS) ? j : stFind(path), items, false) });
+    }
+    problems = false;
+    if (stRandom() % 5 == 0) {
+      entries.insert(entries.begin() + stRandom() % (entries.size() + 1), { { 300 }, { 0x01 } });   // (invalid key, no status)
+      problems = true;
+    }
+
+    /* payload: the zero key entry with the base path first or last */
+    zeroFirst = (stRandom() % 2 == 0);
+    payload.clear();
+    stHead(payload, 5, entries.size() + 1);
+    if (zeroFirst) {
+      payload.push_back(0x00);
+      stHead(payload, 4, base.size());
+      payload.insert(payload.end(), base.begin(), base.end());
+    }
+    for (const StEntry &e : entries) {
+      stHead(payload, 0, e.path.back());
+      payload.insert(payload.end(), e.item.begin(), e.item.end());
+    }
+    if (!zeroFirst) {
+      payload.push_back(0x00);
+      stHead(payload, 4, base.size());
+      payload.insert(payload.end(), base.begin(), base.end());
+    }
+
+    /* expected updates and reply */
+    memcpy(expData, stData, sizeof(stData));
+    found = updated = 0;
+    codes.assign(entries.size(), 0);
+    stApply(entries, expData, &found, &updated, codes.data());
+    expected.assign(1, 0xbf);
+    n = 0;
+    for (size_t e = 0; e < entries.size(); e++) {
+      if (entries[e].path.back() > 255)
+        continue;
+      stHead(expected, 0, entries[e].path.back());
+      stHead(expected, 0, codes[e]);
+      problems = problems || (codes[e] != 200);
+      n++;
+    }
+    expected.push_back(0x00);
+    stHead(expected, 0, stMainCode(problems, n, updated));
+    expected.push_back(0xff);
+    if (!problems && LOLAN_SET_SHORT_REPLY_IF_OK)
+      expected = { 0xa1, 0x00, 0x18, 200 };
+
+    lp = stPacket(payload);
+    rp.payload = reply.data();
+    CHECK(lolan_processSet(&sctx, &lp, &rp) == LOLAN_RETVAL_YES);
+    CHECK(memcmp(stData, expData, sizeof(stData)) == 0);
+    CHECK(std::vector<uint8_t>(rp.payload, rp.payload + rp.payloadSize) == expected);
+  }
+}
+
+// lolanVarCborSize() and the size of the lolanVarToCbor() output with random values
+static void stCborSize()
+{
+  uint8_t buf[32];
+  CborEncoder enc;
+  LR_SIZE_T i;
+
+  for (size_t j = 0; j < stVars.size(); j++) {
+    i = lolanRegMapFindByPtr(&sctx, stData[j]);
+    for (int r = 0; r < 64; r++) {
+      stData[j][0] = stRandom64();
+      if (stVars[j].type == LOLAN_INT)   // (negative values of every width)
+        stStore((uint8_t *) stData[j], stVars[j].size, (r % 2) ? ~stRandom64() : stRandom64());
+      if (stVars[j].type == LOLAN_STR)
+        ((uint8_t *) stData[j])[r % stVars[j].size] = 0;
+#ifdef LOLAN_ALLOW_VARLEN_LOLANDATA
+      if (stVars[j].type == LOLAN_DATA)
+        LRM_SIZEACTUAL(&sctx, i) = 1 + r % stVars[j].size;
+#endif
+      cbor_encoder_init(&enc, buf, sizeof(buf), 0);
+      CHECK(lolanVarToCbor(&sctx, NULL, i, &enc) == LOLAN_RETVAL_YES);
+      CHECK(lolanVarCborSize(&sctx, i) == cbor_encoder_get_buffer_size(&enc, buf));
+    }
+    memset(stData[j], 0, sizeof(stData[j]));
+  }
+}
+
+static void testSet()
+{
+  testUpdateKernels();
+  stCtx();
+  stNewStyleRun(3000, false);
+  stNewStyleRun(300, true);   // (the status codes do not fit in the reply with a large register map)
+  stOldStyleRun(3000);
+  stCborSize();
+}
+
+#ifdef LOLAN_PREPARED_INFORM_SIZE
+// canonical text of a CBOR data item (the integer widths and the container lengths are not visible)
+static void stDump(CborValue *it, std::string &s)
+{
+  CborValue sub;
+  uint64_t u;
+  float f;
+  double d;
+
+  switch (cbor_value_get_type(it)) {
+    case CborIntegerType:
+      cbor_value_get_raw_integer(it, &u);
+      s += (cbor_value_is_unsigned_integer(it) ? "+" : "-") + std::to_string(u) + " ";
+      break;
+    case CborFloatType:
+      cbor_value_get_float(it, &f);
+      memcpy(&u, &f, 4);
+      s += "f" + std::to_string((uint32_t) u) + " ";
+      break;
+    case CborDoubleType:
+      cbor_value_get_double(it, &d);
+      memcpy(&u, &d, 8);
+      s += "d" + std::to_string(u) + " ";
+      break;
+    case CborMapType:
+    case CborArrayType:
+      s += cbor_value_is_map(it) ? "{ " : "[ ";
+      cbor_value_enter_container(it, &sub);
+      while (!cbor_value_at_end(&sub))
+        stDump(&sub, s);
+      cbor_value_leave_container(it, &sub);
+      s += "} ";
+      return;
+    default:
+      s += "? ";
+      break;
+  }
+  cbor_value_advance(it);
+}
+
+static std::string stDump(const lolan_Packet &lp)
+{
+  CborParser parser;
+  CborValue it;
+  std::string s;
+
+  if (cbor_parser_init(lp.payload, lp.payloadSize, 0, &parser, &it) != CborNoError)
+    return "error";
+  stDump(&it, s);
+  return s;
+}
+
+// size of a CBOR unsigned integer
+static size_t stUintSize(uint64_t v)
+{
+  return (v < 24) ? 1 : (v <= UINT8_MAX) ? 2 : (v <= UINT16_MAX) ? 3 : (v <= UINT32_MAX) ? 5 : 9;
+}
+
+// payload size of a prepared INFORM (the values are encoded with the full width of the variables)
+static size_t stPreparedSize(std::vector<size_t> sel)
+{
+  const std::vector<uint8_t> *last = NULL;
+  bool oldStyle = !LOLAN_FORCE_NEW_STYLE_INFORM;
+  size_t size, depth, lvl;
+
+  std::sort(sel.begin(), sel.end(), [](size_t a, size_t b) { return stVars[a].p < stVars[b].p; });
+  const std::vector<uint8_t> &base = stVars[sel[0]].p;
+  depth = base.size();
+  for (size_t k : sel) {
+    if ((stVars[k].p.size() != depth) || !std::equal(base.begin(), base.end() - 1, stVars[k].p.begin()))
+      oldStyle = false;
+  }
+  if (oldStyle) {   // root map, base path
+    size = stUintSize((depth > 1) ? sel.size() + 1 : sel.size());
+    if (depth > 1) {
+      size += 1 + stUintSize(depth - 1);
+      for (lvl = 0; lvl < depth - 1; lvl++)
+        size += stUintSize(base[lvl]);
+    }
+  } else {   // root map, status code, break
+    size = 1 + 1 + stUintSize(299) + 1;
+  }
+  for (size_t k : sel) {
+    const std::vector<uint8_t> &p = stVars[k].p;
+    if (!oldStyle) {   // nested maps (key, map, break) not shared with the previous variable
+      lvl = 0;
+      while ((last != NULL) && (lvl + 1 < last->size()) && (lvl + 1 < p.size()) && (p[lvl] == (*last)[lvl]))
+        lvl++;
+      for (; lvl + 1 < p.size(); lvl++)
+        size += stUintSize(p[lvl]) + 2;
+    }
+    size += stUintSize(p.back()) + 1 + stVars[k].size;   // key, value
+    last = &p;
+  }
+  return size;
+}
+
+// prepared INFORM of random INT/UINT/FLOAT variables vs. lolan_createInform() of the same variables
+static void testPrepared()
+{
+  static lolan_PreparedInform pi;
+  std::vector<uint8_t> p1(LOLAN_PACKET_MAX_PAYLOAD_SIZE), p2(LOLAN_PACKET_MAX_PAYLOAD_SIZE);
+  std::vector<size_t> cand, sel;
+  std::vector<const void *> ptrs;
+  lolan_Packet inform, prepared;
+  size_t j;
+
+  stCtx();
+  for (unsigned r = 0; r < 2000; r++) {
+    /* variables of a base path (old style) or anywhere */
+    j = stRandom() % ST_VARS;
+    cand.clear();
+    for (size_t k = 0; k < ST_VARS; k++) {
+      if ((stVars[k].type == LOLAN_STR) || (stVars[k].type == LOLAN_DATA))
+        continue;
+      if ((r % 2 == 0) || ((stVars[k].p.size() == stVars[j].p.size())
+          && std::equal(stVars[k].p.begin(), stVars[k].p.end() - 1, stVars[j].p.begin())))
+        cand.push_back(k);
+    }
+    for (size_t k = cand.size(); k > 1; k--)
+      std::swap(cand[k - 1], cand[stRandom() % k]);
+    sel.assign(cand.begin(), cand.begin() + 1 + stRandom() % std::min<size_t>(cand.size(), LOLAN_PREPARED_INFORM_SIZE));
+    ptrs.clear();
+    for (size_t k : sel)
+      ptrs.push_back(stData[k]);
+    inform.payload = p1.data();
+    prepared.payload = p2.data();
+    if (stPreparedSize(sel) > LOLAN_PACKET_MAX_PAYLOAD_SIZE) {   // (not even a previous preparation can be used)
+      CHECK(lolan_prepareInform(&sctx, &pi, ptrs.data(), ptrs.size()) == LOLAN_RETVAL_MEMERROR);
+      CHECK(lolan_createPreparedInform(&sctx, &pi, &prepared, false) == LOLAN_RETVAL_GENERROR);
+      continue;
+    }
+    CHECK(lolan_prepareInform(&sctx, &pi, ptrs.data(), ptrs.size()) == LOLAN_RETVAL_YES);
+
+    /* new values (after the preparation) */
+    lolanFlagClearAll(&sctx, LOLAN_REGMAP_LOCAL_UPDATE_BIT | LOLAN_REGMAP_INFORM_REQUEST_BIT);
+    for (size_t k : sel) {
+      stStore((uint8_t *) stData[k], stVars[k].size, (stRandom() % 2) ? ~stRandom64() : stRandom64());
+      lolanFlagSet(&sctx, lolanRegMapFindByPtr(&sctx, stData[k]), LOLAN_REGMAP_LOCAL_UPDATE_BIT | LOLAN_REGMAP_INFORM_REQUEST_BIT);
+    }
+    CHECK(lolan_createInform(&sctx, &inform, true) == LOLAN_RETVAL_YES);
+    CHECK(lolan_createPreparedInform(&sctx, &pi, &prepared, false) == LOLAN_RETVAL_YES);
+    CHECK(lolanFlagNext(&sctx, LOLAN_REGMAP_LOCAL_UPDATE_BIT, 0) >= LOLAN_REGMAP_SIZE);   // (all reported)
+    CHECK((prepared.packetType == LOLAN_PAK_INFORM) && (prepared.fromId == inform.fromId));
+    CHECK(stDump(prepared) == stDump(inform));
+  }
+}
+#endif
+
+/* CBOR payload cursor: fixed validation vectors, and random items walked with the cursor (compared with their encoding and tinycbor) */
+struct CbVector {       // CBOR data in hexadecimal and the expected result of lolanCborValidate()
+  const char *hex;
+  int8_t result;
+};
+
+struct CbNode {         // encoded CBOR data item (offsets in the data)
+  size_t start;         // first tag (or the head)
+  size_t head;          // initial byte of the item
+  size_t end;           // after the item
+  size_t ord;           // number of container heads before the item
+  size_t nextOrd;       // number of container heads before the end of the item
+  unsigned nesting;     // number of nested containers (0: not a map or array)
+  uint8_t major;
+  bool indefinite;
+  uint64_t arg;         // argument of the head (integer, simple value)
+  std::vector<uint8_t> str;   // content of a string
+  std::vector<CbNode> items;  // items of an array or map (keys and values)
+};
+
+static const CbVector cbVectors[] = {
+  /* valid */
+  { "00", LOLAN_RETVAL_YES }, { "1818", LOLAN_RETVAL_YES }, { "190100", LOLAN_RETVAL_YES },
+  { "1a00010000", LOLAN_RETVAL_YES }, { "1b0000000100000000", LOLAN_RETVAL_YES }, { "3bffffffffffffffff", LOLAN_RETVAL_YES },
+  { "40", LOLAN_RETVAL_YES }, { "4401020304", LOLAN_RETVAL_YES }, { "6161", LOLAN_RETVAL_YES },
+  { "5fff", LOLAN_RETVAL_YES }, { "5f41014202035800ff", LOLAN_RETVAL_YES }, { "7f61616162ff", LOLAN_RETVAL_YES },
+  { "80", LOLAN_RETVAL_YES }, { "8301820203820405", LOLAN_RETVAL_YES }, { "9fff", LOLAN_RETVAL_YES },
+  { "9f019f02ffff", LOLAN_RETVAL_YES }, { "a0", LOLAN_RETVAL_YES }, { "a201020304", LOLAN_RETVAL_YES },
+  { "bfff", LOLAN_RETVAL_YES }, { "bf0102bf03a0ffff", LOLAN_RETVAL_YES },
+  { "bf00ff", LOLAN_RETVAL_YES },   // (the pairs of an indefinite length map are checked by the walk)
+  { "c11a514b67b0", LOLAN_RETVAL_YES }, { "c1d81701", LOLAN_RETVAL_YES }, { "d8174101", LOLAN_RETVAL_YES },
+  { "81c1c200", LOLAN_RETVAL_YES }, { "f4", LOLAN_RETVAL_YES }, { "f7", LOLAN_RETVAL_YES }, { "f820", LOLAN_RETVAL_YES },
+  { "f8ff", LOLAN_RETVAL_YES }, { "f93c00", LOLAN_RETVAL_YES }, { "fa3f800000", LOLAN_RETVAL_YES },
+  { "fb3ff0000000000000", LOLAN_RETVAL_YES },
+  /* truncated */
+  { "", LOLAN_RETVAL_CBORERROR }, { "18", LOLAN_RETVAL_CBORERROR }, { "1901", LOLAN_RETVAL_CBORERROR },
+  { "1a000000", LOLAN_RETVAL_CBORERROR }, { "1b00000000000000", LOLAN_RETVAL_CBORERROR }, { "38", LOLAN_RETVAL_CBORERROR },
+  { "5901", LOLAN_RETVAL_CBORERROR }, { "9a000000", LOLAN_RETVAL_CBORERROR }, { "d8", LOLAN_RETVAL_CBORERROR },
+  { "f9", LOLAN_RETVAL_CBORERROR }, { "fa000000", LOLAN_RETVAL_CBORERROR }, { "fb00000000000000", LOLAN_RETVAL_CBORERROR },
+  { "41", LOLAN_RETVAL_CBORERROR }, { "6261", LOLAN_RETVAL_CBORERROR }, { "5bffffffffffffffff00", LOLAN_RETVAL_CBORERROR },
+  { "8201", LOLAN_RETVAL_CBORERROR }, { "a2010203", LOLAN_RETVAL_CBORERROR }, { "a101", LOLAN_RETVAL_CBORERROR },
+  { "9bffffffffffffffff00", LOLAN_RETVAL_CBORERROR }, { "bb8000000000000000", LOLAN_RETVAL_CBORERROR },
+  { "b90002000000", LOLAN_RETVAL_CBORERROR }, { "c1", LOLAN_RETVAL_CBORERROR }, { "c1c1", LOLAN_RETVAL_CBORERROR },
+  /* reserved additional information */
+  { "1c", LOLAN_RETVAL_CBORERROR }, { "1d", LOLAN_RETVAL_CBORERROR }, { "1e", LOLAN_RETVAL_CBORERROR },
+  { "5c", LOLAN_RETVAL_CBORERROR }, { "9d", LOLAN_RETVAL_CBORERROR }, { "dc00", LOLAN_RETVAL_CBORERROR },
+  { "fc", LOLAN_RETVAL_CBORERROR }, { "fd", LOLAN_RETVAL_CBORERROR }, { "fe", LOLAN_RETVAL_CBORERROR },
+  /* indefinite lengths and breaks */
+  { "1f", LOLAN_RETVAL_CBORERROR }, { "3f", LOLAN_RETVAL_CBORERROR }, { "df00", LOLAN_RETVAL_CBORERROR },
+  { "ff", LOLAN_RETVAL_CBORERROR }, { "9f", LOLAN_RETVAL_CBORERROR }, { "9f01", LOLAN_RETVAL_CBORERROR },
+  { "bf", LOLAN_RETVAL_CBORERROR }, { "bf0102", LOLAN_RETVAL_CBORERROR }, { "9f9fff", LOLAN_RETVAL_CBORERROR },
+  { "81ff", LOLAN_RETVAL_CBORERROR }, { "a1ff", LOLAN_RETVAL_CBORERROR }, { "a101ff", LOLAN_RETVAL_CBORERROR },
+  { "8201ff", LOLAN_RETVAL_CBORERROR }, { "c1ff", LOLAN_RETVAL_CBORERROR }, { "9fc1ff", LOLAN_RETVAL_CBORERROR },
+  { "5f", LOLAN_RETVAL_CBORERROR }, { "5f41", LOLAN_RETVAL_CBORERROR }, { "5f4101", LOLAN_RETVAL_CBORERROR },
+  { "5f6161ff", LOLAN_RETVAL_CBORERROR }, { "7f4161ff", LOLAN_RETVAL_CBORERROR }, { "5f00ff", LOLAN_RETVAL_CBORERROR },
+  { "5f5fffff", LOLAN_RETVAL_CBORERROR }, { "5f5c", LOLAN_RETVAL_CBORERROR }, { "5f58", LOLAN_RETVAL_CBORERROR },
+  { "5fc14101ff", LOLAN_RETVAL_CBORERROR },
+  /* illegal simple values */
+  { "f800", LOLAN_RETVAL_CBORERROR }, { "f81f", LOLAN_RETVAL_CBORERROR }, { "f8", LOLAN_RETVAL_CBORERROR },
+};
+
+static uint32_t cbRnd = 2024;
+
+static uint32_t cbRandom()
+{
+  cbRnd = cbRnd * 1103515245u + 12345u;
+  return cbRnd >> 8;
+}
+
+static std::vector<uint8_t> cbHex(const char *hex)
+{
+  std::vector<uint8_t> b;
+
+  for (; hex[0] && hex[1]; hex += 2)
+    b.push_back((uint8_t) strtoul(std::string(hex, 2).c_str(), NULL, 16));
+  return b;
+}
+
+// CBOR head with an argument of n bytes (0: in the initial byte), not always in the shortest form
+static void cbHead(std::vector<uint8_t> &b, uint8_t major, uint64_t arg, int n)
+{
+  major <<= 5;
+  if (n == 0) {
+    b.push_back(major | arg);
+    return;
+  }
+  b.push_back(major | ((n == 1) ? 24 : (n == 2) ? 25 : (n == 4) ? 26 : 27));
+  for (int k = n - 1; k >= 0; k--)
+    b.push_back(arg >> (8 * k));
+}
+
+static void cbRandomHead(std::vector<uint8_t> &b, uint8_t major, uint64_t arg)
+{
+  int n;
+
+  n = (arg < 24) ? 0 : (arg <= UINT8_MAX) ? 1 : (arg <= UINT16_MAX) ? 2 : (arg <= UINT32_MAX) ? 4 : 8;
+  if ((n < 8) && (cbRandom() % 4 == 0))   // (a wider argument)
+    n = (n == 0) ? 1 : 2 * n;
+  cbHead(b, major, arg, n);
+}
+
+// random CBOR data item (often containers, also empty ones, tags, chunked strings, every head width)
+static void cbItem(std::vector<uint8_t> &b, CbNode &node, unsigned depth, size_t &ord)
+{
+  static const uint64_t tags[] = { 1, 3, 22, 23, 24, 55799 };
+  unsigned kind, count;
+
+  node.start = b.size();
+  while (cbRandom() % 8 == 0)
+    cbRandomHead(b, 6, tags[cbRandom() % 6]);
+  node.head = b.size();
+  node.ord = ord;
+  node.indefinite = false;
+  node.arg = 0;
+  node.nesting = 0;
+  kind = cbRandom() % ((depth < LOLAN_CBOR_MAX_NESTING) ? 10 : 6);
+  switch (kind) {
+    case 0:   // integer
+    case 1:
+      node.major = kind;
+      node.arg = (cbRandom() % 2) ? cbRandom() % 30 : ((uint64_t) cbRandom() << 40) ^ cbRandom();
+      node.arg >>= cbRandom() % 64;
+      cbRandomHead(b, node.major, node.arg);
+      break;
+    case 2:   // string
+    case 3:
+      node.major = 2 + cbRandom() % 2;
+      node.indefinite = (cbRandom() % 3 == 0);
+      if (node.indefinite) {
+        ord++;
+        b.push_back((node.major << 5) | 31);
+        for (count = cbRandom() % 4; count > 0; count--) {   // chunks
+          size_t len = cbRandom() % 4;
+          cbRandomHead(b, node.major, len);
+          for (size_t k = 0; k < len; k++) {
+            node.str.push_back(cbRandom());
+            b.push_back(node.str.back());
+          }
+        }
+        b.push_back(0xff);
+      } else {
+        size_t len = cbRandom() % 6;
+        cbRandomHead(b, node.major, len);
+        for (size_t k = 0; k < len; k++) {
+          node.str.push_back(cbRandom());
+          b.push_back(node.str.back());
+        }
+      }
+      break;
+    case 4:   // simple value or floating-point number
+    case 5: {
+      static const uint8_t ibs[] = { 0xf4, 0xf5, 0xf6, 0xf7, 0xf0, 0xf8, 0xf9, 0xfa, 0xfb };
+      uint8_t ib = ibs[cbRandom() % 9];
+      int n = (ib == 0xf8) ? 1 : (ib == 0xf9) ? 2 : (ib == 0xfa) ? 4 : (ib == 0xfb) ? 8 : 0;
+
+      node.major = 7;
+      node.arg = (ib < 0xf8) ? (ib & 0x1f) : ((uint64_t) cbRandom() << 40) ^ cbRandom();
+      if ((n > 0) && (n < 8)) node.arg &= ((uint64_t) 1 << (8 * n)) - 1;
+      if ((ib == 0xf8) && (node.arg < 32)) node.arg += 32;   // (not an illegal simple value)
+      b.push_back(ib);
+      for (int k = n - 1; k >= 0; k--)
+        b.push_back(node.arg >> (8 * k));
+      break;
+    }
+    default:   // array or map (wide arrays of empty containers exceed the container index)
+      node.major = 4 + cbRandom() % 2;
+      node.indefinite = (cbRandom() % 3 == 0);
+      ord++;
+      count = (cbRandom() % 16 == 0) ? 10 + cbRandom() % 30 : cbRandom() % ((depth < 2) ? 5 : 3);
+      if (node.major == 5) count = (count + 1) / 2;
+      if (node.indefinite)
+        b.push_back((node.major << 5) | 31);
+      else
+        cbRandomHead(b, node.major, count);
+      node.items.resize((node.major == 5) ? 2 * count : count);
+      for (auto &item : node.items) {
+        if ((count >= 10) && (depth + 1 < LOLAN_CBOR_MAX_NESTING)) {   // empty container
+          item.start = item.head = b.size();
+          item.ord = ord++;
+          item.major = 4 + cbRandom() % 2;
+          item.indefinite = (cbRandom() % 2 == 0);
+          item.arg = 0;
+          item.nesting = 1;
+          b.push_back(item.indefinite ? ((item.major << 5) | 31) : (item.major << 5));
+          if (item.indefinite) b.push_back(0xff);
+          item.end = b.size();
+          item.nextOrd = ord;
+        } else {
+          cbItem(b, item, depth + 1, ord);
+        }
+        node.nesting = std::max(node.nesting, item.nesting);
+      }
+      node.nesting++;
+      if (node.indefinite)
+        b.push_back(0xff);
+      break;
+  }
+  node.end = b.size();
+  node.nextOrd = ord;
+}
+
+// the containers of an item in the order of their heads
+static void cbContainers(const CbNode &node, std::vector<const CbNode *> &list)
+{
+  if ((node.major == 4) || (node.major == 5) || (((node.major == 2) || (node.major == 3)) && node.indefinite))
+    list.push_back(&node);
+  for (auto &item : node.items)
+    cbContainers(item, list);
+}
+
+// walk an item with the cursor (entered or skipped at random), the positions are compared with the encoding
+static void cbWalk(const CbNode &node, lolan_CborCursor *cur, const std::vector<uint8_t> &data)
+{
+  lolan_CborCursor child;
+  CborParser parser;
+  CborValue it;
+  std::vector<uint8_t> s;
+  const uint8_t *chunk, *pos;
+  size_t remaining, n;
+
+  remaining = cur->remaining;
+  CHECK(cur->ptr == &data[node.start]);
+  CHECK(cur->ord == node.ord);
+  while (cur->ptr < &data[node.head]) {   // tags (not counted)
+    lolanCborCursorAdvance(cur);
+    CHECK(cur->remaining == remaining);
+  }
+  CHECK(cur->ptr == &data[node.head]);
+
+  /* the end of the item by tinycbor (it skips up to 10 nested containers) */
+  if (node.nesting <= 10) {
+    CHECK(cbor_parser_init(&data[node.head], data.size() - node.head, 0, &parser, &it) == CborNoError);
+    CHECK((cbor_value_advance(&it) == CborNoError) && (cbor_value_get_next_byte(&it) == &data[node.end]));
+  }
+
+  if (((node.major == 4) || (node.major == 5)) && (cbRandom() % 2)) {   // enter
+    lolanCborCursorEnter(cur, &child);
+    CHECK(child.remaining == (node.indefinite ? LOLAN_CBOR_INDEFINITE : node.items.size()));
+    for (auto &item : node.items) {
+      CHECK(!LOLAN_CBOR_AT_END(&child));
+      cbWalk(item, &child, data);
+    }
+    CHECK(LOLAN_CBOR_AT_END(&child));
+    lolanCborCursorLeave(cur, &child);
+  } else {
+    if (node.major <= 1) {
+      CHECK(LOLAN_CBOR_IS_INTEGER(cur) && (lolanCborCursorGetUint(cur) == node.arg));
+    } else if (node.major == 7) {
+      CHECK(lolanCborCursorGetUint(cur) == node.arg);
+    } else if (node.major <= 3) {
+      CHECK(lolanCborCursorStringLength(cur) == node.str.size());
+      s.assign(node.str.size() + 1, 0xaa);
+      lolanCborCursorCopyString(cur, s.data(), s.size());
+      CHECK(std::equal(node.str.begin(), node.str.end(), s.begin()) && (s.back() == 0));
+      s.clear();
+      pos = NULL;
+      while ((chunk = lolanCborCursorStringChunk(cur, &pos, &n)) != NULL)
+        s.insert(s.end(), chunk, chunk + n);
+      CHECK(s == node.str);
+    }
+    CHECK(LOLAN_CBOR_IS_MAP(cur) == (node.major == 5));
+    lolanCborCursorAdvance(cur);   // (skipped by the index or by walking)
+  }
+  CHECK(cur->ptr == &data[node.end]);
+  CHECK(cur->ord == node.nextOrd);
+  CHECK(cur->remaining == ((remaining == LOLAN_CBOR_INDEFINITE) ? remaining : remaining - 1));
+}
+
+// nested containers of one kind around an integer
+static std::vector<uint8_t> cbNested(const char *open, const char *close, unsigned levels)
+{
+  std::vector<uint8_t> b, o = cbHex(open), c = cbHex(close);
+
+  for (unsigned k = 0; k < levels; k++)
+    b.insert(b.end(), o.begin(), o.end());
+  b.push_back(0x00);
+  for (unsigned k = 0; k < levels; k++)
+    b.insert(b.end(), c.begin(), c.end());
+  return b;
+}
+
+static void testCbor()
+{
+  static const char * const nestings[][2] = { { "81", "" }, { "9f", "ff" }, { "a100", "" }, { "bf00", "ff" } };
+  lolan_CborIndex idx;
+  lolan_CborCursor cur;
+  std::vector<const CbNode *> list;
+  std::vector<uint8_t> data;
+  CbNode root;
+  size_t ord;
+
+  /* fixed vectors (the strict prefixes of a valid item are truncated) */
+  for (const CbVector &v : cbVectors) {
+    data = cbHex(v.hex);
+    CHECK(lolanCborValidate(&idx, data.data(), data.size()) == v.result);
+    if (v.result != LOLAN_RETVAL_YES)
+      continue;
+    for (size_t n = 0; n < data.size(); n++)
+      CHECK(lolanCborValidate(&idx, data.data(), n) == LOLAN_RETVAL_CBORERROR);
+    data.insert(data.end(), { 0xff, 0x18 });   // (the bytes after the root item are ignored)
+    CHECK(lolanCborValidate(&idx, data.data(), data.size()) == LOLAN_RETVAL_YES);
+  }
+  data = cbHex("9f9fff82a0bfffff");   // (container index)
+  CHECK(lolanCborValidate(&idx, data.data(), data.size()) == LOLAN_RETVAL_YES);
+  CHECK(idx.count == std::min(5, LOLAN_CBOR_INDEX_SIZE));
+  CHECK((idx.skip[0] == 8) && (idx.next[0] == 5));
+  if (LOLAN_CBOR_INDEX_SIZE >= 5) {
+    CHECK((idx.skip[1] == 3) && (idx.next[1] == 2));
+    CHECK((idx.skip[2] == 7) && (idx.next[2] == 5));
+    CHECK((idx.skip[3] == 5) && (idx.next[3] == 4));
+    CHECK((idx.skip[4] == 7) && (idx.next[4] == 5));
+  }
+
+  /* nesting limit */
+  for (auto &k : nestings) {
+    data = cbNested(k[0], k[1], LOLAN_CBOR_MAX_NESTING);
+    CHECK(lolanCborValidate(&idx, data.data(), data.size()) == LOLAN_RETVAL_YES);
+    data = cbNested(k[0], k[1], LOLAN_CBOR_MAX_NESTING + 1);
+    CHECK(lolanCborValidate(&idx, data.data(), data.size()) == LOLAN_RETVAL_CBORERROR);
+  }
+
+  /* more containers than the container index holds */
+  data = cbHex("9828");
+  for (unsigned k = 0; k < 40; k++)
+    data.push_back((k % 2) ? 0x80 : 0xa0);
+  CHECK(lolanCborValidate(&idx, data.data(), data.size()) == LOLAN_RETVAL_YES);
+  CHECK(idx.count == std::min(41, LOLAN_CBOR_INDEX_SIZE));
+  for (unsigned k = 1; k < idx.count; k++)
+    CHECK((idx.skip[k] == k + 2) && (idx.next[k] == k + 1));
+  lolanCborCursorRoot(&idx, &cur);
+  lolanCborCursorAdvance(&cur);
+  CHECK((cur.ptr == data.data() + data.size()) && (cur.ord == 41) && LOLAN_CBOR_AT_END(&cur));
+
+  /* random items */
+  for (unsigned r = 0; r < 20000; r++) {
+    data.clear();
+    root = CbNode();
+    ord = 0;
+    cbItem(data, root, 0, ord);
+    if (data.size() >= LOLAN_PACKET_MAX_PAYLOAD_SIZE)
+      continue;
+    list.clear();
+    cbContainers(root, list);
+    for (size_t n = 0; n < data.size(); n++)   // (truncated)
+      CHECK(lolanCborValidate(&idx, data.data(), n) == LOLAN_RETVAL_CBORERROR);
+    data.push_back(0xff);   // (ignored after the root item)
+    CHECK(lolanCborValidate(&idx, data.data(), data.size()) == LOLAN_RETVAL_YES);
+    CHECK(idx.count == std::min<size_t>(list.size(), LOLAN_CBOR_INDEX_SIZE));
+    for (size_t k = 0; k < idx.count; k++)
+      CHECK((idx.skip[k] == list[k]->end) && (idx.next[k] == list[k]->nextOrd));
+    lolanCborCursorRoot(&idx, &cur);
+    cbWalk(root, &cur, data);
+  }
+}
+
+/* JSON: fixed conversion vectors, the fixed size buffer and the growing buffer */
+struct JsVector {       // CBOR data in hexadecimal, conversion flags, the expected result and JSON text
+  const char *hex;
+  uint8_t flags;
+  int8_t result;
+  const char *json;
+};
+
+static const JsVector jsVectors[] = {
+  /* integers */
+  { "00", 0, LOLAN_RETVAL_YES, "0" }, { "17", 0, LOLAN_RETVAL_YES, "23" }, { "190100", 0, LOLAN_RETVAL_YES, "256" },
+  { "1a00989680", 0, LOLAN_RETVAL_YES, "10000000" },
+  { "1b0020000000000001", 0, LOLAN_RETVAL_YES, "9007199254740993" },   // (not exact in double)
+  { "1bffffffffffffffff", 0, LOLAN_RETVAL_YES, "18446744073709551615" }, { "20", 0, LOLAN_RETVAL_YES, "-1" },
+  { "3903e7", 0, LOLAN_RETVAL_YES, "-1000" }, { "3b7fffffffffffffff", 0, LOLAN_RETVAL_YES, "-9223372036854775808" },
+  { "3bffffffffffffffff", 0, LOLAN_RETVAL_YES, "-18446744073709551616" },
+  /* floating-point numbers */
+  { "fa3fc00000", 0, LOLAN_RETVAL_YES, "1.5" }, { "fa3dcccccd", 0, LOLAN_RETVAL_YES, "0.1" },
+  { "fac2f60000", 0, LOLAN_RETVAL_YES, "-123" }, { "fa7f7fffff", 0, LOLAN_RETVAL_YES, "3.4028235e+38" },
+  { "fb3fb999999999999a", 0, LOLAN_RETVAL_YES, "0.1" }, { "fb3fd5555555555555", 0, LOLAN_RETVAL_YES, "0.3333333333333333" },
+  { "fbc010000000000000", 0, LOLAN_RETVAL_YES, "-4" }, { "fb3ff0000000000001", 0, LOLAN_RETVAL_YES, "1.0000000000000002" },
+  { "fb43e158e460913d00", 0, LOLAN_RETVAL_YES, "10000000000000000000" },
+  { "fb4415af1d78b58c40", 0, LOLAN_RETVAL_YES, "1e+20" }, { "fb7e37e43c8800759c", 0, LOLAN_RETVAL_YES, "1e+300" },
+  { "fb8000000000000000", 0, LOLAN_RETVAL_YES, "-0" }, { "fb7ff0000000000000", 0, LOLAN_RETVAL_YES, "null" },
+  { "fbfff0000000000000", 0, LOLAN_RETVAL_YES, "null" }, { "fb7ff8000000000000", 0, LOLAN_RETVAL_YES, "null" },
+  { "fa7fc00000", 0, LOLAN_RETVAL_YES, "null" },
+  /* half precision (converted to float) */
+  { "f93c00", 0, LOLAN_RETVAL_YES, "1" }, { "f93e00", 0, LOLAN_RETVAL_YES, "1.5" }, { "f9c400", 0, LOLAN_RETVAL_YES, "-4" },
+  { "f97bff", 0, LOLAN_RETVAL_YES, "65504" }, { "f93555", 0, LOLAN_RETVAL_YES, "0.33325195" },
+  { "f90001", 0, LOLAN_RETVAL_YES, "0.000000059604645" }, { "f98000", 0, LOLAN_RETVAL_YES, "-0" },
+  { "f97c00", 0, LOLAN_RETVAL_YES, "null" }, { "f9fc00", 0, LOLAN_RETVAL_YES, "null" }, { "f97e00", 0, LOLAN_RETVAL_YES, "null" },
+  /* simple values */
+  { "f4", 0, LOLAN_RETVAL_YES, "false" }, { "f5", 0, LOLAN_RETVAL_YES, "true" }, { "f6", 0, LOLAN_RETVAL_YES, "null" },
+  { "f7", 0, LOLAN_RETVAL_YES, "\"undefined\"" }, { "f0", 0, LOLAN_RETVAL_YES, "\"simple(16)\"" },
+  { "f8ff", 0, LOLAN_RETVAL_YES, "\"simple(255)\"" },
+  /* text strings (escaping, UTF-8 is copied) */
+  { "60", 0, LOLAN_RETVAL_YES, "\"\"" }, { "63616263", 0, LOLAN_RETVAL_YES, "\"abc\"" },
+  { "6d225c080c0a0d09011f617fc3a9", 0, LOLAN_RETVAL_YES, "\"\\\"\\\\\\b\\f\\n\\r\\t\\u0001\\u001fa\x7f\xc3\xa9\"" },
+  { "7f626122610aff", 0, LOLAN_RETVAL_YES, "\"a\\\"\\n\"" }, { "7fff", 0, LOLAN_RETVAL_YES, "\"\"" },
+  /* byte strings (base64url, base64, hexadecimal, negative bignum) */
+  { "40", 0, LOLAN_RETVAL_YES, "\"\"" }, { "4101", 0, LOLAN_RETVAL_YES, "\"AQ\"" }, { "420102", 0, LOLAN_RETVAL_YES, "\"AQI\"" },
+  { "43010203", 0, LOLAN_RETVAL_YES, "\"AQID\"" }, { "44fbff0001", 0, LOLAN_RETVAL_YES, "\"-_8AAQ\"" },
+  { "5f41fb42ff004101ff", 0, LOLAN_RETVAL_YES, "\"-_8AAQ\"" },   // (groups across the chunks)
+  { "d644fbff0001", 0, LOLAN_RETVAL_YES, "\"+/8AAQ==\"" }, { "d65f41fb41ffff", 0, LOLAN_RETVAL_YES, "\"+/8=\"" },
+  { "d6d640", 0, LOLAN_RETVAL_YES, "\"\"" }, { "d74301abff", 0, LOLAN_RETVAL_YES, "\"01abff\"" },
+  { "4301abff", LOLAN_JSON_BYTES_HEX, LOLAN_RETVAL_YES, "\"01abff\"" },
+  { "d642fbff", LOLAN_JSON_BYTES_HEX, LOLAN_RETVAL_YES, "\"fbff\"" },
+  { "5f4101ff", LOLAN_JSON_BYTES_HEX, LOLAN_RETVAL_YES, "\"01\"" },
+  { "c3420102", 0, LOLAN_RETVAL_YES, "\"~AQI\"" }, { "d7d642fbff", 0, LOLAN_RETVAL_YES, "\"+/8=\"" },   // (innermost tag)
+  { "c11a514b67b0", 0, LOLAN_RETVAL_YES, "1363896240" },   // (other tags are skipped)
+  /* containers, map keys */
+  { "80", 0, LOLAN_RETVAL_YES, "[]" }, { "a0", 0, LOLAN_RETVAL_YES, "{}" }, { "9fff", 0, LOLAN_RETVAL_YES, "[]" },
+  { "83010203", 0, LOLAN_RETVAL_YES, "[1,2,3]" }, { "9f019f80ffa0ff", 0, LOLAN_RETVAL_YES, "[1,[[]],{}]" },
+  { "a201a1020563616263f5", 0, LOLAN_RETVAL_YES, "{\"1\":{\"2\":5},\"abc\":true}" },
+  { "a22000c10102", 0, LOLAN_RETVAL_YES, "{\"-1\":0,\"1\":2}" }, { "bf616101ff", 0, LOLAN_RETVAL_YES, "{\"a\":1}" },
+  { "a17f61616162ff00", 0, LOLAN_RETVAL_YES, "{\"ab\":0}" }, { "a1612260", 0, LOLAN_RETVAL_YES, "{\"\\\"\":\"\"}" },
+  { "a141010a", 0, LOLAN_RETVAL_GENERROR, "" }, { "a18000", 0, LOLAN_RETVAL_GENERROR, "" },
+  { "a1a000", 0, LOLAN_RETVAL_GENERROR, "" }, { "a1f500", 0, LOLAN_RETVAL_GENERROR, "" },
+  { "a1f93c0000", 0, LOLAN_RETVAL_GENERROR, "" }, { "a1fa3f80000000", 0, LOLAN_RETVAL_GENERROR, "" },
+  { "bff6f6ff", 0, LOLAN_RETVAL_GENERROR, "" }, { "8201a101a1f600", 0, LOLAN_RETVAL_GENERROR, "" },
+  /* invalid data */
+  { "", 0, LOLAN_RETVAL_CBORERROR, "" }, { "18", 0, LOLAN_RETVAL_CBORERROR, "" }, { "8201", 0, LOLAN_RETVAL_CBORERROR, "" },
+  { "bf00ff", 0, LOLAN_RETVAL_CBORERROR, "" }, { "bf010203ff", 0, LOLAN_RETVAL_CBORERROR, "" },   // (key without value)
+};
+
+static bool jsGrow(void *arg, lolan_JsonBuffer *jb, size_t size)
+{
+  std::vector<char> *v = (std::vector<char> *) arg;
+
+  if (size > 4096)   // (limit of the test)
+    return false;
+  v->resize(size);
+  jb->buf = v->data();
+  jb->size = v->size();
+  return true;
+}
+
+static void testJson()
+{
+  std::vector<uint8_t> data;
+  std::vector<char> buf, grown;
+  std::string json, all;
+  lolan_JsonBuffer jb, fixed;
+  const uint8_t zero[1] = { 0x00 };
+  size_t len;
+  int8_t err;
+
+  /* fixed vectors, appended to the text of the growing buffer */
+  lolan_jsonBufferInit(&jb, NULL, 0, jsGrow, &grown);
+  for (const JsVector &v : jsVectors) {
+    data = cbHex(v.hex);
+    err = lolan_cborToJson(data.data(), data.size(), &jb, v.flags);
+    CHECK(err == v.result);
+    if (err == LOLAN_RETVAL_YES)
+      all += v.json;
+    CHECK((jb.len == all.size()) && (jb.size > jb.len) && (jb.buf[jb.len] == 0) && (all == jb.buf));
+    CHECK(lolan_cborToJson(data.data(), data.size(), &jb, v.flags) == err);   // (the same after the other texts)
+    if (err == LOLAN_RETVAL_YES)
+      all += v.json;
+    CHECK((jb.len == all.size()) && (all == jb.buf));
+    if (err != LOLAN_RETVAL_YES)
+      continue;
+
+    /* fixed size buffer after a number: too small (the text is not modified) and large enough */
+    json = v.json;
+    for (size_t size = 0; size <= json.size() + 2; size++) {
+      buf.assign(size + 1, '#');   // (a guard byte after the buffer)
+      lolan_jsonBufferInit(&fixed, buf.data(), size, NULL, NULL);
+      if (size >= 2)
+        CHECK(lolan_cborToJson(zero, 1, &fixed, 0) == LOLAN_RETVAL_YES);
+      len = fixed.len;
+      err = lolan_cborToJson(data.data(), data.size(), &fixed, v.flags);
+      if (len + json.size() < size) {   // (room for the terminating zero)
+        CHECK((err == LOLAN_RETVAL_YES) && (fixed.len == len + json.size()) && (("0" + json) == buf.data()));
+      } else {
+        CHECK((err == LOLAN_RETVAL_MEMERROR) && (fixed.len == len));
+        CHECK((size == 0) || (strcmp(buf.data(), (len > 0) ? "0" : "") == 0));
+      }
+      CHECK(buf[size] == '#');
+    }
+  }
+
+  /* data larger than a packet (e.g. a reassembled multipart payload) */
+  data = cbHex("99012c");   // (array of 300 items)
+  json = "[";
+  for (unsigned i = 0; i < 300; i++) {
+    data.push_back(i % 24);
+    json += ((i > 0) ? "," : "") + std::to_string(i % 24);
+  }
+  json += "]";
+  lolan_jsonBufferInit(&jb, NULL, 0, jsGrow, &grown);
+  CHECK((lolan_cborToJson(data.data(), data.size(), &jb, 0) == LOLAN_RETVAL_YES) && (json == jb.buf));
+}
+
+/* JSON records of INFORM and ACK packets: fixed payloads */
+struct PjVector {       // packet type, payload in hexadecimal, conversion flags, the expected result and records
+  lolan_PacketType type;
+  const char *hex;
+  uint8_t flags;
+  int8_t result;
+  const char *json;
+};
+
+static const PjVector pjVectors[] = {
+  /* legacy style INFORM (relative to the base path of the zero key) */
+  { LOLAN_PAK_INFORM, "a101a102182a", 0, LOLAN_RETVAL_YES, "{\"from\":12,\"path\":\"1/2\",\"type\":\"uint\",\"value\":42}\n" },
+  { LOLAN_PAK_INFORM, "a2008201020320", 0, LOLAN_RETVAL_YES, "{\"from\":12,\"path\":\"1/2/3\",\"type\":\"int\",\"value\":-1}\n" },
+  { LOLAN_PAK_INFORM, "a20081050a6161", 0, LOLAN_RETVAL_YES, "{\"from\":12,\"path\":\"5/10\",\"type\":\"str\",\"value\":\"a\"}\n" },
+  /* new style INFORM */
+  { LOLAN_PAK_INFORM, "a20019012b01a102a103fa3fc00000", 0, LOLAN_RETVAL_YES,
+    "{\"from\":12,\"path\":\"1/2/3\",\"type\":\"float\",\"value\":1.5}\n" },
+  { LOLAN_PAK_INFORM, "a40019012b05636122620642010218c8fb3fb999999999999a", 0, LOLAN_RETVAL_YES,
+    "{\"from\":12,\"path\":\"5\",\"type\":\"str\",\"value\":\"a\\\"b\"}\n"
+    "{\"from\":12,\"path\":\"6\",\"type\":\"data\",\"value\":\"AQI\"}\n"
+    "{\"from\":12,\"path\":\"200\",\"type\":\"float\",\"value\":0.1}\n" },
+  { LOLAN_PAK_INFORM, "a20019012b064301abff", LOLAN_JSON_BYTES_HEX, LOLAN_RETVAL_YES,
+    "{\"from\":12,\"path\":\"6\",\"type\":\"data\",\"value\":\"01abff\"}\n" },
+  { LOLAN_PAK_INFORM, "bf0019012b19012c0107bf0820ffff", 0, LOLAN_RETVAL_YES,   // (key >255 skipped, indefinite lengths)
+    "{\"from\":12,\"path\":\"7/8\",\"type\":\"int\",\"value\":-1}\n" },
+  { LOLAN_PAK_INFORM, "a20019012b013b7fffffffffffffff", 0, LOLAN_RETVAL_YES,
+    "{\"from\":12,\"path\":\"1\",\"type\":\"int\",\"value\":-9223372036854775808}\n" },
+  { LOLAN_PAK_INFORM, "a0", 0, LOLAN_RETVAL_NO, "" },
+  { LOLAN_PAK_INFORM, "a10019012b", 0, LOLAN_RETVAL_NO, "" },
+  { LOLAN_PAK_INFORM, "a20019012a0101", 0, LOLAN_RETVAL_GENERROR, "" },   // (status code 298)
+  { LOLAN_PAK_INFORM, "182a", 0, LOLAN_RETVAL_GENERROR, "" },   // (no root map)
+  { LOLAN_PAK_INFORM, "a1410101", 0, LOLAN_RETVAL_GENERROR, "" },   // (key is not an integer)
+  { LOLAN_PAK_INFORM, "a2010a0280", 0, LOLAN_RETVAL_GENERROR, "" },   // (the other records are dropped)
+  { LOLAN_PAK_INFORM, "a20019012b0180", 0, LOLAN_RETVAL_GENERROR, "" },
+  { LOLAN_PAK_INFORM, "a20019012b01f93c00", 0, LOLAN_RETVAL_GENERROR, "" },
+  { LOLAN_PAK_INFORM, "a20019012b01f5", 0, LOLAN_RETVAL_GENERROR, "" },
+  { LOLAN_PAK_INFORM, "a20019012b01c100", 0, LOLAN_RETVAL_GENERROR, "" },
+  { LOLAN_PAK_INFORM, "a30019012b010002f6", 0, LOLAN_RETVAL_GENERROR, "" },
+  { LOLAN_PAK_INFORM, "a2001901", 0, LOLAN_RETVAL_CBORERROR, "" },
+  { LOLAN_PAK_INFORM, "bf0019012b01ff", 0, LOLAN_RETVAL_GENERROR, "" },   // (key without value)
+  /* ACK (GET and SET replies) */
+  { LOLAN_PAK_ACK, "a30018c801a102050721", 0, LOLAN_RETVAL_YES,
+    "{\"from\":12,\"path\":null,\"type\":\"status\",\"value\":200}\n"
+    "{\"from\":12,\"path\":\"1/2\",\"type\":\"uint\",\"value\":5}\n"
+    "{\"from\":12,\"path\":\"7\",\"type\":\"int\",\"value\":-2}\n" },
+  { LOLAN_PAK_ACK, "a201a10218c80018cf", 0, LOLAN_RETVAL_YES,   // (zero key after the variables)
+    "{\"from\":12,\"path\":null,\"type\":\"status\",\"value\":207}\n"
+    "{\"from\":12,\"path\":\"1/2\",\"type\":\"uint\",\"value\":200}\n" },
+  { LOLAN_PAK_ACK, "a10018c8", 0, LOLAN_RETVAL_YES, "{\"from\":12,\"path\":null,\"type\":\"status\",\"value\":200}\n" },
+  { LOLAN_PAK_ACK, "182a", 0, LOLAN_RETVAL_YES, "{\"from\":12,\"path\":null,\"type\":\"uint\",\"value\":42}\n" },   // (short GET reply)
+  { LOLAN_PAK_ACK, "63616263", 0, LOLAN_RETVAL_YES, "{\"from\":12,\"path\":null,\"type\":\"str\",\"value\":\"abc\"}\n" },
+  { LOLAN_PAK_ACK, "fa3fc00000", 0, LOLAN_RETVAL_YES, "{\"from\":12,\"path\":null,\"type\":\"float\",\"value\":1.5}\n" },
+  { LOLAN_PAK_ACK, "a10102", 0, LOLAN_RETVAL_GENERROR, "" },   // (no zero key)
+  { LOLAN_PAK_ACK, "a2008101010a", 0, LOLAN_RETVAL_GENERROR, "" },   // (path in the zero key)
+  { LOLAN_PAK_ACK, "80", 0, LOLAN_RETVAL_GENERROR, "" }, { LOLAN_PAK_ACK, "f6", 0, LOLAN_RETVAL_GENERROR, "" },
+  { LOLAN_PAK_ACK, "f93c00", 0, LOLAN_RETVAL_GENERROR, "" }, { LOLAN_PAK_ACK, "", 0, LOLAN_RETVAL_CBORERROR, "" },
+  /* other packet types */
+  { LOLAN_PAK_GET, "a101a102182a", 0, LOLAN_RETVAL_GENERROR, "" }, { LOLAN_PAK_SET, "a10018c8", 0, LOLAN_RETVAL_GENERROR, "" },
+};
+
+static void testPacketJson()
+{
+  std::vector<uint8_t> data;
+  std::vector<char> grown, buf;
+  std::string all, json;
+  lolan_JsonBuffer jb, fixed;
+  lolan_Packet lp;
+  size_t len;
+  int8_t err;
+
+  lolan_jsonBufferInit(&jb, NULL, 0, jsGrow, &grown);
+  for (const PjVector &v : pjVectors) {
+    data = cbHex(v.hex);
+    lolan_resetPacket(&lp);
+    lp.packetType = v.type;
+    lp.fromId = 12;
+    lp.payload = data.data();
+    lp.payloadSize = data.size();
+    err = lolan_packetToJson(&lp, &jb, v.flags);
+    CHECK(err == v.result);
+    all += v.json;
+    CHECK((jb.len == all.size()) && (jb.size > jb.len) && (all == jb.buf));   // (appended, not modified on error)
+    if (err != LOLAN_RETVAL_YES)
+      continue;
+
+    /* fixed size buffer: the text is not modified if the records do not fit */
+    json = v.json;
+    for (size_t size = 0; size <= json.size() + 1; size++) {
+      buf.assign(size + 1, '#');
+      lolan_jsonBufferInit(&fixed, buf.data(), size, NULL, NULL);
+      len = fixed.len;
+      err = lolan_packetToJson(&lp, &fixed, v.flags);
+      if (json.size() < size) {
+        CHECK((err == LOLAN_RETVAL_YES) && (fixed.len == json.size()) && (json == buf.data()));
+      } else {
+        CHECK((err == LOLAN_RETVAL_MEMERROR) && (fixed.len == len) && ((size == 0) || (buf[0] == 0)));
+      }
+      CHECK(buf[size] == '#');
+    }
+  }
+
+  /* the source address */
+  data = cbHex("a20019012b0100");
+  lp.packetType = LOLAN_PAK_INFORM;
+  lp.fromId = 65535;
+  lp.payload = data.data();
+  lp.payloadSize = data.size();
+  all += "{\"from\":65535,\"path\":\"1\",\"type\":\"uint\",\"value\":0}\n";
+  CHECK((lolan_packetToJson(&lp, &jb, 0) == LOLAN_RETVAL_YES) && (all == jb.buf));
+}
+
+/* reentrancy: contexts processing the same requests in parallel threads, compared to a single thread */
+#define TH_THREADS  4
+#define TH_ROUNDS   20000   // (the threads are interleaved by preemption on a single core as well)
+#define TH_VARS     ((LOLAN_REGMAP_SIZE < 24) ? LOLAN_REGMAP_SIZE : 24)
+
+static lolan_ctx thCtx[TH_THREADS + 1];        // (the last one encodes the reference output)
+static uint32_t thData[TH_THREADS + 1][TH_VARS];
+static std::vector<std::vector<uint8_t> > thPayloads;
+static std::vector<lolan_Packet> thGet, thSet;
+
+// GET, SET and INFORM output of a context (with the return values)
+static void thRun(size_t t, std::vector<std::vector<uint8_t> > *out)
+{
+  uint8_t payload[LOLAN_PACKET_MAX_PAYLOAD_SIZE];
+  lolan_Packet reply;
+  int8_t err;
+
+  for (size_t r = 0; r < TH_ROUNDS; r++) {
+    std::vector<uint8_t> &o = (*out)[r];
+
+    o.clear();
+    lolan_resetPacket(&reply);
+    reply.payload = payload;
+    err = lolan_processGet(&thCtx[t], &thGet[r], &reply);
+    o.push_back(err);
+    if (err == LOLAN_RETVAL_YES)
+      o.insert(o.end(), payload, payload + reply.payloadSize);
+    lolan_resetPacket(&reply);
+    reply.payload = payload;
+    err = lolan_processSet(&thCtx[t], &thSet[r], &reply);
+    o.push_back(err);
+    if (err == LOLAN_RETVAL_YES)
+      o.insert(o.end(), payload, payload + reply.payloadSize);
+    for (size_t k = 0; k < 3; k++)
+      lolan_setFlag(&thCtx[t], &thData[t][(r + 7 * k) % TH_VARS], LOLAN_REGMAP_LOCAL_UPDATE_BIT);
+    for (;;) {
+      lolan_resetPacket(&reply);
+      reply.payload = payload;
+      if (lolan_createInform(&thCtx[t], &reply, true) != LOLAN_RETVAL_YES)
+        break;
+      o.insert(o.end(), payload, payload + reply.payloadSize);
+    }
+  }
+}
+
+static void testThreads()
+{
+  std::vector<std::vector<std::vector<uint8_t> > > out(TH_THREADS + 1, std::vector<std::vector<uint8_t> >(TH_ROUNDS));
+  std::vector<std::thread> workers;
+  std::vector<StEntry> entries;
+  uint8_t path[LOLAN_REGMAP_DEPTH];
+  StEntry e;
+
+  /* contexts with the same variables */
+  for (size_t t = 0; t <= TH_THREADS; t++) {
+    lolan_init(&thCtx[t], 1);
+    for (size_t j = 0; j < TH_VARS; j++) {
+      memset(path, 0, sizeof(path));
+      path[0] = 1 + j % 3;
+      path[1] = 1 + j / 3;
+      thData[t][j] = j;
+      CHECK(lolan_regVar(&thCtx[t], path, LOLAN_UINT, &thData[t][j], 4, false) == LOLAN_RETVAL_YES);
+    }
+  }
+
+  /* requests: GET of a branch or a variable, New Style SET of a few variables */
+  thPayloads.resize(2 * TH_ROUNDS);
+  thGet.resize(TH_ROUNDS);
+  thSet.resize(TH_ROUNDS);
+  for (size_t r = 0; r < TH_ROUNDS; r++) {
+    entries.clear();
+    for (size_t k = 0; k < 1 + r % 4; k++) {
+      size_t j = (r * 5 + k * 3) % TH_VARS;
+      e.path = { (uint16_t) (1 + j % 3), (uint16_t) (1 + j / 3) };
+      e.item.clear();
+      stHead(e.item, 0, stRandom() % ((r % 5 == 0) ? 100000 : 1000));
+      entries.push_back(e);
+    }
+    thPayloads[2 * r] = stNewStyle(entries, r % 2);
+    thSet[r] = stPacket(thPayloads[2 * r]);
+    thPayloads[2 * r + 1].resize(LOLAN_PACKET_MAX_PAYLOAD_SIZE);
+    lolan_resetPacket(&thGet[r]);
+    thGet[r].payload = thPayloads[2 * r + 1].data();
+    memset(path, 0, sizeof(path));
+    path[0] = 1 + r % 3;
+    path[1] = (r % 2) ? 1 + r % (TH_VARS / 3) : 0;
+    CHECK(lolan_createGet(&thCtx[TH_THREADS], &thGet[r], path) == LOLAN_RETVAL_YES);
+    thGet[r].fromId = 2;
+    thGet[r].toId = 1;
+    thGet[r].packetCounter = r;
+  }
+
+  thRun(TH_THREADS, &out[TH_THREADS]);
+  for (size_t t = 0; t < TH_THREADS; t++)
+    workers.push_back(std::thread(thRun, t, &out[t]));
+  for (auto &w : workers)
+    w.join();
+  for (size_t t = 0; t < TH_THREADS; t++) {
+    CHECK(out[t] == out[TH_THREADS]);
+    CHECK(memcmp(thData[t], thData[TH_THREADS], sizeof(thData[t])) == 0);
+  }
+  for (size_t r = 0; r < TH_ROUNDS; r++)   // (replies to every request)
+    CHECK((out[TH_THREADS][r][0] == LOLAN_RETVAL_YES) && (out[TH_THREADS][r].size() > 10));
+#ifdef LOLAN_REGMAP_DYNAMIC
+  for (size_t t = 0; t <= TH_THREADS; t++)
+    lolan_free(&thCtx[t]);
+#endif
+}
+
+#if defined(LOLAN_MULTIPART_MAX_SIZE) || defined(LOLAN_DUPFILTER_SOURCES)
+// header of a request sent by fromId
+static lolan_Packet requestHeader(uint16_t fromId, uint8_t packetCounter)
+{
+  lolan_Packet lp;
+
+  lolan_resetPacket(&lp);
+  lp.packetType = LOLAN_PAK_SET;
+  lp.packetCounter = packetCounter;
+  lp.fromId = fromId;
+  lp.toId = 1;
+  return lp;
+}
+#endif
+
+#ifdef LOLAN_MULTIPART_MAX_SIZE
+// CBOR map of count small integer entries (1: 3, 2: 6, ...)
+static std::vector<uint8_t> mapPayload(size_t count)
+{
+  std::vector<uint8_t> buf(16 + count * 8);
+  CborEncoder enc, map;
+
+  cbor_encoder_init(&enc, buf.data(), buf.size(), 0);
+  cbor_encoder_create_map(&enc, &map, count);
+  for (size_t i = 1; i <= count; i++) {
+    cbor_encode_uint(&map, i);
+    cbor_encode_uint(&map, i * 3);
+  }
+  cbor_encoder_close_container(&enc, &map);
+  buf.resize(cbor_encoder_get_buffer_size(&enc, buf.data()));
+  return buf;
+}
+
+// CBOR map with one byte string entry (1: h'0102...')
+static std::vector<uint8_t> bytesPayload(size_t len)
+{
+  std::vector<uint8_t> data(len), buf(16 + len);
+  CborEncoder enc, map;
+
+  for (size_t i = 0; i < len; i++)
+    data[i] = i;
+  cbor_encoder_init(&enc, buf.data(), buf.size(), 0);
+  cbor_encoder_create_map(&enc, &map, 1);
+  cbor_encode_uint(&map, 1);
+  cbor_encode_byte_string(&map, data.data(), len);
+  cbor_encoder_close_container(&enc, &map);
+  buf.resize(cbor_encoder_get_buffer_size(&enc, buf.data()));
+  return buf;
+}
+
+// split a payload into fragments
+static std::vector<lolan_Packet> fragments(const lolan_Packet &header, const std::vector<uint8_t> &payload,
+                                           LP_SIZE_T fragmentSize)
+{
+  std::vector<lolan_Packet> frags;
+  lolan_Fragmenter fr;
+  lolan_Packet lp;
+
+  lolan_fragmenterInit(&fr, &header, payload.data(), payload.size(), fragmentSize);
+  while (lolan_fragmenterNext(&fr, &lp) == LOLAN_RETVAL_YES)
+    frags.push_back(lp);
+  return frags;
+}
+
+static void testMultipart()
+{
+  static lolan_Reassembly ra;
+  std::vector<uint8_t> payload;
+  std::vector<lolan_Packet> frags;
+  lolan_Packet out;
+  size_t i;
+
+  /* round trip */
+  lolan_reassemblyInit(&ra, 100);
+  payload = mapPayload(LOLAN_MULTIPART_MAX_SIZE / 8);
+  frags = fragments(requestHeader(2, 7), payload, 16);
+  CHECK(frags.size() > 2);
+  CHECK(frags.front().multiPart == LOLAN_MPC_MULTIPART_START);
+  CHECK(frags.back().multiPart == LOLAN_MPC_MULTIPART_END);
+  for (i = 0; i + 1 < frags.size(); i++)
+    CHECK(lolan_reassemblyPush(&ra, &frags[i], i, &out) == LOLAN_RETVAL_NO);
+  CHECK(lolan_reassemblyPush(&ra, &frags[i], i, &out) == LOLAN_RETVAL_YES);
+  CHECK(out.multiPart == LOLAN_MPC_NOMULTIPART);
+  CHECK((out.fromId == 2) && (out.packetCounter == 7));
+  CHECK((out.payloadSize == payload.size()) && (memcmp(out.payload, payload.data(), payload.size()) == 0));
+
+  /* single packet */
+  payload = mapPayload(2);
+  frags = fragments(requestHeader(2, 8), payload, 0);
+  CHECK((frags.size() == 1) && (frags[0].multiPart == LOLAN_MPC_NOMULTIPART));
+  CHECK(lolan_reassemblyPush(&ra, &frags[0], 0, &out) == LOLAN_RETVAL_YES);
+  CHECK((out.payloadSize == payload.size()) && (memcmp(out.payload, payload.data(), payload.size()) == 0));
+
+  /* lost MIDDLE fragment (truncated byte string) */
+  payload = bytesPayload(40);
+  frags = fragments(requestHeader(3, 1), payload, 8);
+  frags.erase(frags.begin() + 2);
+  for (i = 0; i + 1 < frags.size(); i++)
+    CHECK(lolan_reassemblyPush(&ra, &frags[i], 0, &out) == LOLAN_RETVAL_NO);
+  CHECK(lolan_reassemblyPush(&ra, &frags[i], 0, &out) == LOLAN_RETVAL_GENERROR);
+
+  /* no START fragment */
+  frags = fragments(requestHeader(3, 2), payload, 8);
+  CHECK(lolan_reassemblyPush(&ra, &frags[1], 0, &out) == LOLAN_RETVAL_GENERROR);
+
+  /* timeout */
+  CHECK(lolan_reassemblyPush(&ra, &frags[0], 1000, &out) == LOLAN_RETVAL_NO);
+  CHECK(lolan_reassemblyPush(&ra, &frags[1], 1100, &out) == LOLAN_RETVAL_NO);   // (not expired yet)
+  CHECK(lolan_reassemblyPush(&ra, &frags[2], 1201, &out) == LOLAN_RETVAL_GENERROR);   // expired
+  lolan_reassemblyInit(&ra, 0);   // no timeout
+  CHECK(lolan_reassemblyPush(&ra, &frags[0], 0, &out) == LOLAN_RETVAL_NO);
+  for (i = 1; i + 1 < frags.size(); i++)
+    CHECK(lolan_reassemblyPush(&ra, &frags[i], 0x80000000u * i, &out) == LOLAN_RETVAL_NO);
+  CHECK(lolan_reassemblyPush(&ra, &frags[i], 0, &out) == LOLAN_RETVAL_YES);
+
+  /* slot replacement: a new START replaces the least recently updated packet */
+  lolan_reassemblyInit(&ra, 0);
+  std::vector<std::vector<lolan_Packet>> senders;
+  for (i = 0; i <= LOLAN_MULTIPART_SLOTS; i++)
+    senders.push_back(fragments(requestHeader(10 + i, i), payload, 8));
+  for (i = 0; i < LOLAN_MULTIPART_SLOTS; i++)
+    CHECK(lolan_reassemblyPush(&ra, &senders[i][0], 100 + i, &out) == LOLAN_RETVAL_NO);
+  CHECK(lolan_reassemblyPush(&ra, &senders[0][1], 200, &out) == LOLAN_RETVAL_NO);   // sender 0 is updated
+  CHECK(lolan_reassemblyPush(&ra, &senders[LOLAN_MULTIPART_SLOTS][0], 300, &out) == LOLAN_RETVAL_NO);
+  if (LOLAN_MULTIPART_SLOTS > 1) {
+    CHECK(lolan_reassemblyPush(&ra, &senders[0][2], 301, &out) == LOLAN_RETVAL_NO);   // (kept)
+    CHECK(lolan_reassemblyPush(&ra, &senders[1][1], 302, &out) == LOLAN_RETVAL_GENERROR);   // (replaced)
+  } else {
+    CHECK(lolan_reassemblyPush(&ra, &senders[0][2], 301, &out) == LOLAN_RETVAL_GENERROR);   // (replaced)
+  }
+  CHECK(lolan_reassemblyPush(&ra, &senders[LOLAN_MULTIPART_SLOTS][1], 303, &out) == LOLAN_RETVAL_NO);
+
+  /* oversize packet */
+  lolan_reassemblyInit(&ra, 0);
+  payload = bytesPayload(LOLAN_MULTIPART_MAX_SIZE + 32);
+  frags = fragments(requestHeader(4, 1), payload, 16);
+  for (i = 0; (i < frags.size()) && (lolan_reassemblyPush(&ra, &frags[i], 0, &out) == LOLAN_RETVAL_NO); i++)
+    ;
+  CHECK(i < frags.size() - 1);   // refused before the END fragment
+  CHECK((LOLAN_MULTIPART_MAX_SIZE - 16 < i * 16) && (i * 16 <= LOLAN_MULTIPART_MAX_SIZE));
+  for (i++; i < frags.size(); i++)
+    CHECK(lolan_reassemblyPush(&ra, &frags[i], 0, &out) == LOLAN_RETVAL_GENERROR);
+}
+#endif
+
+#ifdef LOLAN_DUPFILTER_SOURCES
+static lolan_ctx dctx;
+static uint32_t dvars[16];
+
+// (re)initialize the context with the variables (1, 24..39)
+static void dupFilterCtx()
+{
+#ifdef LOLAN_REGMAP_DYNAMIC
+  lolan_free(&dctx);
+#endif
+  lolan_init(&dctx, 1);
+  for (uint8_t k = 0; k < 16; k++) {
+    uint8_t path[LOLAN_REGMAP_DEPTH] = { 0 };
+    path[0] = 1;
+    path[1] = 24 + k;   // (2-byte keys)
+    dvars[k] = 0;
+    CHECK(lolan_regVar(&dctx, path, LOLAN_UINT, &dvars[k], sizeof(dvars[k]), false) == LOLAN_RETVAL_YES);
+  }
+}
+
+// new style SET request for the variables (1, 24..) with value, value + 1, ...
+static lolan_Packet setRequest(uint16_t fromId, uint8_t packetCounter, uint8_t *buf, uint8_t count, uint32_t value)
+{
+  lolan_Packet lp = requestHeader(fromId, packetCounter);
+  CborEncoder enc, map, sub;
+
+  cbor_encoder_init(&enc, buf, LOLAN_PACKET_MAX_PAYLOAD_SIZE, 0);
+  cbor_encoder_create_map(&enc, &map, 2);
+  cbor_encode_uint(&map, 0);
+  cbor_encode_uint(&map, 1);
+  cbor_encode_uint(&map, 1);
+  cbor_encoder_create_map(&map, &sub, count);
+  for (uint8_t k = 0; k < count; k++) {
+    cbor_encode_uint(&sub, 24 + k);
+    cbor_encode_uint(&sub, value + k);
+  }
+  cbor_encoder_close_container(&map, &sub);
+  cbor_encoder_close_container(&enc, &map);
+  lp.payload = buf;
+  lp.payloadSize = cbor_encoder_get_buffer_size(&enc, buf);
+  return lp;
+}
+
+// GET request for the path (1, k) (k = 0: all variables)
+static lolan_Packet getRequest(uint16_t fromId, uint8_t packetCounter, uint8_t *buf, uint8_t k)
+{
+  lolan_Packet lp = requestHeader(fromId, packetCounter);
+  CborEncoder enc, map, arr;
+
+  lp.packetType = LOLAN_PAK_GET;
+  cbor_encoder_init(&enc, buf, LOLAN_PACKET_MAX_PAYLOAD_SIZE, 0);
+  cbor_encoder_create_map(&enc, &map, 1);
+  cbor_encode_uint(&map, 0);
+  cbor_encoder_create_array(&map, &arr, (k > 0) ? 2 : 1);
+  cbor_encode_uint(&arr, 1);
+  if (k > 0)
+    cbor_encode_uint(&arr, k);
+  cbor_encoder_close_container(&map, &arr);
+  cbor_encoder_close_container(&enc, &map);
+  lp.payload = buf;
+  lp.payloadSize = cbor_encoder_get_buffer_size(&enc, buf);
+  return lp;
+}
+
+static void testDupFilter()
+{
+  uint8_t req[LOLAN_PACKET_MAX_PAYLOAD_SIZE], rep[LOLAN_PACKET_MAX_PAYLOAD_SIZE];
+  std::vector<uint8_t> first;
+  lolan_Packet q, r;
+  LP_SIZE_T size;
+  uint8_t c;
+
+  dupFilterCtx();
+  r.payload = rep;
+
+  /* fresh request */
+  q = setRequest(2, 10, req, 1, 100000);
+  CHECK(lolan_processSet(&dctx, &q, &r) == LOLAN_RETVAL_YES);
+  CHECK(dvars[0] == 100000);
+  first.assign(rep, rep + r.payloadSize);
+
+  /* repeated request: answered from the cache, not processed again */
+  dvars[0] = 5;
+  memset(rep, 0, sizeof(rep));
+  CHECK(lolan_processSet(&dctx, &q, &r) == LOLAN_RETVAL_YES);
+  CHECK(dvars[0] == 5);
+  CHECK((r.packetType == LOLAN_PAK_ACK) && (r.packetCounter == 10) && (r.toId == 2) && (r.fromId == 1));
+  CHECK((r.payloadSize == first.size()) && (memcmp(rep, first.data(), first.size()) == 0));
+
+  /* newer request, then the old one again: dropped */
+  q = setRequest(2, 11, req, 1, 200000);
+  CHECK(lolan_processSet(&dctx, &q, &r) == LOLAN_RETVAL_YES);
+  CHECK(dvars[0] == 200000);
+  q = setRequest(2, 10, req, 1, 100000);
+  CHECK(lolan_processSet(&dctx, &q, &r) == LOLAN_RETVAL_NO);
+  CHECK(dvars[0] == 200000);
+
+  /* restarted packet counter: same counter with another payload, or far behind the window */
+  q = setRequest(2, 11, req, 1, 300000);
+  CHECK(lolan_processSet(&dctx, &q, &r) == LOLAN_RETVAL_YES);
+  CHECK(dvars[0] == 300000);
+  q = setRequest(2, 11 - LOLAN_DUPFILTER_WINDOW - 8, req, 1, 400000);
+  CHECK(lolan_processSet(&dctx, &q, &r) == LOLAN_RETVAL_YES);
+  CHECK(dvars[0] == 400000);
+
+  /* packet counter wraparound */
+  for (c = 250; c != 6; c++) {
+    q = setRequest(2, c, req, 1, 1000 + c);
+    CHECK(lolan_processSet(&dctx, &q, &r) == LOLAN_RETVAL_YES);
+    CHECK(dvars[0] == 1000u + c);
+  }
+  q = setRequest(2, 254, req, 1, 1254);
+  CHECK(lolan_processSet(&dctx, &q, &r) == LOLAN_RETVAL_NO);   // (old)
+  q = setRequest(2, 5, req, 1, 1005);
+  dvars[0] = 0;
+  CHECK(lolan_processSet(&dctx, &q, &r) == LOLAN_RETVAL_YES);   // (newest, cached)
+  CHECK(dvars[0] == 0);
+
+  /* SET reply larger than the cache: not answered */
+  q = setRequest(3, 1, req, 16, 100000);
+  CHECK(lolan_processSet(&dctx, &q, &r) == LOLAN_RETVAL_YES);
+  size = r.payloadSize;
+  dvars[15] = 0;
+  CHECK(lolan_processSet(&dctx, &q, &r) == ((size > LOLAN_DUPFILTER_REPLY_SIZE) ? LOLAN_RETVAL_NO : LOLAN_RETVAL_YES));
+  CHECK(dvars[15] == 0);
+
+  /* GET reply larger than the cache: processed again */
+  q = getRequest(4, 1, req, 0);
+  CHECK(lolan_processGet(&dctx, &q, &r) == LOLAN_RETVAL_YES);
+  first.assign(rep, rep + r.payloadSize);
+  dvars[15]++;   // (same encoded size)
+  CHECK(lolan_processGet(&dctx, &q, &r) == LOLAN_RETVAL_YES);
+  CHECK(r.payloadSize == first.size());
+  if (first.size() > LOLAN_DUPFILTER_REPLY_SIZE)   // processed again: the new value
+    CHECK(std::vector<uint8_t>(rep, rep + r.payloadSize) != first);
+  else   // from the cache
+    CHECK(std::vector<uint8_t>(rep, rep + r.payloadSize) == first);
+
+  /* old GET request: processed again */
+  q = getRequest(4, 2, req, 24);
+  CHECK(lolan_processGet(&dctx, &q, &r) == LOLAN_RETVAL_YES);
+  q = getRequest(4, 1, req, 0);
+  CHECK(lolan_processGet(&dctx, &q, &r) == LOLAN_RETVAL_YES);
+
+  /* the least recently used sender is replaced */
+  dupFilterCtx();
+  for (c = 0; c <= LOLAN_DUPFILTER_SOURCES; c++) {
+    q = setRequest(10 + c, 1, req, 1, 100 + c);
+    CHECK(lolan_processSet(&dctx, &q, &r) == LOLAN_RETVAL_YES);
+  }
+  dvars[0] = 0;
+  q = setRequest(10 + LOLAN_DUPFILTER_SOURCES, 1, req, 1, 100 + LOLAN_DUPFILTER_SOURCES);
+  CHECK(lolan_processSet(&dctx, &q, &r) == LOLAN_RETVAL_YES);   // (cached)
+  CHECK(dvars[0] == 0);
+  q = setRequest(10, 1, req, 1, 100);
+  CHECK(lolan_processSet(&dctx, &q, &r) == LOLAN_RETVAL_YES);   // (replaced: processed)
+  CHECK(dvars[0] == 100);
+}
+#endif
+
+#ifdef LOLAN_TX_SLOTS
+struct TxSent {
+  uint16_t toId;
+  uint8_t packetCounter;
+  uint32_t time;
+};
+
+static uint32_t txNow;                  // fake clock
+static std::vector<TxSent> txSent;      // packets sent by the engine
+static std::vector<int8_t> txStatus;    // completion statuses
+static lolan_TxEngine txe;
+static uint8_t txPayload[1];
+
+// GET request to toId
+static lolan_Packet txRequest(uint16_t toId, uint8_t packetCounter)
+{
+  lolan_Packet lp;
+
+  lolan_resetPacket(&lp);
+  lp.packetType = LOLAN_PAK_GET;
+  lp.packetCounter = packetCounter;
+  lp.fromId = 1;
+  lp.toId = toId;
+  lp.payload = txPayload;
+  lp.payloadSize = sizeof(txPayload);
+  return lp;
+}
+
+// ACK of a request from toId
+static lolan_Packet txAckOf(uint16_t toId, uint8_t packetCounter)
+{
+  lolan_Packet lp;
+
+  lolan_resetPacket(&lp);
+  lp.packetType = LOLAN_PAK_ACK;
+  lp.packetCounter = packetCounter;
+  lp.fromId = toId;
+  lp.toId = 1;
+  return lp;
+}
+
+static void txSend(void *arg, const lolan_Packet *lp)
+{
+  (void) arg;
+  CHECK(lp->ackRequired);
+  txSent.push_back({lp->toId, lp->packetCounter, txNow});
+}
+
+// records the status, submits the request pointed by arg (if any)
+static void txDone(void *arg, const lolan_Packet *request, const lolan_Packet *ack, int8_t status)
+{
+  CHECK((status == LOLAN_RETVAL_YES) == (ack != NULL));
+  CHECK((ack == NULL) || (ack->packetCounter == request->packetCounter));
+  txStatus.push_back(status);
+  if (arg != NULL)
+    CHECK(lolan_txSubmit(&txe, (const lolan_Packet *) arg, txNow, txDone, NULL) == LOLAN_RETVAL_YES);
+}
+
+static void testTx()
+{
+  lolan_Packet q, a, next;
+
+  txNow = UINT32_MAX - 150;   // (the clock wraps around)
+  lolan_txInit(&txe, txSend, NULL, 100, 6, 1);
+
+  /* not a GET or SET request */
+  q = txAckOf(5, 1);
+  CHECK(lolan_txSubmit(&txe, &q, txNow, txDone, NULL) == LOLAN_RETVAL_GENERROR);
+  CHECK(lolan_txPoll(&txe, txNow) == UINT32_MAX);
+
+  /* window: the second request to the same destination is queued */
+  q = txRequest(5, 1);
+  CHECK(lolan_txSubmit(&txe, &q, txNow, txDone, NULL) == LOLAN_RETVAL_YES);
+  next = txRequest(5, 3);   // (submitted when the second one completes)
+  q = txRequest(5, 2);
+  CHECK(lolan_txSubmit(&txe, &q, txNow, txDone, &next) == LOLAN_RETVAL_YES);
+  CHECK((txSent.size() == 1) && (txSent[0].packetCounter == 1));
+  q = txRequest(6, 1);
+  CHECK(lolan_txSubmit(&txe, &q, txNow, txDone, NULL) == ((LOLAN_TX_SLOTS > 2) ? LOLAN_RETVAL_YES : LOLAN_RETVAL_MEMERROR));
+  if (LOLAN_TX_SLOTS > 2) {   // (other destination: sent)
+    CHECK((txSent.size() == 2) && (txSent[1].toId == 6));
+    a = txAckOf(6, 1);
+    CHECK(lolan_txAck(&txe, &a, txNow) == LOLAN_RETVAL_YES);
+    CHECK((txStatus.size() == 1) && (txStatus[0] == LOLAN_RETVAL_YES));
+    txSent.pop_back();
+    txStatus.clear();
+  }
+
+  /* ACK: the queued request is sent; duplicated or foreign ACKs are ignored */
+  txNow += 50;
+  a = txAckOf(6, 1);
+  CHECK(lolan_txAck(&txe, &a, txNow) == LOLAN_RETVAL_NO);
+  a = txAckOf(5, 1);
+  CHECK(lolan_txAck(&txe, &a, txNow) == LOLAN_RETVAL_YES);
+  CHECK(lolan_txAck(&txe, &a, txNow) == LOLAN_RETVAL_NO);
+  CHECK((txStatus.size() == 1) && (txStatus[0] == LOLAN_RETVAL_YES));
+  CHECK((txSent.size() == 2) && (txSent[1].packetCounter == 2));
+
+  /* backoff: 100, 200, 400, 800, 800 (at most 8 times the initial timeout) */
+  CHECK(lolan_txPoll(&txe, txNow + 99) == 1);
+  CHECK(txSent.size() == 2);
+  txNow += 100;
+  CHECK(lolan_txPoll(&txe, txNow) == 200);
+  txNow += 200;
+  CHECK(lolan_txPoll(&txe, txNow) == 400);
+  txNow += 400;
+  CHECK(lolan_txPoll(&txe, txNow) == 800);
+  txNow += 800;
+  CHECK(lolan_txPoll(&txe, txNow) == 800);
+  txNow += 810;   // (late poll)
+  CHECK(lolan_txPoll(&txe, txNow) == 800);
+  CHECK(txSent.size() == 7);
+  for (size_t i = 1; i < txSent.size(); i++)
+    CHECK((txSent[i].toId == 5) && (txSent[i].packetCounter == 2));
+  CHECK((txSent[3].time - txSent[2].time == 200) && (txSent[5].time - txSent[4].time == 800));
+
+  /* failure after maxTries, a new request is submitted from the callback */
+  txSent.clear();
+  txStatus.clear();
+  CHECK(lolan_txPoll(&txe, txNow + 799) == 1);
+  txNow += 800;
+  CHECK(lolan_txPoll(&txe, txNow) == 100);
+  CHECK((txStatus.size() == 1) && (txStatus[0] == LOLAN_RETVAL_NO));
+  CHECK((txSent.size() == 1) && (txSent[0].packetCounter == 3) && (txSent[0].time == txNow));
+  a = txAckOf(5, 3);
+  CHECK(lolan_txAck(&txe, &a, txNow) == LOLAN_RETVAL_YES);
+  CHECK((txStatus.size() == 2) && (txStatus[1] == LOLAN_RETVAL_YES));
+  CHECK(lolan_txPoll(&txe, txNow) == UINT32_MAX);
+}
+#endif
+
+#ifdef LOLAN_PENDING_SIZE
+#define PENDING_MAX_COUNT   (LOLAN_PENDING_SIZE - LOLAN_PENDING_SIZE / 4)
+#define PENDING_MAX_DESTS   (LOLAN_PENDING_DESTS - LOLAN_PENDING_DESTS / 4)
+
+struct PendingModel {
+  uint16_t toId;
+  uint8_t packetCounter;
+  uint32_t time;
+  uintptr_t id;
+};
+
+static lolan_PendingTable pt;
+static std::vector<std::pair<uintptr_t, int8_t> > pendingDone;   // completion callbacks (id, status)
+static uint32_t pendingRnd = 12345;
+
+static uint32_t pendingRandom()
+{
+  pendingRnd = pendingRnd * 1103515245u + 12345u;
+  return pendingRnd >> 16;
+}
+
+// start slots (same as lolanPendingSlot() and lolanPendingDestSlot() in lolan-pending.c)
+static uint32_t pendingHome(uint16_t toId, uint8_t packetCounter)
+{
+  uint32_t h = (((uint32_t) toId << 8) | packetCounter) * 2654435761u;
+  return (h ^ (h >> 16)) & (LOLAN_PENDING_SIZE - 1);
+}
+
+static uint32_t pendingDestHome(uint16_t toId)
+{
+  uint32_t h = toId * 2654435761u;
+  return (h ^ (h >> 16)) & (LOLAN_PENDING_DESTS - 1);
+}
+
+static void pendingCallback(void *arg, const lolan_Packet *ack, int8_t status)
+{
+  CHECK((status == LOLAN_RETVAL_YES) == (ack != NULL));
+  pendingDone.push_back(std::make_pair((uintptr_t) arg, status));
+}
+
+// adds a GET request to toId, returns the status (the packet counter in packetCounter)
+static int8_t pendingAdd(uint16_t toId, uint32_t now, uintptr_t id, uint8_t *packetCounter)
+{
+  lolan_Packet lp;
+  uint8_t payload[1] = {0};
+  int8_t ret;
+
+  lolan_resetPacket(&lp);
+  lp.packetType = LOLAN_PAK_GET;
+  lp.fromId = 1;
+  lp.toId = toId;
+  lp.payload = payload;
+  lp.payloadSize = sizeof(payload);
+  ret = lolan_pendingAdd(&pt, &lp, now, pendingCallback, (void *) id);
+  if (ret == LOLAN_RETVAL_YES)
+    CHECK(lp.ackRequired);
+  *packetCounter = lp.packetCounter;
+  return ret;
+}
+
+static int8_t pendingAck(uint16_t toId, uint8_t packetCounter)
+{
+  lolan_Packet ack;
+
+  lolan_resetPacket(&ack);
+  ack.packetType = LOLAN_PAK_ACK;
+  ack.packetCounter = packetCounter;
+  ack.fromId = toId;
+  ack.toId = 1;
+  return lolan_pendingAck(&pt, &ack);
+}
+
+static void testPending()
+{
+  std::vector<PendingModel> model;
+  uint16_t nodes, busy[3], idle[3];
+  uint32_t i, j, k, now, n;
+  uint8_t c, c1;
+
+  nodes = (3 * LOLAN_PENDING_DESTS < 60000) ? 3 * LOLAN_PENDING_DESTS : 60000;
+
+  /* more destinations than the table holds (node 1 is used all the time: its counter continues and wraps around) */
+  lolan_pendingInit(&pt);
+  for (i = 0; i < nodes || i < 600; i++) {
+    CHECK(pendingAdd(2 + i % nodes, 0, 0, &c) == LOLAN_RETVAL_YES);
+    CHECK(pendingAck(2 + i % nodes, c) == LOLAN_RETVAL_YES);
+    CHECK(pendingAdd(1, 0, 0, &c1) == LOLAN_RETVAL_YES);
+    CHECK(c1 == (uint8_t) (i + 1));
+    CHECK(pendingAck(1, c1) == LOLAN_RETVAL_YES);
+    CHECK(pendingAck(1, c1) == LOLAN_RETVAL_NO);   // (duplicated ACK)
+  }
+  CHECK((pt.count == 0) && (pt.destCount <= PENDING_MAX_DESTS));
+
+  /* the packet counter of a pending request is skipped at the wraparound */
+  CHECK(pendingAdd(1, 0, 0, &c1) == LOLAN_RETVAL_YES);
+  for (i = 0; i < 300; i++) {
+    CHECK(pendingAdd(1, 0, 0, &c) == LOLAN_RETVAL_YES);
+    CHECK(c != c1);
+    CHECK(lolan_pendingCancel(&pt, 1, c) == LOLAN_RETVAL_YES);
+  }
+  CHECK(lolan_pendingCancel(&pt, 1, c1) == LOLAN_RETVAL_YES);
+  CHECK(lolan_pendingCancel(&pt, 1, c1) == LOLAN_RETVAL_NO);
+
+  /* destination table full: an idle destination is replaced, none if all are busy */
+  lolan_pendingInit(&pt);
+  for (i = 0; i < PENDING_MAX_DESTS; i++)
+    CHECK(pendingAdd(100 + i, 0, 0, &c) == LOLAN_RETVAL_YES);
+  CHECK(pendingAdd(99, 0, 0, &c) == LOLAN_RETVAL_MEMERROR);
+  CHECK(lolan_pendingCancel(&pt, 100, 1) == LOLAN_RETVAL_YES);
+  CHECK((pendingAdd(99, 0, 0, &c) == LOLAN_RETVAL_YES) && (c == 1));
+
+  /* backward-shift deletion at the wrap of the request table (three requests with start slot SIZE-1) */
+  lolan_pendingInit(&pt);
+  for (i = 2, j = 0; j < 3; i++) {
+    if (pendingHome(i, 1) == LOLAN_PENDING_SIZE - 1)
+      busy[j++] = i;
+  }
+  for (j = 0; j < 3; j++)
+    CHECK((pendingAdd(busy[j], 0, j, &c) == LOLAN_RETVAL_YES) && (c == 1));
+  CHECK((pt.entry[LOLAN_PENDING_SIZE - 1].toId == busy[0]) && (pt.entry[0].toId == busy[1]) && (pt.entry[1].toId == busy[2]));
+  CHECK(lolan_pendingCancel(&pt, busy[0], 1) == LOLAN_RETVAL_YES);
+  CHECK((pt.entry[LOLAN_PENDING_SIZE - 1].toId == busy[1]) && (pt.entry[0].toId == busy[2]) && !pt.entry[1].used);
+  CHECK(pendingAck(busy[2], 1) == LOLAN_RETVAL_YES);
+  CHECK(pt.entry[LOLAN_PENDING_SIZE - 1].used && !pt.entry[0].used);
+  CHECK(pendingAck(busy[1], 1) == LOLAN_RETVAL_YES);
+  CHECK(pt.count == 0);
+
+  /* backward-shift deletion at the wrap of the destination table (three idle destinations with start slot DESTS-1) */
+  lolan_pendingInit(&pt);
+  for (i = 2, j = 0; j < 3; i++) {
+    if (pendingDestHome(i) == LOLAN_PENDING_DESTS - 1)
+      idle[j++] = i;
+  }
+  for (j = 0; j < 3; j++) {
+    CHECK(pendingAdd(idle[j], 0, 0, &c) == LOLAN_RETVAL_YES);
+    CHECK(pendingAck(idle[j], c) == LOLAN_RETVAL_YES);
+  }
+  for (i = 0; pt.destCount < PENDING_MAX_DESTS; i++) {   // (busy destinations)
+    if ((30000 + i != idle[0]) && (30000 + i != idle[1]) && (30000 + i != idle[2]))
+      CHECK(pendingAdd(30000 + i, 0, 0, &c) == LOLAN_RETVAL_YES);
+  }
+  CHECK(pendingAdd(29999, 0, 0, &c) == LOLAN_RETVAL_YES);   // (replaces idle[0])
+  CHECK((pendingAdd(idle[1], 0, 0, &c) == LOLAN_RETVAL_YES) && (c == 2));
+  CHECK((pendingAdd(idle[2], 0, 0, &c) == LOLAN_RETVAL_YES) && (c == 2));
+  CHECK(pt.destCount == PENDING_MAX_DESTS);
+
+  /* random add, ack, cancel and expire over many destinations, checked against a model */
+  lolan_pendingInit(&pt);
+  pendingDone.clear();
+  now = UINT32_MAX - 5000;   // (the clock wraps around)
+  for (i = 0; i < 20000; i++) {
+    now++;
+    k = pendingRandom() % 16;
+    if (k < 8) {   // add
+      uint16_t toId = 1 + pendingRandom() % nodes;
+      bool destPending = false;
+      std::vector<uint16_t> dests;
+      int8_t expected;
+      for (const PendingModel &m : model) {
+        destPending |= (m.toId == toId);
+        if (std::find(dests.begin(), dests.end(), m.toId) == dests.end())
+          dests.push_back(m.toId);
+      }
+      expected = LOLAN_RETVAL_YES;
+      if ((model.size() >= PENDING_MAX_COUNT) || (!destPending && (dests.size() >= PENDING_MAX_DESTS)))
+        expected = LOLAN_RETVAL_MEMERROR;
+      CHECK(pendingAdd(toId, now, i, &c) == expected);
+      if (expected == LOLAN_RETVAL_YES) {
+        for (const PendingModel &m : model)
+          CHECK((m.toId != toId) || (m.packetCounter != c));
+        model.push_back({toId, c, now, i});
+      }
+    } else if ((k < 14) && !model.empty()) {   // ack or cancel
+      j = pendingRandom() % model.size();
+      PendingModel m = model[j];
+      model.erase(model.begin() + j);
+      n = pendingDone.size();
+      if (k < 11) {
+        CHECK(pendingAck(m.toId, m.packetCounter) == LOLAN_RETVAL_YES);
+        CHECK((pendingDone.size() == n + 1) && (pendingDone[n] == std::make_pair(m.id, (int8_t) LOLAN_RETVAL_YES)));
+      } else {
+        CHECK(lolan_pendingCancel(&pt, m.toId, m.packetCounter) == LOLAN_RETVAL_YES);
+        CHECK(pendingDone.size() == n);
+      }
+      CHECK(pendingAck(m.toId, m.packetCounter) == LOLAN_RETVAL_NO);
+    } else if (k == 15) {   // expire
+      n = pendingDone.size();
+      j = 0;
+      for (size_t m = 0; m < model.size(); ) {
+        if (now - model[m].time > 40) {
+          model.erase(model.begin() + m);
+          j++;
+        } else {
+          m++;
+        }
+      }
+      CHECK(lolan_pendingExpire(&pt, now, 40) == j);
+      CHECK(pendingDone.size() == n + j);
+      for (; n < pendingDone.size(); n++)
+        CHECK(pendingDone[n].second == LOLAN_RETVAL_NO);
+    }
+    CHECK(pt.count == model.size());
+    if (failures > 0)   // (the model is out of sync)
+      break;
+  }
+  for (const PendingModel &m : model)
+    CHECK(lolan_pendingCancel(&pt, m.toId, m.packetCounter) == LOLAN_RETVAL_YES);
+  CHECK(pt.count == 0);
+}
+#endif
+
+int main()
+{
+  testRegMap();
+  testPacket();
+  testSet();
+#ifdef LOLAN_PREPARED_INFORM_SIZE
+  testPrepared();
+#endif
+  testCbor();
+  testJson();
+  testPacketJson();
+  testThreads();
+#ifdef LOLAN_MULTIPART_MAX_SIZE
+  testMultipart();
+#endif
+#ifdef LOLAN_DUPFILTER_SOURCES
+  testDupFilter();
+#endif
+#ifdef LOLAN_TX_SLOTS
+  testTx();
+#endif
+#ifdef LOLAN_PENDING_SIZE
+  testPending();
+#endif
+
+  printf("%u checks, %u failures\n", checks, failures);
+  return (failures == 0) ? 0 : 1;
+}